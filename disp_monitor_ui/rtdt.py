@@ -1,15 +1,209 @@
+import os
 import sys
 import csv
+import time
+import struct
 import tkinter as tk
 from tkinter import ttk, filedialog
 import socket
 import threading
 import serial
 import serial.tools.list_ports
+from rtdt_rec import Recorder
 
 APPNAME = "ESP32-C6-MPU6050 V1.0"
 RATES = [10, 30, 50, 60, 100, 200, 250, 500, 1000, 2000, 5000] # ms
 
+# Binary telemetry framing (see esp32c6_rtdt_app/src/include/telemetry.h)
+SYNC = b"\xaa\x55"
+HEADER_SIZE = 4 # sync (2), type (1), payload length (1)
+CRC_SIZE = 2
+FRAME_MOTION = 0x01
+MOTION_PAYLOAD = struct.Struct("<BIQ9f") # dev, seq, t_us, ax, ay, az, vx, vy, vz, dx, dy, dz
+FRAME_EVENT = 0x02
+EVENT_PAYLOAD = struct.Struct("<BIQHHHHHB") # dev, event, t_us, rate_hz, pre, post, duration, peak_ratio (Q4), accel_range
+FRAME_EVENT_DATA = 0x03
+EVENT_DATA_HEADER = struct.Struct("<BH") # dev, offset, followed by int16 ax, ay, az per sample
+EVENT_SAMPLE = struct.Struct("<3h")
+ACCEL_LSB_PER_G = [16384, 8192, 4096, 2048] # by accel_range code
+FRAME_RAW = 0x04
+RAW_HEADER = struct.Struct("<BBBIQIBB") # dev, mode, n, seq, t_us, span_us, accel_range, gyro_range, followed by the encoded block
+RAW_CHANNELS = 6 # ax, ay, az, gx, gy, gz
+RAW_MODE_RICE, RAW_MODE_VERBATIM = 0, 1
+RAW_K_BITS = 4
+RAW_ESCAPE = 16
+FRAME_INFO = 0x05
+FRAME_STATE = 0x06
+STATE_PAYLOAD = struct.Struct("<BIQ6fH") # dev, period, t_us, vx, vy, vz, dx, dy, dz, misses (set_mode:control)
+INFO_PAYLOAD = struct.Struct("<10BIf7f")
+INFO_FIELDS = ("dev", "addr", "accel_range", "gyro_range", "dlpf_cfg", "smplrt_div", "acq_mode", "output", "math", "decim",
+               "update_rate_ms", "sample_rate_hz", "ax_bias", "ay_bias", "az_bias", "gx_bias", "gy_bias", "gz_bias", "cal_temp")
+PLOT_DEVICE = 0 # sensor index shown in the plots (0 = primary)
+INGEST_SOCKET = "/tmp/rtdt_ingest.sock" # rtdt_ingest fallback socket (see host_ingest), listed as a port when present
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+class FrameDecoder:
+    """Extracts CRC checked frames from a byte stream mixed with log text."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buffer += data
+        frames = []
+
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # keep a trailing sync byte that may be completed by the next read
+                del self.buffer[:max(len(self.buffer) - 1, 0)]
+                break
+            del self.buffer[:start]
+
+            if len(self.buffer) < HEADER_SIZE:
+                break
+
+            frame_type, length = self.buffer[2], self.buffer[3]
+            size = HEADER_SIZE + length + CRC_SIZE
+            if len(self.buffer) < size:
+                break
+
+            crc = self.buffer[size - 2] | (self.buffer[size - 1] << 8)
+            if crc16(self.buffer[2:HEADER_SIZE + length]) != crc:
+                # false sync or corrupted frame: skip the sync word and rescan
+                self.crc_errors += 1
+                del self.buffer[:1]
+                continue
+
+            frames.append((frame_type, bytes(self.buffer[HEADER_SIZE:HEADER_SIZE + length])))
+            del self.buffer[:size]
+
+        return frames
+
+def decode_raw_block(mode, n, data):
+    """Decodes a raw_codec block (see esp32c6_rtdt_app/src/include/raw_codec.h) into n tuples of 6 counts."""
+    if mode == RAW_MODE_VERBATIM:
+        return list(struct.iter_unpack("<6h", data[:n * RAW_CHANNELS * 2]))
+    if mode != RAW_MODE_RICE:
+        raise ValueError(f"unknown raw block mode {mode}")
+
+    first = struct.unpack_from("<6h", data)
+    bits = int.from_bytes(data[RAW_CHANNELS * 2:], "big")
+    pos = (len(data) - RAW_CHANNELS * 2) * 8 # bits left to read
+
+    def read(count):
+        nonlocal pos
+        if count > pos:
+            raise ValueError("truncated raw block")
+        pos -= count
+        return (bits >> pos) & ((1 << count) - 1)
+
+    columns = []
+    for ch in range(RAW_CHANNELS):
+        k = read(RAW_K_BITS)
+        value = first[ch]
+        column = [value]
+        for _ in range(n - 1):
+            q = 0
+            while q < RAW_ESCAPE and read(1):
+                q += 1
+            z = read(16) if q == RAW_ESCAPE else (q << k) | read(k)
+            delta = (z >> 1) ^ -(z & 1)
+            value = (value + delta + 0x8000) % 0x10000 - 0x8000 # deltas wrap modulo 2^16
+            column.append(value)
+        columns.append(column)
+
+    return list(zip(*columns))
+
+def decode_raw_frame(payload):
+    """Returns dev, [(seq, t_us, ax, ay, az, gx, gy, gz, accel_range, gyro_range), ...] for a raw frame.
+
+    The counts are as measured, every sample of a frame shares the range codes of its header.
+    """
+    dev, mode, n, seq, t_us, span_us, accel_range, gyro_range = RAW_HEADER.unpack_from(payload)
+    samples = decode_raw_block(mode, n, payload[RAW_HEADER.size:])
+    step = span_us / (n - 1) if n > 1 else 0
+    return dev, [(seq + i, t_us + round(i * step), *sample, accel_range, gyro_range) for i, sample in enumerate(samples)]
+
+class EventAssembler:
+    """Collects an event dump (header frame + data frames) and saves it as CSV."""
+
+    def __init__(self, directory="."):
+        self.directory = directory
+        self.header = None
+        self.samples = []
+
+    def feed(self, frame_type, payload):
+        if frame_type == FRAME_EVENT and len(payload) == EVENT_PAYLOAD.size:
+            self.header = EVENT_PAYLOAD.unpack(payload)
+            self.samples = []
+            return None
+
+        if frame_type != FRAME_EVENT_DATA or self.header is None or len(payload) < EVENT_DATA_HEADER.size:
+            return None
+
+        dev, offset = EVENT_DATA_HEADER.unpack_from(payload)
+        if dev != self.header[0] or offset != len(self.samples):
+            # lost a frame: the window is incomplete, wait for the next dump
+            print(f"Event dump out of sequence at sample {len(self.samples)}")
+            self.header = None
+            return None
+
+        self.samples.extend(EVENT_SAMPLE.iter_unpack(payload[EVENT_DATA_HEADER.size:]))
+
+        _, _, _, _, pre, post, _, _, _ = self.header
+        if len(self.samples) < pre + post:
+            return None
+
+        path = self.save()
+        self.header = None
+        return path
+
+    def save(self):
+        dev, event, t_us, rate_hz, pre, _, duration, peak_ratio, accel_range = self.header
+        scale = 9.80665 / ACCEL_LSB_PER_G[accel_range & 3]
+        path = f"{self.directory}/event_{dev}_{event}_{time.strftime('%Y%m%d_%H%M%S')}.csv"
+
+        with open(path, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow([f"# trigger_t_us={t_us} rate_hz={rate_hz} pre={pre} duration={duration} peak_sta_lta={peak_ratio / 16:.2f}"])
+            writer.writerow(["t_s", "ax", "ay", "az"])
+            for i, (ax, ay, az) in enumerate(self.samples):
+                writer.writerow([f"{(i - pre) / rate_hz:.4f}", f"{ax * scale:.4f}", f"{ay * scale:.4f}", f"{az * scale:.4f}"])
+
+        return path
+
+class IngestSocket:
+    """Serial-like wrapper around the rtdt_ingest socket: frames in, command lines out."""
+
+    in_waiting = 0
+
+    def __init__(self, path, timeout=3):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.sock.settimeout(timeout)
+
+    def read(self, size=1):
+        try:
+            return self.sock.recv(max(size, 4096))
+        except socket.timeout:
+            return b""
+
+    def write(self, data):
+        self.sock.sendall(data)
+
+    def close(self):
+        self.sock.close()
+
 class DataClient:
     def __init__(self, host=None, port=None, serial_port=None, baudrate=115200):
         self.host = host
@@ -22,13 +216,20 @@ class DataClient:
 
     def connect_serial(self):
         try:
-            self.client = serial.Serial(self.serial_port, self.baudrate, timeout=3)
+            if self.serial_port == INGEST_SOCKET:
+                # the device is owned by rtdt_ingest, share its stream
+                self.client = IngestSocket(INGEST_SOCKET)
+            else:
+                self.client = serial.Serial(self.serial_port, self.baudrate, timeout=3)
             self.connected = True
         except Exception as e:
             print(f"Serial connection failed: {e}")
 
     def list_ports(self):
-        return [port.device for port in serial.tools.list_ports.comports()]
+        ports = [port.device for port in serial.tools.list_ports.comports()]
+        if hasattr(socket, "AF_UNIX") and os.path.exists(INGEST_SOCKET):
+            ports.insert(0, INGEST_SOCKET)
+        return ports
 
     def send_command(self, command):
         with self.lock:
@@ -41,16 +242,34 @@ class DataClient:
                 self.connected = False
                 print(f"Send failed: {e}")
 
-    def receive_data(self, callback):
+    def receive_data(self, callback, raw_callback=None, info_callback=None):
+        decoder = FrameDecoder()
+        events = EventAssembler()
         if self.connected and self.client:
             while self.connected:
                 try:
-                    data = self.client.readline().decode().strip()
+                    data = self.client.read(self.client.in_waiting or 1)
 
                     if not data:
                         continue
-                    
-                    callback(data)  
+
+                    for frame_type, payload in decoder.feed(data):
+                        if frame_type == FRAME_MOTION and len(payload) == MOTION_PAYLOAD.size:
+                            callback(MOTION_PAYLOAD.unpack(payload))
+                        elif frame_type == FRAME_STATE and len(payload) == STATE_PAYLOAD.size:
+                            # Control mode carries no acceleration
+                            dev, period, t_us, *state, _ = STATE_PAYLOAD.unpack(payload)
+                            callback((dev, period, t_us, 0.0, 0.0, 0.0, *state))
+                        elif frame_type == FRAME_RAW and len(payload) >= RAW_HEADER.size:
+                            if raw_callback:
+                                raw_callback(*decode_raw_frame(payload))
+                        elif frame_type == FRAME_INFO and len(payload) == INFO_PAYLOAD.size:
+                            if info_callback:
+                                info_callback(dict(zip(INFO_FIELDS, INFO_PAYLOAD.unpack(payload))))
+                        else:
+                            path = events.feed(frame_type, payload)
+                            if path:
+                                print(f"Event saved to {path}")
                     
                 except Exception as e:
                     self.connected = False
@@ -77,8 +296,7 @@ class App(tk.Tk):
         self.port_var    = tk.StringVar()
 
         self.is_running     = False
-        self.record_file    = None
-        self.record_writer  = None
+        self.recorder       = None
 
         self.max_points     = 100
 
@@ -135,6 +353,9 @@ class App(tk.Tk):
         self.reset_button = ttk.Button(btn_frame, text="RESET", command=self.toggle_reset)
         self.reset_button.pack(side=tk.LEFT, padx=5)
 
+        self.record_button = ttk.Button(btn_frame, text="REC", command=self.toggle_record)
+        self.record_button.pack(side=tk.LEFT, padx=5)
+
         config_frame = ttk.Frame(self)
         config_frame.pack(fill=tk.X, padx=10)
 
@@ -156,6 +377,8 @@ class App(tk.Tk):
         ttk.Button(config_frame, text="Set Rate", command=self.send_rate).pack(side=tk.LEFT, padx=5)
         ttk.Button(config_frame, text="Set Noise", command=self.send_noise).pack(side=tk.LEFT, padx=5)
         ttk.Button(config_frame, text="Set Config", command=self.send_config).pack(side=tk.LEFT, padx=5)
+        ttk.Button(config_frame, text="Arm Capture", command=lambda: self.data_client.send_command("capture:arm")).pack(side=tk.LEFT, padx=5)
+        ttk.Button(config_frame, text="Dump Event", command=lambda: self.data_client.send_command("capture:dump")).pack(side=tk.LEFT, padx=5)
 
         self.plot_frame = tk.Frame(self)
         self.plot_frame.pack(fill=tk.BOTH, expand=True)
@@ -268,7 +491,8 @@ class App(tk.Tk):
 
                 if self.data_client.connected:
                     self.connect_button.config(text="DISCONNECT")
-                    threading.Thread(target=self.data_client.receive_data, args=(self.update_plot,), daemon=True).start()
+                    self.data_client.send_command("set_output:binary")
+                    threading.Thread(target=self.data_client.receive_data, args=(self.update_plot, self.record_raw, self.record_info), daemon=True).start()
             else:
                 self.data_client.send_command("stop")
                 self.data_client.close()
@@ -312,33 +536,56 @@ class App(tk.Tk):
         cfg = self.mpu_config_entry.get()
         self.data_client.send_command(f"set_mpu6050_config:{cfg}")
             
-    def update_plot(self, data):
-        try:
-            if "Acceleration:" in data:
-                values = list(map(float, data.split("Acceleration:")[1].strip().split(",")))
-                self.accel_x = self.accel_x[1:] + [values[0]]
-                self.accel_y = self.accel_y[1:] + [values[1]]
-                self.accel_z = self.accel_z[1:] + [values[2]]
-
-            elif "Velocity:" in data:
-                values = list(map(float, data.split("Velocity:")[1].strip().split(",")))
-                self.vel_x = self.vel_x[1:] + [values[0]]
-                self.vel_y = self.vel_y[1:] + [values[1]]
-                self.vel_z = self.vel_z[1:] + [values[2]]
-
-            elif "Displacement:" in data:
-                values = list(map(float, data.split("Displacement:")[1].strip().split(",")))
-                self.disp_x = self.disp_x[1:] + [values[0]]
-                self.disp_y = self.disp_y[1:] + [values[1]]
-                self.disp_z = self.disp_z[1:] + [values[2]]
-                
-        except:
-            print("No data to plot")
+    def update_plot(self, sample):
+        recorder = self.recorder
+        if recorder:
+            recorder.add_motion(sample)
+
+        dev, _, _, ax, ay, az, vx, vy, vz, dx, dy, dz = sample
+        if dev != PLOT_DEVICE:
             return
 
+        self.accel_x = self.accel_x[1:] + [ax]
+        self.accel_y = self.accel_y[1:] + [ay]
+        self.accel_z = self.accel_z[1:] + [az]
+
+        self.vel_x = self.vel_x[1:] + [vx]
+        self.vel_y = self.vel_y[1:] + [vy]
+        self.vel_z = self.vel_z[1:] + [vz]
+
+        self.disp_x = self.disp_x[1:] + [dx]
+        self.disp_y = self.disp_y[1:] + [dy]
+        self.disp_z = self.disp_z[1:] + [dz]
+
         self.redraw_canvas = getattr(self, "redraw_canvas", lambda: None)
         self.redraw_canvas()
  
+    def toggle_record(self):
+        if self.recorder:
+            recorder, self.recorder = self.recorder, None
+            recorder.close()
+            print(f"Recording saved to {recorder.path} ({recorder.samples} samples)")
+            self.record_button.config(text="REC")
+        else:
+            self.start_record()
+
+    def start_record(self):
+        self.recorder = Recorder(f"rec_{time.strftime('%Y%m%d_%H%M%S')}.rtdt")
+        self.after(0, lambda: self.record_button.config(text="STOP REC"))
+        # the device answers with its configuration and calibration, stored in the file header
+        self.data_client.send_command("info")
+        return self.recorder
+
+    def record_raw(self, dev, samples):
+        # raw stream (set_output:raw): every sample is kept, recording starts with the stream
+        recorder = self.recorder or self.start_record()
+        recorder.add_raw(dev, samples)
+
+    def record_info(self, info):
+        recorder = self.recorder
+        if recorder:
+            recorder.set_info(info["dev"], info)
+
     def on_resize(self, event):
         if event.width < 300 or event.height < 200: return
         self.plot_width = event.width
@@ -346,8 +593,8 @@ class App(tk.Tk):
         self.redraw_canvas()
 
     def on_closing(self):
-        if self.record_file:
-            self.record_file.close()
+        if self.recorder:
+            self.recorder.close()
         self.data_client.close()
         self.destroy()
         sys.exit()
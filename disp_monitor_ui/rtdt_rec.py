@@ -0,0 +1,453 @@
+"""Binary recorder and memory mapped replay for the RTDT sample streams.
+
+File layout (little endian):
+
+    | file header, HEADER_SIZE bytes | chunk | chunk | ...
+
+The file header is the magic, the format version and a JSON metadata block
+(sensor configuration and calibration from the device's info frames, the
+column layout of every stream), zero padded to HEADER_SIZE. It is rewritten
+in place when new info arrives, so the data never moves.
+
+Chunks are appended and never modified. Each one holds up to CHUNK_SAMPLES
+samples of one stream, stored column by column (every column starts on an
+8-byte boundary), so a reader maps the file and gets every column of a chunk
+as a zero-copy memoryview. A chunk cut short by a crash is ignored, every
+chunk before it stays readable.
+
+Usage:
+    python rtdt_rec.py info FILE
+    python rtdt_rec.py export FILE [-o out.csv] [--stream motion] [--dev N] [--start S] [--end S]
+    python rtdt_rec.py replay FILE [--stream motion] [--speed X]
+    python rtdt_rec.py bench [--samples N]
+"""
+
+import os
+import sys
+import csv
+import json
+import mmap
+import time
+import struct
+import argparse
+import threading
+from array import array
+
+MAGIC = b"RTDTREC1"
+VERSION = 2
+HEADER_SIZE = 4096
+FILE_HEADER = struct.Struct("<8sII") # magic, version, metadata length
+CHUNK_MAGIC = b"CHNK"
+CHUNK_HEADER = struct.Struct("<4sBBHIqqI") # magic, stream, reserved, n, data size, t_min_us, t_max_us, reserved
+CHUNK_SAMPLES = 4096 # samples per chunk (~4 s at 1 kHz)
+ALIGN = 8
+
+# Streams and their columns (name, array typecode), in storage order
+STREAM_MOTION, STREAM_RAW = 1, 2
+STREAMS = {
+    STREAM_MOTION: ("motion", [("t_us", "q"), ("seq", "I"), ("dev", "B")] +
+                    [(name, "f") for name in ("ax", "ay", "az", "vx", "vy", "vz", "dx", "dy", "dz")]),
+    STREAM_RAW:    ("raw", [("t_us", "q"), ("seq", "I"), ("dev", "B")] +
+                    [(name, "h") for name in ("ax", "ay", "az", "gx", "gy", "gz")] +
+                    [("accel_range", "B"), ("gyro_range", "B")]),
+}
+STREAM_IDS = {name: stream for stream, (name, _) in STREAMS.items()}
+
+def stream_layout(stream, version):
+    """Columns of a stream in a recording of the given version."""
+    columns = STREAMS[stream][1]
+    # version 1 raw chunks have no range columns, their counts are at the sensor's configured ranges
+    return columns[:-2] if version == 1 and stream == STREAM_RAW else columns
+
+if sys.byteorder != "little":
+    raise ImportError("rtdt_rec maps little endian files into native columns")
+
+def pad(size):
+    return (size + ALIGN - 1) & ~(ALIGN - 1)
+
+class Recorder:
+    """Appends samples to a recording. Thread safe, samples are buffered per stream until a chunk is full."""
+
+    def __init__(self, path, chunk_samples=CHUNK_SAMPLES):
+        self.path = path
+        self.chunk_samples = chunk_samples
+        self.lock = threading.Lock()
+        self.file = open(path, "w+b")
+        self.columns = {stream: [array(code) for _, code in columns] for stream, (_, columns) in STREAMS.items()}
+        self.samples = 0
+        self.metadata = {
+            "created": time.strftime("%Y-%m-%dT%H:%M:%S"),
+            "chunk_samples": chunk_samples,
+            "streams": {name: {"id": stream, "columns": columns} for stream, (name, columns) in STREAMS.items()},
+            "sensors": {},
+        }
+        self.write_header()
+        self.file.seek(HEADER_SIZE)
+
+    def write_header(self):
+        meta = json.dumps(self.metadata, indent=1).encode()
+        if FILE_HEADER.size + len(meta) > HEADER_SIZE:
+            raise ValueError("recording metadata does not fit in the file header")
+        position = self.file.tell()
+        self.file.seek(0)
+        self.file.write(FILE_HEADER.pack(MAGIC, VERSION, len(meta)) + meta)
+        self.file.write(bytes(HEADER_SIZE - FILE_HEADER.size - len(meta)))
+        self.file.seek(max(position, HEADER_SIZE))
+
+    def set_info(self, dev, info):
+        """Stores the configuration and calibration of a sensor (info frame fields) in the header."""
+        with self.lock:
+            self.metadata["sensors"][str(dev)] = info
+            self.write_header()
+
+    def add_motion(self, sample):
+        """Appends a motion sample (dev, seq, t_us, ax, ay, az, vx, vy, vz, dx, dy, dz)."""
+        dev, seq, t_us, *values = sample
+        with self.lock:
+            self.append(STREAM_MOTION, (t_us, seq, dev, *values))
+
+    def add_raw(self, dev, samples):
+        """Appends raw samples [(seq, t_us, ax, ay, az, gx, gy, gz, accel_range, gyro_range), ...] of one sensor."""
+        with self.lock:
+            for seq, t_us, *values in samples:
+                self.append(STREAM_RAW, (t_us, seq, dev, *values))
+
+    def append(self, stream, row):
+        if self.file.closed:
+            return # late sample from the receive thread after close()
+        columns = self.columns[stream]
+        for column, value in zip(columns, row):
+            column.append(value)
+        if len(columns[0]) >= self.chunk_samples:
+            self.write_chunk(stream)
+
+    def write_chunk(self, stream):
+        columns = self.columns[stream]
+        n = len(columns[0])
+        if n == 0:
+            return
+
+        parts = []
+        for column in columns:
+            data = column.tobytes()
+            parts.append(data + bytes(pad(len(data)) - len(data)))
+        data = b"".join(parts)
+
+        t = columns[0]
+        self.file.write(CHUNK_HEADER.pack(CHUNK_MAGIC, stream, 0, n, len(data), min(t), max(t), 0) + data)
+        self.samples += n
+        self.columns[stream] = [array(column.typecode) for column in columns]
+
+    def flush(self):
+        """Writes the partial chunks, so everything received so far is on disk."""
+        with self.lock:
+            for stream in self.columns:
+                self.write_chunk(stream)
+            self.file.flush()
+
+    def close(self):
+        self.flush()
+        with self.lock:
+            self.file.close()
+
+class Chunk:
+    """A chunk of a mapped recording, columns are memoryviews into the file."""
+
+    def __init__(self, view, offset, version=VERSION):
+        _, self.stream, _, self.n, self.size, self.t_min, self.t_max, _ = CHUNK_HEADER.unpack_from(view, offset)
+        self.name = STREAMS[self.stream][0]
+        self.columns = {}
+        position = offset + CHUNK_HEADER.size
+        for name, code in stream_layout(self.stream, version):
+            size = self.n * array(code).itemsize
+            self.columns[name] = view[position:position + size].cast(code)
+            position += pad(size)
+
+    def rows(self):
+        return zip(*self.columns.values())
+
+class Recording:
+    """Memory mapped, read only view of a recording."""
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.view = memoryview(self.map)
+
+        magic, version, length = FILE_HEADER.unpack_from(self.view)
+        if magic != MAGIC or version not in (1, VERSION):
+            raise ValueError(f"{path} is not an RTDT recording")
+        self.version = version
+        self.metadata = json.loads(bytes(self.view[FILE_HEADER.size:FILE_HEADER.size + length]))
+
+        self.chunks = []
+        offset = HEADER_SIZE
+        while offset + CHUNK_HEADER.size <= len(self.view):
+            magic, stream, _, n, size, *_ = CHUNK_HEADER.unpack_from(self.view, offset)
+            if magic != CHUNK_MAGIC or stream not in STREAMS or offset + CHUNK_HEADER.size + size > len(self.view):
+                break # truncated tail of an interrupted recording
+            self.chunks.append(Chunk(self.view, offset, version))
+            offset += CHUNK_HEADER.size + size
+        self.truncated = len(self.view) - offset
+
+    def select(self, stream="motion", start_us=None, end_us=None):
+        """Chunks of a stream overlapping [start_us, end_us], others are skipped without touching their data."""
+        stream = STREAM_IDS[stream]
+        return [chunk for chunk in self.chunks if chunk.stream == stream
+                and (start_us is None or chunk.t_max >= start_us)
+                and (end_us is None or chunk.t_min <= end_us)]
+
+    def count(self, stream="motion"):
+        return sum(chunk.n for chunk in self.select(stream))
+
+    def time_range(self, stream="motion"):
+        chunks = self.select(stream)
+        if not chunks:
+            return None
+        return min(chunk.t_min for chunk in chunks), max(chunk.t_max for chunk in chunks)
+
+    def column(self, name, stream="motion"):
+        """One column of a stream as an array (one copy, no parsing)."""
+        chunks = self.select(stream)
+        result = array(dict(stream_layout(STREAM_IDS[stream], self.version))[name])
+        for chunk in chunks:
+            result.frombytes(chunk.columns[name].cast("B"))
+        return result
+
+    def rows(self, stream="motion", dev=None, start_us=None, end_us=None):
+        """Yields the samples of a stream as tuples in column order."""
+        for chunk in self.select(stream, start_us, end_us):
+            for row in chunk.rows():
+                t_us, _, row_dev = row[:3]
+                if dev is not None and row_dev != dev:
+                    continue
+                if (start_us is not None and t_us < start_us) or (end_us is not None and t_us > end_us):
+                    continue
+                yield row
+
+    def close(self):
+        for chunk in self.chunks:
+            for column in chunk.columns.values():
+                column.release()
+        self.chunks = []
+        self.view.release()
+        self.map.close()
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+def absolute_range(rec, stream, start, end):
+    """Converts start/end seconds from the beginning of the stream to device microseconds."""
+    t_range = rec.time_range(stream)
+    if t_range is None:
+        return None, None
+    t0 = t_range[0]
+    return (None if start is None else t0 + int(start * 1e6)), (None if end is None else t0 + int(end * 1e6))
+
+def cmd_info(args):
+    with Recording(args.file) as rec:
+        print(f"{args.file}: created {rec.metadata.get('created')}, {len(rec.chunks)} chunks")
+        for name in STREAM_IDS:
+            t_range = rec.time_range(name)
+            if t_range is None:
+                continue
+            devices = sorted({dev for chunk in rec.select(name) for dev in set(chunk.columns["dev"])})
+            seconds = (t_range[1] - t_range[0]) / 1e6
+            count = rec.count(name)
+            print(f"  {name}: {count} samples, {seconds:.1f} s, devices {devices}"
+                  + (f", {count / seconds:.1f} Hz" if seconds > 0 else ""))
+        for dev, info in sorted(rec.metadata["sensors"].items()):
+            print(f"  sensor {dev}: " + ", ".join(f"{key}={value}" for key, value in info.items()))
+        if rec.truncated:
+            print(f"  ignored {rec.truncated} bytes of an incomplete chunk")
+
+def cmd_export(args):
+    with Recording(args.file) as rec:
+        start_us, end_us = absolute_range(rec, args.stream, args.start, args.end)
+        names = [name for name, _ in stream_layout(STREAM_IDS[args.stream], rec.version)]
+        out = open(args.output, "w", newline="") if args.output else sys.stdout
+        writer = csv.writer(out)
+        writer.writerow(names)
+        count = 0
+        for row in rec.rows(args.stream, args.dev, start_us, end_us):
+            writer.writerow(row)
+            count += 1
+        if args.output:
+            out.close()
+            print(f"Exported {count} {args.stream} samples to {args.output}")
+
+def replay_frames(rows, stream, ranges=None):
+    """Yields (t_us, frame) for the recorded samples, re-encoded as device frames.
+
+    `ranges` maps a sensor index to the (accel, gyro) range codes of raw rows recorded without them.
+    """
+    from rtdt import crc16, SYNC, FRAME_MOTION, MOTION_PAYLOAD, FRAME_RAW, RAW_HEADER, RAW_MODE_VERBATIM
+
+    def frame(frame_type, payload):
+        body = bytes([frame_type, len(payload)]) + payload
+        return SYNC + body + struct.pack("<H", crc16(body))
+
+    if stream == "motion":
+        for t_us, seq, dev, *values in rows:
+            yield t_us, frame(FRAME_MOTION, MOTION_PAYLOAD.pack(dev, seq, t_us, *values))
+        return
+
+    # raw samples go out as verbatim blocks of up to 16 consecutive samples of a sensor at the same ranges
+    block = []
+    def flush():
+        t_us, seq, dev = block[0][:3]
+        payload = RAW_HEADER.pack(dev, RAW_MODE_VERBATIM, len(block), seq, t_us, block[-1][0] - t_us, *block[0][9:])
+        payload += b"".join(struct.pack("<6h", *row[3:9]) for row in block)
+        return block[-1][0], frame(FRAME_RAW, payload)
+
+    for row in rows:
+        if len(row) == 9:
+            row = (*row, *(ranges or {}).get(row[2], (0, 0)))
+        if block and (len(block) == 16 or row[2] != block[0][2] or row[1] != block[-1][1] + 1 or row[9:] != block[0][9:]):
+            yield flush()
+            block = []
+        block.append(row)
+    if block:
+        yield flush()
+
+def cmd_replay(args):
+    import pty
+    import tty
+
+    master, slave = pty.openpty()
+    tty.setraw(slave)
+    print(f"Replaying {args.file} on {os.ttyname(slave)}, connect the UI or rtdt_ingest to it (Ctrl+C to stop)")
+
+    with Recording(args.file) as rec:
+        start_us, end_us = absolute_range(rec, args.stream, args.start, args.end)
+        ranges = {int(dev): (info.get("accel_range", 0), info.get("gyro_range", 0))
+                  for dev, info in rec.metadata["sensors"].items()}
+        t0 = None
+        pending = []
+        sent = 0
+        clock = time.monotonic()
+
+        try:
+            for t_us, frame in replay_frames(rec.rows(args.stream, args.dev, start_us, end_us), args.stream, ranges):
+                if t0 is None:
+                    t0 = t_us
+                due = clock + (t_us - t0) / 1e6 / args.speed
+                if pending and due > time.monotonic():
+                    # everything up to now goes out in one write, then wait for the next sample
+                    os.write(master, b"".join(pending))
+                    sent += len(pending)
+                    pending = []
+                    time.sleep(max(due - time.monotonic(), 0))
+                pending.append(frame)
+            if pending:
+                os.write(master, b"".join(pending))
+                sent += len(pending)
+        except KeyboardInterrupt:
+            pass
+
+    print(f"Sent {sent} frames")
+    time.sleep(1) # unread data is lost when the terminal closes, give the reader time to drain it
+    os.close(master)
+    os.close(slave)
+
+def cmd_bench(args):
+    """Writes the same synthetic 1 kHz motion stream as a recording and as CSV, then reads both back."""
+    import math
+    import tempfile
+
+    n = args.samples
+    samples = [(0, i, i * 1000, *(math.sin(i * 1e-3 + k) for k in range(9))) for i in range(n)]
+    directory = tempfile.mkdtemp(prefix="rtdt_rec_bench_")
+    rec_path, csv_path = os.path.join(directory, "bench.rtdt"), os.path.join(directory, "bench.csv")
+    results = []
+
+    start = time.perf_counter()
+    recorder = Recorder(rec_path)
+    for sample in samples:
+        recorder.add_motion(sample)
+    recorder.close()
+    results.append(("write", "binary", time.perf_counter() - start, os.path.getsize(rec_path)))
+
+    start = time.perf_counter()
+    with open(csv_path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["dev", "seq", "t_us", "ax", "ay", "az", "vx", "vy", "vz", "dx", "dy", "dz"])
+        writer.writerows(samples)
+    results.append(("write", "csv", time.perf_counter() - start, os.path.getsize(csv_path)))
+
+    # full scan of one column, the typical post-processing access
+    start = time.perf_counter()
+    with Recording(rec_path) as rec:
+        ax = rec.column("ax")
+        total = sum(ax)
+    results.append(("read ax", "binary", time.perf_counter() - start, len(ax)))
+
+    start = time.perf_counter()
+    with open(csv_path, newline="") as f:
+        reader = csv.reader(f)
+        next(reader)
+        values = [float(row[3]) for row in reader]
+        csv_total = sum(values)
+    results.append(("read ax", "csv", time.perf_counter() - start, len(values)))
+
+    # a 1 s window at the end, e.g. an event found in hours of data
+    window = ((n - 2000) * 1000, (n - 1000) * 1000)
+    start = time.perf_counter()
+    with Recording(rec_path) as rec:
+        rows = sum(1 for _ in rec.rows("motion", start_us=window[0], end_us=window[1]))
+    results.append(("seek 1 s", "binary", time.perf_counter() - start, rows))
+
+    start = time.perf_counter()
+    with open(csv_path, newline="") as f:
+        reader = csv.reader(f)
+        next(reader)
+        rows = sum(1 for row in reader if window[0] <= int(row[2]) <= window[1])
+    results.append(("seek 1 s", "csv", time.perf_counter() - start, rows))
+
+    print(f"{n} motion samples ({n / 3.6e6:.2f} h at 1 kHz), files in {directory}")
+    print(f"{'operation':<10} {'format':<8} {'time (s)':>10} {'samples/s':>12}  size / rows")
+    for operation, fmt, seconds, value in results:
+        rate = (n if operation != "seek 1 s" else value) / seconds
+        detail = f"{value / 1e6:.1f} MB" if operation == "write" else f"{value} rows"
+        print(f"{operation:<10} {fmt:<8} {seconds:>10.3f} {rate:>12.0f}  {detail}")
+    print(f"checksum binary {total:.6f} csv {csv_total:.6f}")
+
+    if not args.keep:
+        os.remove(rec_path)
+        os.remove(csv_path)
+        os.rmdir(directory)
+
+def main():
+    parser = argparse.ArgumentParser(description="RTDT binary recordings")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    info = commands.add_parser("info", help="show the metadata and the contents of a recording")
+    info.add_argument("file")
+    info.set_defaults(func=cmd_info)
+
+    for name, func, text in (("export", cmd_export, "write a stream as CSV"),
+                             ("replay", cmd_replay, "play a stream back as device frames on a pseudo terminal")):
+        command = commands.add_parser(name, help=text)
+        command.add_argument("file")
+        command.add_argument("--stream", choices=list(STREAM_IDS), default="motion")
+        command.add_argument("--dev", type=int, help="only this sensor index")
+        command.add_argument("--start", type=float, help="seconds from the start of the stream")
+        command.add_argument("--end", type=float, help="seconds from the start of the stream")
+        command.set_defaults(func=func)
+    commands.choices["export"].add_argument("-o", "--output", help="output file (default: stdout)")
+    commands.choices["replay"].add_argument("--speed", type=float, default=1.0, help="playback speed factor")
+
+    bench = commands.add_parser("bench", help="compare recording and CSV throughput")
+    bench.add_argument("--samples", type=int, default=600000)
+    bench.add_argument("--keep", action="store_true", help="keep the generated files")
+    bench.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+if __name__ == "__main__":
+    main()
@@ -1,139 +1,1100 @@
+#include <inttypes.h>
+
 #include "app_tasks.h"
+#include "telemetry.h"
+#include "bench.h"
+#include "sample_ring.h"
+#include "command.h"
+#include "config_store.h"
+#include "cal_store.h"
 
-esp_err_t i2c_master_init(void) {
-    // Configure the I2C interface
-    i2c_config_t conf = {
-        .mode               = I2C_MODE_MASTER,
-        .sda_io_num         = I2C_MASTER_SDA_IO,
-        .scl_io_num         = I2C_MASTER_SCL_IO,
-        .sda_pullup_en      = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en      = GPIO_PULLUP_ENABLE,
-        .master.clk_speed   = 400000,
-        .clk_flags          = 0,
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+
+static i2c_master_bus_handle_t i2c_bus;
+static mpu6050_bus_t i2c_gate;          // Sampling before housekeeping on the bus
+static const uint8_t imu_addresses[IMU_MAX_CHANNELS] = {MPU6050_ADDR, MPU6050_ADDR_ALT};
+static imu_channel_t channels[IMU_MAX_CHANNELS];
+static size_t n_channels;
+
+static mpu6050_raw_t fifo_frames[MPU6050_FIFO_MAX_FRAMES];
+static float fifo_ax[MPU6050_FIFO_MAX_FRAMES];    // A drain as structure of arrays for process_accel_block
+static float fifo_ay[MPU6050_FIFO_MAX_FRAMES];
+static float fifo_az[MPU6050_FIFO_MAX_FRAMES];
+static int64_t fifo_t_us[MPU6050_FIFO_MAX_FRAMES];
+
+static decim_fir_kernel_t fir_kernel;
+static decim_mode_t decim_mode;
+static uint32_t decim_factor;           // 0 = decimators need a reset
+static uint32_t decim_pre;              // CIC pre-stage factor of the FIR, 1 = none
+
+static TaskHandle_t readout_task_handle;
+static TaskHandle_t telemetry_task_handle;
+static sample_ring_t sample_ring;
+static drdy_timing_t drdy_timing;
+static readout_stats_t readout_stats;
+static event_capture_t capture;         // Full-rate event capture of the primary sensor
+static control_stats_t control_stats;
+static volatile bool control_active;    // Readout in control mode
+static bool tilt_active;                // Gravity estimates are being tracked
+static bool kalman_active;              // The float path runs the Kalman estimator
+static bool autorange_active;           // Full-scale ranges follow the signal
+static standby_stats_t standby_stats;
+static standby_quiet_t standby_quiet;   // Quiet check of the primary sensor while motion keeps acquisition on
+
+static volatile bool recalibrate_requested;
+static int64_t ready_time_us;           // Calibration done, readout can start
+static int64_t first_sample_time_us;    // First sample processed since boot
+static int64_t cmd_rx_us;               // Console read that completed the command being handled
+
+static esp_err_t drdy_enable(bool enable) {
+    esp_err_t res;
+
+    if (!enable) {
+        gpio_intr_disable(MPU6050_INT_IO);
+        return mpu6050_data_ready_int(&channels[0].dev, false);
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << MPU6050_INT_IO,
+        .mode         = GPIO_MODE_INPUT,
+        .pull_up_en   = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type    = GPIO_INTR_POSEDGE,
     };
+    res = gpio_config(&io_conf);
+    if (res != ESP_OK) { return res; }
 
-    // Apply the configurations
-    esp_err_t res = i2c_param_config(I2C_NUM_0, &conf);
-    if (res != ESP_OK) { return res; } 
+    // The ISR service may already be installed by a previous session
+    res = gpio_install_isr_service(0);
+    if (res != ESP_OK && res != ESP_ERR_INVALID_STATE) { return res; }
 
-    // Install the driver.
-    // This function allocates internal data structures and hooks up the driver, 
-    // so we can use 
-    // i2c_master_write_to_device(...);
-    // i2c_master_read_from_device(...);
-    return i2c_driver_install(I2C_NUM_0, conf.mode, 0, 0, 0);
+    gpio_isr_handler_remove(MPU6050_INT_IO);
+    res = gpio_isr_handler_add(MPU6050_INT_IO, drdy_isr_handler, readout_task_handle);
+    if (res != ESP_OK) { return res; }
+
+    // Drop notifications left over from a previous session
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    // The primary sensor paces all channels
+    return mpu6050_data_ready_int(&channels[0].dev, true);
 }
 
-void accel_readout_task(void *pvParameters) {
-    task_config_t *config = (task_config_t *)pvParameters;
+static void process_sample(const task_config_t *config, imu_channel_t *ch, const mpu6050_raw_t *raw, uint32_t dt_us) {
+    if (dt_us > readout_stats.max_dt_us) { readout_stats.max_dt_us = dt_us; }
+
+    if (first_sample_time_us == 0) {
+        first_sample_time_us = esp_timer_get_time();
+        ESP_LOGI("ReadOut", "First sample %" PRId64 " ms after boot", first_sample_time_us / 1000);
+    }
+
+    if (config->math == MATH_FIXED) {
+        // Convert thresholds only when they change, the per-sample path is integer only
+        if (config->accel_noise_floor != ch->fx_noise_floor || raw->accel_range != ch->fx_accel_range) {
+            ch->fx_noise_floor = config->accel_noise_floor;
+            ch->fx_accel_range = raw->accel_range;
+            motion_fx_params_init(&ch->fx_params, &ch->cal, ch->fx_noise_floor, ch->fx_accel_range);
+        }
+        process_accel_data_fx(raw, &ch->fx_params, dt_us, &ch->fx_state);
+    } else {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(raw, &data);
+
+        // Level frame without gravity: the calibration biases are in the estimate
+        static const mpu6050_cal_data_t no_bias = {0};
+        const mpu6050_cal_data_t *bias = &ch->cal;
+        if (tilt_active) {
+            attitude_update(&ch->att, &data, dt_us / 1e6f);
+            attitude_level(&ch->att, &data.ax, &data.ay, &data.az);
+            bias = &no_bias;
+        }
+
+        if (kalman_active) {
+            kalman_update(&config->kalman, &data, dt_us / 1e6f, &ch->kf, &ch->state);
+        } else {
+            process_accel_data(data, *bias, config->accel_noise_floor, dt_us / 1e6f, &ch->state, &ch->hold);
+        }
+    }
+}
+
+/**
+ * @brief Process a FIFO drain in one block with the float motion path
+ *
+ * Gives the same state as process_sample on every frame in turn; only for
+ * MATH_FLOAT when nothing reads the states in between.
+ *
+ * @param config         Task configuration
+ * @param ch             Channel
+ * @param frames         Frames, oldest first
+ * @param n              Number of frames
+ * @param now            Time of the newest frame
+ * @param dt_us          Frame spacing
+ */
+static void process_block(const task_config_t *config, imu_channel_t *ch, const mpu6050_raw_t *frames, size_t n,
+                          int64_t now, uint32_t dt_us) {
+    if (dt_us > readout_stats.max_dt_us) { readout_stats.max_dt_us = dt_us; }
+
+    if (first_sample_time_us == 0) {
+        first_sample_time_us = esp_timer_get_time();
+        ESP_LOGI("ReadOut", "First sample %" PRId64 " ms after boot", first_sample_time_us / 1000);
+    }
+
+    // mpu6050_raw_to_data, column by column: a drain is read at one range
+    float scale = mpu6050_accel_scale[frames[0].accel_range & 0x03];
+    for (size_t j = 0; j < n; j++) {
+        fifo_ax[j] = frames[j].ax * scale;
+        fifo_ay[j] = frames[j].ay * scale;
+        fifo_az[j] = frames[j].az * scale;
+        fifo_t_us[j] = now - (int64_t)(n - 1 - j) * dt_us;
+    }
+
+    motion_block_t block = {.ax = fifo_ax, .ay = fifo_ay, .az = fifo_az, .t_us = fifo_t_us,
+                            .t_prev_us = fifo_t_us[0] - dt_us, .n = n};
+    process_accel_block(&block, &ch->cal, config->accel_noise_floor, &ch->state, &ch->hold, NULL);
+}
+
+/**
+ * @brief Feed a full-rate sample of the primary sensor to the event capture
+ *
+ * The capture keeps the window at the widest range its samples were measured at.
+ *
+ * @param raw            Raw sample
+ * @param t_us           Sample timestamp
+ */
+static void capture_feed(const mpu6050_raw_t *raw, int64_t t_us) {
+    const int16_t a[CAPTURE_AXES] = {raw->ax, raw->ay, raw->az};
+
+    if (event_capture_push(&capture, a, raw->accel_range, t_us)) {
+        ESP_LOGI("Capture", "Event %" PRIu32 " frozen: trigger at %" PRId64 " ms, duration=%u samples, peak STA/LTA=%.2f",
+                 capture.events, capture.trigger_t_us / 1000, capture.duration,
+                 capture.peak_ratio / (float)(1 << CAPTURE_RATIO_FRAC));
+    }
+}
+
+/**
+ * @brief Follow decimation mode and factor changes
+ *
+ * The factor maps the sensor rate onto the update rate. A change redesigns
+ * the FIR and restarts every channel's decimator. FIR factors beyond
+ * DECIM_MAX_FACTOR run the channel's CIC as a pre-stage.
+ *
+ * @param config         Task configuration
+ */
+static void decim_sync(const task_config_t *config) {
+    float ratio = config->update_rate_ms * mpu6050_sample_rate_hz(&config->cfg) / 1000.0f;
+    uint32_t factor = ratio < 1.0f ? 1 : (uint32_t)lroundf(ratio);
+
+    if (factor > DECIM_CIC_MAX_FACTOR) { factor = DECIM_CIC_MAX_FACTOR; }
+
+    if (config->decim == decim_mode && factor == decim_factor) { return; }
+
+    uint32_t pre = 1;
+    if (config->decim == DECIM_FIR) { decim_fir_design(&fir_kernel, decim_fir_split(factor, &pre)); }
+    for (size_t i = 0; i < n_channels; i++) {
+        decim_fir_reset(&channels[i].fir);
+        decim_cic_reset(&channels[i].cic, config->decim == DECIM_FIR ? pre : factor);
+        channels[i].decim_ready = false;
+    }
+
+    if (config->decim == DECIM_FIR && pre > 1) {
+        ESP_LOGI("ReadOut", "Decimating by %" PRIu32 " (cic %" PRIu32 " x fir %u)", pre * fir_kernel.factor, pre,
+                 fir_kernel.factor);
+    } else if (config->decim != DECIM_OFF) {
+        ESP_LOGI("ReadOut", "Decimating by %" PRIu32 " (%s)", factor, config->decim == DECIM_FIR ? "fir" : "cic");
+    }
+    decim_mode = config->decim;
+    decim_factor = factor;
+    decim_pre = pre;
+}
+
+/**
+ * @brief Feed a full-rate sample's acceleration to the channel's decimator
+ *
+ * @param ch             Channel
+ * @param raw            Sample
+ * @return true          A decimated output is ready in ch->decim_out
+ */
+static bool decimate(imu_channel_t *ch, const mpu6050_raw_t *raw) {
+    int16_t accel[DECIM_AXES] = {raw->ax, raw->ay, raw->az};
+
+    if (decim_mode == DECIM_FIR) {
+        // Past DECIM_MAX_FACTOR the CIC decimates first, the FIR runs at its output rate
+        if (decim_pre > 1 && !decim_cic_push(&ch->cic, accel, accel)) {
+            ch->decim_ready = false;
+            return false;
+        }
+        ch->decim_ready = decim_fir_push(&ch->fir, &fir_kernel, accel, ch->decim_out);
+    } else if (decim_mode == DECIM_CIC) {
+        ch->decim_ready = decim_cic_push(&ch->cic, accel, ch->decim_out);
+    }
+
+    return ch->decim_ready;
+}
 
+static void publish_sample(const task_config_t *config, imu_channel_t *ch, const mpu6050_raw_t *raw, int64_t t_us) {
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    // The raw stream carries the ranges each sample was measured at
+    telemetry_sample_t sample = {.dev = ch - channels, .seq = ch->seq++, .t_us = t_us, .raw = *raw};
+
+    if (config->math == MATH_FIXED) {
+        motion_fx_to_state(&ch->fx_state, &sample.state);
+    } else {
+        sample.state = ch->state;
+    }
+
+    // Report the anti-aliased acceleration instead of the latest sample,
+    // the decimator runs at the sensor's current range
+    if (ch->decim_ready) {
+        float scale = (config->math == MATH_FIXED) ? ch->fx_params.accel_scale / (float)(1L << MOTION_FX_SCALE_FRAC)
+                                                   : mpu6050_accel_scale[raw->accel_range & 0x03];
+        if (tilt_active) {
+            sample.state.ax = ch->decim_out[0] * scale;
+            sample.state.ay = ch->decim_out[1] * scale;
+            sample.state.az = ch->decim_out[2] * scale;
+            attitude_level(&ch->att, &sample.state.ax, &sample.state.ay, &sample.state.az);
+        } else {
+            sample.state.ax = ch->decim_out[0] * scale - ch->cal.ax_bias;
+            sample.state.ay = ch->decim_out[1] * scale - ch->cal.ay_bias;
+            sample.state.az = ch->decim_out[2] * scale - ch->cal.az_bias;
+        }
+        ch->decim_ready = false;
+    }
+
+    // Never wait for the console: queue the sample and wake the telemetry task
+    if (sample_ring_push(&sample_ring, &sample) && telemetry_task_handle != NULL) {
+        xTaskNotifyGive(telemetry_task_handle);
+    }
+
+    stats_hist_add(&readout_stats.publish, esp_cpu_get_cycle_count() - start);
+}
+
+/**
+ * @brief Count the deviation of the readout loop period from its nominal value
+ *
+ * @param last           Cycle count at the previous call (0 = none since start)
+ * @param period_cycles  Nominal period (in CPU cycles)
+ */
+static void loop_jitter_update(esp_cpu_cycle_count_t *last, uint32_t period_cycles) {
+    esp_cpu_cycle_count_t now = esp_cpu_get_cycle_count();
+
+    if (*last != 0) {
+        uint32_t period = now - *last;
+        stats_hist_add(&readout_stats.jitter, period > period_cycles ? period - period_cycles : period_cycles - period);
+    }
+    *last = now;
+}
+
+/**
+ * @brief Follow control period changes
+ *
+ * The period is update_rate_ms rounded to whole sensor samples, so it is
+ * kept by the sensor's sample clock rather than the 10 ms scheduler tick.
+ *
+ * @param config         Task configuration
+ */
+static void control_sync(const task_config_t *config) {
+    float ratio = config->update_rate_ms * mpu6050_sample_rate_hz(&config->cfg) / 1000.0f;
+    uint32_t factor = ratio < 1.0f ? 1 : (uint32_t)lroundf(ratio);
+
+    if (factor == control_stats.samples_per_period && drdy_timing.period_us * factor == control_stats.period_us) {
+        return;
+    }
+
+    control_stats.samples_per_period = factor;
+    control_stats.period_us = drdy_timing.period_us * factor;
+    control_stats.phase = 0;
+    ESP_LOGI("Control", "Period %" PRId64 " us (%" PRIu32 " samples)", control_stats.period_us, factor);
+}
+
+/**
+ * @brief Enter or leave the control mode
+ *
+ * Entering raises the readout above every other application task and
+ * quiets the periodic log output that shares the console with the state
+ * frames. Replies to commands and statistics are still logged.
+ *
+ * @param enable         Enter (true) or leave (false)
+ */
+static void control_enable(bool enable) {
+    if (enable) {
+        control_stats.samples_per_period = 0;
+        control_stats.periods = 0;
+        control_stats.frames = 0;
+        control_stats.late = 0;
+        control_stats.skipped = 0;
+
+        esp_log_level_set("*", ESP_LOG_WARN);
+        esp_log_level_set("CommandListener", ESP_LOG_INFO);
+        esp_log_level_set("Stats", ESP_LOG_INFO);
+        esp_log_level_set("Control", ESP_LOG_INFO);
+        vTaskPrioritySet(NULL, CONTROL_TASK_PRIORITY);
+    } else {
+        vTaskPrioritySet(NULL, READOUT_TASK_PRIORITY);
+        esp_log_level_set("*", ESP_LOG_INFO);
+        ESP_LOGI("Control", "Left after %" PRIu32 " periods: late=%" PRIu32 " skipped=%" PRIu32,
+                 control_stats.periods, control_stats.late, control_stats.skipped);
+    }
+
+    control_active = enable;
+}
+
+/**
+ * @brief Write the state frames if the control period ended with this sample
+ *
+ * A write that completes more than one period after its sample is late; a
+ * period that ends while its sample was missed gets no frame at all.
+ *
+ * @param config         Task configuration
+ * @param isr_time       Data-ready timestamp of the sample
+ * @param elapsed        Sample periods since the previous serviced sample (1 + missed interrupts)
+ */
+static void control_output(const task_config_t *config, int64_t isr_time, uint32_t elapsed) {
+    telemetry_state_payload_t states[IMU_MAX_CHANNELS];
+    control_stats_t *cs = &control_stats;
+
+    cs->phase += elapsed;
+    if (cs->phase < cs->samples_per_period) { return; }
+
+    uint32_t ended = cs->phase / cs->samples_per_period;
+    cs->phase %= cs->samples_per_period;
+    cs->periods += ended;
+    cs->skipped += ended - 1;
+
+    uint32_t misses = cs->late + cs->skipped;
+    for (size_t i = 0; i < n_channels && i < IMU_MAX_CHANNELS; i++) {
+        imu_channel_t *ch = &channels[i];
+        motion_state_t state = ch->state;
+
+        if (config->math == MATH_FIXED) { motion_fx_to_state(&ch->fx_state, &state); }
+
+        states[i] = (telemetry_state_payload_t){
+            .dev = i, .period = cs->periods, .t_us = (uint64_t)ch->last_time,
+            .vx = state.vx, .vy = state.vy, .vz = state.vz,
+            .dx = state.dx, .dy = state.dy, .dz = state.dz,
+            .misses = misses > UINT16_MAX ? UINT16_MAX : misses,
+        };
+    }
+
+    telemetry_emit_state(states, n_channels);
+
+    // Sample-to-wire: from the sensor latching the sample to the frames leaving the console write
+    int64_t wire_us = esp_timer_get_time() - isr_time;
+    stats_hist_add(&cs->wire, (uint32_t)wire_us * esp_rom_get_cpu_ticks_per_us());
+    if (wire_us > cs->period_us) { cs->late++; }
+    cs->frames++;
+}
+
+// --- Wake-on-Motion Standby ---
+
+static void IRAM_ATTR motion_isr_handler(void *arg) {
+    (void)arg;
+    BaseType_t higher_prio_woken = pdFALSE;
+
+    // The pin stays high until the sensors are woken: mask the level interrupt
+    gpio_intr_disable(MPU6050_INT_IO);
+    standby_stats.wake_isr_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(readout_task_handle, &higher_prio_woken);
+    portYIELD_FROM_ISR(higher_prio_woken);
+}
+
+/**
+ * @brief Allow light sleep (standby) or keep the chip awake at full clock
+ *
+ * Light sleep stays off outside standby: waking from it would delay every
+ * data-ready interrupt.
+ *
+ * @param sleep          Allow light sleep
+ */
+static void standby_power(bool sleep) {
+    esp_pm_config_t pm = {
+        .max_freq_mhz       = STANDBY_CPU_MHZ,
+        .min_freq_mhz       = sleep ? STANDBY_IDLE_MHZ : STANDBY_CPU_MHZ,
+        .light_sleep_enable = sleep,
+    };
+
+    esp_err_t res = esp_pm_configure(&pm);
+    if (res != ESP_OK && sleep) {
+        ESP_LOGW("Standby", "Light sleep not available (%s), only the sensors save power", esp_err_to_name(res));
+    }
+}
+
+/**
+ * @brief Add the time since the last call to the standby time and its idle share
+ *
+ * The 32-bit run time counter wraps after 71 minutes, so this runs at
+ * least once per STANDBY_POLL_MS.
+ */
+static void standby_account(void) {
+    int64_t now = esp_timer_get_time();
+    configRUN_TIME_COUNTER_TYPE idle = ulTaskGetIdleRunTimeCounter();
+
+    standby_stats.asleep_us += now - standby_stats.mark_us;
+    standby_stats.idle_us += (configRUN_TIME_COUNTER_TYPE)(idle - standby_stats.mark_idle);
+    standby_stats.mark_us = now;
+    standby_stats.mark_idle = idle;
+}
+
+/**
+ * @brief Put the sensors into cycle mode and arm the motion wake-up
+ *
+ * The primary sensor's INT pin, latched high by motion, is both the GPIO
+ * interrupt that notifies the readout and the light sleep wake source.
+ * A sensor that fails stays as it is; standby is entered regardless and
+ * the failure counted.
+ */
+static void standby_enter(void) {
     esp_err_t res;
 
-    mpu6050_data_t accel_data;
-    mpu6050_cal_data_t accel_bias_data;
-    motion_state_t state; 
- 
-    // calibrate the accelerometer readings first
-    res = mpu6050_calibrate_accel(I2C_NUM_0, &accel_bias_data);
-    if ( res == ESP_OK) {
-        ESP_LOGI("Calibration", "%.2f, %.2f, %.2f", accel_bias_data.ax_bias, accel_bias_data.ay_bias, accel_bias_data.az_bias);
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << MPU6050_INT_IO,
+        .mode         = GPIO_MODE_INPUT,
+        .pull_up_en   = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type    = GPIO_INTR_DISABLE,
+    };
+    res = gpio_config(&io_conf);
+    if (res == ESP_OK) {
+        res = gpio_install_isr_service(0);
+        if (res == ESP_ERR_INVALID_STATE) { res = ESP_OK; }
+    }
+    if (res == ESP_OK) {
+        gpio_isr_handler_remove(MPU6050_INT_IO);
+        res = gpio_isr_handler_add(MPU6050_INT_IO, motion_isr_handler, NULL);
+    }
+
+    // Only the primary sensor's INT is wired, the others just sleep
+    for (size_t i = 0; i < n_channels && res == ESP_OK; i++) {
+        res = mpu6050_motion_standby(&channels[i].dev, i == 0 ? STANDBY_MOTION_MG : 0, STANDBY_LP_WAKE);
+    }
+
+    ulTaskNotifyTake(pdTRUE, 0);
+    if (res == ESP_OK) { res = gpio_wakeup_enable(MPU6050_INT_IO, GPIO_INTR_HIGH_LEVEL); }
+    if (res == ESP_OK) { res = esp_sleep_enable_gpio_wakeup(); }
+    if (res == ESP_OK) { res = gpio_intr_enable(MPU6050_INT_IO); }
+    if (res != ESP_OK) {
+        standby_stats.failures++;
+        ESP_LOGW("Standby", "Motion wake-up not armed: %s", esp_err_to_name(res));
+    }
+
+    standby_power(true);
+    standby_stats.mark_us = esp_timer_get_time();
+    standby_stats.mark_idle = ulTaskGetIdleRunTimeCounter();
+    standby_stats.wake_isr_us = 0;
+    standby_stats.entries++;
+    standby_stats.asleep = true;
+    ESP_LOGI("Standby", "Waiting for motion above %d mg", STANDBY_MOTION_MG);
+}
+
+/**
+ * @brief Return the sensors to full-rate sampling
+ *
+ * @param motion         Woken by motion: acquisition runs until the sensor is quiet
+ */
+static void standby_leave(bool motion) {
+    gpio_intr_disable(MPU6050_INT_IO);
+    gpio_wakeup_disable(MPU6050_INT_IO);
+    standby_power(false);
+    standby_account();
+
+    for (size_t i = 0; i < n_channels; i++) {
+        esp_err_t res = mpu6050_motion_wake(&channels[i].dev);
+        if (res != ESP_OK) {
+            standby_stats.failures++;
+            ESP_LOGW("Standby", "0x%02x wake failed: %s", channels[i].dev.addr, esp_err_to_name(res));
+        }
+    }
+
+    standby_stats.asleep = false;
+    if (motion) {
+        standby_stats.wakes++;
+        standby_stats.session = true;
+        standby_quiet_reset(&standby_quiet);
+        ESP_LOGI("Standby", "Motion, acquiring");
     } else {
-        ESP_LOGE("Calibration", "Failed: %s", esp_err_to_name(res));
-        vTaskSuspend(NULL);
+        standby_stats.wake_isr_us = 0;
     }
+}
 
-    int64_t last_time = esp_timer_get_time();
+/**
+ * @brief Wait in standby for motion or the next configuration check
+ *
+ * @return true          The motion interrupt fired
+ */
+static bool standby_wait(void) {
+    bool motion = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STANDBY_POLL_MS)) != 0;
 
-    while (1) {
-        if (config->start) {
+    if (!motion) {
+        standby_account();
+        standby_stats.polls++;
+    }
 
-            // Read acceleration
-            res = mpu6050_read_accel(I2C_NUM_0, &accel_data);
+    return motion;
+}
 
-            // measure integration time difference
-            int64_t now = esp_timer_get_time(); // in microseconds
-            float dt = (now - last_time) / 1e6f;
-            last_time = now;
+/**
+ * @brief Account for a processed sample of the primary sensor
+ *
+ * Records the wake-to-first-sample latency after a motion wake-up and ends
+ * the motion session once the sensor has been quiet for STANDBY_QUIET_S.
+ *
+ * @param raw            Sample
+ * @param dt_us          Time step of the sample (in microseconds)
+ */
+static void standby_feed(const mpu6050_raw_t *raw, uint32_t dt_us) {
+    if (!standby_stats.session) { return; }
 
-            process_accel_data(accel_data, accel_bias_data, config->accel_noise_floor, dt, &state);
+    if (standby_stats.wake_isr_us != 0) {
+        int64_t latency_us = esp_timer_get_time() - standby_stats.wake_isr_us;
+        stats_hist_add(&standby_stats.wake, (uint32_t)latency_us * esp_rom_get_cpu_ticks_per_us());
+        standby_stats.wake_isr_us = 0;
+        ESP_LOGI("Standby", "First sample %" PRId64 " us after the motion interrupt", latency_us);
+    }
 
-            if (res == ESP_OK) {
-                ESP_LOGI("Acceleration", "%.2f,%.2f,%.2f", state.ax, state.ay, state.az);
-                ESP_LOGI("Velocity", "%.2f,%.2f,%.2f", state.vx, state.vy, state.vz);
-                ESP_LOGI("Displacement", "%.2f,%.2f,%.2f", state.dx, state.dy, state.dz);
+    if (standby_quiet_update(&standby_quiet, raw, dt_us / 1e6f)) {
+        standby_stats.session = false;
+        ESP_LOGI("Standby", "Quiet for %.0f s, back to standby", STANDBY_QUIET_S);
+    }
+}
+
+esp_err_t imu_channels_init(const mpu6050_config_t *cfg) {
+    esp_err_t res;
+
+    n_channels = 0;
+
+    for (size_t i = 0; i < IMU_MAX_CHANNELS; i++) {
+        imu_channel_t *ch = &channels[n_channels];
+
+        memset(ch, 0, sizeof(*ch));
+        ch->fx_noise_floor = -1.0f;
+
+        // Only attach sensors that acknowledge their address
+        res = i2c_master_probe(i2c_bus, imu_addresses[i], MPU6050_TIMEOUT_MS);
+        if (res == ESP_OK) { res = mpu6050_add_device(i2c_bus, &i2c_gate, imu_addresses[i], &ch->dev); }
+        if (res == ESP_OK) { res = mpu6050_init(&ch->dev); }
+        if (res == ESP_OK) { res = mpu6050_config(&ch->dev, cfg); }
+
+        if (res == ESP_OK) {
+            autorange_reset(&ch->ar, cfg->accel_range, cfg->gyro_range);
+            ESP_LOGI("System", "MPU6050 found at 0x%02x", ch->dev.addr);
+            n_channels++;
+        } else if (i == 0) {
+            // The primary sensor is mandatory
+            return res;
+        } else if (ch->dev.handle != NULL) {
+            i2c_master_bus_rm_device(ch->dev.handle);
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_init(void) {
+    esp_err_t res = mpu6050_bus_init(&i2c_gate);
+    if (res != ESP_OK) { return res; }
+
+    // Configure the I2C bus
+    i2c_master_bus_config_t conf = {
+        .i2c_port           = I2C_NUM_0,
+        .sda_io_num         = I2C_MASTER_SDA_IO,
+        .scl_io_num         = I2C_MASTER_SCL_IO,
+        .clk_source         = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt  = 7,
+        .trans_queue_depth  = I2C_TRANS_QUEUE_DEPTH,
+        .flags.enable_internal_pullup = true,
+    };
+
+    // Create the bus. The transaction queue makes transfers on devices with a
+    // registered callback asynchronous; the clock is set per device.
+    return i2c_new_master_bus(&conf, &i2c_bus);
+}
+
+/**
+ * @brief Collect the queued read of channel i and queue the read of channel i + 1
+ *
+ * Reads are pipelined so that the bus transfer of the next sensor runs
+ * while the caller processes the current one.
+ *
+ * @param i              Channel whose read was queued
+ * @param queued         Result of queueing that read
+ * @param raw            Output raw sample of channel i
+ * @param next_queued    Result of queueing the read of channel i + 1
+ * @return esp_err_t     ESP_OK, or the error of the read of channel i
+ */
+static esp_err_t readout_collect(size_t i, esp_err_t queued, mpu6050_raw_t *raw, esp_err_t *next_queued) {
+    esp_err_t res = queued;
+
+    // Read accel, temperature and gyro of the same sample in one transaction
+    if (queued == ESP_OK) { res = mpu6050_read_raw_finish(&channels[i].dev, raw, READOUT_TIMEOUT_MS); }
+
+    if (i + 1 < n_channels) { *next_queued = mpu6050_read_raw_start(&channels[i + 1].dev); }
+
+    return res;
+}
+
+/**
+ * @brief Write the ranges the auto-ranging wants to the sensors that differ
+ *
+ * Runs between two samples. The decimators follow the accelerometer range:
+ * the FIR window is rescaled, the CIC (whose wrapping integrators cannot
+ * be divided) restarts, and with it the FIR it feeds as a pre-stage.
+ */
+static void range_switch(void) {
+    for (size_t i = 0; i < n_channels; i++) {
+        imu_channel_t *ch = &channels[i];
+        uint8_t accel = ch->dev.accel_range;
+        uint8_t gyro = ch->dev.gyro_range;
+
+        if (ch->ar.accel_range == accel && ch->ar.gyro_range == gyro) { continue; }
+
+        esp_err_t res = mpu6050_set_range(&ch->dev, ch->ar.accel_range, ch->ar.gyro_range);
+        if (ch->dev.accel_range != accel || ch->dev.gyro_range != gyro) {
+            autorange_switched(&ch->ar, esp_timer_get_time());
+        }
+        if (ch->dev.accel_range != accel) {
+            if (decim_pre > 1) {
+                decim_fir_reset(&ch->fir);
             } else {
-                ESP_LOGW("ReadOut", "Failed: %s", esp_err_to_name(res));
+                decim_fir_rescale(&ch->fir, ch->dev.accel_range - accel);
             }
+            decim_cic_reset(&ch->cic, ch->cic.factor);
+            ch->decim_ready = false;
+        }
 
-        } 
-        vTaskDelay(pdMS_TO_TICKS(config->update_rate_ms)); // update rate
+        if (res != ESP_OK) {
+            ch->ar.failures++;
+            ch->ar.accel_range = ch->dev.accel_range;
+            ch->ar.gyro_range = ch->dev.gyro_range;
+            ESP_LOGW("ReadOut", "0x%02x range switch failed: %s", ch->dev.addr, esp_err_to_name(res));
+        }
+    }
+}
+
+/**
+ * @brief Return every sensor to the configured ranges
+ *
+ * @param config         Task configuration
+ */
+static void range_restore(const task_config_t *config) {
+    for (size_t i = 0; i < n_channels; i++) {
+        channels[i].ar.accel_range = config->cfg.accel_range;
+        channels[i].ar.gyro_range = config->cfg.gyro_range;
     }
+    range_switch();
 }
 
-void process_accel_data(mpu6050_data_t data, mpu6050_cal_data_t bias, float noise_threshold, float dt, motion_state_t *state) {
-    // Bias Compensation
-    float ax = data.ax - bias.ax_bias;
-    float ay = data.ay - bias.ay_bias;
-    float az = data.az - bias.az_bias;
+/**
+ * @brief Apply a newly adopted configuration snapshot
+ *
+ * Runs in the readout task between two samples, so the sensors are never
+ * reconfigured in the middle of a read.
+ *
+ * @param config         Adopted snapshot
+ * @param sensor_cfg     Sensor configuration currently written to the sensors
+ */
+static void config_apply(const task_config_t *config, mpu6050_config_t *sensor_cfg) {
+    if (memcmp(&config->cfg, sensor_cfg, sizeof(*sensor_cfg)) != 0) {
+        for (size_t i = 0; i < n_channels; i++) {
+            esp_err_t res = mpu6050_config(&channels[i].dev, &config->cfg);
+            if (res != ESP_OK) {
+                ESP_LOGW("ReadOut", "0x%02x reconfiguration failed: %s", channels[i].dev.addr, esp_err_to_name(res));
+            }
+        }
+        *sensor_cfg = config->cfg;
+        drdy_timing_reset(&drdy_timing, (int64_t)(1e6f / mpu6050_sample_rate_hz(sensor_cfg)));
+        for (size_t i = 0; i < n_channels; i++) {
+            autorange_reset(&channels[i].ar, channels[i].dev.accel_range, channels[i].dev.gyro_range);
+        }
+    }
+
+    // Ranges follow the signal sample by sample; FIFO frames carry no range boundary
+    bool autorange = config->autorange && config->acq_mode != ACQ_MODE_FIFO;
+    if (!autorange) { range_restore(config); }
+    autorange_active = autorange;
+
+    // The estimates were not tracked while off: resume from the calibration pose
+    bool tilt = config->tilt && config->math == MATH_FLOAT;
+    if (tilt && !tilt_active) {
+        for (size_t i = 0; i < n_channels; i++) { attitude_init(&channels[i].att, &channels[i].cal); }
+    }
 
-    // Noise Filtering
-    if (fabs(ax) < noise_threshold) ax = 0;
-    if (fabs(ay) < noise_threshold) ay = 0;
-    if (fabs(az) < noise_threshold) az = 0;
+    // The Kalman bias starts from the calibration, or from zero behind the tilt compensation
+    bool kalman = config->drift == DRIFT_KALMAN && config->math == MATH_FLOAT;
+    if (kalman && (!kalman_active || tilt != tilt_active)) {
+        for (size_t i = 0; i < n_channels; i++) { kalman_init(&channels[i].kf, tilt ? NULL : &channels[i].cal); }
+    }
+    tilt_active = tilt;
+    kalman_active = kalman;
+
+    // Command to effect latency
+    if (config->cmd_cycles != 0) {
+        stats_hist_add(&readout_stats.apply, esp_cpu_get_cycle_count() - config->cmd_cycles);
+    }
+}
 
-    // Stillness Detection with Hold Time 
-    float stationary_threshold = 0.05;
-    int hold_cycles = 10;  // Number of consecutive samples to confirm stillness
+/**
+ * @brief Load a sensor's calibration from NVS, or measure and store it
+ *
+ * @param ch             Channel
+ * @param cfg            Sensor configuration the calibration applies to
+ * @param force          Measure even if a valid stored calibration exists
+ * @return esp_err_t     ESP_OK, or the sensor error of a failed measurement
+ */
+static esp_err_t channel_calibrate(imu_channel_t *ch, const mpu6050_config_t *cfg, bool force) {
+    mpu6050_cal_data_t *cal = &ch->cal;
+    mpu6050_data_t data;
+    esp_err_t res = ESP_ERR_INVALID_STATE;
 
-    // Persistent counters for each axis
-    static int ax_still_count = 0;
-    static int ay_still_count = 0;
-    static int az_still_count = 0;
+    // Fixed-point parameters embed the biases
+    ch->fx_noise_floor = -1.0f;
 
-    // X-axis
-    if (fabs(ax) < stationary_threshold) {
-        ax_still_count++;
-        if (ax_still_count >= hold_cycles) {
-            state->vx = 0;
+    if (!force) {
+        res = mpu6050_read_temp(&ch->dev, &data);
+        if (res == ESP_OK) { res = cal_store_load(ch->dev.addr, cfg, data.temp, cal); }
+        if (res == ESP_OK) {
+            ESP_LOGI("Calibration", "0x%02x: cached at %.1f C (now %.1f C)", ch->dev.addr, cal->temp, data.temp);
+        } else {
+            ESP_LOGI("Calibration", "0x%02x: no valid cached calibration (%s)", ch->dev.addr, esp_err_to_name(res));
         }
-    } else {
-        ax_still_count = 0;
-        state->vx += ax * dt;
-        state->dx += state->vx * dt;
     }
 
-    // Y-axis
-    if (fabs(ay) < stationary_threshold) {
-        ay_still_count++;
-        if (ay_still_count >= hold_cycles) {
-            state->vy = 0;
+    if (res != ESP_OK) {
+        res = mpu6050_calibrate(&ch->dev, cal);
+        if (res != ESP_OK) { return res; }
+
+        res = cal_store_save(ch->dev.addr, cfg, cal);
+        if (res != ESP_OK) {
+            ESP_LOGW("Calibration", "0x%02x: not stored: %s", ch->dev.addr, esp_err_to_name(res));
         }
-    } else {
-        ay_still_count = 0;
-        state->vy += ay * dt;
-        state->dy += state->vy * dt;
     }
 
-    // Z-axis
-    if (fabs(az) < stationary_threshold) {
-        az_still_count++;
-        if (az_still_count >= hold_cycles) {
-            state->vz = 0;
+    ESP_LOGI("Calibration", "0x%02x: accel %.2f, %.2f, %.2f gyro %.2f, %.2f, %.2f", ch->dev.addr,
+             cal->ax_bias, cal->ay_bias, cal->az_bias, cal->gx_bias, cal->gy_bias, cal->gz_bias);
+
+    // The tilt compensation and the Kalman bias start over from the calibration pose
+    attitude_init(&ch->att, cal);
+    kalman_init(&ch->kf, tilt_active ? NULL : cal);
+
+    return ESP_OK;
+}
+
+void accel_readout_task(void *pvParameters) {
+    // Private copy, replaced by newer published snapshots between samples only
+    task_config_t snapshot = *(const task_config_t *)pvParameters;
+    task_config_t *config = &snapshot;
+    mpu6050_config_t sensor_cfg = snapshot.cfg;
+
+    esp_err_t res;
+
+    mpu6050_raw_t raw_data;
+
+    // Every other task's transfers wait for the gaps between samples
+    mpu6050_bus_set_sampler(&i2c_gate);
+ 
+    // reuse stored calibrations, measure only sensors without a valid one
+    for (size_t i = 0; i < n_channels; i++) {
+        res = channel_calibrate(&channels[i], &sensor_cfg, false);
+        if (res != ESP_OK) {
+            ESP_LOGE("Calibration", "0x%02x failed: %s", channels[i].dev.addr, esp_err_to_name(res));
+            vTaskSuspend(NULL);
         }
-    } else {
-        az_still_count = 0;
-        state->vz += az * dt;
-        state->dz += state->vz * dt;
     }
 
-    // Store acceleration in state
-    state->ax = ax;
-    state->ay = ay;
-    state->az = az;
+    ready_time_us = esp_timer_get_time();
+    ESP_LOGI("System", "Ready %" PRId64 " ms after boot", ready_time_us / 1000);
+
+    readout_task_handle = xTaskGetCurrentTaskHandle();
+
+    int64_t last_log_time = esp_timer_get_time();
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    esp_cpu_cycle_count_t last_loop = 0;
+    esp_cpu_cycle_count_t start;
+    bool fifo_active = false;
+    bool drdy_active = false;
+
+    while (1) {
+        // Sample boundary: adopt the latest configuration
+        if (config_store_fetch(config)) { config_apply(config, &sensor_cfg); }
+
+        // Recalibration restarts integration from rest with the new biases
+        if (recalibrate_requested) {
+            recalibrate_requested = false;
+            if (standby_stats.asleep) { standby_leave(false); }
+            range_restore(config);
+
+            for (size_t i = 0; i < n_channels; i++) {
+                imu_channel_t *ch = &channels[i];
+
+                res = channel_calibrate(ch, &sensor_cfg, true);
+                if (res != ESP_OK) {
+                    ESP_LOGE("Calibration", "0x%02x failed: %s", ch->dev.addr, esp_err_to_name(res));
+                }
+
+                memset(&ch->state, 0, sizeof(ch->state));
+                memset(&ch->hold, 0, sizeof(ch->hold));
+                memset(&ch->fx_state, 0, sizeof(ch->fx_state));
+                ch->last_time = 0;
+
+                // Samples buffered during calibration are stale
+                if (fifo_active) { mpu6050_fifo_reset(&ch->dev, &ch->fifo); }
+            }
+            decim_factor = 0;
+            last_loop = 0;
+            drdy_timing.last_isr_us = 0;
+            continue;
+        }
+
+        // Acquisition runs when started, or in standby from motion until the sensor is quiet
+        if (config->start || !config->standby) { standby_stats.session = false; }
+        bool run = config->start || standby_stats.session;
+
+        // FIFO buffering only runs while a FIFO acquisition is in progress,
+        // with gyro frames while the tilt compensation needs them
+        bool fifo_wanted = run && config->acq_mode == ACQ_MODE_FIFO;
+        if (fifo_wanted != fifo_active || (fifo_active && tilt_active != channels[0].fifo.with_gyro)) {
+            res = ESP_OK;
+            for (size_t i = 0; i < n_channels && res == ESP_OK; i++) {
+                channels[i].fifo.with_gyro = tilt_active;
+                res = fifo_wanted ? mpu6050_fifo_enable(&channels[i].dev, &channels[i].fifo)
+                                  : mpu6050_fifo_disable(&channels[i].dev);
+            }
+            if (res == ESP_OK) {
+                fifo_active = fifo_wanted;
+            } else {
+                ESP_LOGW("ReadOut", "FIFO %s failed: %s", fifo_wanted ? "enable" : "disable", esp_err_to_name(res));
+            }
+        }
+
+        // Data-ready interrupts only fire while an interrupt driven acquisition is in progress
+        bool drdy_wanted = run && (config->acq_mode == ACQ_MODE_DRDY || config->acq_mode == ACQ_MODE_CONTROL);
+        if (drdy_wanted != drdy_active) {
+            res = drdy_enable(drdy_wanted);
+            if (res == ESP_OK) {
+                drdy_active = drdy_wanted;
+                drdy_timing_reset(&drdy_timing, (int64_t)(1e6f / mpu6050_sample_rate_hz(&config->cfg)));
+            } else {
+                ESP_LOGW("ReadOut", "Data-ready %s failed: %s", drdy_wanted ? "enable" : "disable", esp_err_to_name(res));
+            }
+        }
+
+        // Control mode is data-ready acquisition with its own output path
+        bool control_wanted = drdy_active && config->acq_mode == ACQ_MODE_CONTROL;
+        if (control_wanted != control_active) { control_enable(control_wanted); }
+
+        // Restart every channel's time base when acquisition (re)starts
+        if (!run) {
+            for (size_t i = 0; i < n_channels; i++) { channels[i].last_time = 0; }
+            decim_factor = 0;
+            last_loop = 0;
+        } else if (control_active) {
+            control_sync(config);
+        } else if (fifo_active || drdy_active) {
+            decim_sync(config);
+        }
+
+        // Stopped with standby on: sleep until motion, with a look at the configuration every STANDBY_POLL_MS
+        bool standby_wanted = config->standby && !run;
+        if (standby_wanted != standby_stats.asleep) {
+            if (standby_wanted) {
+                standby_enter();
+            } else {
+                standby_leave(false);
+            }
+        }
+        if (standby_stats.asleep) {
+            if (standby_wait()) { standby_leave(true); }
+            continue;
+        }
+
+        if (run && drdy_active) {
+
+            // Paced by the primary sensor: block until its next sample is latched
+            int64_t isr_time;
+            if (!drdy_wait(&drdy_timing, DRDY_TIMEOUT_MS, &isr_time)) {
+                ESP_LOGW("ReadOut", "Data-ready interrupt timeout");
+                if (control_active) {
+                    // Every period the wait spanned went without a frame
+                    uint32_t lost = (DRDY_TIMEOUT_MS * 1000 + control_stats.period_us - 1) / control_stats.period_us;
+                    control_stats.periods += lost;
+                    control_stats.skipped += lost;
+                    control_stats.phase = 0;
+                }
+                continue;
+            }
+
+            uint32_t missed = drdy_timing.missed;
+            loop_jitter_update(&last_loop, drdy_timing.period_us * cycles_per_us);
+
+            // Every sample is integrated, output is limited to the update rate
+            bool publish = isr_time - last_log_time >= (int64_t)config->update_rate_ms * 1000;
+            if (publish) { last_log_time = isr_time; }
+
+            // Bus schedule: the primary sensor first, then the others back-to-back.
+            // The next sensor's read is queued before this one is processed.
+            mpu6050_bus_claim(&i2c_gate);
+            esp_err_t queued = mpu6050_read_raw_start(&channels[0].dev);
+            for (size_t i = 0; i < n_channels; i++) {
+                imu_channel_t *ch = &channels[i];
+
+                start = esp_cpu_get_cycle_count();
+                res = readout_collect(i, queued, &raw_data, &queued);
+                stats_hist_add(&readout_stats.read, esp_cpu_get_cycle_count() - start);
+                if (res != ESP_OK) {
+                    ch->read_errors++;
+                    ESP_LOGW("ReadOut", "0x%02x failed: %s", ch->dev.addr, esp_err_to_name(res));
+                    continue;
+                }
+
+                int64_t t = (i == 0) ? isr_time : esp_timer_get_time();
+                uint32_t dt_us = (i == 0) ? drdy_timing_update(&drdy_timing, isr_time)
+                                          : (ch->last_time ? t - ch->last_time : drdy_timing.period_us);
+                ch->last_time = t;
+
+                // The primary's latch time is known, the others latched within a period before the read
+                if (!autorange_accept(&ch->ar, (i == 0) ? t : t - drdy_timing.period_us, &dt_us)) { continue; }
+
+                start = esp_cpu_get_cycle_count();
+                process_sample(config, ch, &raw_data, dt_us);
+                if (autorange_active) {
+                    autorange_update(&ch->ar, &raw_data, config->cfg.accel_range, config->cfg.gyro_range, dt_us / 1e6f);
+                }
+                if (i == 0) {
+                    capture_feed(&raw_data, t);
+                    standby_feed(&raw_data, dt_us);
+                }
+
+                // Control mode writes the states of all sensors together, below
+                if (control_active) {
+                    stats_hist_add(&readout_stats.process, esp_cpu_get_cycle_count() - start);
+                    continue;
+                }
+
+                // Decimated output replaces the update rate timer, the raw stream takes every sample
+                bool out = (decim_mode != DECIM_OFF) ? decimate(ch, &raw_data) : publish;
+                stats_hist_add(&readout_stats.process, esp_cpu_get_cycle_count() - start);
+                if (out || config->output == OUTPUT_RAW) { publish_sample(config, ch, &raw_data, t); }
+            }
+
+            if (control_active) { control_output(config, isr_time, 1 + drdy_timing.missed - missed); }
+
+            // Range switches before housekeeping, which gets the rest of the period
+            if (autorange_active) { range_switch(); }
+            mpu6050_bus_yield(&i2c_gate, isr_time + drdy_timing.period_us);
+            continue;
+
+        } else if (run && fifo_active) {
+
+            // Samples are evenly spaced by the sensor sample period
+            uint32_t dt_us = (uint32_t)(1e6f / mpu6050_sample_rate_hz(&config->cfg));
+            loop_jitter_update(&last_loop, config->update_rate_ms * 1000 * cycles_per_us);
+
+            mpu6050_bus_claim(&i2c_gate);
+            for (size_t i = 0; i < n_channels; i++) {
+                imu_channel_t *ch = &channels[i];
+                size_t n_frames = 0;
+                size_t n_frames_done = 0;
+
+                // Drain every buffered sample in one burst
+                start = esp_cpu_get_cycle_count();
+                res = mpu6050_fifo_read(&ch->dev, &ch->fifo, fifo_frames, MPU6050_FIFO_MAX_FRAMES, &n_frames);
+                stats_hist_add(&readout_stats.read, esp_cpu_get_cycle_count() - start);
+
+                int64_t now = esp_timer_get_time();
+
+                // Only the newest state is published: integrate the whole drain at once
+                if (config->math == MATH_FLOAT && !tilt_active && !kalman_active && decim_mode == DECIM_OFF && config->output != OUTPUT_RAW &&
+                    n_frames > 0) {
+                    start = esp_cpu_get_cycle_count();
+                    process_block(config, ch, fifo_frames, n_frames, now, dt_us);
+                    for (size_t j = 0; i == 0 && j < n_frames; j++) {
+                        capture_feed(&fifo_frames[j], fifo_t_us[j]);
+                        standby_feed(&fifo_frames[j], dt_us);
+                    }
+                    uint32_t per_sample = (esp_cpu_get_cycle_count() - start) / n_frames;
+                    for (size_t j = 0; j < n_frames; j++) { stats_hist_add(&readout_stats.process, per_sample); }
+                    n_frames_done = n_frames;
+                }
+
+                for (size_t j = n_frames_done; j < n_frames; j++) {
+                    // Frames are dt_us apart, the newest one was latched just before the drain
+                    int64_t t = now - (int64_t)(n_frames - 1 - j) * dt_us;
+
+                    start = esp_cpu_get_cycle_count();
+                    process_sample(config, ch, &fifo_frames[j], dt_us);
+                    if (i == 0) {
+                        capture_feed(&fifo_frames[j], t);
+                        standby_feed(&fifo_frames[j], dt_us);
+                    }
+                    bool out = decim_mode != DECIM_OFF && decimate(ch, &fifo_frames[j]);
+                    stats_hist_add(&readout_stats.process, esp_cpu_get_cycle_count() - start);
+
+                    if (out || config->output == OUTPUT_RAW) { publish_sample(config, ch, &fifo_frames[j], t); }
+                }
+
+                if (res == ESP_OK && n_frames > 0) {
+                    if (decim_mode == DECIM_OFF && config->output != OUTPUT_RAW) {
+                        publish_sample(config, ch, &fifo_frames[n_frames - 1], now);
+                    }
+                } else if (res == ESP_ERR_INVALID_STATE) {
+                    ESP_LOGW("ReadOut", "0x%02x FIFO overflow, resynchronized (overflows=%" PRIu32 ")", ch->dev.addr, ch->fifo.overflows);
+                } else if (res != ESP_OK) {
+                    ch->read_errors++;
+                    ESP_LOGW("ReadOut", "0x%02x failed: %s", ch->dev.addr, esp_err_to_name(res));
+                }
+            }
+
+        } else if (run) {
+
+            loop_jitter_update(&last_loop, config->update_rate_ms * 1000 * cycles_per_us);
+
+            // Bus schedule: every sensor once per update period, back-to-back.
+            // The next sensor's read is queued before this one is processed.
+            mpu6050_bus_claim(&i2c_gate);
+            esp_err_t queued = mpu6050_read_raw_start(&channels[0].dev);
+            for (size_t i = 0; i < n_channels; i++) {
+                imu_channel_t *ch = &channels[i];
+
+                start = esp_cpu_get_cycle_count();
+                res = readout_collect(i, queued, &raw_data, &queued);
+                stats_hist_add(&readout_stats.read, esp_cpu_get_cycle_count() - start);
+
+                if (res == ESP_OK) {
+                    // measure integration time difference, from the last good read so a
+                    // failed one leaves its period to the next
+                    int64_t now = esp_timer_get_time(); // in microseconds
+                    uint32_t dt_us = ch->last_time ? (uint32_t)(now - ch->last_time) : config->update_rate_ms * 1000;
+                    ch->last_time = now;
+
+                    int64_t latch = now - (int64_t)(1e6f / mpu6050_sample_rate_hz(&config->cfg));
+                    if (!autorange_accept(&ch->ar, latch, &dt_us)) { continue; }
+
+                    start = esp_cpu_get_cycle_count();
+                    process_sample(config, ch, &raw_data, dt_us);
+                    if (autorange_active) {
+                        autorange_update(&ch->ar, &raw_data, config->cfg.accel_range, config->cfg.gyro_range, dt_us / 1e6f);
+                    }
+                    if (i == 0) { standby_feed(&raw_data, dt_us); }
+                    stats_hist_add(&readout_stats.process, esp_cpu_get_cycle_count() - start);
+                    publish_sample(config, ch, &raw_data, now);
+                } else {
+                    ch->read_errors++;
+                    ESP_LOGW("ReadOut", "0x%02x failed: %s", ch->dev.addr, esp_err_to_name(res));
+                }
+            }
+            if (autorange_active) { range_switch(); }
+
+        } 
+        // Samples wait in the sensor until the next period
+        mpu6050_bus_yield(&i2c_gate, 0);
+        vTaskDelay(pdMS_TO_TICKS(config->update_rate_ms)); // update rate
+    }
 }
 
 void system_monitor_task(void *pvParameters) {
-    uint8_t reg;
+    (void)pvParameters;
     uint8_t who_am_i = 0;
     esp_err_t res;
 
@@ -144,76 +1105,588 @@ void system_monitor_task(void *pvParameters) {
         uint32_t uptime = now_sec - start_time_sec;
 
 
-        ESP_LOGI("SystemMonitor", "Uptime=%lu s", uptime);
+        ESP_LOGI("SystemMonitor", "Uptime=%" PRIu32 " s", uptime);
 
-        // MPU6050 WHO_AM_I check via I2C
-        reg = MPU6050_WHO_AM_I;
-        res = i2c_master_write_read_device(I2C_NUM_0, MPU6050_ADDR, &reg, 1, &who_am_i, 1, pdMS_TO_TICKS(1000));
-        if (res == ESP_OK && who_am_i == MPU6050_DEVICE_ID) {
-            ESP_LOGI("SystemMonitor", "MPU6050 OK");
-        } else {
-            ESP_LOGE("SystemMonitor", "MPU6050 not responding (%s)", esp_err_to_name(res));
+        // MPU6050 WHO_AM_I check via I2C, in the gaps the readout leaves on the bus
+        for (size_t i = 0; i < n_channels; i++) {
+            mpu6050_dev_t *dev = &channels[i].dev;
+            uint32_t timeouts = i2c_gate.timeouts;
+
+            res = mpu6050_who_am_i(dev, &who_am_i);
+            if (res == ESP_OK && who_am_i == MPU6050_DEVICE_ID) {
+                ESP_LOGI("SystemMonitor", "MPU6050 0x%02x OK (read errors=%" PRIu32 ")", dev->addr, channels[i].read_errors);
+            } else if (i2c_gate.timeouts != timeouts) {
+                ESP_LOGI("SystemMonitor", "MPU6050 0x%02x check skipped, no gap between samples", dev->addr);
+            } else {
+                ESP_LOGE("SystemMonitor", "MPU6050 0x%02x not responding (%s)", dev->addr, esp_err_to_name(res));
+            }
+        }
+
+        // Data-ready acquisition timing
+        if (drdy_timing.samples > 0) {
+            ESP_LOGI("SystemMonitor", "DRDY samples=%" PRIu32 " missed=%" PRIu32 " jitter max=%" PRId64 " us mean=%" PRId64 " us",
+                     drdy_timing.samples, drdy_timing.missed, drdy_timing.jitter_max_us,
+                     drdy_timing.jitter_sum_us / drdy_timing.samples);
         }
 
+        // Telemetry queue
+        ESP_LOGI("SystemMonitor", "Telemetry ring high-water=%" PRIu32 "/%d overruns=%" PRIu32,
+                 sample_ring.high_water, SAMPLE_RING_SIZE, sample_ring.overruns);
+
         // Heap Status
         size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
-        ESP_LOGI("SystemMonitor", "Heap free=%u bytes", heap_free);
+        ESP_LOGI("SystemMonitor", "Heap free=%zu bytes", heap_free);
 
         vTaskDelay(pdMS_TO_TICKS(30000)); // repeat every 30 seconds
     }
 }
 
+void telemetry_task(void *pvParameters) {
+    task_config_t config = *(const task_config_t *)pvParameters;
+    telemetry_sample_t batch[TELEMETRY_BATCH_SIZE];
+    bool flushed = true;
+
+    telemetry_task_handle = xTaskGetCurrentTaskHandle();
+
+    while (1) {
+        config_store_fetch(&config);
+
+        size_t n = sample_ring_pop(&sample_ring, batch, TELEMETRY_BATCH_SIZE);
+
+        if (n == 0) {
+            // The stream paused: send what is left of the raw blocks, then
+            // sleep until the next sample so standby is not woken for nothing
+            TickType_t wait = flushed ? portMAX_DELAY : pdMS_TO_TICKS(TELEMETRY_IDLE_MS);
+            if (ulTaskNotifyTake(pdTRUE, wait) == 0) {
+                telemetry_flush_raw();
+                flushed = true;
+            }
+            continue;
+        }
+        flushed = false;
+
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        telemetry_emit_batch(config.output, batch, n);
+        stats_hist_add(&readout_stats.output, esp_cpu_get_cycle_count() - start);
+    }
+}
+
+/**
+ * @brief Log stack high-water mark and CPU share of every task
+ *
+ * CPU shares are since boot; the load line covers the time since the
+ * previous call.
+ */
+static void task_stats_log(void) {
+    static TaskStatus_t tasks[STATS_MAX_TASKS];
+    static configRUN_TIME_COUNTER_TYPE last_total, last_idle;
+    configRUN_TIME_COUNTER_TYPE total = 0, idle = 0;
+
+    UBaseType_t n = uxTaskGetSystemState(tasks, STATS_MAX_TASKS, &total);
+    if (n == 0 || total == 0) {
+        ESP_LOGW("Stats", "Task state unavailable (%u tasks)", uxTaskGetNumberOfTasks());
+        return;
+    }
+
+    TaskHandle_t idle_task = xTaskGetIdleTaskHandle();
+    for (UBaseType_t i = 0; i < n; i++) {
+        if (tasks[i].xHandle == idle_task) { idle = tasks[i].ulRunTimeCounter; }
+
+        ESP_LOGI("Stats", "task %-16s prio=%u stack free=%" PRIu32 " B cpu=%" PRIu64 "%%",
+                 tasks[i].pcTaskName, tasks[i].uxCurrentPriority, (uint32_t)tasks[i].usStackHighWaterMark,
+                 (uint64_t)tasks[i].ulRunTimeCounter * 100 / total);
+    }
+
+    if (last_total != 0 && total != last_total) {
+        ESP_LOGI("Stats", "CPU load since last stats: %" PRIu64 "%%",
+                 100 - (uint64_t)(idle - last_idle) * 100 / (total - last_total));
+    }
+    last_total = total;
+    last_idle = idle;
+}
+
+/**
+ * @brief Log the hot-path histograms, error and drop counters and task statistics
+ */
+static void stats_log(void) {
+    uint32_t cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    uint32_t fifo_overflows = 0;
+
+    stats_hist_log("Stats", "read", &readout_stats.read, cycles_per_us);
+    stats_hist_log("Stats", "process", &readout_stats.process, cycles_per_us);
+    stats_hist_log("Stats", "publish", &readout_stats.publish, cycles_per_us);
+    stats_hist_log("Stats", "output", &readout_stats.output, cycles_per_us);
+    stats_hist_log("Stats", "jitter", &readout_stats.jitter, cycles_per_us);
+    stats_hist_log("Stats", "apply", &readout_stats.apply, cycles_per_us);
+    ESP_LOGI("Stats", "max dt=%" PRIu32 " us", readout_stats.max_dt_us);
+    ESP_LOGI("Stats", "boot: ready=%" PRId64 " ms first sample=%" PRId64 " ms", ready_time_us / 1000, first_sample_time_us / 1000);
+
+    for (size_t i = 0; i < n_channels; i++) {
+        ESP_LOGI("Stats", "0x%02x failed reads=%" PRIu32 " bus resets=%" PRIu32 " fifo overflows=%" PRIu32,
+                 channels[i].dev.addr, channels[i].read_errors, channels[i].dev.resets, channels[i].fifo.overflows);
+        fifo_overflows += channels[i].fifo.overflows;
+        if (tilt_active) {
+            const attitude_t *att = &channels[i].att;
+            ESP_LOGI("Stats", "0x%02x tilt=%.2f deg corrected=%" PRIu32 "/%" PRIu32 " samples", channels[i].dev.addr,
+                     attitude_tilt_deg(att), att->corrections, att->updates);
+        }
+        if (kalman_active) {
+            const kalman_state_t *kf = &channels[i].kf;
+            ESP_LOGI("Stats", "0x%02x kalman bias=%.4f, %.4f, %.4f m/s2 zero-velocity updates=%" PRIu32, channels[i].dev.addr,
+                     kf->b[0], kf->b[1], kf->b[2], kf->updates);
+        }
+        const autorange_t *ar = &channels[i].ar;
+        if (autorange_active || ar->switches > 0) {
+            ESP_LOGI("Stats", "0x%02x range=%dg/%ddps switches=%" PRIu32 " lost=%" PRIu32 " (max %" PRIu32 " per switch) saturated=%" PRIu32 " failed=%" PRIu32,
+                     channels[i].dev.addr, 2 << channels[i].dev.accel_range, 250 << channels[i].dev.gyro_range,
+                     ar->switches, ar->lost, ar->lost_max, ar->saturated, ar->failures);
+        }
+    }
+    ESP_LOGI("Stats", "dropped: fifo overflows=%" PRIu32 " drdy missed=%" PRIu32 " ring overruns=%" PRIu32,
+             fifo_overflows, drdy_timing.missed, sample_ring.overruns);
+    ESP_LOGI("Stats", "bus: housekeeping granted=%" PRIu32 " deferred=%" PRIu32 " timeouts=%" PRIu32 ", sampler preempted=%" PRIu32 " (max wait %" PRId64 " us)",
+             i2c_gate.granted, i2c_gate.deferred, i2c_gate.timeouts, i2c_gate.preempts, i2c_gate.preempt_max_us);
+
+    if (standby_stats.entries > 0) {
+        const standby_stats_t *sb = &standby_stats;
+        float busy = sb->asleep_us > 0 ? 1.0f - (float)sb->idle_us / sb->asleep_us : 0.0f;
+        if (busy < 0.0f) { busy = 0.0f; }
+
+        ESP_LOGI("Stats", "standby: %s entries=%" PRIu32 " motion wakes=%" PRIu32 " polls=%" PRIu32 " failed=%" PRIu32 " time=%.1f s cpu busy=%.3f%%",
+                 sb->asleep ? "asleep" : (sb->session ? "acquiring on motion" : "off"), sb->entries, sb->wakes,
+                 sb->polls, sb->failures, sb->asleep_us / 1e6, busy * 100.0f);
+        ESP_LOGI("Stats", "standby: current budget %.0f uA, %.0f uA without standby (%" PRIu32 " sensors, typical currents)",
+                 standby_current_ua(busy, n_channels), standby_awake_current_ua(n_channels), (uint32_t)n_channels);
+        stats_hist_log("Stats", "wake", &sb->wake, cycles_per_us);
+    }
+
+    if (control_stats.periods > 0) {
+        ESP_LOGI("Stats", "control: period=%" PRId64 " us periods=%" PRIu32 " frames=%" PRIu32 " deadline misses: late=%" PRIu32 " skipped=%" PRIu32,
+                 control_stats.period_us, control_stats.periods, control_stats.frames,
+                 control_stats.late, control_stats.skipped);
+        stats_hist_log("Stats", "wire", &control_stats.wire, cycles_per_us);
+    }
+
+    task_stats_log();
+}
+
+// --- Command Handlers ---
+//
+// Handlers edit the command listener's private configuration copy, which
+// is published as a new snapshot whenever a command changed it.
+
+static esp_err_t cmd_reset(void *ctx, const char *arg) {
+    (void)ctx;
+    (void)arg;
+    esp_restart();
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_rate(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    int rate = atoi(arg);
+    if (rate <= 0) { return ESP_ERR_INVALID_ARG; }
+
+    config->update_rate_ms = rate;
+    ESP_LOGI("CommandListener", "Set Update Rate: %d", rate);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_accel_noise_floor(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    float noise = atof(arg);
+    config->accel_noise_floor = noise;
+    ESP_LOGI("CommandListener", "Set Accel. Noice Floor: %.2f", noise);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_mpu6050_config(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+    int a, g, d, s;
+
+    if (sscanf(arg, "%d,%d,%d,%d", &a, &g, &d, &s) != 4) { return ESP_ERR_INVALID_ARG; }
+
+    // The codes are shifted into the registers as they are, a larger one would set the
+    // self-test or reserved bits while the scales still follow its low bits
+    if (a < 0 || a >= MPU6050_RANGES || g < 0 || g >= MPU6050_RANGES) { return ESP_ERR_INVALID_ARG; }
+    if (d < 0 || d > 6 || s < 0 || s > UINT8_MAX) { return ESP_ERR_INVALID_ARG; }
+
+    // Written to the sensors by the readout task between two samples
+    config->cfg.accel_range = a;
+    config->cfg.gyro_range  = g;
+    config->cfg.dlpf_cfg    = d;
+    config->cfg.smplrt_div  = s;
+    ESP_LOGI("CommandListener", "MPU6050 reconfigured: a=%d, g=%d, d=%d, s=%d", a, g, d, s);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_mode(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "poll") == 0) {
+        config->acq_mode = ACQ_MODE_POLL;
+    } else if (strcmp(arg, "fifo") == 0) {
+        config->acq_mode = ACQ_MODE_FIFO;
+    } else if (strcmp(arg, "drdy") == 0) {
+        config->acq_mode = ACQ_MODE_DRDY;
+    } else if (strcmp(arg, "control") == 0) {
+        config->acq_mode = ACQ_MODE_CONTROL;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Acquisition mode: %s", arg);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_output(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "text") == 0) {
+        config->output = OUTPUT_TEXT;
+    } else if (strcmp(arg, "binary") == 0) {
+        config->output = OUTPUT_BINARY;
+    } else if (strcmp(arg, "raw") == 0) {
+        config->output = OUTPUT_RAW;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Output format: %s", arg);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_math(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "float") == 0) {
+        config->math = MATH_FLOAT;
+    } else if (strcmp(arg, "fixed") == 0) {
+        config->math = MATH_FIXED;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Processing: %s", arg);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_decim(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "off") == 0) {
+        config->decim = DECIM_OFF;
+    } else if (strcmp(arg, "fir") == 0) {
+        config->decim = DECIM_FIR;
+    } else if (strcmp(arg, "cic") == 0) {
+        config->decim = DECIM_CIC;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Decimation: %s", arg);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_tilt(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "on") == 0) {
+        config->tilt = true;
+    } else if (strcmp(arg, "off") == 0) {
+        config->tilt = false;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Tilt compensation: %s%s", arg,
+             (config->tilt && config->math != MATH_FLOAT) ? " (float math only)" : "");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_drift(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "hold") == 0) {
+        config->drift = DRIFT_HOLD;
+    } else if (strcmp(arg, "kalman") == 0) {
+        config->drift = DRIFT_KALMAN;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Drift control: %s%s", arg,
+             (config->drift == DRIFT_KALMAN && config->math != MATH_FLOAT) ? " (float math only)" : "");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_autorange(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "on") == 0) {
+        config->autorange = true;
+    } else if (strcmp(arg, "off") == 0) {
+        config->autorange = false;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Auto-ranging: %s%s", arg,
+             (config->autorange && config->acq_mode == ACQ_MODE_FIFO) ? " (not in fifo mode)" : "");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_set_standby(void *ctx, const char *arg) {
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "on") == 0) {
+        config->standby = true;
+    } else if (strcmp(arg, "off") == 0) {
+        config->standby = false;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI("CommandListener", "Standby: %s%s", arg, (config->standby && config->start) ? " (once stopped)" : "");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_stats(void *ctx, const char *arg) {
+    (void)ctx;
+    if (strcmp(arg, "reset") == 0) {
+        // Racy by at most the sample in flight in each writer task
+        stats_hist_reset(&readout_stats.read);
+        stats_hist_reset(&readout_stats.process);
+        stats_hist_reset(&readout_stats.publish);
+        stats_hist_reset(&readout_stats.output);
+        stats_hist_reset(&readout_stats.jitter);
+        stats_hist_reset(&readout_stats.apply);
+        stats_hist_reset(&control_stats.wire);
+        stats_hist_reset(&standby_stats.wake);
+        readout_stats.max_dt_us = 0;
+        ESP_LOGI("CommandListener", "Statistics cleared");
+    } else if (arg[0] == '\0') {
+        stats_log();
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_capture(void *ctx, const char *arg) {
+    static const char *const state_names[] = {"idle", "armed", "triggered", "frozen"};
+    task_config_t *config = ctx;
+
+    if (strcmp(arg, "arm") == 0) {
+        // Applied by the readout task with the next full-rate sample
+        event_capture_request(&capture, CAPTURE_REQ_ARM);
+        ESP_LOGI("Capture", "Arming, trigger enabled after %d samples", CAPTURE_WARMUP);
+    } else if (strcmp(arg, "disarm") == 0) {
+        event_capture_request(&capture, CAPTURE_REQ_DISARM);
+        ESP_LOGI("Capture", "Disarmed");
+    } else if (strcmp(arg, "dump") == 0) {
+        int64_t start = esp_timer_get_time();
+        size_t bytes = telemetry_emit_event(&capture, 0, (uint16_t)mpu6050_sample_rate_hz(&config->cfg));
+        int64_t elapsed_us = esp_timer_get_time() - start;
+
+        if (bytes == 0) { return ESP_ERR_INVALID_STATE; }
+        ESP_LOGI("Capture", "Event %" PRIu32 " dumped: %u samples, %zu bytes in %" PRId64 " ms (%" PRId64 " B/s)",
+                 capture.events, capture.pre + CAPTURE_POST_SAMPLES, bytes,
+                 elapsed_us / 1000, elapsed_us > 0 ? (int64_t)bytes * 1000000 / elapsed_us : 0);
+    } else if (arg[0] == '\0') {
+        capture_state_t state = atomic_load(&capture.state);
+        ESP_LOGI("Capture", "state=%s events=%" PRIu32 " STA/LTA=%.2f warmup=%" PRIu32 " ring=%zu bytes",
+                 state_names[state], capture.events, event_capture_ratio(&capture) / (float)(1 << CAPTURE_RATIO_FRAC),
+                 capture.warmup, sizeof(capture.ring));
+        if (capture.request != CAPTURE_REQ_NONE) {
+            ESP_LOGI("Capture", "Request pending until the next full-rate sample (fifo, drdy or control mode)");
+        }
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_info(void *ctx, const char *arg) {
+    (void)arg;
+    // Recorders read this to describe what they record
+    telemetry_emit_info(ctx, channels, n_channels);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_ping(void *ctx, const char *arg) {
+    (void)ctx;
+    unsigned long id;
+    char extra;
+
+    if (sscanf(arg, "%lu%c", &id, &extra) != 1) { return ESP_ERR_INVALID_ARG; }
+
+    // The host times the round trip, nothing else goes in between
+    telemetry_emit_sync((uint32_t)id, cmd_rx_us);
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_bench(void *ctx, const char *arg) {
+    (void)ctx;
+    return bench_run(arg, &channels[0].dev);
+}
+
+static esp_err_t cmd_recalibrate(void *ctx, const char *arg) {
+    (void)ctx;
+    (void)arg;
+    // Runs in the readout task at its next sample boundary
+    recalibrate_requested = true;
+    ESP_LOGI("CommandListener", "Recalibrating, keep the sensors still");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_start(void *ctx, const char *arg) {
+    (void)arg;
+    task_config_t *config = ctx;
+
+    config->start = true;
+    ESP_LOGI("CommandListener", "Starting the readout task");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_stop(void *ctx, const char *arg) {
+    (void)arg;
+    task_config_t *config = ctx;
+
+    config->start = false;
+    ESP_LOGI("CommandListener", "Stoping the readout taks");
+
+    return ESP_OK;
+}
+
+static esp_err_t cmd_help(void *ctx, const char *arg);
+
+static const command_t commands[] = {
+    {"reset",                   cmd_reset,                  "restart the device"},
+    {"start",                   cmd_start,                  "start the readout"},
+    {"stop",                    cmd_stop,                   "stop the readout"},
+    {"recalibrate",             cmd_recalibrate,            "measure and store new sensor biases"},
+    {"set_rate",                cmd_set_rate,               ":<ms> update / output period"},
+    {"set_accel_noise_floor",   cmd_set_accel_noise_floor,  ":<m/s2> acceleration noise floor"},
+    {"set_mpu6050_config",      cmd_set_mpu6050_config,     ":<accel>,<gyro>,<dlpf>,<div> sensor configuration"},
+    {"set_mode",                cmd_set_mode,               ":poll|fifo|drdy|control acquisition mode"},
+    {"set_output",              cmd_set_output,             ":text|binary|raw console output format"},
+    {"set_math",                cmd_set_math,               ":float|fixed processing arithmetic"},
+    {"set_decim",               cmd_set_decim,              ":off|fir|cic decimation filter"},
+    {"set_tilt",                cmd_set_tilt,               ":on|off gyro-fused tilt compensation"},
+    {"set_drift",               cmd_set_drift,              ":hold|kalman drift control"},
+    {"set_autorange",           cmd_set_autorange,          ":on|off follow the signal with the full-scale ranges"},
+    {"set_standby",             cmd_set_standby,            ":on|off while stopped, sleep until motion and acquire until quiet"},
+    {"stats",                   cmd_stats,                  "[:reset] log or clear runtime statistics"},
+    {"info",                    cmd_info,                   "send configuration and calibration as info frames"},
+    {"ping",                    cmd_ping,                   ":<id> reply with a sync frame, for host clock sync"},
+    {"capture",                 cmd_capture,                "[:arm|disarm|dump] event capture status and control"},
+    {"bench",                   cmd_bench,                  ":<name> run an on-device benchmark"},
+    {"help",                    cmd_help,                   "list commands"},
+};
+
+#define N_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+static esp_err_t cmd_help(void *ctx, const char *arg) {
+    (void)ctx;
+    (void)arg;
+    for (size_t i = 0; i < N_COMMANDS; i++) {
+        ESP_LOGI("CommandListener", "%s%s", commands[i].name, commands[i].help);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Solve the Kalman gains of a configuration for its sample period
+ *
+ * The sample period follows from the acquisition mode, the update rate and
+ * the sensor configuration. Solving takes thousands of Riccati iterations,
+ * so it runs here, at command time, and never in the readout task.
+ *
+ * @param config         Configuration about to be published
+ */
+static void kalman_sync(task_config_t *config) {
+    if (config->drift != DRIFT_KALMAN) { return; }
+
+    uint32_t dt_us = (config->acq_mode == ACQ_MODE_POLL) ? config->update_rate_ms * 1000
+                                                         : (uint32_t)(1e6f / mpu6050_sample_rate_hz(&config->cfg));
+    if (dt_us == config->kalman.dt_us) { return; }
+
+    int64_t start = esp_timer_get_time();
+    kalman_params_init(&config->kalman, dt_us);
+    ESP_LOGI("CommandListener", "Kalman gains for %" PRIu32 " us: d=%.6f v=%.6f b=%.6f (%" PRIu32 " iterations, %" PRId64 " ms)", dt_us,
+             config->kalman.kd, config->kalman.kv, config->kalman.kb, config->kalman.iterations,
+             (esp_timer_get_time() - start) / 1000);
+}
+
 void command_listener_task(void *pvParameters) {
-    char buf[CMD_BUF_SIZE];
     task_config_t *config = (task_config_t *)pvParameters;
+    static line_reader_t reader;
+    uint8_t rx[CMD_RX_CHUNK];
+
+    // Blocking reads: the task sleeps until the console delivers input
+    usb_serial_jtag_driver_config_t usj_cfg = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    esp_err_t res = usb_serial_jtag_driver_install(&usj_cfg);
+    if (res != ESP_OK) {
+        ESP_LOGE("CommandListener", "Console driver install failed: %s", esp_err_to_name(res));
+        vTaskSuspend(NULL);
+    }
+    usb_serial_jtag_vfs_use_driver();
+
+    // Binary frames share stdout with the log: no byte may be translated
+    usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+    usb_serial_jtag_vfs_set_rx_line_endings(ESP_LINE_ENDINGS_LF);
 
     while (1) {
-        if (fgets(buf, CMD_BUF_SIZE, stdin) != NULL) {
-            buf[strcspn(buf, "\r\n")] = 0; 
-
-            ESP_LOGI("CommandListener", "Received: %s", buf);
-
-            if (strncmp(buf, "reset", 5) == 0) {
-                esp_restart();
-            
-            } else if (strncmp(buf, "set_rate:", 9) == 0) {
-            
-                int rate = atoi(buf + 9);
-                config->update_rate_ms = rate;
-                ESP_LOGI("CommandListener", "Set Update Rate: %d", rate);
-            
-            }  else if (strncmp(buf, "set_accel_noise_floor:", 23) == 0) {
-            
-                float noise = atof(buf + 23);
-                config->accel_noise_floor = noise;
-                ESP_LOGI("CommandListener", "Set Accel. Noice Floor: %.2f", noise);
-            
-            }  else if (strncmp(buf, "set_mpu6050_config:", 19) == 0) {
-                int a, g, d, s;
-
-                if (sscanf(buf + 19, "%d,%d,%d,%d", &a, &g, &d, &s) == 4) {
-                    config->cfg.accel_range = a;
-                    config->cfg.gyro_range  = g;
-                    config->cfg.dlpf_cfg    = d;
-                    config->cfg.smplrt_div  = s;
-
-                    mpu6050_config(I2C_NUM_0, &config->cfg);
-                    ESP_LOGI("CommandListener", "MPU6050 reconfigured: a=%d, g=%d, d=%d, s=%d", a, g, d, s);
-                } else {
-                    ESP_LOGE("CommandListener", "Invalid config string");
-                }
+        int n = usb_serial_jtag_read_bytes(rx, sizeof(rx), portMAX_DELAY);
+        int64_t rx_us = esp_timer_get_time();
 
-            } else if (strncmp(buf, "start", 5) == 0) {
-                config->start = true;
-                ESP_LOGI("CommandListener", "Starting the readout task");
-            } else if (strncmp(buf, "stop", 4) == 0) {
-                config->start = false;
-                ESP_LOGI("CommandListener", "Stoping the readout taks");
+        for (int i = 0; i < n; i++) {
+            if (!line_reader_push(&reader, (char)rx[i])) { continue; }
+
+            uint32_t rx_cycles = esp_cpu_get_cycle_count();
+            cmd_rx_us = rx_us;
+
+            // The host pings every second, those lines are not logged
+            if (strncmp(reader.buf, "ping:", 5) != 0) { ESP_LOGI("CommandListener", "Received: %s", reader.buf); }
+
+            // Handlers edit a scratch copy, readers only ever see complete snapshots
+            task_config_t next = *config;
+            char name[CMD_BUF_SIZE];
+            strcpy(name, reader.buf);
+
+            res = command_dispatch(commands, N_COMMANDS, &next, reader.buf);
+            if (res == ESP_ERR_NOT_FOUND) {
+                ESP_LOGE("CommandListener", "Unknown command: %s", name);
+            } else if (res == ESP_ERR_INVALID_ARG) {
+                ESP_LOGE("CommandListener", "Invalid argument: %s", name);
+            } else if (res != ESP_OK) {
+                ESP_LOGE("CommandListener", "%s failed: %s", name, esp_err_to_name(res));
             } else {
-                ESP_LOGE("CommandListener", "Unknown command: %s\n", buf);
+                kalman_sync(&next);
+                if (memcmp(&next, config, sizeof(next)) != 0) {
+                    next.cmd_cycles = rx_cycles;
+                    *config = next;
+                    config_store_publish(config);
+                }
             }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(100)); 
+        if (reader.overflows != 0) {
+            ESP_LOGE("CommandListener", "Dropped %u over-long command line(s)", reader.overflows);
+            reader.overflows = 0;
+        }
     }
 }
@@ -0,0 +1,96 @@
+#include <math.h>
+
+#include "attitude.h"
+
+void attitude_init(attitude_t *att, const mpu6050_cal_data_t *cal) {
+    float bx = cal->ax_bias;
+    float by = cal->ay_bias;
+    float bz = cal->az_bias;
+    float g = sqrtf(bx * bx + by * by + bz * bz);
+
+    // Without a usable calibration the sensor is assumed level
+    if (g < 1.0f) {
+        bx = 0.0f;
+        by = 0.0f;
+        bz = 9.80665f;
+        g = 9.80665f;
+    }
+
+    att->g = g;
+    att->inv_g = 1.0f / g;
+    att->gx = bx * att->inv_g;
+    att->gy = by * att->inv_g;
+    att->gz = bz * att->inv_g;
+
+    float lo = g * (1.0f - ATTITUDE_GATE);
+    float hi = g * (1.0f + ATTITUDE_GATE);
+    att->gate_lo = lo * lo;
+    att->gate_hi = hi * hi;
+
+    att->gyro_bias[0] = cal->gx_bias;
+    att->gyro_bias[1] = cal->gy_bias;
+    att->gyro_bias[2] = cal->gz_bias;
+    att->corrections = 0;
+    att->updates = 0;
+}
+
+void attitude_update(attitude_t *att, const mpu6050_data_t *data, float dt) {
+    float gx = att->gx;
+    float gy = att->gy;
+    float gz = att->gz;
+
+    // Gyro: the sensor turns by w * dt, gravity turns the other way in its frame
+    float k = ATTITUDE_DEG_TO_RAD * dt;
+    float wx = (data->gx - att->gyro_bias[0]) * k;
+    float wy = (data->gy - att->gyro_bias[1]) * k;
+    float wz = (data->gz - att->gyro_bias[2]) * k;
+    float nx = gx + (gy * wz - gz * wy);
+    float ny = gy + (gz * wx - gx * wz);
+    float nz = gz + (gx * wy - gy * wx);
+
+    // Accelerometer: only while the sensor is not accelerating noticeably
+    float a2 = data->ax * data->ax + data->ay * data->ay + data->az * data->az;
+    if (a2 > att->gate_lo && a2 < att->gate_hi) {
+        float c = dt * (1.0f / ATTITUDE_TAU_S);
+        if (c > 1.0f) { c = 1.0f; }
+        float ci = c * att->inv_g;
+        nx += ci * data->ax - c * nx;
+        ny += ci * data->ay - c * ny;
+        nz += ci * data->az - c * nz;
+        att->corrections++;
+    }
+
+    // Back to unit length, one Newton step: the error per sample is tiny
+    float s = 1.5f - 0.5f * (nx * nx + ny * ny + nz * nz);
+    att->gx = nx * s;
+    att->gy = ny * s;
+    att->gz = nz * s;
+    att->updates++;
+}
+
+void attitude_level(const attitude_t *att, float *ax, float *ay, float *az) {
+    float gx = att->gx;
+    float gy = att->gy;
+    float gz = att->gz;
+
+    // Rotation about (gy, -gx, 0) that takes the gravity estimate onto +Z
+    float c = 1.0f + gz;
+    if (c < ATTITUDE_MIN_COS) { c = ATTITUDE_MIN_COS; }
+    float p = gx * *ax + gy * *ay;
+    float q = p / c + *az;
+
+    float lx = *ax - gx * q;
+    float ly = *ay - gy * q;
+    float lz = p + gz * *az;
+
+    *ax = lx;
+    *ay = ly;
+    *az = lz - att->g;
+}
+
+float attitude_tilt_deg(const attitude_t *att) {
+    float gz = att->gz;
+    if (gz > 1.0f) { gz = 1.0f; }
+    if (gz < -1.0f) { gz = -1.0f; }
+    return acosf(gz) / ATTITUDE_DEG_TO_RAD;
+}
@@ -0,0 +1,92 @@
+#include "autorange.h"
+
+static inline int32_t autorange_peak(int16_t x, int16_t y, int16_t z) {
+    int32_t ax = x < 0 ? -(int32_t)x : x;
+    int32_t ay = y < 0 ? -(int32_t)y : y;
+    int32_t az = z < 0 ? -(int32_t)z : z;
+    int32_t peak = ax > ay ? ax : ay;
+
+    return peak > az ? peak : az;
+}
+
+/**
+ * @brief One sensor's range after a sample
+ *
+ * @param peak           Largest |counts| of the sample's axes
+ * @param range          Current range
+ * @param floor          Finest range allowed
+ * @param calm_s         Time below AUTORANGE_LOW, updated
+ * @param dt             Time step (in seconds)
+ * @return uint8_t       Range wanted
+ */
+static uint8_t autorange_step(int32_t peak, uint8_t range, uint8_t floor, float *calm_s, float dt) {
+    if (range < floor) { return floor; }
+
+    if (peak >= AUTORANGE_HIGH) {
+        *calm_s = 0.0f;
+        return range < AUTORANGE_MAX_RANGE ? range + 1 : range;
+    }
+
+    if (peak >= AUTORANGE_LOW || range == floor) {
+        *calm_s = 0.0f;
+        return range;
+    }
+
+    *calm_s += dt;
+    if (*calm_s < AUTORANGE_HOLD_S) { return range; }
+
+    *calm_s = 0.0f;
+    return range - 1;
+}
+
+void autorange_reset(autorange_t *ar, uint8_t accel_range, uint8_t gyro_range) {
+    ar->accel_range = accel_range;
+    ar->gyro_range = gyro_range;
+    ar->accel_calm_s = 0.0f;
+    ar->gyro_calm_s = 0.0f;
+    ar->switch_us = 0;
+    ar->carry_us = 0;
+    ar->pending = 0;
+}
+
+bool autorange_update(autorange_t *ar, const mpu6050_raw_t *raw, uint8_t accel_floor, uint8_t gyro_floor, float dt) {
+    int32_t accel_peak = autorange_peak(raw->ax, raw->ay, raw->az);
+    int32_t gyro_peak = autorange_peak(raw->gx, raw->gy, raw->gz);
+
+    if (accel_peak >= INT16_MAX || gyro_peak >= INT16_MAX) { ar->saturated++; }
+
+    uint8_t accel = autorange_step(accel_peak, ar->accel_range, accel_floor, &ar->accel_calm_s, dt);
+    uint8_t gyro = autorange_step(gyro_peak, ar->gyro_range, gyro_floor, &ar->gyro_calm_s, dt);
+    if (accel == ar->accel_range && gyro == ar->gyro_range) { return false; }
+
+    ar->accel_range = accel;
+    ar->gyro_range = gyro;
+
+    return true;
+}
+
+void autorange_switched(autorange_t *ar, int64_t done_us) {
+    // A switch before the first sample of the previous one adds to its count
+    if (ar->switch_us == 0) { ar->pending = 0; }
+    ar->switch_us = done_us;
+    ar->switches++;
+}
+
+bool autorange_accept(autorange_t *ar, int64_t latch_us, uint32_t *dt_us) {
+    if (ar->switch_us != 0) {
+        if (latch_us < ar->switch_us) {
+            ar->carry_us += *dt_us;
+            ar->pending++;
+            ar->lost++;
+            return false;
+        }
+
+        if (ar->pending > ar->lost_max) { ar->lost_max = ar->pending; }
+        ar->switch_us = 0;
+    }
+
+    *dt_us += ar->carry_us;
+    ar->carry_us = 0;
+
+    return true;
+}
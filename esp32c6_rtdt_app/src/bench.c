@@ -0,0 +1,654 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "bench.h"
+#include "mpu6050.h"
+#include "motion.h"
+#include "attitude.h"
+#include "kalman.h"
+#include "autorange.h"
+#include "decimator.h"
+#include "sample_ring.h"
+#include "event_capture.h"
+#include "raw_codec.h"
+#include "telemetry.h"
+
+typedef struct {
+    const char *name;
+    esp_err_t (*run)(mpu6050_dev_t *dev);
+} bench_entry_t;
+
+typedef struct {
+    int64_t total_us;
+    int64_t max_us;
+} bench_timing_t;
+
+static void bench_timing_add(bench_timing_t *timing, int64_t elapsed_us) {
+    timing->total_us += elapsed_us;
+    if (elapsed_us > timing->max_us) { timing->max_us = elapsed_us; }
+}
+
+static esp_err_t bench_i2c(mpu6050_dev_t *dev) {
+    bench_timing_t three_call = {0};
+    bench_timing_t burst = {0};
+    mpu6050_data_t data;
+    esp_err_t res;
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        int64_t start = esp_timer_get_time();
+        res = mpu6050_read_accel(dev, &data);
+        if (res == ESP_OK) { res = mpu6050_read_gyro(dev, &data); }
+        if (res == ESP_OK) { res = mpu6050_read_temp(dev, &data); }
+        if (res != ESP_OK) { return res; }
+        bench_timing_add(&three_call, esp_timer_get_time() - start);
+
+        start = esp_timer_get_time();
+        res = mpu6050_read_all(dev, &data);
+        if (res != ESP_OK) { return res; }
+        bench_timing_add(&burst, esp_timer_get_time() - start);
+    }
+
+    ESP_LOGI("Bench", "i2c three-call: mean=%" PRId64 " us max=%" PRId64 " us",
+             three_call.total_us / BENCH_ITERATIONS, three_call.max_us);
+    ESP_LOGI("Bench", "i2c read_all:   mean=%" PRId64 " us max=%" PRId64 " us",
+             burst.total_us / BENCH_ITERATIONS, burst.max_us);
+
+    return ESP_OK;
+}
+
+static esp_err_t bench_motion(mpu6050_dev_t *dev) {
+    mpu6050_raw_t *samples = malloc(BENCH_MOTION_SAMPLES * sizeof(mpu6050_raw_t));
+    if (samples == NULL) { return ESP_ERR_NO_MEM; }
+
+    // Counts are read at the sensor's current range
+    const float accel_scale = mpu6050_accel_scale[dev->accel_range & 0x03];
+
+    // Record live sensor data and compute its bias
+    mpu6050_cal_data_t bias = {.samples = BENCH_MOTION_SAMPLES};
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) {
+        esp_err_t res = mpu6050_read_raw(dev, &samples[i]);
+        if (res != ESP_OK) { free(samples); return res; }
+
+        bias.ax_bias += samples[i].ax * accel_scale;
+        bias.ay_bias += samples[i].ay * accel_scale;
+        bias.az_bias += samples[i].az * accel_scale;
+    }
+    bias.ax_bias /= BENCH_MOTION_SAMPLES;
+    bias.ay_bias /= BENCH_MOTION_SAMPLES;
+    bias.az_bias /= BENCH_MOTION_SAMPLES;
+
+    // Superimpose a known excitation so the integrators are exercised
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) {
+        float phase = 2.0f * (float)M_PI * i / BENCH_MOTION_SAMPLES;
+        samples[i].ax += (int16_t)(BENCH_MOTION_AMPLITUDE * sinf(phase) / accel_scale);
+        samples[i].ay += (int16_t)(BENCH_MOTION_AMPLITUDE * cosf(phase) / accel_scale);
+    }
+
+    const float noise_floor = 0.1f;
+    motion_fx_params_t params;
+    motion_fx_params_init(&params, &bias, noise_floor, dev->accel_range);
+
+    // Timed runs over the whole recording
+    motion_state_t fl = {0};
+    motion_hold_t hold = {0};
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        process_accel_data(data, bias, noise_floor, BENCH_MOTION_DT_US / 1e6f, &fl, &hold);
+    }
+    uint32_t float_cycles = esp_cpu_get_cycle_count() - start;
+
+    // The same recording in blocks of BENCH_MOTION_BLOCK, converted to structure of arrays as part of the run
+    float *soa = malloc(3 * BENCH_MOTION_SAMPLES * sizeof(float));
+    int64_t *t_us = malloc(BENCH_MOTION_SAMPLES * sizeof(int64_t));
+    if (soa == NULL || t_us == NULL) { free(soa); free(t_us); free(samples); return ESP_ERR_NO_MEM; }
+    float *ax = soa, *ay = soa + BENCH_MOTION_SAMPLES, *az = soa + 2 * BENCH_MOTION_SAMPLES;
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) { t_us[i] = (int64_t)(i + 1) * BENCH_MOTION_DT_US; }
+
+    motion_state_t blk = {0};
+    motion_hold_t blk_hold = {0};
+    start = esp_cpu_get_cycle_count();
+    for (int i0 = 0; i0 < BENCH_MOTION_SAMPLES; i0 += BENCH_MOTION_BLOCK) {
+        int n = BENCH_MOTION_SAMPLES - i0 < BENCH_MOTION_BLOCK ? BENCH_MOTION_SAMPLES - i0 : BENCH_MOTION_BLOCK;
+        for (int i = i0; i < i0 + n; i++) {
+            ax[i] = samples[i].ax * accel_scale;
+            ay[i] = samples[i].ay * accel_scale;
+            az[i] = samples[i].az * accel_scale;
+        }
+        motion_block_t block = {.ax = ax + i0, .ay = ay + i0, .az = az + i0, .t_us = t_us + i0,
+                                .t_prev_us = (int64_t)i0 * BENCH_MOTION_DT_US, .n = n};
+        process_accel_block(&block, &bias, noise_floor, &blk, &blk_hold, NULL);
+    }
+    uint32_t block_cycles = esp_cpu_get_cycle_count() - start;
+    bool block_same = memcmp(&blk, &fl, sizeof(fl)) == 0 && memcmp(&blk_hold, &hold, sizeof(hold)) == 0;
+    free(soa);
+    free(t_us);
+
+    motion_fx_state_t fx = {0};
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) {
+        process_accel_data_fx(&samples[i], &params, BENCH_MOTION_DT_US, &fx);
+    }
+    uint32_t fixed_cycles = esp_cpu_get_cycle_count() - start;
+
+    // Untimed lockstep run for the accuracy comparison
+    float max_dv = 0, max_dd = 0;
+    memset(&fl, 0, sizeof(fl));
+    memset(&hold, 0, sizeof(hold));
+    memset(&fx, 0, sizeof(fx));
+    for (int i = 0; i < BENCH_MOTION_SAMPLES; i++) {
+        mpu6050_data_t data;
+        motion_state_t out;
+
+        mpu6050_raw_to_data(&samples[i], &data);
+        process_accel_data(data, bias, noise_floor, BENCH_MOTION_DT_US / 1e6f, &fl, &hold);
+        process_accel_data_fx(&samples[i], &params, BENCH_MOTION_DT_US, &fx);
+        motion_fx_to_state(&fx, &out);
+
+        max_dv = fmaxf(max_dv, fmaxf(fabsf(out.vx - fl.vx), fabsf(out.vy - fl.vy)));
+        max_dd = fmaxf(max_dd, fmaxf(fabsf(out.dx - fl.dx), fabsf(out.dy - fl.dy)));
+    }
+
+    ESP_LOGI("Bench", "motion float: %" PRIu32 " cycles/sample", float_cycles / BENCH_MOTION_SAMPLES);
+    ESP_LOGI("Bench", "motion block: %" PRIu32 " cycles/sample (%d samples per call), result %s the per-sample path",
+             block_cycles / BENCH_MOTION_SAMPLES, BENCH_MOTION_BLOCK, block_same ? "bit-identical to" : "DIFFERS from");
+    ESP_LOGI("Bench", "motion fixed: %" PRIu32 " cycles/sample (saturations=%" PRIu32 ")", fixed_cycles / BENCH_MOTION_SAMPLES, fx.saturations);
+    ESP_LOGI("Bench", "motion max |fixed - float|: v=%.6f m/s d=%.6f m", max_dv, max_dd);
+
+    free(samples);
+    return block_same ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bench_ring(mpu6050_dev_t *dev) {
+    (void)dev;
+    sample_ring_t *ring = malloc(sizeof(sample_ring_t));
+    if (ring == NULL) { return ESP_ERR_NO_MEM; }
+
+    telemetry_sample_t sample = {0};
+    telemetry_sample_t batch[TELEMETRY_BATCH_SIZE];
+    uint32_t push_cycles = 0, pop_cycles = 0;
+    size_t popped = 0;
+
+    sample_ring_init(ring);
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        // Fill the ring completely, then drain it in telemetry sized batches
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        for (int j = 0; j < SAMPLE_RING_SIZE; j++) {
+            sample.seq++;
+            sample_ring_push(ring, &sample);
+        }
+        push_cycles += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        size_t n;
+        while ((n = sample_ring_pop(ring, batch, TELEMETRY_BATCH_SIZE)) > 0) {
+            popped += n;
+        }
+        pop_cycles += esp_cpu_get_cycle_count() - start;
+    }
+
+    ESP_LOGI("Bench", "ring push: %" PRIu32 " cycles/sample", push_cycles / (BENCH_ITERATIONS * SAMPLE_RING_SIZE));
+    ESP_LOGI("Bench", "ring pop:  %" PRIu32 " cycles/sample (batch=%d, popped=%zu, overruns=%" PRIu32 ")",
+             pop_cycles / (BENCH_ITERATIONS * SAMPLE_RING_SIZE), TELEMETRY_BATCH_SIZE, popped, ring->overruns);
+
+    free(ring);
+    return ESP_OK;
+}
+
+typedef struct {
+    decim_fir_kernel_t kernel;
+    decim_fir_t fir;
+    decim_cic_t cic;
+    int16_t tone[BENCH_DECIM_SAMPLES];
+} bench_decim_t;
+
+static esp_err_t bench_decim(mpu6050_dev_t *dev) {
+    (void)dev;
+    bench_decim_t *b = malloc(sizeof(bench_decim_t));
+    if (b == NULL) { return ESP_ERR_NO_MEM; }
+
+    // A tone above the output Nyquist frequency: everything that comes out of the decimator is aliasing
+    for (int i = 0; i < BENCH_DECIM_SAMPLES; i++) {
+        b->tone[i] = (int16_t)(BENCH_DECIM_AMPLITUDE * sinf(2.0f * (float)M_PI * BENCH_DECIM_TONE_HZ * i / BENCH_DECIM_RATE_HZ));
+    }
+
+    decim_fir_design(&b->kernel, BENCH_DECIM_FACTOR);
+    decim_fir_reset(&b->fir);
+    decim_cic_reset(&b->cic, BENCH_DECIM_FACTOR);
+
+    int16_t in[DECIM_AXES], out[DECIM_AXES];
+    uint32_t fir_cycles = 0, cic_cycles = 0;
+    int32_t fir_peak = 0, cic_peak = 0;
+
+    for (int i = 0; i < BENCH_DECIM_SAMPLES; i++) {
+        in[0] = in[1] = in[2] = b->tone[i];
+
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        bool ready = decim_fir_push(&b->fir, &b->kernel, in, out);
+        fir_cycles += esp_cpu_get_cycle_count() - start;
+
+        // Skip the filter start-up transient
+        if (ready && i >= b->kernel.taps && abs(out[0]) > fir_peak) { fir_peak = abs(out[0]); }
+
+        start = esp_cpu_get_cycle_count();
+        ready = decim_cic_push(&b->cic, in, out);
+        cic_cycles += esp_cpu_get_cycle_count() - start;
+
+        if (ready && i >= DECIM_CIC_ORDER * BENCH_DECIM_FACTOR && abs(out[0]) > cic_peak) { cic_peak = abs(out[0]); }
+    }
+
+    ESP_LOGI("Bench", "decim fir: %" PRIu32 " cycles/sample (%d taps, %d axes)",
+             fir_cycles / BENCH_DECIM_SAMPLES, b->kernel.taps, DECIM_AXES);
+    ESP_LOGI("Bench", "decim cic: %" PRIu32 " cycles/sample (order %d, %d axes)",
+             cic_cycles / BENCH_DECIM_SAMPLES, DECIM_CIC_ORDER, DECIM_AXES);
+    ESP_LOGI("Bench", "decim %d Hz alias at /%d: off=%d fir=%" PRId32 " cic=%" PRId32 " (peak counts)",
+             BENCH_DECIM_TONE_HZ, BENCH_DECIM_FACTOR, BENCH_DECIM_AMPLITUDE, fir_peak, cic_peak);
+
+    free(b);
+    return ESP_OK;
+}
+
+static esp_err_t bench_capture(mpu6050_dev_t *dev) {
+    (void)dev;
+    event_capture_t *ec = calloc(1, sizeof(event_capture_t));
+    if (ec == NULL) { return ESP_ERR_NO_MEM; }
+
+    const int total = CAPTURE_WARMUP + BENCH_CAPTURE_QUIET + CAPTURE_POST_SAMPLES;
+    const int onset = CAPTURE_WARMUP + BENCH_CAPTURE_QUIET;
+    uint32_t armed_cycles = 0, triggered_cycles = 0;
+    int armed_n = 0, triggered_n = 0, frozen_at = -1;
+
+    event_capture_request(ec, CAPTURE_REQ_ARM);
+
+    // 1 g on Z with background noise, then a decaying burst on X
+    for (int i = 0; i < total && frozen_at < 0; i++) {
+        int16_t a[CAPTURE_AXES] = {
+            rand() % (2 * BENCH_CAPTURE_NOISE + 1) - BENCH_CAPTURE_NOISE,
+            rand() % (2 * BENCH_CAPTURE_NOISE + 1) - BENCH_CAPTURE_NOISE,
+            16384 + rand() % (2 * BENCH_CAPTURE_NOISE + 1) - BENCH_CAPTURE_NOISE,
+        };
+        if (i >= onset && i < onset + BENCH_CAPTURE_BURST) {
+            float decay = 1.0f - (float)(i - onset) / BENCH_CAPTURE_BURST;
+            a[0] += (int16_t)(BENCH_CAPTURE_AMPLITUDE * decay * sinf(0.3f * i));
+        }
+
+        bool armed = atomic_load_explicit(&ec->state, memory_order_relaxed) != CAPTURE_TRIGGERED;
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        bool frozen = event_capture_push(ec, a, 0, (int64_t)i * 1000);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+
+        if (armed) {
+            armed_cycles += cycles;
+            armed_n++;
+        } else {
+            triggered_cycles += cycles;
+            triggered_n++;
+        }
+        if (frozen) { frozen_at = i; }
+    }
+
+    if (frozen_at < 0) {
+        ESP_LOGW("Bench", "capture: synthetic event did not trigger");
+        free(ec);
+        return ESP_FAIL;
+    }
+
+    // The trigger sample is the first of the post-event window
+    int trigger_at = frozen_at - CAPTURE_POST_SAMPLES + 1;
+
+    int64_t start_us = esp_timer_get_time();
+    size_t bytes = telemetry_emit_event(ec, BENCH_CAPTURE_DEV, 1000);
+    int64_t dump_us = esp_timer_get_time() - start_us;
+
+    ESP_LOGI("Bench", "capture armed:     %" PRIu32 " cycles/sample", armed_cycles / armed_n);
+    ESP_LOGI("Bench", "capture triggered: %" PRIu32 " cycles/sample", triggered_cycles / (triggered_n ? triggered_n : 1));
+    ESP_LOGI("Bench", "capture trigger delay: %d samples, duration=%u samples, peak STA/LTA=%.2f",
+             trigger_at - onset, ec->duration, ec->peak_ratio / (float)(1 << CAPTURE_RATIO_FRAC));
+    ESP_LOGI("Bench", "capture memory: %zu bytes (ring %zu = %d samples x %zu bytes)",
+             sizeof(event_capture_t), sizeof(ec->ring), CAPTURE_RING_SAMPLES, sizeof(capture_sample_t));
+    ESP_LOGI("Bench", "capture dump: %zu bytes in %" PRId64 " us (%" PRId64 " B/s, %zu payload bytes)",
+             bytes, dump_us, dump_us > 0 ? (int64_t)bytes * 1000000 / dump_us : 0,
+             (ec->pre + CAPTURE_POST_SAMPLES) * sizeof(capture_sample_t));
+
+    free(ec);
+    return ESP_OK;
+}
+
+static size_t bench_varint_size(uint16_t z) {
+    return z < (1 << 7) ? 1 : z < (1 << 14) ? 2 : 3;
+}
+
+static esp_err_t bench_codec(mpu6050_dev_t *dev) {
+    int16_t (*samples)[RAW_CODEC_CHANNELS] = malloc(BENCH_CODEC_SAMPLES * sizeof(*samples));
+    if (samples == NULL) { return ESP_ERR_NO_MEM; }
+
+    // Record at 1 kHz, busy waiting between reads (the tick is too coarse to pace this)
+    int64_t next = esp_timer_get_time();
+    for (int i = 0; i < BENCH_CODEC_SAMPLES; i++) {
+        mpu6050_raw_t raw;
+
+        while (esp_timer_get_time() < next) {}
+        next += BENCH_CODEC_PERIOD_US;
+
+        esp_err_t res = mpu6050_read_raw(dev, &raw);
+        if (res != ESP_OK) { free(samples); return res; }
+
+        samples[i][0] = raw.ax; samples[i][1] = raw.ay; samples[i][2] = raw.az;
+        samples[i][3] = raw.gx; samples[i][4] = raw.gy; samples[i][5] = raw.gz;
+    }
+
+    uint8_t block[RAW_CODEC_MAX_BYTES];
+    int16_t decoded[RAW_CODEC_BLOCK][RAW_CODEC_CHANNELS];
+    uint32_t encode_cycles = 0, decode_cycles = 0;
+    size_t coded = 0, varint = 0, verbatim = 0, mismatches = 0;
+
+    for (int i = 0; i < BENCH_CODEC_SAMPLES; i += RAW_CODEC_BLOCK) {
+        raw_codec_mode_t mode;
+
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        size_t len = raw_codec_encode(&samples[i], RAW_CODEC_BLOCK, block, &mode);
+        encode_cycles += esp_cpu_get_cycle_count() - start;
+
+        start = esp_cpu_get_cycle_count();
+        bool ok = raw_codec_decode(block, len, mode, decoded, RAW_CODEC_BLOCK);
+        decode_cycles += esp_cpu_get_cycle_count() - start;
+
+        if (!ok || memcmp(decoded, &samples[i], sizeof(decoded)) != 0) { mismatches++; }
+        if (mode == RAW_CODEC_VERBATIM) { verbatim++; }
+        coded += len;
+
+        // Same block structure with varint deltas instead of Rice codes
+        varint += RAW_CODEC_CHANNELS * 2;
+        for (int j = i + 1; j < i + RAW_CODEC_BLOCK; j++) {
+            for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+                int16_t d = samples[j][ch] - samples[j - 1][ch];
+                varint += bench_varint_size((uint16_t)(((uint16_t)d << 1) ^ (uint16_t)(d >> 15)));
+            }
+        }
+    }
+
+    const size_t blocks = BENCH_CODEC_SAMPLES / RAW_CODEC_BLOCK;
+    const size_t raw_bytes = BENCH_CODEC_SAMPLES * RAW_CODEC_CHANNELS * 2;
+    const size_t framing = blocks * (TELEMETRY_HEADER_SIZE + sizeof(telemetry_raw_header_t) + TELEMETRY_CRC_SIZE);
+
+    ESP_LOGI("Bench", "codec rice:   %zu -> %zu bytes, ratio %.2f (%.2f with framing, %.1f bytes/sample)",
+             raw_bytes, coded, (float)raw_bytes / coded, (float)raw_bytes / (coded + framing),
+             (float)(coded + framing) / BENCH_CODEC_SAMPLES);
+    ESP_LOGI("Bench", "codec varint: %zu -> %zu bytes, ratio %.2f", raw_bytes, varint, (float)raw_bytes / varint);
+    ESP_LOGI("Bench", "codec encode: %" PRIu32 " cycles/sample, decode: %" PRIu32 " cycles/sample",
+             encode_cycles / BENCH_CODEC_SAMPLES, decode_cycles / BENCH_CODEC_SAMPLES);
+    ESP_LOGI("Bench", "codec blocks=%zu verbatim=%zu mismatches=%zu", blocks, verbatim, mismatches);
+
+    free(samples);
+    return mismatches == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bench_attitude(mpu6050_dev_t *dev) {
+    mpu6050_raw_t *samples = malloc(BENCH_ATTITUDE_SAMPLES * sizeof(mpu6050_raw_t));
+    if (samples == NULL) { return ESP_ERR_NO_MEM; }
+
+    // Counts are read at the sensor's current range
+    const float accel_scale = mpu6050_accel_scale[dev->accel_range & 0x03];
+    const float gyro_scale = mpu6050_gyro_scale[dev->gyro_range & 0x03];
+
+    // Record the sensor at rest, its means are the calibration
+    mpu6050_cal_data_t cal = {.samples = BENCH_ATTITUDE_SAMPLES};
+    for (int i = 0; i < BENCH_ATTITUDE_SAMPLES; i++) {
+        esp_err_t res = mpu6050_read_raw(dev, &samples[i]);
+        if (res != ESP_OK) { free(samples); return res; }
+
+        cal.ax_bias += samples[i].ax * accel_scale;
+        cal.ay_bias += samples[i].ay * accel_scale;
+        cal.az_bias += samples[i].az * accel_scale;
+        cal.gx_bias += samples[i].gx * gyro_scale;
+        cal.gy_bias += samples[i].gy * gyro_scale;
+        cal.gz_bias += samples[i].gz * gyro_scale;
+    }
+    cal.ax_bias /= BENCH_ATTITUDE_SAMPLES;
+    cal.ay_bias /= BENCH_ATTITUDE_SAMPLES;
+    cal.az_bias /= BENCH_ATTITUDE_SAMPLES;
+    cal.gx_bias /= BENCH_ATTITUDE_SAMPLES;
+    cal.gy_bias /= BENCH_ATTITUDE_SAMPLES;
+    cal.gz_bias /= BENCH_ATTITUDE_SAMPLES;
+
+    // Tilt the recording about Y by a raised cosine ramp, with the matching gyro rate:
+    // the true motion stays zero, everything the integrators see is gravity leaking in
+    const float dt = BENCH_MOTION_DT_US / 1e6f;
+    const float tilt = BENCH_ATTITUDE_TILT_DEG * ATTITUDE_DEG_TO_RAD;
+    for (int i = 0; i < BENCH_ATTITUDE_SAMPLES; i++) {
+        float r = i < BENCH_ATTITUDE_RAMP ? (float)i / BENCH_ATTITUDE_RAMP : 1.0f;
+        float theta = 0.5f * tilt * (1.0f - cosf((float)M_PI * r));
+        float rate = i < BENCH_ATTITUDE_RAMP ? 0.5f * tilt * (float)M_PI * sinf((float)M_PI * r) / (BENCH_ATTITUDE_RAMP * dt) : 0.0f;
+        float c = cosf(theta), sn = sinf(theta);
+        float fx = samples[i].ax, fz = samples[i].az;
+
+        samples[i].ax = (int16_t)lroundf(c * fx - sn * fz);
+        samples[i].az = (int16_t)lroundf(sn * fx + c * fz);
+        samples[i].gy += (int16_t)lroundf(rate / ATTITUDE_DEG_TO_RAD / gyro_scale);
+    }
+
+    const float noise_floor = 0.1f;
+    const mpu6050_cal_data_t no_bias = {0};
+
+    // Timed runs: the plain float path, the filter alone, the tilt compensated float path
+    motion_state_t plain = {0};
+    motion_hold_t plain_hold = {0};
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_ATTITUDE_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        process_accel_data(data, cal, noise_floor, dt, &plain, &plain_hold);
+    }
+    uint32_t plain_cycles = esp_cpu_get_cycle_count() - start;
+
+    attitude_t att;
+    attitude_init(&att, &cal);
+    uint32_t filter_cycles = 0;
+    for (int i = 0; i < BENCH_ATTITUDE_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        start = esp_cpu_get_cycle_count();
+        attitude_update(&att, &data, dt);
+        attitude_level(&att, &data.ax, &data.ay, &data.az);
+        filter_cycles += esp_cpu_get_cycle_count() - start;
+    }
+
+    motion_state_t level = {0};
+    motion_hold_t level_hold = {0};
+    attitude_init(&att, &cal);
+    start = esp_cpu_get_cycle_count();
+    for (int i = 0; i < BENCH_ATTITUDE_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        attitude_update(&att, &data, dt);
+        attitude_level(&att, &data.ax, &data.ay, &data.az);
+        process_accel_data(data, no_bias, noise_floor, dt, &level, &level_hold);
+    }
+    uint32_t level_cycles = esp_cpu_get_cycle_count() - start;
+
+    uint32_t budget = esp_rom_get_cpu_ticks_per_us() * BENCH_MOTION_DT_US;
+    ESP_LOGI("Bench", "attitude filter: %" PRIu32 " cycles/sample (update + level)", filter_cycles / BENCH_ATTITUDE_SAMPLES);
+    ESP_LOGI("Bench", "attitude float path: %" PRIu32 " cycles/sample plain, %" PRIu32 " with tilt compensation (%.1f%% of a %d us sample period)",
+             plain_cycles / BENCH_ATTITUDE_SAMPLES, level_cycles / BENCH_ATTITUDE_SAMPLES,
+             100.0f * level_cycles / BENCH_ATTITUDE_SAMPLES / budget, BENCH_MOTION_DT_US);
+    ESP_LOGI("Bench", "attitude %.1f deg tilt at rest: plain |v|=%.3f m/s |d|=%.3f m, compensated |v|=%.3f m/s |d|=%.3f m (estimate %.2f deg)",
+             BENCH_ATTITUDE_TILT_DEG,
+             sqrtf(plain.vx * plain.vx + plain.vy * plain.vy + plain.vz * plain.vz),
+             sqrtf(plain.dx * plain.dx + plain.dy * plain.dy + plain.dz * plain.dz),
+             sqrtf(level.vx * level.vx + level.vy * level.vy + level.vz * level.vz),
+             sqrtf(level.dx * level.dx + level.dy * level.dy + level.dz * level.dz),
+             attitude_tilt_deg(&att));
+
+    free(samples);
+    return ESP_OK;
+}
+
+static esp_err_t bench_kalman(mpu6050_dev_t *dev) {
+    mpu6050_raw_t *samples = malloc(BENCH_KALMAN_SAMPLES * sizeof(mpu6050_raw_t));
+    if (samples == NULL) { return ESP_ERR_NO_MEM; }
+
+    // Counts are read at the sensor's current range
+    const float accel_scale = mpu6050_accel_scale[dev->accel_range & 0x03];
+
+    // Record the sensor at rest, its means are the calibration
+    mpu6050_cal_data_t cal = {.samples = BENCH_KALMAN_SAMPLES};
+    for (int i = 0; i < BENCH_KALMAN_SAMPLES; i++) {
+        esp_err_t res = mpu6050_read_raw(dev, &samples[i]);
+        if (res != ESP_OK) { free(samples); return res; }
+
+        cal.ax_bias += samples[i].ax * accel_scale;
+        cal.ay_bias += samples[i].ay * accel_scale;
+        cal.az_bias += samples[i].az * accel_scale;
+    }
+    cal.ax_bias /= BENCH_KALMAN_SAMPLES;
+    cal.ay_bias /= BENCH_KALMAN_SAMPLES;
+    cal.az_bias /= BENCH_KALMAN_SAMPLES;
+
+    // Raised cosine displacement on X between two rests: the true motion ends where it started
+    const int n_motion = BENCH_KALMAN_SAMPLES - 2 * BENCH_KALMAN_REST;
+    const float w = 2.0f * (float)M_PI / n_motion;
+    for (int i = 0; i < n_motion; i++) {
+        float a = 0.5f * BENCH_KALMAN_DISP * w * w * cosf(w * i) / (BENCH_MOTION_DT_US * BENCH_MOTION_DT_US / 1e12f);
+        samples[BENCH_KALMAN_REST + i].ax += (int16_t)lroundf(a / accel_scale);
+    }
+
+    const float noise_floor = 0.1f;
+    const float dt = BENCH_MOTION_DT_US / 1e6f;
+
+    int64_t solve_us = esp_timer_get_time();
+    kalman_params_t params;
+    kalman_params_init(&params, BENCH_MOTION_DT_US);
+    solve_us = esp_timer_get_time() - solve_us;
+
+    // Timed runs, keeping the largest deviation from the true displacement on X
+    motion_state_t hold_state = {0};
+    motion_hold_t hold = {0};
+    float hold_err = 0.0f;
+    uint32_t hold_cycles = 0;
+    for (int i = 0; i < BENCH_KALMAN_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        process_accel_data(data, cal, noise_floor, dt, &hold_state, &hold);
+        hold_cycles += esp_cpu_get_cycle_count() - start;
+
+        int k = i - BENCH_KALMAN_REST;
+        float truth = (k >= 0 && k < n_motion) ? 0.5f * BENCH_KALMAN_DISP * (1.0f - cosf(w * (k + 1))) : 0.0f;
+        hold_err = fmaxf(hold_err, fabsf(hold_state.dx - truth));
+    }
+
+    motion_state_t kf_state = {0};
+    kalman_state_t kf;
+    kalman_init(&kf, &cal);
+    float kf_err = 0.0f;
+    uint32_t kf_cycles = 0;
+    for (int i = 0; i < BENCH_KALMAN_SAMPLES; i++) {
+        mpu6050_data_t data;
+        mpu6050_raw_to_data(&samples[i], &data);
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        kalman_update(&params, &data, dt, &kf, &kf_state);
+        kf_cycles += esp_cpu_get_cycle_count() - start;
+
+        int k = i - BENCH_KALMAN_REST;
+        float truth = (k >= 0 && k < n_motion) ? 0.5f * BENCH_KALMAN_DISP * (1.0f - cosf(w * (k + 1))) : 0.0f;
+        kf_err = fmaxf(kf_err, fabsf(kf_state.dx - truth));
+    }
+
+    ESP_LOGI("Bench", "kalman gains for %d us: d=%.6f v=%.6f b=%.6f, %" PRIu32 " Riccati iterations in %" PRId64 " ms",
+             BENCH_MOTION_DT_US, params.kd, params.kv, params.kb, params.iterations, solve_us / 1000);
+    ESP_LOGI("Bench", "kalman cycles/sample: hold %" PRIu32 ", kalman %" PRIu32, hold_cycles / BENCH_KALMAN_SAMPLES,
+             kf_cycles / BENCH_KALMAN_SAMPLES);
+    ESP_LOGI("Bench", "kalman %.0f mm pulse on X: hold final dx=%.2f mm max error %.2f mm, kalman final dx=%.2f mm max error %.2f mm",
+             BENCH_KALMAN_DISP * 1e3f, hold_state.dx * 1e3f, hold_err * 1e3f, kf_state.dx * 1e3f, kf_err * 1e3f);
+    ESP_LOGI("Bench", "kalman final |v|: hold %.2f mm/s, kalman %.2f mm/s (%" PRIu32 " zero-velocity updates)",
+             1e3f * sqrtf(hold_state.vx * hold_state.vx + hold_state.vy * hold_state.vy + hold_state.vz * hold_state.vz),
+             1e3f * sqrtf(kf_state.vx * kf_state.vx + kf_state.vy * kf_state.vy + kf_state.vz * kf_state.vz), kf.updates);
+
+    free(samples);
+    return ESP_OK;
+}
+
+/**
+ * @brief Quantize an acceleration the way the sensor does at a range
+ *
+ * @param a              Acceleration (m/s²)
+ * @param range          Accelerometer range code
+ * @return int16_t       Counts, clipped at full scale
+ */
+static int16_t bench_quantize(float a, uint8_t range) {
+    float counts = roundf(a / mpu6050_accel_scale[range]);
+
+    return counts > INT16_MAX ? INT16_MAX : counts < INT16_MIN ? INT16_MIN : (int16_t)counts;
+}
+
+static esp_err_t bench_autorange(mpu6050_dev_t *dev) {
+    (void)dev;
+    const float g = 9.80665f;
+    const float dt = BENCH_MOTION_DT_US / 1e6f;
+    autorange_t ar = {0};
+    uint32_t fixed_clipped = 0, auto_clipped = 0, cycles = 0;
+    float fixed_err = 0.0f, auto_err = 0.0f;
+
+    autorange_reset(&ar, 0, 0);
+
+    // A decaying BENCH_AUTORANGE_HZ burst on X on top of gravity on Z, switches applied between samples
+    for (int i = 0; i < BENCH_AUTORANGE_SAMPLES; i++) {
+        float t = i * dt;
+        float ax = BENCH_AUTORANGE_PEAK_G * g * expf(-t / BENCH_AUTORANGE_DECAY_S) * sinf(2.0f * (float)M_PI * BENCH_AUTORANGE_HZ * t);
+        mpu6050_raw_t fixed = {.ax = bench_quantize(ax, 0), .az = bench_quantize(g, 0)};
+        mpu6050_raw_t raw = {.ax = bench_quantize(ax, ar.accel_range), .az = bench_quantize(g, ar.accel_range),
+                             .accel_range = ar.accel_range};
+        mpu6050_data_t data;
+
+        if (abs(fixed.ax) >= INT16_MAX) { fixed_clipped++; }
+        if (abs(raw.ax) >= INT16_MAX) { auto_clipped++; }
+
+        mpu6050_raw_to_data(&fixed, &data);
+        fixed_err = fmaxf(fixed_err, fabsf(data.ax - ax));
+        mpu6050_raw_to_data(&raw, &data);
+        auto_err = fmaxf(auto_err, fabsf(data.ax - ax));
+
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        autorange_update(&ar, &raw, 0, 0, dt);
+        cycles += esp_cpu_get_cycle_count() - start;
+        if (ar.accel_range != raw.accel_range) { ar.switches++; }
+    }
+
+    ESP_LOGI("Bench", "autorange cycles/sample: %" PRIu32 " (%.2f%% of the 1 kHz period)", cycles / BENCH_AUTORANGE_SAMPLES,
+             100.0f * cycles / BENCH_AUTORANGE_SAMPLES / (BENCH_MOTION_DT_US * esp_rom_get_cpu_ticks_per_us()));
+    ESP_LOGI("Bench", "autorange %.1f g burst: fixed +-2g clipped=%" PRIu32 " max error %.3f m/s2, auto-ranged clipped=%" PRIu32 " max error %.3f m/s2 (%" PRIu32 " switches, ends at +-%dg)",
+             BENCH_AUTORANGE_PEAK_G, fixed_clipped, fixed_err, auto_clipped, auto_err, ar.switches, 2 << ar.accel_range);
+
+    return ESP_OK;
+}
+
+static const bench_entry_t benches[] = {
+    {"i2c", bench_i2c},
+    {"motion", bench_motion},
+    {"ring", bench_ring},
+    {"decim", bench_decim},
+    {"capture", bench_capture},
+    {"codec", bench_codec},
+    {"attitude", bench_attitude},
+    {"kalman", bench_kalman},
+    {"autorange", bench_autorange},
+};
+
+esp_err_t bench_run(const char *name, mpu6050_dev_t *dev) {
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        if (strcmp(name, benches[i].name) == 0) {
+            return benches[i].run(dev);
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
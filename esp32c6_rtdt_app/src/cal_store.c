@@ -0,0 +1,87 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "cal_store.h"
+
+/**
+ * @brief Calibration record as stored in NVS (one blob per sensor)
+ */
+typedef struct {
+    uint8_t version;                // CAL_STORE_VERSION
+    uint8_t addr;                   // Sensor I2C address
+    uint8_t accel_range;            // Configuration the biases were measured with
+    uint8_t gyro_range;
+    uint8_t dlpf_cfg;
+    mpu6050_cal_data_t cal;
+} cal_record_t;
+
+static void cal_store_key(uint8_t addr, char *key, size_t len) {
+    snprintf(key, len, "cal_%02x", addr);
+}
+
+esp_err_t cal_store_init(void) {
+    esp_err_t res = nvs_flash_init();
+
+    if (res == ESP_ERR_NVS_NO_FREE_PAGES || res == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        res = nvs_flash_erase();
+        if (res != ESP_OK) { return res; }
+        res = nvs_flash_init();
+    }
+
+    return res;
+}
+
+esp_err_t cal_store_load(uint8_t addr, const mpu6050_config_t *cfg, float temp, mpu6050_cal_data_t *cal) {
+    nvs_handle_t handle;
+    cal_record_t record;
+    size_t len = sizeof(record);
+    char key[NVS_KEY_NAME_MAX_SIZE];
+
+    esp_err_t res = nvs_open(CAL_STORE_NAMESPACE, NVS_READONLY, &handle);
+    if (res == ESP_ERR_NVS_NOT_FOUND) { return ESP_ERR_NOT_FOUND; }
+    if (res != ESP_OK) { return res; }
+
+    cal_store_key(addr, key, sizeof(key));
+    res = nvs_get_blob(handle, key, &record, &len);
+    nvs_close(handle);
+
+    if (res == ESP_ERR_NVS_NOT_FOUND) { return ESP_ERR_NOT_FOUND; }
+    if (res != ESP_OK) { return res; }
+
+    // Biases only hold for the configuration and temperature they were measured at
+    if (len != sizeof(record) || record.version != CAL_STORE_VERSION || record.addr != addr ||
+        record.accel_range != cfg->accel_range || record.gyro_range != cfg->gyro_range ||
+        record.dlpf_cfg != cfg->dlpf_cfg || fabsf(temp - record.cal.temp) > CAL_STORE_MAX_TEMP_DELTA) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *cal = record.cal;
+
+    return ESP_OK;
+}
+
+esp_err_t cal_store_save(uint8_t addr, const mpu6050_config_t *cfg, const mpu6050_cal_data_t *cal) {
+    nvs_handle_t handle;
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    cal_record_t record = {
+        .version     = CAL_STORE_VERSION,
+        .addr        = addr,
+        .accel_range = cfg->accel_range,
+        .gyro_range  = cfg->gyro_range,
+        .dlpf_cfg    = cfg->dlpf_cfg,
+        .cal         = *cal,
+    };
+
+    esp_err_t res = nvs_open(CAL_STORE_NAMESPACE, NVS_READWRITE, &handle);
+    if (res != ESP_OK) { return res; }
+
+    cal_store_key(addr, key, sizeof(key));
+    res = nvs_set_blob(handle, key, &record, sizeof(record));
+    if (res == ESP_OK) { res = nvs_commit(handle); }
+    nvs_close(handle);
+
+    return res;
+}
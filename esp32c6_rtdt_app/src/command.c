@@ -0,0 +1,47 @@
+#include <string.h>
+
+#include "command.h"
+
+bool line_reader_push(line_reader_t *reader, char c) {
+    if (c == '\r' || c == '\n') {
+        bool complete = !reader->discard && reader->len > 0;
+
+        reader->buf[reader->len] = '\0';
+        reader->len = 0;
+        reader->discard = false;
+
+        return complete;
+    }
+
+    if (reader->discard) { return false; }
+
+    // Keep room for the terminator
+    if (reader->len + 1 >= CMD_BUF_SIZE) {
+        reader->discard = true;
+        reader->len = 0;
+        reader->overflows++;
+        return false;
+    }
+
+    reader->buf[reader->len++] = c;
+
+    return false;
+}
+
+esp_err_t command_dispatch(const command_t *table, size_t n, void *ctx, char *line) {
+    const char *arg = "";
+
+    char *sep = strchr(line, CMD_ARG_SEPARATOR);
+    if (sep != NULL) {
+        *sep = '\0';
+        arg = sep + 1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(line, table[i].name) == 0) {
+            return table[i].handler(ctx, arg);
+        }
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,31 @@
+#include <stdatomic.h>
+
+#include "freertos/queue.h"
+
+#include "config_store.h"
+
+static QueueHandle_t config_mailbox;
+static _Atomic uint32_t config_version;
+
+esp_err_t config_store_init(task_config_t *initial) {
+    config_mailbox = xQueueCreate(1, sizeof(task_config_t));
+    if (config_mailbox == NULL) { return ESP_ERR_NO_MEM; }
+
+    config_store_publish(initial);
+
+    return ESP_OK;
+}
+
+void config_store_publish(task_config_t *config) {
+    config->version = atomic_load_explicit(&config_version, memory_order_relaxed) + 1;
+
+    // The snapshot is in the mailbox before its version becomes visible
+    xQueueOverwrite(config_mailbox, config);
+    atomic_store_explicit(&config_version, config->version, memory_order_release);
+}
+
+bool config_store_fetch(task_config_t *config) {
+    if (atomic_load_explicit(&config_version, memory_order_acquire) == config->version) { return false; }
+
+    return xQueuePeek(config_mailbox, config, 0) == pdTRUE;
+}
@@ -0,0 +1,152 @@
+#include <math.h>
+#include <string.h>
+
+#include "decimator.h"
+
+static float decim_fir_tap(uint16_t i, uint16_t taps, float fc) {
+    if (taps == 1) { return 1.0f; }
+
+    // Windowed sinc with a Hamming window
+    float x = i - (taps - 1) / 2.0f;
+    float sinc = (x == 0.0f) ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * x) / ((float)M_PI * x);
+    float window = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (taps - 1));
+
+    return sinc * window;
+}
+
+void decim_fir_design(decim_fir_kernel_t *kernel, uint16_t factor) {
+    if (factor < 1) { factor = 1; }
+    if (factor > DECIM_MAX_FACTOR) { factor = DECIM_MAX_FACTOR; }
+
+    kernel->factor = factor;
+    kernel->taps = DECIM_FIR_TAPS_PER_PHASE * factor;
+
+    // Cutoff at the output Nyquist frequency (cycles/sample)
+    float fc = 0.5f / factor;
+    float sum = 0.0f;
+
+    // Taps are evaluated twice rather than buffered, this runs on small task stacks
+    for (uint16_t i = 0; i < kernel->taps; i++) {
+        sum += decim_fir_tap(i, kernel->taps, fc);
+    }
+
+    // Quantize to Q1.15 normalized to unity DC gain, rounding error goes to the center tap
+    int32_t total = 0;
+    for (uint16_t i = 0; i < kernel->taps; i++) {
+        kernel->coef[i] = (int16_t)lroundf(decim_fir_tap(i, kernel->taps, fc) / sum * (1 << DECIM_FIR_COEF_FRAC));
+        total += kernel->coef[i];
+    }
+    kernel->coef[kernel->taps / 2] += (int16_t)((1 << DECIM_FIR_COEF_FRAC) - total);
+}
+
+uint16_t decim_fir_split(uint32_t factor, uint32_t *pre) {
+    *pre = 1;
+    if (factor <= DECIM_MAX_FACTOR) { return factor < 1 ? 1 : (uint16_t)factor; }
+
+    uint32_t first = (factor + DECIM_MAX_FACTOR - 1) / DECIM_MAX_FACTOR;
+    uint32_t best_error = UINT32_MAX;
+    uint16_t fir = DECIM_MAX_FACTOR;
+
+    // Below twice the smallest pre-stage the FIR factor stays above DECIM_MAX_FACTOR / 3
+    for (uint32_t p = first; p < 2 * first && p <= DECIM_CIC_MAX_FACTOR; p++) {
+        uint32_t f = (factor + p / 2) / p;
+        if (f > DECIM_MAX_FACTOR) { continue; }
+
+        uint32_t error = p * f > factor ? p * f - factor : factor - p * f;
+        if (error < best_error) {
+            best_error = error;
+            *pre = p;
+            fir = (uint16_t)f;
+        }
+        if (error == 0) { break; }
+    }
+
+    if (best_error == UINT32_MAX) { *pre = DECIM_CIC_MAX_FACTOR; }
+
+    return fir;
+}
+
+void decim_fir_reset(decim_fir_t *fir) {
+    memset(fir, 0, sizeof(*fir));
+}
+
+void decim_fir_rescale(decim_fir_t *fir, int shift) {
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        for (int i = 0; i < 2 * DECIM_FIR_MAX_TAPS; i++) {
+            int32_t v = fir->hist[axis][i];
+            v = shift >= 0 ? v >> shift : v * (1 << -shift);
+            fir->hist[axis][i] = v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+        }
+    }
+}
+
+bool decim_fir_push(decim_fir_t *fir, const decim_fir_kernel_t *kernel, const int16_t in[DECIM_AXES], int16_t out[DECIM_AXES]) {
+    uint16_t taps = kernel->taps;
+
+    // Store the input twice so hist[pos + 1 .. pos + taps] is the whole window, oldest first
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        fir->hist[axis][fir->pos] = in[axis];
+        fir->hist[axis][fir->pos + taps] = in[axis];
+    }
+    uint16_t oldest = fir->pos + 1;
+    fir->pos = (fir->pos + 1 == taps) ? 0 : fir->pos + 1;
+
+    // Polyphase: the filter output is only computed for the samples that are kept
+    if (++fir->phase < kernel->factor) { return false; }
+    fir->phase = 0;
+
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        const int16_t *x = &fir->hist[axis][oldest];
+        int32_t acc = 0;
+
+        // |sum of coefficients| stays well below 2, so Q1.15 * int16 fits in 32 bits
+        for (uint16_t i = 0; i < taps; i++) {
+            acc += (int32_t)kernel->coef[i] * x[i];
+        }
+
+        acc = (acc + (1 << (DECIM_FIR_COEF_FRAC - 1))) >> DECIM_FIR_COEF_FRAC;
+        out[axis] = (int16_t)(acc > INT16_MAX ? INT16_MAX : acc < INT16_MIN ? INT16_MIN : acc);
+    }
+
+    return true;
+}
+
+void decim_cic_reset(decim_cic_t *cic, uint32_t factor) {
+    if (factor < 1) { factor = 1; }
+    if (factor > DECIM_CIC_MAX_FACTOR) { factor = DECIM_CIC_MAX_FACTOR; }
+
+    memset(cic, 0, sizeof(*cic));
+    cic->factor = factor;
+    cic->gain = 1;
+    for (int stage = 0; stage < DECIM_CIC_ORDER; stage++) {
+        cic->gain *= factor;
+    }
+}
+
+bool decim_cic_push(decim_cic_t *cic, const int16_t in[DECIM_AXES], int16_t out[DECIM_AXES]) {
+    // Integrators run at the input rate
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        uint64_t acc = (uint64_t)(int64_t)in[axis];
+        for (int stage = 0; stage < DECIM_CIC_ORDER; stage++) {
+            cic->integ[axis][stage] += acc;
+            acc = cic->integ[axis][stage];
+        }
+    }
+
+    if (++cic->phase < cic->factor) { return false; }
+    cic->phase = 0;
+
+    // Combs run at the output rate
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        uint64_t acc = cic->integ[axis][DECIM_CIC_ORDER - 1];
+        for (int stage = 0; stage < DECIM_CIC_ORDER; stage++) {
+            uint64_t prev = cic->comb[axis][stage];
+            cic->comb[axis][stage] = acc;
+            acc -= prev;
+        }
+
+        out[axis] = (int16_t)((int64_t)acc / cic->gain);
+    }
+
+    return true;
+}
@@ -0,0 +1,66 @@
+#include "drdy.h"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+static volatile int64_t drdy_isr_time_us;
+
+void IRAM_ATTR drdy_isr_handler(void *arg) {
+    TaskHandle_t task = arg;
+    BaseType_t higher_prio_woken = pdFALSE;
+
+    // Stamp the sample at the moment the sensor latched it
+    drdy_isr_time_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(task, &higher_prio_woken);
+    portYIELD_FROM_ISR(higher_prio_woken);
+}
+
+static int64_t drdy_last_isr_time(void) {
+    int64_t t;
+
+    // The 64-bit stamp is not written atomically; re-read until stable
+    do {
+        t = drdy_isr_time_us;
+    } while (t != drdy_isr_time_us);
+
+    return t;
+}
+
+bool drdy_wait(drdy_timing_t *timing, uint32_t timeout_ms, int64_t *isr_us) {
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms)) == 0) {
+        timing->last_isr_us = 0;
+        return false;
+    }
+
+    *isr_us = drdy_last_isr_time();
+
+    return true;
+}
+
+void drdy_timing_reset(drdy_timing_t *timing, int64_t period_us) {
+    timing->period_us     = period_us;
+    timing->last_isr_us   = 0;
+    timing->samples       = 0;
+    timing->missed        = 0;
+    timing->jitter_max_us = 0;
+    timing->jitter_sum_us = 0;
+}
+
+int64_t drdy_timing_update(drdy_timing_t *timing, int64_t isr_us) {
+    int64_t interval = timing->last_isr_us ? isr_us - timing->last_isr_us : timing->period_us;
+    timing->last_isr_us = isr_us;
+    timing->samples++;
+
+    // Round to the nearest number of periods to detect skipped samples
+    int64_t periods = (interval + timing->period_us / 2) / timing->period_us;
+    if (periods > 1) {
+        timing->missed += periods - 1;
+    } else {
+        int64_t jitter = interval - timing->period_us;
+        if (jitter < 0) { jitter = -jitter; }
+        if (jitter > timing->jitter_max_us) { timing->jitter_max_us = jitter; }
+        timing->jitter_sum_us += jitter;
+    }
+
+    return interval;
+}
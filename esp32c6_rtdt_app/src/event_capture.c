@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_capture.h"
+
+static void event_capture_arm(event_capture_t *ec) {
+    ec->pos = 0;
+    ec->written = 0;
+    ec->sta = 0;
+    ec->lta = 0;
+    ec->warmup = CAPTURE_WARMUP;
+    ec->pre = 0;
+    ec->post_left = 0;
+    ec->duration = 0;
+    ec->peak_ratio = 0;
+    ec->trigger_t_us = 0;
+}
+
+void event_capture_request(event_capture_t *ec, capture_request_t request) {
+    atomic_store_explicit(&ec->request, request, memory_order_release);
+}
+
+static uint32_t event_capture_lta(const event_capture_t *ec) {
+    uint32_t lta = (uint32_t)(ec->lta >> CAPTURE_LTA_SHIFT);
+
+    return lta > CAPTURE_LTA_MIN ? lta : CAPTURE_LTA_MIN;
+}
+
+uint32_t event_capture_ratio(const event_capture_t *ec) {
+    return ((ec->sta >> CAPTURE_STA_SHIFT) << CAPTURE_RATIO_FRAC) / event_capture_lta(ec);
+}
+
+static int16_t event_capture_shift(int32_t counts, int shift) {
+    counts = shift >= 0 ? counts >> shift : counts * (1 << -shift);
+
+    return counts > INT16_MAX ? INT16_MAX : counts < INT16_MIN ? INT16_MIN : (int16_t)counts;
+}
+
+/**
+ * @brief Move the ring and the trigger state to counts of another range
+ *
+ * Only on range switches, which are rare next to the sample rate, so the
+ * whole ring is walked rather than tagging samples with their range.
+ *
+ * @param shift Range codes coarser (positive) or finer (negative)
+ */
+static void event_capture_rescale(event_capture_t *ec, int shift) {
+    for (uint16_t i = 0; i < ec->written; i++) {
+        capture_sample_t *s = &ec->ring[i];
+        *s = (capture_sample_t){event_capture_shift(s->ax, shift), event_capture_shift(s->ay, shift),
+                                event_capture_shift(s->az, shift)};
+    }
+
+    // Coarser halves, finer doubles: the ratios stay where they were
+    for (int axis = 0; axis < CAPTURE_AXES; axis++) {
+        ec->dc[axis] = shift >= 0 ? ec->dc[axis] >> shift : ec->dc[axis] * (1 << -shift);
+    }
+    ec->sta = shift >= 0 ? ec->sta >> shift : ec->sta << -shift;
+    ec->lta = shift >= 0 ? ec->lta >> shift : ec->lta << -shift;
+    ec->range = (uint8_t)(ec->range + shift);
+    ec->finer = 0;
+}
+
+bool event_capture_push(event_capture_t *ec, const int16_t in[CAPTURE_AXES], uint8_t range, int64_t t_us) {
+    capture_request_t request = atomic_exchange_explicit(&ec->request, CAPTURE_REQ_NONE, memory_order_acquire);
+    if (request == CAPTURE_REQ_ARM) {
+        event_capture_arm(ec);
+        atomic_store_explicit(&ec->state, CAPTURE_ARMED, memory_order_relaxed);
+    } else if (request == CAPTURE_REQ_DISARM) {
+        atomic_store_explicit(&ec->state, CAPTURE_IDLE, memory_order_relaxed);
+    }
+
+    capture_state_t state = atomic_load_explicit(&ec->state, memory_order_relaxed);
+    if (state != CAPTURE_ARMED && state != CAPTURE_TRIGGERED) { return false; }
+
+    // The window starts at the first sample's range and widens with the samples, it only
+    // narrows while armed and once the whole ring fits the finer range
+    if (ec->written == 0) {
+        ec->range = range;
+        ec->finer = 0;
+    } else if (range > ec->range) {
+        event_capture_rescale(ec, range - ec->range);
+    } else if (range == ec->range) {
+        ec->finer = 0;
+    } else if (++ec->finer >= CAPTURE_RING_SAMPLES && state == CAPTURE_ARMED) {
+        event_capture_rescale(ec, -1);
+    }
+
+    int shift = ec->range - range;
+    const int16_t a[CAPTURE_AXES] = {(int16_t)(in[0] >> shift), (int16_t)(in[1] >> shift), (int16_t)(in[2] >> shift)};
+
+    // Start the mean at the first sample, a gravity step would otherwise dominate the LTA
+    if (ec->written == 0) {
+        for (int axis = 0; axis < CAPTURE_AXES; axis++) {
+            ec->dc[axis] = (int32_t)a[axis] << CAPTURE_DC_SHIFT;
+        }
+    }
+
+    ec->ring[ec->pos] = (capture_sample_t){a[0], a[1], a[2]};
+    ec->pos = (ec->pos + 1 == CAPTURE_RING_SAMPLES) ? 0 : ec->pos + 1;
+    if (ec->written < CAPTURE_RING_SAMPLES) { ec->written++; }
+
+    // Characteristic function: L1 distance from the running mean, |deviation| < 2^26 before
+    // scaling to Q4, so cf < 2^22
+    uint32_t cf = 0;
+    for (int axis = 0; axis < CAPTURE_AXES; axis++) {
+        int32_t x = (int32_t)a[axis] << CAPTURE_DC_SHIFT;
+        int32_t dev = x - ec->dc[axis];
+        ec->dc[axis] += a[axis] - (ec->dc[axis] >> CAPTURE_DC_SHIFT);
+        cf += (uint32_t)abs(dev) >> (CAPTURE_DC_SHIFT - CAPTURE_CF_FRAC);
+    }
+
+    ec->sta += cf - (ec->sta >> CAPTURE_STA_SHIFT);
+
+    // Ratios compared without dividing: sta < 2^22 and the ratios are below 2^8 (Q4), so both
+    // sides fit in 32 bits
+    uint32_t sta_q = (ec->sta >> CAPTURE_STA_SHIFT) << CAPTURE_RATIO_FRAC;
+    uint32_t lta = event_capture_lta(ec);
+
+    if (state == CAPTURE_ARMED) {
+        ec->lta += cf - (ec->lta >> CAPTURE_LTA_SHIFT);
+
+        if (ec->warmup > 0) {
+            ec->warmup--;
+            return false;
+        }
+
+        if (sta_q > CAPTURE_TRIGGER_ON * lta) {
+            ec->pre = ec->written - 1 < CAPTURE_PRE_SAMPLES ? ec->written - 1 : CAPTURE_PRE_SAMPLES;
+            ec->post_left = CAPTURE_POST_SAMPLES;
+            ec->trigger_t_us = t_us;
+            ec->peak_ratio = 0;
+            atomic_store_explicit(&ec->state, CAPTURE_TRIGGERED, memory_order_relaxed);
+        } else {
+            return false;
+        }
+    }
+
+    // Triggered: the LTA is held so the event does not raise its own threshold
+    uint32_t ratio = sta_q / lta;
+    if (ratio > ec->peak_ratio) { ec->peak_ratio = ratio > UINT16_MAX ? UINT16_MAX : ratio; }
+
+    uint16_t elapsed = CAPTURE_POST_SAMPLES - ec->post_left;
+    if (ec->duration == 0 && elapsed > 0 && sta_q < CAPTURE_TRIGGER_OFF * lta) {
+        ec->duration = elapsed;
+    }
+
+    if (--ec->post_left > 0) { return false; }
+
+    ec->events++;
+    atomic_store_explicit(&ec->state, CAPTURE_FROZEN, memory_order_release);
+
+    return true;
+}
+
+uint16_t event_capture_read(const event_capture_t *ec, uint16_t offset, capture_sample_t *out, uint16_t n) {
+    if (atomic_load_explicit(&ec->state, memory_order_acquire) != CAPTURE_FROZEN) { return 0; }
+
+    // The window ends with the newest sample, pos is one past it
+    uint16_t length = ec->pre + CAPTURE_POST_SAMPLES;
+    if (offset >= length) { return 0; }
+    if (n > length - offset) { n = length - offset; }
+
+    uint16_t slot = (ec->pos + CAPTURE_RING_SAMPLES - length + offset) % CAPTURE_RING_SAMPLES;
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = ec->ring[slot];
+        slot = (slot + 1 == CAPTURE_RING_SAMPLES) ? 0 : slot + 1;
+    }
+
+    return n;
+}
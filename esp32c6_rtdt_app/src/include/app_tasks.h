@@ -11,65 +11,292 @@
 #include "esp_timer.h"
 #include "esp_system.h"
 #include "esp_err.h"
-#include "driver/i2c.h" 
+#include "driver/i2c_master.h"
 
 #include "mpu6050.h"
-
-#define CMD_BUF_SIZE                128
+#include "motion.h"
+#include "decimator.h"
+#include "stats.h"
+#include "attitude.h"
+#include "kalman.h"
+#include "autorange.h"
+#include "standby.h"
+#include "drdy.h"
 
 #define I2C_MASTER_SDA_IO           19      // GPIO for Master I2C data line (SDA)
 #define I2C_MASTER_SCL_IO           20      // GPIO for Master I2C clock line (SCL)
+#define I2C_TRANS_QUEUE_DEPTH       4       // Queued asynchronous transfers per bus
+#define MPU6050_INT_IO              7       // GPIO connected to the MPU6050 INT (data ready) pin
+
+#define DRDY_TIMEOUT_MS             100     // Data-ready wait before the interrupt is considered lost
+#define READOUT_TIMEOUT_MS          5       // Wait for a queued sensor read before it is counted as an error
+#define IMU_MAX_CHANNELS            2       // Sensors on the bus: MPU6050_ADDR and MPU6050_ADDR_ALT
+
+#define CMD_RX_CHUNK                64      // Console bytes read per wake-up of the command listener
+#define TELEMETRY_IDLE_MS           100     // Telemetry task wake-up period when no sample is queued
+
+#define STATS_MAX_TASKS             16      // Tasks covered by the stack and CPU load report
+
+#define READOUT_TASK_PRIORITY       2       // accel_readout_task, below the command listener and the monitor
+#define CONTROL_TASK_PRIORITY       6       // accel_readout_task in control mode, above every other application task
+
+/**
+ * @brief Sensor acquisition modes
+ *
+ * ACQ_MODE_POLL:        One register read per update period
+ * ACQ_MODE_FIFO:        Every sensor sample is buffered in the MPU6050 FIFO and
+ *                       drained in a single burst read per update period
+ * ACQ_MODE_DRDY:        Every sensor sample is read when the MPU6050 raises its
+ *                       data-ready interrupt and is stamped at interrupt time
+ * ACQ_MODE_CONTROL:     Data-ready acquisition for a feedback controller: the
+ *                       readout runs at CONTROL_TASK_PRIORITY and writes the
+ *                       latest state as a state frame itself, once per control
+ *                       period (update_rate_ms in whole sensor samples)
+ */
+typedef enum {
+    ACQ_MODE_POLL = 0,
+    ACQ_MODE_FIFO,
+    ACQ_MODE_DRDY,
+    ACQ_MODE_CONTROL,
+} acq_mode_t;
+
+/**
+ * @brief Console output formats for the motion state
+ *
+ * OUTPUT_TEXT:          Three log lines per sample (Acceleration, Velocity, Displacement)
+ * OUTPUT_BINARY:        One CRC protected binary frame per sample (see telemetry.h)
+ * OUTPUT_RAW:           Raw accel + gyro counts of every sensor sample, losslessly
+ *                       compressed in blocks (see raw_codec.h)
+ */
+typedef enum {
+    OUTPUT_TEXT = 0,
+    OUTPUT_BINARY,
+    OUTPUT_RAW,
+} output_format_t;
+
+/**
+ * @brief Arithmetic used by the motion processing pipeline
+ *
+ * MATH_FLOAT:           Software floating point (process_accel_data)
+ * MATH_FIXED:           Integer fixed point on raw counts (process_accel_data_fx)
+ */
+typedef enum {
+    MATH_FLOAT = 0,
+    MATH_FIXED,
+} math_mode_t;
+
+/**
+ * @brief Drift control of the float motion path
+ *
+ * DRIFT_HOLD:           Noise floor and stillness hold (process_accel_data)
+ * DRIFT_KALMAN:         Steady-state Kalman estimator with zero-velocity
+ *                       updates while still (kalman_update)
+ */
+typedef enum {
+    DRIFT_HOLD = 0,
+    DRIFT_KALMAN,
+} drift_mode_t;
 
 /**
  * @brief Task configuration structure for FreeRTOS tasks
  *
  * update_rate_ms:       Period at which sensor data is updated (in milliseconds)
  * accel_noise_floor:    Threshold below which accelerometer data is considered noise
+ * acq_mode:             Sensor acquisition mode
+ * output:               Console output format
+ * math:                 Arithmetic used for processing
+ * decim:                Anti-alias decimation from the sensor rate to the update
+ *                       rate in the FIFO and data-ready modes
+ * tilt:                 Gyro-fused tilt compensation before integration
+ *                       (float math only, the fixed-point path ignores it)
+ * drift:                Drift control (float math only)
+ * autorange:            Switch the full-scale ranges with the signal, from the
+ *                       ranges in cfg up (not in FIFO mode)
+ * standby:              While stopped, wait for motion in low-power standby and
+ *                       acquire until the sensor is quiet again
+ * kalman:               Kalman gains for the sample period of this configuration,
+ *                       solved by the command listener
  * cfg:                  Configuration parameters for MPU6050
+ * version:              Snapshot version assigned by config_store_publish
+ * cmd_cycles:           CPU cycle count when the command that produced this
+ *                       snapshot was received (0 = not from a command)
  */
 typedef struct {
     uint32_t update_rate_ms;
     float accel_noise_floor;
     bool start;
+    acq_mode_t acq_mode;
+    output_format_t output;
+    math_mode_t math;
+    decim_mode_t decim;
+    bool tilt;
+    drift_mode_t drift;
+    bool autorange;
+    bool standby;
+    kalman_params_t kalman;
     mpu6050_config_t cfg;
+    uint32_t version;
+    uint32_t cmd_cycles;
 } task_config_t;
 
+/**
+ * @brief Per-sensor acquisition and processing context
+ *
+ * dev:                  Bus port and address of the sensor
+ * cal:                  Calibration biases
+ * fifo:                 FIFO state and burst buffer
+ * state, hold:          Float path motion state and stillness counters
+ * att:                  Gravity estimate of the tilt compensation
+ * kf:                   Bias estimate and stillness detector of the Kalman estimator
+ * ar:                   Auto-ranging state and switch statistics
+ * fx_state, fx_params:  Fixed-point path state and parameters
+ * fx_noise_floor:       Noise floor fx_params were computed for
+ * fx_accel_range:       Accelerometer range fx_params were computed for
+ * fir, cic:             Decimator state of the acceleration stream
+ * decim_out:            Latest decimated acceleration (raw counts)
+ * decim_ready:          decim_out holds an output not yet published
+ * last_time:            Timestamp of the previous sample (0 = none since start)
+ * seq:                  Next telemetry sequence number
+ * read_errors:          Number of failed sensor reads
+ */
+typedef struct {
+    mpu6050_dev_t dev;
+    mpu6050_cal_data_t cal;
+    mpu6050_fifo_t fifo;
+    motion_state_t state;
+    motion_hold_t hold;
+    attitude_t att;
+    kalman_state_t kf;
+    autorange_t ar;
+    motion_fx_state_t fx_state;
+    motion_fx_params_t fx_params;
+    float fx_noise_floor;
+    uint8_t fx_accel_range;
+    decim_fir_t fir;
+    decim_cic_t cic;
+    int16_t decim_out[DECIM_AXES];
+    bool decim_ready;
+    int64_t last_time;
+    uint32_t seq;
+    uint32_t read_errors;
+} imu_channel_t;
+
+/**
+ * @brief Output timing of the control mode
+ *
+ * period_us:            Control period (in microseconds)
+ * samples_per_period:   Sensor samples per control period
+ * phase:                Sensor sample periods since the last control period ended
+ * periods:              Control periods ended since the mode was entered
+ * frames:               State frame writes
+ * late:                 Writes that completed after their deadline (one period after the sample)
+ * skipped:              Periods that ended without a write (data-ready interrupts missed)
+ * wire:                 Sample latch to state frame written (sample-to-wire latency)
+ *
+ * A deadline miss is a late or a skipped period.
+ */
 typedef struct {
-    float ax, ay, az;  // acceleration in m/s²
-    float vx, vy, vz;  // velocity in m/s
-    float dx, dy, dz;  // displacement in meters
-} motion_state_t;
+    int64_t period_us;
+    uint32_t samples_per_period;
+    uint32_t phase;
+    uint32_t periods;
+    uint32_t frames;
+    uint32_t late;
+    uint32_t skipped;
+    stats_hist_t wire;
+} control_stats_t;
 
 /**
- * @brief Initialize the I2C master interface
+ * @brief Wake-on-motion standby state and statistics
+ *
+ * asleep:               Sensors in cycle mode, the readout waits for motion
+ * session:              Acquisition started by motion rather than by the start command
+ * entries:              Times standby was entered
+ * wakes:                Motion wake-ups
+ * polls:                Readout wake-ups in standby without motion
+ * failures:             Sensor mode changes that failed
+ * asleep_us:            Time spent in standby
+ * idle_us:              Idle task run time during asleep_us, when the chip may light-sleep
+ * mark_us, mark_idle:   Time and idle run time counter at the last accounting
+ * wake_isr_us:          Motion interrupt time, until the first sample after it (0 = none)
+ * wake:                 Motion interrupt to first sample processed (wake-to-first-sample latency)
+ */
+typedef struct {
+    bool asleep;
+    bool session;
+    uint32_t entries;
+    uint32_t wakes;
+    uint32_t polls;
+    uint32_t failures;
+    uint64_t asleep_us;
+    uint64_t idle_us;
+    int64_t mark_us;
+    configRUN_TIME_COUNTER_TYPE mark_idle;
+    volatile int64_t wake_isr_us;
+    stats_hist_t wake;
+} standby_stats_t;
+
+/**
+ * @brief Hot-path timing collected with the CPU cycle counter
+ *
+ * read:                 Time spent waiting for a sensor read or FIFO drain
+ * process:              Motion processing and decimation of one sample
+ * publish:              Queuing one sample for telemetry
+ * output:               Console write of one telemetry batch (telemetry task)
+ * jitter:               Deviation of the readout loop period from its nominal period
+ * apply:                Command reception to configuration taking effect
+ * max_dt_us:            Largest integration time step
+ *
+ * output is written by the telemetry task, everything else by the readout task.
+ */
+typedef struct {
+    stats_hist_t read;
+    stats_hist_t process;
+    stats_hist_t publish;
+    stats_hist_t output;
+    stats_hist_t jitter;
+    stats_hist_t apply;
+    uint32_t max_dt_us;
+} readout_stats_t;
+
+/**
+ * @brief Create the I2C master bus on I2C_NUM_0
+ *
+ * The bus is created with a transaction queue so that sensor reads can be
+ * queued and completed asynchronously. Its sensors share a priority gate:
+ * accel_readout_task is the sampler, every other task's transfers are
+ * housekeeping that waits for the gaps between samples.
  *
  * @return esp_err_t     ESP_OK on success, error code on failure
  */
 esp_err_t i2c_master_init(void);
 
+/**
+ * @brief Probe, initialize and configure every supported sensor on the I2C bus
+ *
+ * The sensor at MPU6050_ADDR is required; the one at MPU6050_ADDR_ALT is
+ * used when present. All sensors share the same configuration and are
+ * sampled at the same rate by accel_readout_task.
+ *
+ * @param cfg            Configuration applied to every sensor
+ * @return esp_err_t     ESP_OK on success, error code if the primary sensor fails
+ */
+esp_err_t imu_channels_init(const mpu6050_config_t *cfg);
+
 /**
  * @brief Task to periodically read accelerometer and gyroscope data
  *
  * This task polls data from the MPU6050 sensor based on the configuration
  * provided in the task_config_t structure. Data is filtered and processed.
+ * In FIFO mode every sensor sample is integrated with the sensor sample
+ * period and only the latest state is logged per update period.
+ * Each tick services every sensor in turn on the shared bus.
  *
- * @param pvParameters   Pointer to task_config_t passed during task creation
+ * @param pvParameters   Pointer to the initial task_config_t, later snapshots come from config_store
  */
 void accel_readout_task(void *pvParameters);
 
 
-/**
- * @brief Process raw accelerometer data: bias compensation, noise filtering,
- *        and numerical integration to compute velocity and displacement.
- *
- * @param data              Raw accelerometer readings (m/s²)
- * @param bias              Bias offset from calibration
- * @param noise_threshold   Acceleration threshold below which noise is ignored
- * @param dt                Time step between samples (in seconds)
- * @param state             Pointer to persistent motion state (velocity/displacement)
- */
-void process_accel_data(mpu6050_data_t data, mpu6050_cal_data_t bias, float noise_threshold, float dt, motion_state_t *state);
-
 /**
  * @brief Task to monitor system health and diagnostics 
  *
@@ -80,6 +307,26 @@ void process_accel_data(mpu6050_data_t data, mpu6050_cal_data_t bias, float nois
  */
 void system_monitor_task(void *pvParameters);
 
+/**
+ * @brief Task to serialize queued motion samples on the console
+ *
+ * Runs below the acquisition task and drains the sample ring in batches,
+ * so a slow console never stretches the sampling period.
+ *
+ * @param pvParameters   Pointer to the initial task_config_t, later snapshots come from config_store
+ */
+void telemetry_task(void *pvParameters);
+
+/**
+ * @brief Task to receive and execute console commands
+ *
+ * Sleeps until console input arrives, assembles it into lines and runs
+ * them through the command table. Configuration changes are published
+ * with config_store_publish and take effect in the other tasks at their
+ * next sample boundary.
+ *
+ * @param pvParameters   Pointer to task_config_t, the listener's working copy
+ */
 void command_listener_task(void *pvParameters);
 
 #endif // APP_TASKS_H
@@ -0,0 +1,88 @@
+#ifndef ATTITUDE_H
+#define ATTITUDE_H
+
+#include <stdint.h>
+
+#include "mpu6050.h"
+
+// --- Attitude Filter ---
+//
+// Complementary filter on the direction of gravity in the sensor frame.
+// Every sample the gyro rotates the estimate, and the accelerometer pulls
+// it towards the measured specific force with time constant ATTITUDE_TAU_S
+// while the measured magnitude is close to gravity. The level frame is the
+// shortest rotation that takes the estimate onto +Z, so it keeps the
+// sensor's heading (yaw is not observable without a magnetometer).
+//
+// The estimate is seeded with the calibration biases: the accelerometer
+// bias measured at rest is gravity plus the sensor offset, and both are
+// treated as gravity. In the calibration pose the level frame output is
+// therefore the bias compensated acceleration of process_accel_data; after
+// a tilt the gravity vector is removed along its new direction.
+//
+// One division and no trigonometry or square root per sample, for the
+// FPU-less ESP32-C6.
+
+#define ATTITUDE_TAU_S              5.0f    // Accelerometer correction time constant (s)
+#define ATTITUDE_GATE               0.05f   // Accelerometer ignored when |a| is further than this fraction from gravity
+#define ATTITUDE_MIN_COS            1e-3f   // Smallest 1 + cos(tilt) used by the level rotation (the sensor is never upside down)
+#define ATTITUDE_DEG_TO_RAD         0.017453292f
+
+/**
+ * @brief Attitude filter state of one sensor
+ *
+ * gx, gy, gz:           Direction of gravity in the sensor frame (unit vector)
+ * g:                    Gravity magnitude, the length of the calibration bias (m/s²)
+ * inv_g:                1 / g
+ * gate_lo, gate_hi:     Squared |a| range in which the accelerometer corrects the estimate
+ * gyro_bias:            Gyroscope calibration bias X..Z (°/s)
+ * corrections:          Samples the accelerometer corrected the estimate on
+ * updates:              Samples processed since attitude_init
+ */
+typedef struct {
+    float gx, gy, gz;
+    float g;
+    float inv_g;
+    float gate_lo, gate_hi;
+    float gyro_bias[3];
+    uint32_t corrections;
+    uint32_t updates;
+} attitude_t;
+
+/**
+ * @brief Seed the filter with a sensor's calibration
+ *
+ * @param att               Filter state
+ * @param cal               Calibration biases, measured at rest
+ */
+void attitude_init(attitude_t *att, const mpu6050_cal_data_t *cal);
+
+/**
+ * @brief Propagate the gravity estimate over one sample
+ *
+ * @param att               Filter state
+ * @param data              Sample (m/s², °/s)
+ * @param dt                Time step since the previous sample (in seconds)
+ */
+void attitude_update(attitude_t *att, const mpu6050_data_t *data, float dt);
+
+/**
+ * @brief Rotate an acceleration into the level frame and remove gravity
+ *
+ * @param att               Filter state
+ * @param ax, ay, az        Acceleration in the sensor frame (m/s²), replaced by
+ *                          the level frame acceleration without gravity
+ */
+void attitude_level(const attitude_t *att, float *ax, float *ay, float *az);
+
+/**
+ * @brief Angle between the gravity estimate and the sensor's Z axis
+ *
+ * For logging, uses acosf.
+ *
+ * @param att               Filter state
+ * @return float            Tilt (in degrees)
+ */
+float attitude_tilt_deg(const attitude_t *att);
+
+#endif // ATTITUDE_H
@@ -0,0 +1,101 @@
+#ifndef AUTORANGE_H
+#define AUTORANGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mpu6050.h"
+
+// --- Auto-Ranging ---
+//
+// Follows the signal with the accelerometer and gyroscope full-scale
+// ranges. A range goes up one step as soon as a sample comes within
+// AUTORANGE_HIGH counts of clipping, before the sensor saturates, and back
+// down once every sample has stayed below AUTORANGE_LOW for
+// AUTORANGE_HOLD_S, low enough to have room to spare at the finer range.
+// The configured range is the finest one used.
+//
+// Counts only mean something together with the range they were measured
+// at: the driver tags every raw sample with its ranges, and conversions
+// use the scale tables of mpu6050.h. A switch is written between two
+// samples; a sample that may have been latched before the write completed
+// has an unknown range and is dropped, its time step carried over to the
+// next one. Those are the samples a switch loses.
+
+#define AUTORANGE_HIGH              29000   // |counts| at which the range goes up (88% of full scale)
+#define AUTORANGE_LOW               12000   // |counts| below which the next finer range is safe (73% of its full scale)
+#define AUTORANGE_HOLD_S            1.0f    // Time below AUTORANGE_LOW before the range goes down (s)
+#define AUTORANGE_MAX_RANGE         3       // Widest range code: ±16 g, ±2000 °/s
+
+/**
+ * @brief Auto-ranging state of one sensor
+ *
+ * accel_range:          Accelerometer range wanted (the sensor's when no switch is pending)
+ * gyro_range:           Gyroscope range wanted
+ * accel_calm_s:         Time the accelerometer has stayed below AUTORANGE_LOW (s)
+ * gyro_calm_s:          Time the gyroscope has stayed below AUTORANGE_LOW (s)
+ * switch_us:            Time the last switch completed, until the first sample after it (0 = none)
+ * carry_us:             Time steps of dropped samples, added to the next processed one
+ * pending:              Samples dropped since the last switch
+ * switches:             Switches written
+ * lost:                 Samples dropped by all switches
+ * lost_max:             Most samples dropped by one switch
+ * saturated:            Samples with a clipped accelerometer or gyroscope axis
+ * failures:             Switches that could not be written
+ */
+typedef struct {
+    uint8_t accel_range;
+    uint8_t gyro_range;
+    float accel_calm_s;
+    float gyro_calm_s;
+    int64_t switch_us;
+    uint32_t carry_us;
+    uint32_t pending;
+    uint32_t switches;
+    uint32_t lost;
+    uint32_t lost_max;
+    uint32_t saturated;
+    uint32_t failures;
+} autorange_t;
+
+/**
+ * @brief Start over at the given ranges, keeping the counters
+ *
+ * @param ar                Auto-ranging state
+ * @param accel_range       Accelerometer range the sensor is at
+ * @param gyro_range        Gyroscope range the sensor is at
+ */
+void autorange_reset(autorange_t *ar, uint8_t accel_range, uint8_t gyro_range);
+
+/**
+ * @brief Decide on the ranges after a sample
+ *
+ * @param ar                Auto-ranging state
+ * @param raw               Sample, measured at the ranges in ar
+ * @param accel_floor       Finest accelerometer range allowed (the configured one)
+ * @param gyro_floor        Finest gyroscope range allowed
+ * @param dt                Time step of the sample (in seconds)
+ * @return true             The wanted ranges in ar changed: write them before the next sample
+ */
+bool autorange_update(autorange_t *ar, const mpu6050_raw_t *raw, uint8_t accel_floor, uint8_t gyro_floor, float dt);
+
+/**
+ * @brief Record a completed switch
+ *
+ * @param ar                Auto-ranging state
+ * @param done_us           Time the register writes completed
+ */
+void autorange_switched(autorange_t *ar, int64_t done_us);
+
+/**
+ * @brief Check whether a sample's ranges are known after a switch
+ *
+ * @param ar                Auto-ranging state
+ * @param latch_us          Earliest time the sensor may have latched the sample
+ * @param dt_us             Time step of the sample, extended by the steps of
+ *                          dropped samples when it is kept
+ * @return true             Keep the sample; false: drop it (counted as lost)
+ */
+bool autorange_accept(autorange_t *ar, int64_t latch_us, uint32_t *dt_us);
+
+#endif // AUTORANGE_H
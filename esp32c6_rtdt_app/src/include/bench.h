@@ -0,0 +1,85 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "esp_err.h"
+
+#include "mpu6050.h"
+
+#define BENCH_ITERATIONS            200     // Iterations per measured code path
+
+#define BENCH_MOTION_SAMPLES        1000    // Recorded samples replayed through both motion paths
+#define BENCH_MOTION_DT_US          1000    // Nominal sample period of the replay (1 kHz)
+#define BENCH_MOTION_AMPLITUDE      0.5f    // Excitation added on X/Y during the replay (m/s²)
+#define BENCH_MOTION_BLOCK          50      // Samples per process_accel_block call (a 50 ms FIFO drain at 1 kHz)
+
+#define BENCH_DECIM_SAMPLES         5000    // Input samples fed to each decimator
+#define BENCH_DECIM_RATE_HZ         1000    // Input rate of the decimator replay
+#define BENCH_DECIM_FACTOR          50      // 1 kHz to the default 50 ms update rate
+#define BENCH_DECIM_TONE_HZ         33      // Test tone, aliases to 7 Hz at the 20 Hz output rate
+#define BENCH_DECIM_AMPLITUDE       8000    // Test tone amplitude (counts)
+
+#define BENCH_CAPTURE_QUIET         2000    // Background samples fed after the trigger warm-up
+#define BENCH_CAPTURE_NOISE         10      // Background noise amplitude (counts)
+#define BENCH_CAPTURE_BURST         500     // Length of the synthetic event (samples)
+#define BENCH_CAPTURE_AMPLITUDE     3000    // Synthetic event amplitude on X (counts)
+#define BENCH_CAPTURE_DEV           0xFF    // Device index of the dumped synthetic event
+
+#define BENCH_CODEC_SAMPLES         2048    // Live samples recorded for the codec benchmark (multiple of RAW_CODEC_BLOCK)
+#define BENCH_CODEC_PERIOD_US       1000    // Recording period (1 kHz)
+
+#define BENCH_ATTITUDE_SAMPLES      1000    // Recorded samples replayed with and without tilt compensation (at BENCH_MOTION_DT_US)
+#define BENCH_ATTITUDE_TILT_DEG     5.0f    // Synthetic tilt about Y applied to the replay
+#define BENCH_ATTITUDE_RAMP         500     // Samples over which the tilt is ramped in (raised cosine)
+
+#define BENCH_KALMAN_SAMPLES        2000    // Recorded samples replayed through both drift controls (at BENCH_MOTION_DT_US)
+#define BENCH_KALMAN_REST           500     // Samples at rest before and after the synthetic motion
+#define BENCH_KALMAN_DISP           0.01f   // Peak of the synthetic raised cosine displacement on X (m)
+
+#define BENCH_AUTORANGE_SAMPLES     3000    // Synthetic samples of the auto-ranging replay (at BENCH_MOTION_DT_US)
+#define BENCH_AUTORANGE_PEAK_G      6.0f    // Peak of the synthetic burst on X (g)
+#define BENCH_AUTORANGE_HZ          20.0f   // Burst frequency (Hz)
+#define BENCH_AUTORANGE_DECAY_S     0.3f    // Burst decay time constant (s)
+
+/**
+ * @brief Run an on-device benchmark and log its results
+ *
+ * Benchmarks share the sensor and the CPU with the acquisition path, so
+ * the readout should be stopped while they run to get undisturbed numbers.
+ *
+ * Available benchmarks:
+ *   i2c:     Bus time of mpu6050_read_all vs. the accel + gyro + temp three-call path
+ *   motion:  CPU cycles per sample of the float (per sample and in blocks) and
+ *            fixed-point motion paths on a recording of the live sensor, whether the
+ *            block path matches the per-sample one bit for bit, and the largest
+ *            deviation of the fixed-point path
+ *   ring:    CPU cycles per sample to push into and pop from the telemetry sample ring
+ *   decim:   CPU cycles per input sample of the FIR and CIC decimators and how much
+ *            of an out-of-band tone each lets through as aliasing
+ *   capture: CPU cycles per sample of the event capture while armed and while
+ *            triggered, trigger delay on a synthetic event, the capture memory
+ *            footprint, and the console throughput of dumping the frozen window
+ *            (the dump is a real binary dump tagged with BENCH_CAPTURE_DEV)
+ *   codec:   Compression ratio of the raw stream codec on a 1 kHz recording of the
+ *            live sensor (block payload and with frame overhead, next to what plain
+ *            delta + zigzag varint would reach), CPU cycles per sample to encode and
+ *            decode, and a lossless round-trip check
+ *   attitude: CPU cycles per sample of the tilt compensation filter and of the float
+ *            motion path with and without it, as a share of the 1 kHz sample period,
+ *            and the drift of both on a recording of the sensor at rest with a
+ *            synthetic tilt (gravity leaking into the plain path)
+ *   kalman:  Time to solve the steady-state Kalman gains at 1 kHz, CPU cycles per
+ *            sample of process_accel_data and kalman_update, and the displacement
+ *            error and final velocity of both on a recording of the sensor at rest
+ *            with a synthetic displacement pulse that returns to zero
+ *   autorange: CPU cycles per sample of the range decision, and the clipped samples
+ *            and largest conversion error of a synthetic decaying burst past ±2 g,
+ *            read at a fixed ±2 g and auto-ranged (switches take effect on the
+ *            next sample, the bus is not used)
+ *
+ * @param name Benchmark name
+ * @param dev Sensor to benchmark against
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND for an unknown name, or the first sensor error
+ */
+esp_err_t bench_run(const char *name, mpu6050_dev_t *dev);
+
+#endif // BENCH_H
@@ -0,0 +1,49 @@
+#ifndef CAL_STORE_H
+#define CAL_STORE_H
+
+#include "esp_err.h"
+
+#include "mpu6050.h"
+
+#define CAL_STORE_NAMESPACE         "rtdt_cal"  // NVS namespace of the calibration cache
+#define CAL_STORE_VERSION           1           // Bumped when the stored record layout changes
+#define CAL_STORE_MAX_TEMP_DELTA    5.0f        // Largest temperature change (°C) for which a stored calibration is reused
+
+/**
+ * @brief Initialize the default NVS partition
+ *
+ * The partition is erased and re-initialized if it is full or was written
+ * by a newer NVS version; the cache is only an optimization.
+ *
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t cal_store_init(void);
+
+/**
+ * @brief Load the stored calibration of a sensor if it is still valid
+ *
+ * A record is valid when it was written with the current record version
+ * for the same address and range / filter configuration, and the sensor
+ * temperature is within CAL_STORE_MAX_TEMP_DELTA of the calibration
+ * temperature.
+ *
+ * @param addr Sensor I2C address
+ * @param cfg Current sensor configuration
+ * @param temp Current sensor temperature (°C)
+ * @param cal Output calibration
+ * @return esp_err_t ESP_OK, ESP_ERR_NOT_FOUND if there is no record, ESP_ERR_INVALID_STATE
+ *         if the record is stale, or NVS error code
+ */
+esp_err_t cal_store_load(uint8_t addr, const mpu6050_config_t *cfg, float temp, mpu6050_cal_data_t *cal);
+
+/**
+ * @brief Store the calibration of a sensor
+ *
+ * @param addr Sensor I2C address
+ * @param cfg Sensor configuration the calibration was taken with
+ * @param cal Calibration
+ * @return esp_err_t ESP_OK or NVS error code
+ */
+esp_err_t cal_store_save(uint8_t addr, const mpu6050_config_t *cfg, const mpu6050_cal_data_t *cal);
+
+#endif // CAL_STORE_H
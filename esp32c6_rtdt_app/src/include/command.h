@@ -0,0 +1,66 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#define CMD_BUF_SIZE                128     // Longest command line including the terminator
+#define CMD_ARG_SEPARATOR           ':'     // Separates a command name from its argument
+
+/**
+ * @brief Command handler
+ *
+ * @param ctx Context given to command_dispatch
+ * @param arg Text after the separator, or "" when the command has no argument
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_ARG for a bad argument, or error code
+ */
+typedef esp_err_t (*command_handler_t)(void *ctx, const char *arg);
+
+/**
+ * @brief Command table entry
+ */
+typedef struct {
+    const char *name;                       // Command name, matched exactly
+    command_handler_t handler;
+    const char *help;                       // Argument synopsis and one-line description
+} command_t;
+
+/**
+ * @brief Assembles console input into lines
+ *
+ * Lines end at CR or LF; empty lines are skipped. A line that does not fit
+ * in buf is dropped as a whole and reported through `overflows`.
+ */
+typedef struct {
+    char buf[CMD_BUF_SIZE];
+    size_t len;
+    bool discard;                           // Skipping the rest of an over-long line
+    unsigned overflows;                     // Number of dropped over-long lines
+} line_reader_t;
+
+/**
+ * @brief Feed one received character
+ *
+ * @param reader Line reader
+ * @param c Received character
+ * @return true when c completed a line, which is then available NUL terminated in reader->buf
+ *         until the next call
+ */
+bool line_reader_push(line_reader_t *reader, char c);
+
+/**
+ * @brief Split a line into name and argument and run the matching handler
+ *
+ * "name" and "name:arg" are accepted; the separator is replaced in place.
+ *
+ * @param table Command table
+ * @param n Number of entries in the table
+ * @param ctx Context passed to the handler
+ * @param line Command line (modified)
+ * @return esp_err_t Handler result, or ESP_ERR_NOT_FOUND for an unknown command
+ */
+esp_err_t command_dispatch(const command_t *table, size_t n, void *ctx, char *line);
+
+#endif // COMMAND_H
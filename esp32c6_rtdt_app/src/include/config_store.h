@@ -0,0 +1,45 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "app_tasks.h"
+
+/**
+ * @brief Versioned task configuration shared between tasks
+ *
+ * The command listener is the only writer. It edits a private copy and
+ * publishes it as a whole; readers keep their own copy and pick up a new
+ * version when they reach a point where a change is safe (a sample
+ * boundary for the readout task). A snapshot is swapped atomically
+ * through a one-slot FreeRTOS queue, so a reader never sees a partially
+ * updated configuration, and a version counter makes the "nothing new"
+ * check a single atomic load.
+ */
+
+/**
+ * @brief Create the store and publish the initial configuration
+ *
+ * @param initial        Initial configuration (its version is updated)
+ * @return esp_err_t     ESP_OK, or ESP_ERR_NO_MEM
+ */
+esp_err_t config_store_init(task_config_t *initial);
+
+/**
+ * @brief Publish a new configuration snapshot (single writer)
+ *
+ * @param config         Configuration; its version is set to the published version
+ */
+void config_store_publish(task_config_t *config);
+
+/**
+ * @brief Replace a reader's copy if a newer snapshot has been published
+ *
+ * @param config         Reader's copy, compared and updated by version
+ * @return true          config was replaced by a newer snapshot
+ */
+bool config_store_fetch(task_config_t *config);
+
+#endif // CONFIG_STORE_H
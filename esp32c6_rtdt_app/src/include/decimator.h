@@ -0,0 +1,140 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DECIM_AXES                  3       // Signals filtered per stream (accel X, Y, Z)
+#define DECIM_MAX_FACTOR            64      // Largest FIR decimation factor, larger ones get a CIC pre-stage
+#define DECIM_FIR_TAPS_PER_PHASE    8       // FIR length is this times the decimation factor
+#define DECIM_FIR_MAX_TAPS          (DECIM_FIR_TAPS_PER_PHASE * DECIM_MAX_FACTOR)
+#define DECIM_FIR_COEF_FRAC         15      // Coefficients are Q1.15 with a DC gain of exactly 1
+#define DECIM_CIC_ORDER             3       // Integrator / comb stages of the CIC decimator
+#define DECIM_CIC_MAX_FACTOR        4096    // Largest CIC decimation factor (keeps the gain below 2^48)
+
+/**
+ * @brief Decimation filters
+ *
+ * DECIM_OFF:            Output the latest sample (no anti-alias filtering)
+ * DECIM_FIR:            Windowed-sinc FIR evaluated in polyphase form: the
+ *                       filter is only computed for samples that are output
+ * DECIM_CIC:            Cascaded integrator-comb, multiplier free and any
+ *                       factor, at the cost of passband droop
+ */
+typedef enum {
+    DECIM_OFF = 0,
+    DECIM_FIR,
+    DECIM_CIC,
+} decim_mode_t;
+
+/**
+ * @brief FIR kernel shared by every stream decimating by the same factor
+ *
+ * Lowpass with its cutoff at the output Nyquist frequency, Hamming window.
+ */
+typedef struct {
+    uint16_t factor;                            // Decimation factor
+    uint16_t taps;                              // Filter length (DECIM_FIR_TAPS_PER_PHASE * factor)
+    int16_t coef[DECIM_FIR_MAX_TAPS];           // Coefficients, oldest sample first (Q1.15)
+} decim_fir_kernel_t;
+
+/**
+ * @brief Per-stream FIR decimator state
+ *
+ * Every input is written twice, taps apart, so the newest `taps` samples
+ * are always contiguous and the dot product needs no wrap-around.
+ */
+typedef struct {
+    int16_t hist[DECIM_AXES][2 * DECIM_FIR_MAX_TAPS];
+    uint16_t pos;                               // Slot of the next input
+    uint16_t phase;                             // Inputs since the last output
+} decim_fir_t;
+
+/**
+ * @brief Per-stream CIC decimator state
+ *
+ * Integrators wrap in two's complement; the combs undo the wrap as long as
+ * the output (input * factor^DECIM_CIC_ORDER) fits in 64 bits.
+ */
+typedef struct {
+    uint32_t factor;
+    uint32_t phase;
+    uint64_t integ[DECIM_AXES][DECIM_CIC_ORDER];
+    uint64_t comb[DECIM_AXES][DECIM_CIC_ORDER];
+    int64_t gain;                               // factor^DECIM_CIC_ORDER
+} decim_cic_t;
+
+/**
+ * @brief Design the anti-alias FIR for a decimation factor
+ *
+ * Uses floating point and is meant to run when the configuration changes,
+ * not per sample.
+ *
+ * @param kernel Output kernel
+ * @param factor Decimation factor (1..DECIM_MAX_FACTOR, clamped)
+ */
+void decim_fir_design(decim_fir_kernel_t *kernel, uint16_t factor);
+
+/**
+ * @brief Split a decimation factor between a CIC pre-stage and the FIR
+ *
+ * Factors up to DECIM_MAX_FACTOR are the FIR's alone. Larger ones are
+ * decimated by a CIC first, by less than twice the smallest factor that
+ * fits, so the FIR keeps a factor above 20: the CIC's droop at the output
+ * passband stays below 0.3 % and the FIR sets the cutoff. The product is
+ * the factor itself where it has such a divisor, the closest one otherwise.
+ *
+ * @param factor Overall decimation factor
+ * @param pre Output CIC pre-stage factor (1 = none)
+ * @return FIR factor (1..DECIM_MAX_FACTOR)
+ */
+uint16_t decim_fir_split(uint32_t factor, uint32_t *pre);
+
+/**
+ * @brief Clear the FIR history and restart the output phase
+ *
+ * @param fir FIR decimator state
+ */
+void decim_fir_reset(decim_fir_t *fir);
+
+/**
+ * @brief Rescale the FIR history after the input's full-scale range changed
+ *
+ * Keeps the filter running across a range switch: the window is converted
+ * to counts of the new range, saturating where the finer range clips.
+ *
+ * @param fir FIR decimator state
+ * @param shift Range codes moved up (coarser, counts halve per step) or down (negative)
+ */
+void decim_fir_rescale(decim_fir_t *fir, int shift);
+
+/**
+ * @brief Feed one input sample to the FIR decimator
+ *
+ * @param fir FIR decimator state
+ * @param kernel Kernel from decim_fir_design
+ * @param in Input sample (DECIM_AXES values)
+ * @param out Filtered output sample, written when true is returned
+ * @return true every kernel->factor inputs, when an output sample is ready
+ */
+bool decim_fir_push(decim_fir_t *fir, const decim_fir_kernel_t *kernel, const int16_t in[DECIM_AXES], int16_t out[DECIM_AXES]);
+
+/**
+ * @brief Clear the CIC registers and set the decimation factor
+ *
+ * @param cic CIC decimator state
+ * @param factor Decimation factor (1..DECIM_CIC_MAX_FACTOR, clamped)
+ */
+void decim_cic_reset(decim_cic_t *cic, uint32_t factor);
+
+/**
+ * @brief Feed one input sample to the CIC decimator
+ *
+ * @param cic CIC decimator state
+ * @param in Input sample (DECIM_AXES values)
+ * @param out Filtered output sample normalized to unity DC gain, written when true is returned
+ * @return true every cic->factor inputs, when an output sample is ready
+ */
+bool decim_cic_push(decim_cic_t *cic, const int16_t in[DECIM_AXES], int16_t out[DECIM_AXES]);
+
+#endif // DECIMATOR_H
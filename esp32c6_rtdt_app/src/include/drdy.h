@@ -0,0 +1,82 @@
+#ifndef DRDY_H
+#define DRDY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// --- Data-Ready Pacing ---
+//
+// In the interrupt driven acquisition modes the MPU6050 INT pin paces the
+// readout: the GPIO interrupt stamps the sample and notifies the readout
+// task, which services it and accounts for the interval since the previous
+// one. Notifications coalesce, so a sample serviced late shows up as an
+// interval of several periods and its predecessors as missed interrupts.
+// A wait that times out restarts the interval measurement, so a stall is
+// not counted as a run of missed samples once the interrupts come back.
+
+/**
+ * @brief Sample timing statistics for interrupt driven acquisition
+ *
+ * period_us:            Expected sample period (in microseconds)
+ * last_isr_us:          Interrupt timestamp of the previous sample (0 = none yet)
+ * samples:              Number of samples processed
+ * missed:               Number of data-ready interrupts not serviced in time
+ * jitter_max_us:        Largest deviation of a sample interval from period_us
+ * jitter_sum_us:        Sum of absolute deviations (mean = jitter_sum_us / samples)
+ */
+typedef struct {
+    int64_t period_us;
+    int64_t last_isr_us;
+    uint32_t samples;
+    uint32_t missed;
+    int64_t jitter_max_us;
+    int64_t jitter_sum_us;
+} drdy_timing_t;
+
+/**
+ * @brief GPIO interrupt handler of the data-ready pin
+ *
+ * Register with gpio_isr_handler_add, the argument is the task to notify.
+ *
+ * @param arg             TaskHandle_t of the readout task
+ */
+void drdy_isr_handler(void *arg);
+
+/**
+ * @brief Wait for the next data-ready interrupt (readout task side)
+ *
+ * On a timeout the previous interrupt timestamp is forgotten, so the next
+ * sample starts a new interval of one period.
+ *
+ * @param timing          Timing statistics
+ * @param timeout_ms      Longest wait for the interrupt
+ * @param isr_us          Interrupt timestamp of the latest sample
+ * @return true if an interrupt arrived, false on timeout
+ */
+bool drdy_wait(drdy_timing_t *timing, uint32_t timeout_ms, int64_t *isr_us);
+
+/**
+ * @brief Reset timing statistics for a new acquisition session
+ *
+ * @param timing          Timing statistics
+ * @param period_us       Expected sample period (in microseconds)
+ */
+void drdy_timing_reset(drdy_timing_t *timing, int64_t period_us);
+
+/**
+ * @brief Account for a serviced data-ready interrupt
+ *
+ * Intervals spanning more than one sample period (notifications coalesced
+ * or interrupts lost) are counted as missed interrupts. Jitter is only
+ * accumulated over intervals where no interrupt was missed.
+ *
+ * @param timing          Timing statistics
+ * @param isr_us          Interrupt timestamp of the sample being serviced
+ * @return int64_t        Integration time step since the previous sample (in microseconds)
+ */
+int64_t drdy_timing_update(drdy_timing_t *timing, int64_t isr_us);
+
+#endif // DRDY_H
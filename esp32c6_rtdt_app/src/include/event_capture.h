@@ -0,0 +1,161 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// --- Memory Budget ---
+//
+// The ring holds raw accelerometer samples as packed int16 triples (6 bytes,
+// no padding, no timestamps: samples are evenly spaced at the sensor rate).
+// At 1 kHz the default 2 s + 3 s window costs 5000 * 6 = 30000 bytes of
+// static RAM; the trigger state adds a few dozen bytes.
+//
+// Averaging windows are powers of two so the STA/LTA update is shifts and
+// adds. Time constants below assume the 1 kHz sensor rate and scale with it.
+
+#define CAPTURE_PRE_SAMPLES         2000    // Samples kept before the trigger (2 s at 1 kHz)
+#define CAPTURE_POST_SAMPLES        3000    // Samples recorded after the trigger (3 s at 1 kHz)
+#define CAPTURE_RING_SAMPLES        (CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES)
+#define CAPTURE_AXES                3       // Accelerometer X, Y, Z
+
+#define CAPTURE_CF_FRAC             4       // Characteristic function and averages are Q4 counts
+#define CAPTURE_DC_SHIFT            10      // Gravity / bias tracker time constant, 2^10 samples (~1 s)
+#define CAPTURE_STA_SHIFT           5       // Short-term average, 2^5 samples (32 ms)
+#define CAPTURE_LTA_SHIFT           12      // Long-term average, 2^12 samples (4.1 s)
+#define CAPTURE_WARMUP              (2 << CAPTURE_LTA_SHIFT)    // Samples after arming before the trigger is enabled
+#define CAPTURE_LTA_MIN             (8 << CAPTURE_CF_FRAC)      // LTA floor so a very quiet sensor does not trigger on noise
+
+#define CAPTURE_RATIO_FRAC          4       // STA/LTA ratios are Q4
+#define CAPTURE_TRIGGER_ON          (4 << CAPTURE_RATIO_FRAC)   // Trigger when STA/LTA rises above 4.0
+#define CAPTURE_TRIGGER_OFF         (3 << (CAPTURE_RATIO_FRAC - 1)) // Event ends when STA/LTA falls below 1.5
+
+/**
+ * @brief One raw accelerometer sample in the capture ring (6 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    int16_t ax, ay, az;
+} capture_sample_t;
+
+/**
+ * @brief Capture states
+ *
+ * CAPTURE_IDLE:         Samples are ignored
+ * CAPTURE_ARMED:        Samples fill the ring and feed the trigger
+ * CAPTURE_TRIGGERED:    Recording the post-event window
+ * CAPTURE_FROZEN:       The window is complete and stays untouched until
+ *                       the next arm request
+ */
+typedef enum {
+    CAPTURE_IDLE = 0,
+    CAPTURE_ARMED,
+    CAPTURE_TRIGGERED,
+    CAPTURE_FROZEN,
+} capture_state_t;
+
+/**
+ * @brief Arm / disarm requests, applied by the writer on its next sample
+ */
+typedef enum {
+    CAPTURE_REQ_NONE = 0,
+    CAPTURE_REQ_ARM,
+    CAPTURE_REQ_DISARM,
+} capture_request_t;
+
+/**
+ * @brief Pre-trigger capture ring with an STA/LTA trigger
+ *
+ * The characteristic function is the L1 norm of the acceleration minus a
+ * slow running mean (gravity and bias), so the trigger reacts to shaking
+ * regardless of orientation. The LTA is held while an event is in progress.
+ * Averages are kept as sums scaled by their window length, which avoids
+ * the dead band a shifted exponential average has at small inputs.
+ *
+ * The ring and the trigger state are counts of one accelerometer range,
+ * the widest the samples in the ring were measured at: a wider sample
+ * rescales everything at once, and once a whole ring was measured finer
+ * the window narrows by a step, so auto-ranging never clips the window.
+ *
+ * Single writer (the readout task). Other tasks only post requests and
+ * read the ring once `state` is CAPTURE_FROZEN, which the writer publishes
+ * with release ordering after the last sample.
+ *
+ * ring:                 Raw samples, pos is the next slot
+ * written:              Samples stored since arming (saturates at the ring size)
+ * dc:                   Running mean per axis, times 2^CAPTURE_DC_SHIFT (counts)
+ * sta, lta:             Short- and long-term averages of the characteristic function,
+ *                       times 2^CAPTURE_STA_SHIFT and 2^CAPTURE_LTA_SHIFT (Q4 counts)
+ * warmup:               Samples left before the trigger is enabled
+ * pre:                  Samples before the trigger in the frozen window
+ * post_left:            Samples still to record after the trigger
+ * duration:             Samples from trigger to detrigger, 0 while still above the off ratio
+ * peak_ratio:           Largest STA/LTA during the event (Q4)
+ * trigger_t_us:         Timestamp of the trigger sample
+ * events:               Number of windows frozen since boot
+ * range:                Accelerometer range code of the ring and trigger counts
+ * finer:                Consecutive samples measured at a finer range than `range`
+ */
+typedef struct {
+    capture_sample_t ring[CAPTURE_RING_SAMPLES];
+    uint16_t pos;
+    uint16_t written;
+    int32_t dc[CAPTURE_AXES];
+    uint32_t sta;
+    uint64_t lta;
+    uint32_t warmup;
+    uint16_t pre;
+    uint16_t post_left;
+    uint16_t duration;
+    uint16_t peak_ratio;
+    int64_t trigger_t_us;
+    uint32_t events;
+    uint8_t range;
+    uint16_t finer;
+    _Atomic capture_state_t state;
+    _Atomic capture_request_t request;
+} event_capture_t;
+
+/**
+ * @brief Post an arm or disarm request
+ *
+ * Arming discards a frozen window and restarts the warm-up.
+ *
+ * @param ec Capture
+ * @param request CAPTURE_REQ_ARM or CAPTURE_REQ_DISARM
+ */
+void event_capture_request(event_capture_t *ec, capture_request_t request);
+
+/**
+ * @brief Store one sample and run the trigger (writer only)
+ *
+ * @param ec Capture
+ * @param in Raw acceleration X, Y, Z (counts)
+ * @param range Accelerometer range code the counts were measured at
+ * @param t_us Sample timestamp
+ * @return true when this sample completed the post-event window
+ */
+bool event_capture_push(event_capture_t *ec, const int16_t in[CAPTURE_AXES], uint8_t range, int64_t t_us);
+
+/**
+ * @brief Current STA/LTA ratio
+ *
+ * @param ec Capture
+ * @return uint32_t Ratio (Q4), with the LTA floor applied
+ */
+uint32_t event_capture_ratio(const event_capture_t *ec);
+
+/**
+ * @brief Copy samples out of a frozen window
+ *
+ * The counts are of the window's `range`.
+ *
+ * @param ec Capture in CAPTURE_FROZEN state
+ * @param offset First sample, 0 is the oldest pre-trigger sample
+ * @param out Output samples
+ * @param n Maximum number of samples
+ * @return uint16_t Number of samples copied, 0 past the end of the window or when not frozen
+ */
+uint16_t event_capture_read(const event_capture_t *ec, uint16_t offset, capture_sample_t *out, uint16_t n);
+
+#endif // EVENT_CAPTURE_H
@@ -0,0 +1,102 @@
+#ifndef KALMAN_H
+#define KALMAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mpu6050.h"
+#include "motion.h"
+
+// --- Kalman Estimator ---
+//
+// Per-axis displacement, velocity and accelerometer bias estimator, an
+// alternative to the noise floor and stillness hold of process_accel_data.
+// The measured acceleration drives the prediction; while the sensor is
+// still, a zero-velocity pseudo-measurement corrects all three states,
+// which is what makes the bias observable.
+//
+// The pseudo-measurement comes every sample while still and never during
+// motion, so the filter only ever runs with one of two gains: the
+// steady-state gain of the zero-velocity update, or none. The steady-state
+// gain is solved once per sample period by kalman_params_init, and the
+// per-sample update is a few multiply-adds.
+
+#define KALMAN_ACCEL_NOISE          0.05f   // Accelerometer noise per sample (m/s² rms)
+#define KALMAN_BIAS_WALK            1e-3f   // Accelerometer bias random walk (m/s² per √s)
+#define KALMAN_ZUPT_NOISE           0.01f   // Velocity of a still sensor, the pseudo-measurement noise (m/s rms)
+#define KALMAN_BIAS_INIT            0.1f    // Bias uncertainty the Riccati iteration starts from (m/s² rms)
+#define KALMAN_TOLERANCE            1e-5    // Relative gain change at which the Riccati iteration has converged
+#define KALMAN_MAX_ITERATIONS       50000   // Riccati iteration limit (8 kHz samples need about 15000)
+
+#define KALMAN_STILL_TAU_S          0.05f   // Smoothing of the bias compensated acceleration for stillness detection (s)
+#define KALMAN_STILL_THRESHOLD      0.015f  // Smoothed acceleration below which an axis is considered still (m/s²)
+#define KALMAN_STILL_SIGMAS         3.0f    // Lower bound of the stillness threshold in smoothed noise rms, for slow sample rates
+#define KALMAN_STILL_S              0.2f    // Time all axes must stay still before updates start (s)
+
+/**
+ * @brief Steady-state gains of the zero-velocity update
+ *
+ * dt_us:                Sample period the gains were solved for (0 = not solved)
+ * kd, kv, kb:           Gains from the velocity innovation to displacement,
+ *                       velocity and bias
+ * still_c:              Smoothing factor of the stillness detector per sample
+ * still_threshold:      Stillness threshold on the smoothed acceleration (m/s²)
+ * iterations:           Riccati iterations to convergence
+ */
+typedef struct {
+    uint32_t dt_us;
+    float kd, kv, kb;
+    float still_c;
+    float still_threshold;
+    uint32_t iterations;
+} kalman_params_t;
+
+/**
+ * @brief Estimator state of one sensor besides its motion_state_t
+ *
+ * b:                    Accelerometer bias estimate X..Z (m/s²)
+ * lp:                   Smoothed bias compensated acceleration X..Z (m/s²)
+ * still_s:              Time the sensor has been still (s)
+ * updates:              Zero-velocity updates applied
+ */
+typedef struct {
+    float b[3];
+    float lp[3];
+    float still_s;
+    uint32_t updates;
+} kalman_state_t;
+
+/**
+ * @brief Solve the steady-state gains for a sample period
+ *
+ * Iterates the Riccati equation in double precision until the gains
+ * settle; thousands of iterations at 1 kHz, so not on the sample path.
+ * Also sets up the stillness detector for the sample period.
+ *
+ * @param params            Output gains
+ * @param dt_us             Sample period (in microseconds)
+ */
+void kalman_params_init(kalman_params_t *params, uint32_t dt_us);
+
+/**
+ * @brief Restart the estimator from a known bias
+ *
+ * @param kf                Estimator state
+ * @param bias              Initial bias (the calibration), NULL for zero
+ */
+void kalman_init(kalman_state_t *kf, const mpu6050_cal_data_t *bias);
+
+/**
+ * @brief Process one sample: prediction, stillness detection and update
+ *
+ * @param params            Gains from kalman_params_init
+ * @param data              Acceleration (m/s², bias included)
+ * @param dt                Time step between samples (in seconds)
+ * @param kf                Estimator state
+ * @param state             Motion state: bias compensated acceleration,
+ *                          velocity and displacement
+ */
+void kalman_update(const kalman_params_t *params, const mpu6050_data_t *data, float dt, kalman_state_t *kf,
+                   motion_state_t *state);
+
+#endif // KALMAN_H
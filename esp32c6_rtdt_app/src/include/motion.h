@@ -0,0 +1,172 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mpu6050.h"
+
+// --- Drift Control Constants ---
+
+#define MOTION_STATIONARY_THRESHOLD 0.05f   // Acceleration below which an axis is considered still (m/s²)
+#define MOTION_HOLD_CYCLES          10      // Consecutive still samples before velocity is zeroed
+#define MOTION_BLOCK_STEPS          64      // Time steps converted at once by process_accel_block (stack floats)
+
+// --- Fixed-Point Formats ---
+//
+// Acceleration:  Q16.16 m/s²   (int32)
+// Velocity:      Q40.24 m/s    (int64)
+// Displacement:  Q32.32 m      (int64)
+// Time step:     Q0.32  s      (int64, from microseconds)
+//
+// With dt limited to MOTION_FX_MAX_DT_US and velocity saturated at
+// MOTION_FX_V_MAX, every product stays below 2^63.
+
+#define MOTION_FX_ACCEL_FRAC        16
+#define MOTION_FX_VEL_FRAC          24
+#define MOTION_FX_DISP_FRAC         32
+#define MOTION_FX_SCALE_FRAC        24      // Fraction bits of the counts to m/s² scale factor
+
+#define MOTION_FX_MAX_DT_US         1000000                              // Largest integrated time step (1 s)
+#define MOTION_FX_V_MAX             ((int64_t)64 << MOTION_FX_VEL_FRAC)   // Velocity saturation (±64 m/s)
+#define MOTION_FX_D_MAX             ((int64_t)1 << 62)                    // Displacement saturation (±2^30 m)
+
+typedef struct {
+    float ax, ay, az;  // acceleration in m/s²
+    float vx, vy, vz;  // velocity in m/s
+    float dx, dy, dz;  // displacement in meters
+} motion_state_t;
+
+/**
+ * @brief Stillness detection counters (consecutive still samples per axis)
+ *
+ * Kept per sensor alongside its motion state so that several sensors can
+ * be processed independently.
+ */
+typedef struct {
+    uint16_t ax_still_count;
+    uint16_t ay_still_count;
+    uint16_t az_still_count;
+} motion_hold_t;
+
+/**
+ * @brief Precomputed fixed-point processing parameters
+ *
+ * accel_scale:          Counts to m/s² factor for the active range (Q8.24)
+ * ax_bias..az_bias:     Calibration bias (Q16.16 m/s²)
+ * noise_threshold:      Noise floor (Q16.16 m/s²)
+ * stationary_threshold: Stillness threshold (Q16.16 m/s²)
+ */
+typedef struct {
+    int32_t accel_scale;
+    int32_t ax_bias, ay_bias, az_bias;
+    int32_t noise_threshold;
+    int32_t stationary_threshold;
+} motion_fx_params_t;
+
+/**
+ * @brief Persistent fixed-point motion state
+ */
+typedef struct {
+    int32_t ax, ay, az;                 // compensated acceleration (Q16.16 m/s²)
+    int64_t vx, vy, vz;                 // velocity (Q40.24 m/s)
+    int64_t dx, dy, dz;                 // displacement (Q32.32 m)
+    motion_hold_t hold;                 // stillness detection counters
+    uint32_t saturations;               // number of clamped velocity/displacement updates
+} motion_fx_state_t;
+
+/**
+ * @brief Process raw accelerometer data: bias compensation, noise filtering,
+ *        and numerical integration to compute velocity and displacement.
+ *
+ * @param data              Raw accelerometer readings (m/s²)
+ * @param bias              Bias offset from calibration
+ * @param noise_threshold   Acceleration threshold below which noise is ignored
+ * @param dt                Time step between samples (in seconds)
+ * @param state             Pointer to persistent motion state (velocity/displacement)
+ * @param hold              Pointer to persistent stillness counters of the same sensor
+ */
+void process_accel_data(mpu6050_data_t data, mpu6050_cal_data_t bias, float noise_threshold, float dt, motion_state_t *state, motion_hold_t *hold);
+
+/**
+ * @brief A block of one sensor's samples as structure of arrays
+ *
+ * ax, ay, az:           Acceleration (m/s², before bias compensation)
+ * t_us:                 Sample times (us); sample i is integrated over t_us[i] - t_us[i - 1]
+ * t_prev_us:            Time of the sample before the block, the start of sample 0's step
+ * n:                    Number of samples
+ */
+typedef struct {
+    const float *ax, *ay, *az;
+    const int64_t *t_us;
+    int64_t t_prev_us;
+    size_t n;
+} motion_block_t;
+
+/**
+ * @brief Motion state after every sample of a block, as structure of arrays
+ *
+ * Each member is NULL or an array of motion_block_t.n elements; NULL
+ * members are not written.
+ */
+typedef struct {
+    float *ax, *ay, *az;
+    float *vx, *vy, *vz;
+    float *dx, *dy, *dz;
+} motion_track_t;
+
+/**
+ * @brief Block form of process_accel_data
+ *
+ * Processes a block of samples with the same arithmetic, sample for sample,
+ * so state and hold end up bit-identical to calling process_accel_data on
+ * each sample with dt = (t_us[i] - t_us[i - 1]) / 1e6f. Axes are processed
+ * one after the other with their state in registers, without the per-sample
+ * call and argument copies, and a time step is converted to seconds once
+ * per distinct value instead of once per sample.
+ *
+ * @param block             Input samples
+ * @param bias              Bias offset from calibration
+ * @param noise_threshold   Acceleration threshold below which noise is ignored
+ * @param state             Pointer to persistent motion state, holds the last sample's on return
+ * @param hold              Pointer to persistent stillness counters of the same sensor
+ * @param track             Per-sample output, may be NULL
+ */
+void process_accel_block(const motion_block_t *block, const mpu6050_cal_data_t *bias, float noise_threshold,
+                         motion_state_t *state, motion_hold_t *hold, const motion_track_t *track);
+
+/**
+ * @brief Convert calibration and thresholds to fixed-point parameters
+ *
+ * Called whenever the configuration changes; the per-sample path then
+ * uses integer arithmetic only.
+ *
+ * @param params            Output parameters
+ * @param bias              Bias offset from calibration (m/s²)
+ * @param noise_threshold   Acceleration noise floor (m/s²)
+ * @param accel_range       Accelerometer range: 0=±2g, 1=±4g, 2=±8g, 3=±16g
+ */
+void motion_fx_params_init(motion_fx_params_t *params, const mpu6050_cal_data_t *bias, float noise_threshold, uint8_t accel_range);
+
+/**
+ * @brief Fixed-point equivalent of process_accel_data working on raw counts
+ *
+ * Velocity and displacement saturate instead of wrapping; every clamp is
+ * counted in state->saturations.
+ *
+ * @param raw               Raw sensor counts
+ * @param params            Fixed-point parameters from motion_fx_params_init
+ * @param dt_us             Time step between samples (in microseconds)
+ * @param state             Pointer to persistent fixed-point motion state
+ */
+void process_accel_data_fx(const mpu6050_raw_t *raw, const motion_fx_params_t *params, uint32_t dt_us, motion_fx_state_t *state);
+
+/**
+ * @brief Convert the fixed-point state to physical units for output
+ *
+ * @param fx                Fixed-point motion state
+ * @param state             Output motion state
+ */
+void motion_fx_to_state(const motion_fx_state_t *fx, motion_state_t *state);
+
+#endif // MOTION_H
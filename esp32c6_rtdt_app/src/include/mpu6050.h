@@ -1,36 +1,167 @@
 #ifndef MPU6050_H 
 #define MPU6050_H 
 
-#include "driver/i2c.h"     
+#include "driver/i2c_master.h"
 #include "driver/gpio.h"    
 #include "esp_err.h"        
 #include "esp_log.h"        
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
 // --- MPU6050 Device Constants ---
 
-#define MPU6050_ADDR         0x68    // Default I2C address of MPU6050
+#define MPU6050_ADDR         0x68    // Default I2C address of MPU6050 (AD0 low)
+#define MPU6050_ADDR_ALT     0x69    // Alternate I2C address of MPU6050 (AD0 high)
 #define MPU6050_DEVICE_ID    0x68    // Expected WHO_AM_I register value
 #define MPU6050_CLKSEL_PLL   0x01    // Clock source: X-axis gyroscope PLL
 #define MPU6050_WAKE_UP      0x00    // Command to wake the sensor from sleep
 
+#define MPU6050_SCL_SPEED_HZ 400000  // I2C clock for register access
+#define MPU6050_TIMEOUT_MS   10      // Bound on a single register transaction
+#define MPU6050_FIFO_TIMEOUT_MS 50   // Bound on a FIFO burst (a full 1 KB FIFO takes ~25 ms at 400 kHz)
+#define MPU6050_ABORT_MS     20      // Wait for a timed-out transfer to end after the bus reset
+
+#define MPU6050_BUS_WAIT_MS  200     // Longest a housekeeping transfer waits for the sampler to yield the bus
+#define MPU6050_BUS_SLOT_US  500     // Window left before the sampler's next sample for a housekeeping transfer to start
+
+#define MPU6050_CAL_SAMPLES  100     // Samples averaged by mpu6050_calibrate
+#define MPU6050_CAL_PERIOD_MS 10     // Spacing of the calibration samples
+
 // --- Register Map Addresses ---
 
 #define MPU6050_WHO_AM_I     0x75    // WHO_AM_I register (device ID)
 #define MPU6050_PWR_MGMT_1   0x6B    // Power management register
+#define MPU6050_PWR_MGMT_2   0x6C    // Power management 2 (cycle mode wake-up rate, axis standby)
 
 #define MPU6050_SMPLRT_DIV   0x19    // Sample rate divider register
 #define MPU6050_CONFIG       0x1A    // Configuration register (DLPF, FSYNC)
 #define MPU6050_GYRO_CONFIG  0x1B    // Gyroscope range configuration
 #define MPU6050_ACCEL_CONFIG 0x1C    // Accelerometer range configuration
+#define MPU6050_MOT_THR      0x1F    // Motion detection threshold (MPU6050_MOT_THR_MG per LSB)
+#define MPU6050_MOT_DUR      0x20    // Samples above the threshold before motion is signalled
 
 #define MPU6050_ACCEL_XOUT_H 0x3B    // Start of accelerometer data (6 bytes total: X, Y, Z, each in H and L)
 #define MPU6050_GYRO_XOUT_H  0x43    // Start of gyroscope data (6 bytes total: X, Y, Z, each in H and L)
 #define MPU6050_TEMP_OUT_H   0x41    // Temperature data high byte (2 bytes total: H, L)
+#define MPU6050_BURST_SIZE   14      // ACCEL_XOUT_H..GYRO_ZOUT_L (accel 6, temp 2, gyro 6)
+
+#define MPU6050_FIFO_EN      0x23    // Selects which sensor data is pushed into the FIFO
+#define MPU6050_INT_PIN_CFG  0x37    // INT pin behaviour (level, latch, clear mode)
+#define MPU6050_INT_ENABLE   0x38    // Interrupt enable register
+#define MPU6050_INT_STATUS   0x3A    // Interrupt status register (cleared on read)
+#define MPU6050_USER_CTRL    0x6A    // User control register (FIFO enable / reset)
+#define MPU6050_FIFO_COUNT_H 0x72    // Number of bytes in the FIFO (2 bytes total: H, L)
+#define MPU6050_FIFO_R_W     0x74    // FIFO data read port
+
+// --- Register Bit Fields ---
+
+#define MPU6050_FIFO_EN_ACCEL        0x08    // FIFO_EN: push ACCEL_XOUT..ACCEL_ZOUT
+#define MPU6050_FIFO_EN_GYRO         0x70    // FIFO_EN: push GYRO_XOUT..GYRO_ZOUT (XG, YG, ZG)
+#define MPU6050_USER_CTRL_FIFO_EN    0x40    // USER_CTRL: enable FIFO operation
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04    // USER_CTRL: reset FIFO buffer (self clearing)
+#define MPU6050_INT_FIFO_OFLOW       0x10    // INT_STATUS: FIFO overflow occurred
+#define MPU6050_INT_DATA_RDY         0x01    // INT_ENABLE / INT_STATUS: new sample available
+#define MPU6050_INT_PIN_RD_CLEAR     0x10    // INT_PIN_CFG: any register read clears the interrupt
+#define MPU6050_INT_PIN_LATCH        0x20    // INT_PIN_CFG: INT stays high until the interrupt is cleared
+#define MPU6050_INT_MOT              0x40    // INT_ENABLE / INT_STATUS: motion detected
+#define MPU6050_PWR_CYCLE            0x20    // PWR_MGMT_1: sleep between single accelerometer samples
+#define MPU6050_PWR_TEMP_DIS         0x08    // PWR_MGMT_1: temperature sensor off
+#define MPU6050_PWR_STBY_GYRO        0x07    // PWR_MGMT_2: gyroscope X, Y and Z in standby
+#define MPU6050_LP_WAKE_SHIFT        6       // PWR_MGMT_2: cycle mode wake-up rate (0..3 = 1.25, 5, 20, 40 Hz)
+#define MPU6050_ACCEL_HPF_5HZ        0x01    // ACCEL_CONFIG: motion detection high-pass at 5 Hz
+#define MPU6050_ACCEL_HPF_HOLD       0x07    // ACCEL_CONFIG: motion detection against the sample held when set
+#define MPU6050_MOT_THR_MG           2       // Motion threshold per MOT_THR LSB (mg)
+#define MPU6050_FS_SEL_SHIFT         3       // GYRO_CONFIG / ACCEL_CONFIG: full-scale range field
+
+// --- FIFO Constants ---
+
+#define MPU6050_FIFO_SIZE             1024   // FIFO capacity in bytes
+#define MPU6050_FIFO_FRAME_ACCEL      6      // Bytes per frame when only accel is buffered
+#define MPU6050_FIFO_FRAME_ACCEL_GYRO 12     // Bytes per frame when accel and gyro are buffered
+#define MPU6050_FIFO_MAX_FRAMES       (MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_ACCEL)
 
 // --- Scaling Factors ---
 
-#define ACCEL_SCALE (9.80665 / 16384.0) // Convert raw accel data (LSB) to m/s² for ±2g
-#define GYRO_SCALE  (1.0 / 131.0)       // Convert raw gyro data (LSB) to °/s for ±250°/s
+#define ACCEL_SCALE (9.80665f / 16384.0f) // Convert raw accel data (LSB) to m/s² for ±2g
+#define GYRO_SCALE  (1.0f / 131.0f)       // Convert raw gyro data (LSB) to °/s for ±250°/s
+#define MPU6050_RANGES 4                  // Full-scale range codes 0..3 of accel and gyro
+
+extern const float mpu6050_accel_scale[MPU6050_RANGES];  // m/s² per LSB by accel_range (ACCEL_SCALE << range)
+extern const float mpu6050_gyro_scale[MPU6050_RANGES];   // °/s per LSB by gyro_range (datasheet sensitivities)
+
+// --- Bus Arbitration ---
+
+/**
+ * @brief Priority gate of the sensors sharing one I2C bus
+ *
+ * One task, the sampler, owns the bus timing: its transfers never wait for
+ * the gate. Every other task's transfer is housekeeping and only starts
+ * while the sampler has yielded the bus, and only if it can finish before
+ * the sampler's next sample is due. A sampler claim therefore waits for at
+ * most the one housekeeping transfer already on the wire, an I2C
+ * transaction not being interruptible; `hk_lock` is held for the duration
+ * of that transfer and lends it the sampler's priority while it waits.
+ *
+ * hk_lock:              Held by the housekeeping transfer in progress
+ * sampler:              Task whose transfers have priority (NULL = none yet)
+ * claimed:              The sampler is reading, housekeeping waits
+ * window_end_us:        Housekeeping must be done by this time (0 = no sample due)
+ * granted:              Housekeeping transfers started
+ * deferred:             Housekeeping attempts put off by a claim or a short window
+ * timeouts:             Housekeeping transfers that gave up after MPU6050_BUS_WAIT_MS
+ * preempts:             Claims that found a housekeeping transfer on the wire
+ * preempt_max_us:       Longest a claim waited for it
+ */
+typedef struct {
+    SemaphoreHandle_t hk_lock;
+    TaskHandle_t sampler;
+    volatile bool claimed;
+    volatile int64_t window_end_us;
+    uint32_t granted;
+    uint32_t deferred;
+    uint32_t timeouts;
+    uint32_t preempts;
+    int64_t preempt_max_us;
+} mpu6050_bus_t;
+
+// --- Device Handle ---
+
+/**
+ * @brief Identifies one MPU6050 on an I2C master bus
+ *
+ * Every driver call takes a handle, so several sensors can share a bus
+ * (one at MPU6050_ADDR, one at MPU6050_ADDR_ALT) or use separate buses.
+ *
+ * All transfers are queued asynchronously on the bus; completion is
+ * signalled from the bus interrupt through `done`. Blocking API calls
+ * simply wait for their own completion with a bounded timeout, while
+ * mpu6050_read_raw_start / mpu6050_read_raw_finish let the caller do other
+ * work during the transfer. `lock` serializes users of the same sensor
+ * from the start of a transfer until its completion has been collected.
+ *
+ * The bus driver reads and writes the transfer's buffers until it
+ * completes, so they live here (or in the FIFO state), never on a caller's
+ * stack. A transfer that times out is aborted with a bus reset while the
+ * lock is still held; if even its completion does not come, the device
+ * stays `busy` and its next transfer collects the completion first.
+ */
+typedef struct {
+    i2c_master_bus_handle_t bus;        // Bus of the device, reset to abort a stuck transfer
+    i2c_master_dev_handle_t handle;     // Device on the bus (from mpu6050_add_device)
+    uint8_t addr;                       // 7-bit I2C address
+    SemaphoreHandle_t lock;             // Held for the duration of a transfer
+    SemaphoreHandle_t done;             // Given by the transfer-done callback
+    mpu6050_bus_t *gate;                // Priority gate of the bus (NULL = none)
+    uint8_t accel_range;                // Full-scale ranges last written, tag every raw read
+    uint8_t gyro_range;
+    volatile esp_err_t status;          // Result of the last completed transfer
+    bool busy;                          // An aborted transfer has not completed yet
+    uint32_t resets;                    // Bus resets after a transfer timed out
+    uint8_t tx[2];                      // Transmit buffer of the transfer in flight (register, value)
+    uint8_t rx[MPU6050_BURST_SIZE];     // Receive buffer of the transfer in flight
+} mpu6050_dev_t;
 
 // --- Configuration Structure ---
 
@@ -59,6 +190,21 @@ typedef struct {
     float temp; // Temperature in °C
 } mpu6050_data_t;
 
+/**
+ * @brief Raw register values from the MPU6050 (counts, before scaling)
+ */
+typedef struct {
+    int16_t ax;     // Acceleration in X (LSB)
+    int16_t ay;     // Acceleration in Y (LSB)
+    int16_t az;     // Acceleration in Z (LSB)
+    int16_t temp;   // Temperature (LSB)
+    int16_t gx;     // Angular velocity in X (LSB)
+    int16_t gy;     // Angular velocity in Y (LSB)
+    int16_t gz;     // Angular velocity in Z (LSB)
+    uint8_t accel_range;    // Accelerometer range the counts were measured with
+    uint8_t gyro_range;     // Gyroscope range the counts were measured with
+} mpu6050_raw_t;
+
 // --- Calibration Data Structure ---
 
 /**
@@ -72,61 +218,309 @@ typedef struct {
     float gx_bias;
     float gy_bias;
     float gz_bias;
+    float temp;       // Sensor temperature during calibration (°C)
 } mpu6050_cal_data_t;
 
+// --- FIFO State Structure ---
+
+/**
+ * @brief FIFO acquisition state and burst buffer
+ *
+ * The buffer is sized for a completely full FIFO so that a single burst
+ * read can always drain everything that is available. It is the receive
+ * buffer of the burst, so the state must outlive the read.
+ */
+typedef struct {
+    bool with_gyro;                     // Gyro samples are pushed along with accel
+    uint8_t frame_size;                 // Bytes per FIFO frame (6 or 12)
+    uint32_t overflows;                 // Number of FIFO overflows detected
+    uint32_t resyncs;                   // Number of FIFO resets (overflows and calibrations)
+    uint8_t buf[MPU6050_FIFO_SIZE];     // Burst read buffer
+} mpu6050_fifo_t;
+
 // --- MPU6050 API Functions ---
 
+/**
+ * @brief Initialize the priority gate of a bus
+ *
+ * The gate starts without a sampler and open, so every transfer proceeds.
+ *
+ * @param gate Gate to initialize
+ * @return esp_err_t ESP_OK or ESP_ERR_NO_MEM
+ */
+esp_err_t mpu6050_bus_init(mpu6050_bus_t *gate);
+
+/**
+ * @brief Make the calling task the sampler of the bus
+ *
+ * @param gate Bus gate
+ */
+void mpu6050_bus_set_sampler(mpu6050_bus_t *gate);
+
+/**
+ * @brief Sampler: take the bus before reading a sample
+ *
+ * Stops new housekeeping transfers and waits for one already on the wire.
+ *
+ * @param gate Bus gate
+ */
+void mpu6050_bus_claim(mpu6050_bus_t *gate);
+
+/**
+ * @brief Sampler: hand the bus to housekeeping until the next sample
+ *
+ * @param gate Bus gate
+ * @param until_us Time the next sample is due (esp_timer), 0 if none is
+ *                 (samples wait in the sensor, or are not being taken)
+ */
+void mpu6050_bus_yield(mpu6050_bus_t *gate, int64_t until_us);
+
+/**
+ * @brief Attach an MPU6050 to an I2C master bus
+ *
+ * Creates the bus device, its synchronization objects and registers the
+ * transfer-done callback that makes its transfers asynchronous. The bus
+ * must have been created with a non-zero trans_queue_depth.
+ *
+ * @param bus I2C master bus
+ * @param gate Priority gate shared by the sensors on the bus, or NULL
+ * @param addr 7-bit I2C address (MPU6050_ADDR or MPU6050_ADDR_ALT)
+ * @param dev Device handle to initialize
+ * @return esp_err_t ESP_OK or error code on failure
+ */
+esp_err_t mpu6050_add_device(i2c_master_bus_handle_t bus, mpu6050_bus_t *gate, uint8_t addr, mpu6050_dev_t *dev);
+
+/**
+ * @brief Read the WHO_AM_I register
+ *
+ * @param dev Device handle
+ * @param who_am_i Output register value (MPU6050_DEVICE_ID when healthy)
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_who_am_i(mpu6050_dev_t *dev, uint8_t *who_am_i);
+
 /**
  * @brief Initialize the MPU6050 sensor (wake from sleep and check WHO_AM_I)
  * 
- * @param port I2C port (e.g., I2C_NUM_0)
+ * @param dev Device handle
  * @return esp_err_t ESP_OK on success or error code on failure
  */
-esp_err_t mpu6050_init(i2c_port_t port);
+esp_err_t mpu6050_init(mpu6050_dev_t *dev);
 
 /**
  * @brief Configure the MPU6050 with specified range and filtering settings
  * 
- * @param port I2C port
+ * @param dev Device handle
  * @param cfg Pointer to mpu6050_config_t struct
  * @return esp_err_t ESP_OK or error code on failure
  */
-esp_err_t mpu6050_config(i2c_port_t port, const mpu6050_config_t *cfg);
+esp_err_t mpu6050_config(mpu6050_dev_t *dev, const mpu6050_config_t *cfg);
+
+/**
+ * @brief Change the full-scale ranges, writing only the registers that differ
+ *
+ * Samples latched once the write has completed use the new ranges, and
+ * raw reads are tagged with them from then on.
+ *
+ * @param dev Device handle
+ * @param accel_range Accelerometer range code (0..3)
+ * @param gyro_range Gyroscope range code (0..3)
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_set_range(mpu6050_dev_t *dev, uint8_t accel_range, uint8_t gyro_range);
 
 /**
  * @brief Read and convert accelerometer data
  * 
- * @param port I2C port
+ * @param dev Device handle
  * @param data Output struct to store accel data
  * @return esp_err_t ESP_OK or error code
  */
-esp_err_t mpu6050_read_accel(i2c_port_t port, mpu6050_data_t *data);
+esp_err_t mpu6050_read_accel(mpu6050_dev_t *dev, mpu6050_data_t *data);
 
 /**
  * @brief Read and convert gyroscope data
  * 
- * @param port I2C port
+ * @param dev Device handle
  * @param data Output struct to store gyro data
  * @return esp_err_t ESP_OK or error code
  */
-esp_err_t mpu6050_read_gyro(i2c_port_t port, mpu6050_data_t *data);
+esp_err_t mpu6050_read_gyro(mpu6050_dev_t *dev, mpu6050_data_t *data);
 
 /**
  * @brief Read and convert temperature data
  * 
- * @param port I2C port
+ * @param dev Device handle
  * @param data Output struct to store temperature
  * @return esp_err_t ESP_OK or error code
  */
-esp_err_t mpu6050_read_temp(i2c_port_t port, mpu6050_data_t *data);
+esp_err_t mpu6050_read_temp(mpu6050_dev_t *dev, mpu6050_data_t *data);
+
+/**
+ * @brief Read and convert accel, temperature and gyro data in one transaction
+ *
+ * Burst reads ACCEL_XOUT_H through GYRO_ZOUT_L so that all values belong to
+ * the same sensor sample and only one bus round trip is needed.
+ * 
+ * @param dev Device handle
+ * @param data Output struct to store all sensor data
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_read_all(mpu6050_dev_t *dev, mpu6050_data_t *data);
+
+/**
+ * @brief Read raw accel, temperature and gyro counts in one transaction
+ *
+ * Same burst as mpu6050_read_all without the conversion to physical units.
+ * 
+ * @param dev Device handle
+ * @param raw Output struct to store raw counts
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_read_raw(mpu6050_dev_t *dev, mpu6050_raw_t *raw);
+
+/**
+ * @brief Queue a raw 14-byte burst read without waiting for it
+ *
+ * The sensor stays locked until mpu6050_read_raw_finish is called from the
+ * same task, which must happen for every successful start.
+ *
+ * @param dev Device handle
+ * @return esp_err_t ESP_OK if the transfer was queued, or error code
+ */
+esp_err_t mpu6050_read_raw_start(mpu6050_dev_t *dev);
+
+/**
+ * @brief Wait for a read queued by mpu6050_read_raw_start and decode it
+ *
+ * @param dev Device handle
+ * @param raw Output struct to store raw counts
+ * @param timeout_ms Longest time to wait for completion
+ * @return esp_err_t ESP_OK, ESP_ERR_TIMEOUT, or the bus error of the transfer
+ */
+esp_err_t mpu6050_read_raw_finish(mpu6050_dev_t *dev, mpu6050_raw_t *raw, uint32_t timeout_ms);
+
+/**
+ * @brief Convert raw counts to physical units
+ *
+ * Uses the scale of the ranges the counts are tagged with.
+ *
+ * @param raw Raw counts
+ * @param data Output struct to store converted data
+ */
+void mpu6050_raw_to_data(const mpu6050_raw_t *raw, mpu6050_data_t *data);
 
 /**
- * @brief Calibrate accelerometer by computing bias offsets
+ * @brief Calibrate accelerometer and gyroscope by computing bias offsets
+ *
+ * Averages MPU6050_CAL_SAMPLES burst reads taken MPU6050_CAL_PERIOD_MS
+ * apart; the sensor must be at rest. The mean temperature is recorded so
+ * that a stored calibration can later be checked against the current one.
  * 
- * @param port I2C port
+ * @param dev Device handle
  * @param cal_data Pointer to store computed calibration offsets
  * @return esp_err_t ESP_OK or error code
  */
-esp_err_t mpu6050_calibrate_accel(i2c_port_t port, mpu6050_cal_data_t *cal_data);
+esp_err_t mpu6050_calibrate(mpu6050_dev_t *dev, mpu6050_cal_data_t *cal_data);
+
+/**
+ * @brief Compute the sensor output rate for a given configuration
+ *
+ * The gyro output rate is 8kHz when the DLPF is disabled (dlpf_cfg 0 or 7)
+ * and 1kHz otherwise. The sample rate is that divided by (1 + smplrt_div).
+ *
+ * @param cfg Pointer to mpu6050_config_t struct
+ * @return float Sample rate in Hz
+ */
+float mpu6050_sample_rate_hz(const mpu6050_config_t *cfg);
+
+/**
+ * @brief Enable or disable the data-ready interrupt on the INT pin
+ *
+ * The INT pin is configured active high with a 50us pulse per sample, so
+ * a rising edge marks the instant a new sample has been latched.
+ *
+ * @param dev Device handle
+ * @param enable true to raise INT on every new sample, false to mask it
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_data_ready_int(mpu6050_dev_t *dev, bool enable);
+
+/**
+ * @brief Reset and enable the FIFO
+ *
+ * @param dev Device handle
+ * @param fifo FIFO state; with_gyro selects the frame layout
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_fifo_enable(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo);
+
+/**
+ * @brief Stop pushing samples into the FIFO and disable it
+ *
+ * @param dev Device handle
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_fifo_disable(mpu6050_dev_t *dev);
+
+/**
+ * @brief Put the sensor into low-power accelerometer cycle mode
+ *
+ * The gyroscope and the temperature sensor are put in standby and the
+ * sensor sleeps between single accelerometer samples at the lp_wake rate.
+ * With a threshold, every sample is compared against the acceleration at
+ * entry (high-pass hold) and a difference above it on any axis raises the
+ * motion interrupt; the INT pin is latched high until mpu6050_motion_wake.
+ * The caller keeps the sensor still while this runs: the hold reference is
+ * taken one tick after the high-pass filter is started.
+ *
+ * @param dev Device handle
+ * @param threshold_mg Motion threshold (mg), 0 for no motion interrupt
+ * @param lp_wake Wake-up rate code (0..3 = 1.25, 5, 20, 40 Hz)
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_motion_standby(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t lp_wake);
+
+/**
+ * @brief Leave cycle mode for full-rate sampling
+ *
+ * Restores the PLL clock, the gyroscope, the accelerometer range without
+ * high-pass and the data-ready pin mode, masks the interrupts and clears
+ * a latched motion interrupt. Sample rate and DLPF are not touched by the
+ * cycle mode. The gyroscope needs its start-up time (30 ms typical) before
+ * its readings settle.
+ *
+ * @param dev Device handle
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_motion_wake(mpu6050_dev_t *dev);
+
+/**
+ * @brief Discard the FIFO contents and restart buffering on a frame boundary
+ *
+ * @param dev Device handle
+ * @param fifo FIFO state (resync counter is updated)
+ * @return esp_err_t ESP_OK or error code
+ */
+esp_err_t mpu6050_fifo_reset(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo);
+
+/**
+ * @brief Drain buffered frames from the FIFO in a single burst read
+ *
+ * Reads FIFO_COUNT and then up to max_frames complete frames from FIFO_R_W.
+ * Frames are returned oldest first as raw counts; gyro fields are zero
+ * unless the FIFO buffers gyro samples. A frame the sensor is still writing
+ * is left in the FIFO for the next call. If the FIFO overflowed, it is reset
+ * and ESP_ERR_INVALID_STATE is returned: samples were lost and the caller
+ * must restart its time base.
+ *
+ * @param dev Device handle
+ * @param fifo FIFO state and burst buffer
+ * @param frames Output array of raw samples
+ * @param max_frames Capacity of the frames array
+ * @param n_frames Number of frames written to the output array
+ * @return esp_err_t ESP_OK, ESP_ERR_INVALID_STATE after a resync, or error code
+ */
+esp_err_t mpu6050_fifo_read(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo, mpu6050_raw_t *frames, size_t max_frames, size_t *n_frames);
 
 #endif // MPU6050_H
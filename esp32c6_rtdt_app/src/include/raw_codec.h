@@ -0,0 +1,62 @@
+#ifndef RAW_CODEC_H
+#define RAW_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Block Layout ---
+//
+// RAW_CODEC_RICE:
+//   | first sample, 6 x int16 LE (12) | bitstream, MSB first, zero padded |
+//
+//   For every channel: k (4 bits), then the n - 1 zigzag mapped deltas to
+//   the previous sample, Rice coded with parameter k: the quotient z >> k
+//   in unary (ones terminated by a zero) and the k low bits. A quotient of
+//   RAW_CODEC_ESCAPE or more is sent as RAW_CODEC_ESCAPE ones followed by
+//   z in 16 bits. Deltas wrap modulo 2^16, so any int16 input round-trips.
+//
+// RAW_CODEC_VERBATIM:
+//   n samples of 6 x int16 LE, used when coding would not save space.
+
+#define RAW_CODEC_CHANNELS          6       // Accel X, Y, Z and gyro X, Y, Z
+#define RAW_CODEC_BLOCK             16      // Samples per block (one telemetry frame)
+#define RAW_CODEC_K_BITS            4       // Width of the Rice parameter field
+#define RAW_CODEC_MAX_K             15      // Largest Rice parameter
+#define RAW_CODEC_ESCAPE            16      // Unary quotient length that introduces a verbatim value
+#define RAW_CODEC_MAX_BYTES         (RAW_CODEC_BLOCK * RAW_CODEC_CHANNELS * 2)  // Verbatim block size, bound for every block
+
+/**
+ * @brief Block encodings
+ */
+typedef enum {
+    RAW_CODEC_RICE = 0,
+    RAW_CODEC_VERBATIM,
+} raw_codec_mode_t;
+
+/**
+ * @brief Encode a block of samples
+ *
+ * Blocks are independent, a lost block does not affect the next one.
+ *
+ * @param samples Input samples, channels in RAW_CODEC_CHANNELS order
+ * @param n Number of samples (1..RAW_CODEC_BLOCK)
+ * @param out Output buffer, at least RAW_CODEC_MAX_BYTES
+ * @param mode Selected encoding
+ * @return size_t Number of bytes written to out
+ */
+size_t raw_codec_encode(const int16_t samples[][RAW_CODEC_CHANNELS], size_t n, uint8_t *out, raw_codec_mode_t *mode);
+
+/**
+ * @brief Decode a block of samples
+ *
+ * @param in Encoded block
+ * @param len Length of the encoded block
+ * @param mode Encoding of the block
+ * @param samples Output samples
+ * @param n Number of samples in the block (1..RAW_CODEC_BLOCK)
+ * @return true on success, false if the block is truncated or malformed
+ */
+bool raw_codec_decode(const uint8_t *in, size_t len, raw_codec_mode_t mode, int16_t samples[][RAW_CODEC_CHANNELS], size_t n);
+
+#endif // RAW_CODEC_H
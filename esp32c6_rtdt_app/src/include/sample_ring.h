@@ -0,0 +1,57 @@
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "telemetry.h"
+
+#define SAMPLE_RING_SIZE            256     // Number of slots, must be a power of two
+
+/**
+ * @brief Lock-free single-producer / single-consumer sample queue
+ *
+ * head is only written by the producer and tail only by the consumer, so
+ * no lock is needed: the release store of an index publishes the slot
+ * contents to the other side. Indices run freely and are masked on access.
+ * The producer never blocks; a push into a full ring is dropped and counted.
+ */
+typedef struct {
+    telemetry_sample_t slots[SAMPLE_RING_SIZE];
+    _Atomic uint32_t head;      // Next slot to write (producer)
+    _Atomic uint32_t tail;      // Next slot to read (consumer)
+    uint32_t overruns;          // Samples dropped because the ring was full (producer)
+    uint32_t high_water;        // Largest fill level observed (producer)
+} sample_ring_t;
+
+/**
+ * @brief Empty the ring and clear its counters
+ *
+ * Must not run concurrently with push or pop.
+ *
+ * @param ring Sample ring
+ */
+void sample_ring_init(sample_ring_t *ring);
+
+/**
+ * @brief Append a sample (producer side)
+ *
+ * @param ring Sample ring
+ * @param sample Sample to copy into the ring
+ * @return true if queued, false if the ring was full and the sample was dropped
+ */
+bool sample_ring_push(sample_ring_t *ring, const telemetry_sample_t *sample);
+
+/**
+ * @brief Remove up to max samples, oldest first (consumer side)
+ *
+ * @param ring Sample ring
+ * @param out Output array
+ * @param max Capacity of the output array
+ * @return size_t Number of samples copied to out
+ */
+size_t sample_ring_pop(sample_ring_t *ring, telemetry_sample_t *out, size_t max);
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,89 @@
+#ifndef STANDBY_H
+#define STANDBY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mpu6050.h"
+
+// --- Wake-on-Motion Standby ---
+//
+// While the readout is stopped with standby on, the sensors run in the
+// MPU6050's low-power accelerometer cycle mode and the primary sensor's
+// motion interrupt is the only wake source the readout waits for, so the
+// chip can light-sleep between the few tasks that still wake up. Motion
+// starts full-rate acquisition in the configured mode; once no sample of
+// the primary sensor has moved by more than STANDBY_MOTION_MG from its
+// running mean for STANDBY_QUIET_S, the readout goes back to standby.
+//
+// The motion interrupt compares against the acceleration when standby was
+// entered, the quiet check against a running mean over
+// 2^STANDBY_QUIET_SHIFT samples: both ignore gravity and a slow tilt.
+//
+// The current budget combines the measured share of time the CPU was busy
+// during standby with typical datasheet currents. The chip figures are
+// for a bare module; set them to the board's measured values.
+
+#define STANDBY_MOTION_MG           64      // Motion threshold of the wake interrupt and the quiet check (mg)
+#define STANDBY_LP_WAKE             1       // Sensor wake-ups in standby: MPU6050 LP_WAKE_CTRL code (1 = 5 Hz)
+#define STANDBY_QUIET_S             10.0f   // Time without motion before acquisition goes back to standby (s)
+#define STANDBY_QUIET_SHIFT         6       // Running mean of the quiet check over 2^n samples
+#define STANDBY_POLL_MS             1000    // Readout wake-up period in standby, commands take effect within it
+#define STANDBY_CPU_MHZ             160     // CPU clock while awake (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#define STANDBY_IDLE_MHZ            40      // CPU clock while idle in standby, the crystal (CONFIG_XTAL_FREQ)
+
+#define STANDBY_SENSOR_UA           20.0f   // MPU6050 in cycle mode at 5 Hz (typical)
+#define STANDBY_SENSOR_ACTIVE_UA    3900.0f // MPU6050 with accelerometer and gyroscope on (typical)
+#define STANDBY_CHIP_SLEEP_UA       180.0f  // ESP32-C6 in light sleep (typical)
+#define STANDBY_CHIP_ACTIVE_UA      25000.0f // ESP32-C6 awake at 160 MHz, radio off (typical)
+
+/**
+ * @brief Quiet check of one sensor's accelerometer
+ *
+ * mean:                 Running mean X..Z, scaled by 2^STANDBY_QUIET_SHIFT (counts)
+ * range:                Accelerometer range the mean is in
+ * primed:               mean holds a sample
+ * quiet_s:              Time every sample has stayed within the threshold of the mean (s)
+ */
+typedef struct {
+    int32_t mean[3];
+    uint8_t range;
+    bool primed;
+    float quiet_s;
+} standby_quiet_t;
+
+/**
+ * @brief Start over, as if the sensor had just moved
+ *
+ * @param q                 Quiet check
+ */
+void standby_quiet_reset(standby_quiet_t *q);
+
+/**
+ * @brief Account for a sample
+ *
+ * @param q                 Quiet check
+ * @param raw               Sample with its range tags
+ * @param dt                Time step of the sample (in seconds)
+ * @return true             The sensor has been quiet for STANDBY_QUIET_S
+ */
+bool standby_quiet_update(standby_quiet_t *q, const mpu6050_raw_t *raw, float dt);
+
+/**
+ * @brief Average current of a standby interval
+ *
+ * @param busy              Share of the interval the CPU was not idle (0..1)
+ * @param n_sensors         Sensors in cycle mode
+ * @return float            Sensors plus chip, asleep while idle (µA)
+ */
+float standby_current_ua(float busy, uint32_t n_sensors);
+
+/**
+ * @brief Average current of the same interval without standby
+ *
+ * @param n_sensors         Sensors sampling at full rate
+ * @return float            Sensors plus chip, awake throughout (µA)
+ */
+float standby_awake_current_ua(uint32_t n_sensors);
+
+#endif // STANDBY_H
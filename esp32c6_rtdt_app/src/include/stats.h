@@ -0,0 +1,51 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+
+#define STATS_HIST_BUCKETS          16      // Power-of-two buckets per histogram
+#define STATS_HIST_MIN_SHIFT        8       // First bucket holds [0, 2^8) cycles, the last one everything above 2^22
+
+/**
+ * @brief Fixed-bucket latency histogram in CPU cycles
+ *
+ * Bucket i counts durations in [2^(MIN_SHIFT + i - 1), 2^(MIN_SHIFT + i))
+ * cycles, so adding a sample is a count-leading-zeros and an increment.
+ * Each histogram must have a single writer; readers may see a sample
+ * counted in `count` but not yet in `buckets`.
+ */
+typedef struct {
+    uint32_t buckets[STATS_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max;                           // Largest duration (cycles)
+    uint64_t sum;                           // Sum of durations (cycles, mean = sum / count)
+} stats_hist_t;
+
+/**
+ * @brief Clear a histogram
+ *
+ * @param hist Histogram
+ */
+void stats_hist_reset(stats_hist_t *hist);
+
+/**
+ * @brief Count one duration
+ *
+ * @param hist Histogram
+ * @param cycles Duration in CPU cycles
+ */
+void stats_hist_add(stats_hist_t *hist, uint32_t cycles);
+
+/**
+ * @brief Log count, mean, max and the non-empty buckets of a histogram
+ *
+ * Bucket upper bounds are printed in microseconds.
+ *
+ * @param tag Log tag
+ * @param name Histogram name
+ * @param hist Histogram
+ * @param cycles_per_us CPU clock in cycles per microsecond
+ */
+void stats_hist_log(const char *tag, const char *name, const stats_hist_t *hist, uint32_t cycles_per_us);
+
+#endif // STATS_H
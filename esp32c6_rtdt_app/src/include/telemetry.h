@@ -0,0 +1,261 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "app_tasks.h"
+#include "event_capture.h"
+#include "raw_codec.h"
+
+// --- Frame Layout ---
+//
+// | sync (2) | type (1) | length (1) | payload (length) | crc16 (2) |
+//
+// All multi-byte fields are little-endian. The CRC (CRC-16/CCITT-FALSE)
+// covers type, length and payload. Frames share the console with text log
+// lines, so receivers resynchronize by scanning for the sync word.
+
+#define TELEMETRY_SYNC_0        0xAA    // First sync byte (never produced by ASCII log text)
+#define TELEMETRY_SYNC_1        0x55    // Second sync byte
+#define TELEMETRY_HEADER_SIZE   4       // Sync word, type and payload length
+#define TELEMETRY_CRC_SIZE      2       // Trailing CRC16
+#define TELEMETRY_MAX_PAYLOAD   255     // Payload length is a single byte
+#define TELEMETRY_MAX_FRAME     (TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE)
+#define TELEMETRY_BATCH_SIZE    16      // Samples serialized per console write
+#define TELEMETRY_EVENT_CHUNK   40      // Raw samples per event data frame (240 bytes)
+#define TELEMETRY_EVENT_BATCH   4       // Event data frames serialized per console write
+
+/**
+ * @brief Frame types
+ */
+typedef enum {
+    TELEMETRY_FRAME_MOTION = 0x01,      // telemetry_motion_payload_t
+    TELEMETRY_FRAME_EVENT = 0x02,       // telemetry_event_payload_t, starts an event dump
+    TELEMETRY_FRAME_EVENT_DATA = 0x03,  // telemetry_event_data_payload_t
+    TELEMETRY_FRAME_RAW = 0x04,         // telemetry_raw_header_t + raw_codec block
+    TELEMETRY_FRAME_INFO = 0x05,        // telemetry_info_payload_t, one per sensor on request
+    TELEMETRY_FRAME_STATE = 0x06,       // telemetry_state_payload_t, control mode output
+    TELEMETRY_FRAME_SYNC = 0x07,        // telemetry_sync_payload_t, reply to a ping command
+} telemetry_frame_type_t;
+
+/**
+ * @brief Payload of a motion frame (49 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint32_t seq;           // Sample sequence number (per sensor)
+    uint64_t t_us;          // Sample timestamp (esp_timer, in microseconds)
+    float ax, ay, az;       // acceleration in m/s²
+    float vx, vy, vz;       // velocity in m/s
+    float dx, dy, dz;       // displacement in meters
+} telemetry_motion_payload_t;
+
+#define TELEMETRY_MOTION_FRAME  (TELEMETRY_HEADER_SIZE + sizeof(telemetry_motion_payload_t) + TELEMETRY_CRC_SIZE)
+
+/**
+ * @brief Payload of a state frame (39 bytes)
+ *
+ * One per sensor and control period, all sensors of a period in one write.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint32_t period;        // Control period number since control mode was entered
+    uint64_t t_us;          // Data-ready timestamp of the sample the state belongs to
+    float vx, vy, vz;       // velocity in m/s
+    float dx, dy, dz;       // displacement in meters
+    uint16_t misses;        // Deadline misses since control mode was entered (saturating)
+} telemetry_state_payload_t;
+
+#define TELEMETRY_STATE_FRAME   (TELEMETRY_HEADER_SIZE + sizeof(telemetry_state_payload_t) + TELEMETRY_CRC_SIZE)
+
+/**
+ * @brief Payload of a sync frame (20 bytes)
+ *
+ * The reply to `ping:<id>`. The host stamps the command's write (t1) and
+ * the reply's arrival (t4); with the device stamps in between it knows
+ * the round trip without the device's turnaround, (t4 - t1) - (tx - rx),
+ * and the clock offset to within half of it.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t id;            // Ping identifier, echoed
+    uint64_t rx_us;         // Console read that completed the command line (esp_timer)
+    uint64_t tx_us;         // Reply handed to the console (esp_timer)
+} telemetry_sync_payload_t;
+
+/**
+ * @brief Payload of an event frame (24 bytes)
+ *
+ * Followed by the window as event data frames, oldest sample first. The
+ * trigger sample is at offset `pre`, the window holds pre + post samples.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint32_t event;         // Event number since boot
+    uint64_t t_us;          // Trigger sample timestamp (esp_timer, in microseconds)
+    uint16_t rate_hz;       // Sample rate of the window
+    uint16_t pre;           // Samples before the trigger
+    uint16_t post;          // Samples from the trigger on
+    uint16_t duration;      // Samples from trigger to detrigger, 0 if still active at the end
+    uint16_t peak_ratio;    // Largest STA/LTA (Q4)
+    uint8_t accel_range;    // Accelerometer range code of the counts, the widest measured in the window
+} telemetry_event_payload_t;
+
+/**
+ * @brief Payload of an event data frame (3 + 6 * n bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint16_t offset;        // Window index of the first sample
+    capture_sample_t samples[TELEMETRY_EVENT_CHUNK];    // Raw counts, n = (length - 3) / 6
+} telemetry_event_data_payload_t;
+
+/**
+ * @brief Header of a raw frame (21 bytes), followed by the encoded block
+ *
+ * Sample i of the block has sequence number seq + i and was taken at
+ * t_us + i * span_us / (n - 1). Counts are as measured, a block ends at a
+ * range switch so all of its samples share the ranges in the header.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint8_t mode;           // raw_codec_mode_t
+    uint8_t n;              // Samples in the block
+    uint32_t seq;           // Sequence number of the first sample
+    uint64_t t_us;          // Timestamp of the first sample (esp_timer, in microseconds)
+    uint32_t span_us;       // Time from the first to the last sample
+    uint8_t accel_range;    // Accelerometer range code of the counts (0..3)
+    uint8_t gyro_range;     // Gyroscope range code of the counts (0..3)
+} telemetry_raw_header_t;
+
+/**
+ * @brief Payload of an info frame (46 bytes): configuration and calibration of one sensor
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t dev;            // Sensor index (0 = primary)
+    uint8_t addr;           // I2C address
+    uint8_t accel_range;    // mpu6050_config_t fields
+    uint8_t gyro_range;
+    uint8_t dlpf_cfg;
+    uint8_t smplrt_div;
+    uint8_t acq_mode;       // acq_mode_t
+    uint8_t output;         // output_format_t
+    uint8_t math;           // math_mode_t
+    uint8_t decim;          // decim_mode_t
+    uint32_t update_rate_ms;
+    float sample_rate_hz;   // Sensor output data rate
+    float ax_bias, ay_bias, az_bias;    // Accelerometer bias (m/s²)
+    float gx_bias, gy_bias, gz_bias;    // Gyroscope bias (°/s)
+    float cal_temp;         // Temperature during calibration (°C)
+} telemetry_info_payload_t;
+
+/**
+ * @brief Timestamped motion sample handed from acquisition to output
+ */
+typedef struct {
+    uint8_t dev;                // Sensor index (0 = primary)
+    uint32_t seq;               // Sample sequence number (per sensor)
+    int64_t t_us;               // Sample timestamp (esp_timer, in microseconds)
+    motion_state_t state;       // Motion state at t_us
+    mpu6050_raw_t raw;          // Sensor counts the state was computed from
+} telemetry_sample_t;
+
+/**
+ * @brief Compute the CRC-16/CCITT-FALSE checksum (poly 0x1021, init 0xFFFF)
+ *
+ * @param data    Input bytes
+ * @param len     Number of bytes
+ * @return uint16_t Checksum
+ */
+uint16_t telemetry_crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief Build a complete frame around a payload
+ *
+ * @param buf     Output buffer, at least TELEMETRY_MAX_FRAME bytes
+ * @param type    Frame type
+ * @param payload Payload bytes
+ * @param len     Payload length
+ * @return size_t Number of bytes written to buf
+ */
+size_t telemetry_encode_frame(uint8_t *buf, uint8_t type, const void *payload, uint8_t len);
+
+/**
+ * @brief Build a motion frame for a sample
+ *
+ * @param buf     Output buffer, at least TELEMETRY_MOTION_FRAME bytes
+ * @param sample  Sample to encode
+ * @return size_t Number of bytes written to buf
+ */
+size_t telemetry_encode_motion(uint8_t *buf, const telemetry_sample_t *sample);
+
+/**
+ * @brief Publish a batch of motion samples on the console
+ *
+ * In text mode each state is logged as "Acceleration", "Velocity" and
+ * "Displacement" lines; in binary mode all frames of the batch are
+ * written with a single console write. In raw mode samples are collected
+ * per sensor and a raw frame is written for every RAW_CODEC_BLOCK
+ * consecutive samples.
+ *
+ * @param format  Output format
+ * @param samples Samples to publish, oldest first
+ * @param n       Number of samples (at most TELEMETRY_BATCH_SIZE)
+ */
+void telemetry_emit_batch(output_format_t format, const telemetry_sample_t *samples, size_t n);
+
+/**
+ * @brief Write the state frames of one control period
+ *
+ * Always binary, all frames with a single console write that returns
+ * once they are handed to the console driver.
+ *
+ * @param states  One payload per sensor
+ * @param n       Number of payloads (at most IMU_MAX_CHANNELS)
+ */
+void telemetry_emit_state(const telemetry_state_payload_t *states, size_t n);
+
+/**
+ * @brief Write a sync frame, stamped right before the console write
+ *
+ * Always binary, whatever the output format.
+ *
+ * @param id      Ping identifier
+ * @param rx_us   Time the command line was read (esp_timer, in microseconds)
+ */
+void telemetry_emit_sync(uint32_t id, int64_t rx_us);
+
+/**
+ * @brief Write the partially filled raw blocks
+ *
+ * Called when the sample stream pauses so the tail of a recording is not
+ * held back until the next block fills up.
+ */
+void telemetry_flush_raw(void);
+
+/**
+ * @brief Write one info frame per sensor
+ *
+ * Always binary, whatever the output format.
+ *
+ * @param config   Current configuration
+ * @param channels Sensor channels
+ * @param n        Number of channels
+ */
+void telemetry_emit_info(const task_config_t *config, const imu_channel_t *channels, size_t n);
+
+/**
+ * @brief Dump a frozen capture window on the console
+ *
+ * Writes an event frame followed by the whole window in event data
+ * frames, TELEMETRY_EVENT_BATCH frames per console write. Always binary,
+ * whatever the output format.
+ *
+ * @param ec          Capture in CAPTURE_FROZEN state
+ * @param dev         Sensor index reported in the frames
+ * @param rate_hz     Sample rate of the window
+ * @return size_t Number of bytes written, 0 if the capture is not frozen
+ */
+size_t telemetry_emit_event(const event_capture_t *ec, uint8_t dev, uint16_t rate_hz);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,120 @@
+#include <math.h>
+#include <string.h>
+
+#include "kalman.h"
+
+void kalman_params_init(kalman_params_t *params, uint32_t dt_us) {
+    // State (d, v, b), input the measured acceleration, b subtracted from it
+    double h = dt_us / 1e6;
+    double f[3][3] = {{1.0, h, -0.5 * h * h}, {0.0, 1.0, -h}, {0.0, 0.0, 1.0}};
+    double g[3] = {0.5 * h * h, h, 0.0};
+    double q_a = (double)KALMAN_ACCEL_NOISE * KALMAN_ACCEL_NOISE;
+    double q_b = (double)KALMAN_BIAS_WALK * KALMAN_BIAS_WALK * h;
+    double r = (double)KALMAN_ZUPT_NOISE * KALMAN_ZUPT_NOISE;
+    double p[3][3] = {{0.0}};
+    double k[3] = {0.0};
+
+    p[2][2] = (double)KALMAN_BIAS_INIT * KALMAN_BIAS_INIT;
+
+    uint32_t it;
+    for (it = 1; it <= KALMAN_MAX_ITERATIONS; it++) {
+        double fp[3][3] = {{0.0}};
+        double pp[3][3];
+
+        // Prediction: F P F' + Q
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                for (int m = 0; m < 3; m++) { fp[i][j] += f[i][m] * p[m][j]; }
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                pp[i][j] = g[i] * g[j] * q_a;
+                for (int m = 0; m < 3; m++) { pp[i][j] += fp[i][m] * f[j][m]; }
+            }
+        }
+        pp[2][2] += q_b;
+
+        // Update with H = (0 1 0)
+        double s = pp[1][1] + r;
+        bool settled = true;
+        for (int i = 0; i < 3; i++) {
+            double kn = pp[i][1] / s;
+            if (fabs(kn - k[i]) > KALMAN_TOLERANCE * fabs(kn)) { settled = false; }
+            k[i] = kn;
+        }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) { p[i][j] = pp[i][j] - k[i] * pp[1][j]; }
+        }
+
+        if (settled) { break; }
+    }
+
+    params->dt_us = dt_us;
+    params->kd = (float)k[0];
+    params->kv = (float)k[1];
+    params->kb = (float)k[2];
+    params->iterations = it;
+
+    // The smoothed noise must not look like motion at low sample rates
+    float c = (float)(h / KALMAN_STILL_TAU_S);
+    if (c > 1.0f) { c = 1.0f; }
+    float noise = KALMAN_STILL_SIGMAS * KALMAN_ACCEL_NOISE * sqrtf(c / (2.0f - c));
+    params->still_c = c;
+    params->still_threshold = noise > KALMAN_STILL_THRESHOLD ? noise : KALMAN_STILL_THRESHOLD;
+}
+
+void kalman_init(kalman_state_t *kf, const mpu6050_cal_data_t *bias) {
+    memset(kf, 0, sizeof(*kf));
+
+    if (bias != NULL) {
+        kf->b[0] = bias->ax_bias;
+        kf->b[1] = bias->ay_bias;
+        kf->b[2] = bias->az_bias;
+    }
+}
+
+static inline void kalman_axis(const kalman_params_t *params, float u, float dt, bool zupt, float *b, float *v, float *d) {
+    // Prediction with the bias compensated acceleration
+    *d += (*v + 0.5f * u * dt) * dt;
+    *v += u * dt;
+
+    // Zero-velocity pseudo-measurement
+    if (zupt) {
+        float y = -*v;
+        *d += params->kd * y;
+        *v += params->kv * y;
+        *b += params->kb * y;
+    }
+}
+
+void kalman_update(const kalman_params_t *params, const mpu6050_data_t *data, float dt, kalman_state_t *kf,
+                   motion_state_t *state) {
+    float ux = data->ax - kf->b[0];
+    float uy = data->ay - kf->b[1];
+    float uz = data->az - kf->b[2];
+
+    // Stillness: the smoothed acceleration of every axis near zero for KALMAN_STILL_S
+    float c = params->still_c;
+    float threshold = params->still_threshold;
+    kf->lp[0] += c * (ux - kf->lp[0]);
+    kf->lp[1] += c * (uy - kf->lp[1]);
+    kf->lp[2] += c * (uz - kf->lp[2]);
+
+    bool still = fabsf(kf->lp[0]) < threshold && fabsf(kf->lp[1]) < threshold && fabsf(kf->lp[2]) < threshold;
+    if (!still) {
+        kf->still_s = 0.0f;
+    } else if (kf->still_s < KALMAN_STILL_S) {
+        kf->still_s += dt;
+    }
+    bool zupt = still && kf->still_s >= KALMAN_STILL_S;
+    if (zupt) { kf->updates++; }
+
+    kalman_axis(params, ux, dt, zupt, &kf->b[0], &state->vx, &state->dx);
+    kalman_axis(params, uy, dt, zupt, &kf->b[1], &state->vy, &state->dy);
+    kalman_axis(params, uz, dt, zupt, &kf->b[2], &state->vz, &state->dz);
+
+    state->ax = ux;
+    state->ay = uy;
+    state->az = uz;
+}
@@ -23,6 +23,8 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "app_tasks.h"
+#include "config_store.h"
+#include "cal_store.h"
 #include "mpu6050.h"
 
 static task_config_t task_cfg;
@@ -35,6 +37,14 @@ void app_main(void)
     task_cfg.start = false; // keep it idle
     task_cfg.update_rate_ms    = 50;
     task_cfg.accel_noise_floor = 0.5;
+    task_cfg.acq_mode          = ACQ_MODE_POLL;
+    task_cfg.output            = OUTPUT_TEXT;
+    task_cfg.math              = MATH_FLOAT;
+    task_cfg.decim             = DECIM_FIR;
+    task_cfg.tilt              = true;
+    task_cfg.drift             = DRIFT_HOLD;
+    task_cfg.autorange         = false;
+    task_cfg.standby           = false;
     task_cfg.cfg = (mpu6050_config_t){
         .accel_range = 0,      // +-2g
         .gyro_range  = 0,      // +-250 deg/sec
@@ -42,6 +52,12 @@ void app_main(void)
         .smplrt_div  = 0       // Sample rate = 1kHz / (1 + 0) = 1kHz
     };
     
+    // calibration cache, a failure only costs a fresh calibration at boot
+    res = cal_store_init();
+    if (res != ESP_OK) {
+        ESP_LOGW("System", "NVS Initialization failed: %s", esp_err_to_name(res));
+    }
+
     // initialize the I2C interface
     res = i2c_master_init(); 
     if (res != ESP_OK) {
@@ -49,17 +65,17 @@ void app_main(void)
         vTaskSuspend(NULL);
     }
 
-    // initialize the MPU6050 device
-    res = mpu6050_init(I2C_NUM_0);
+    // initialize and configure the MPU6050 devices
+    res = imu_channels_init(&task_cfg.cfg);
     if (res != ESP_OK) {
         ESP_LOGE("System", "MPU6050 Initialization failed: %s", esp_err_to_name(res));
         vTaskSuspend(NULL);
     }
 
-    // configure MPU6050 device
-    res = mpu6050_config(I2C_NUM_0, &task_cfg.cfg);
+    // publish the defaults as the first configuration snapshot
+    res = config_store_init(&task_cfg);
     if (res != ESP_OK) {
-        ESP_LOGI("System", "MPU6050 Configuration failed: %s", esp_err_to_name(res));
+        ESP_LOGE("System", "Configuration store failed: %s", esp_err_to_name(res));
         vTaskSuspend(NULL);
     }
 
@@ -81,7 +97,17 @@ void app_main(void)
         "accel_readout",
         2048,
         &task_cfg,
-        2,
+        READOUT_TASK_PRIORITY,
+        NULL
+    );
+
+    // start the telemetry output task below the readout task
+    xTaskCreate(
+        telemetry_task,
+        "telemetry",
+        4096,
+        &task_cfg,
+        1,
         NULL
     );
 
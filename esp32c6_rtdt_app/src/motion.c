@@ -0,0 +1,214 @@
+#include <math.h>
+
+#include "motion.h"
+
+void process_accel_data(mpu6050_data_t data, mpu6050_cal_data_t bias, float noise_threshold, float dt, motion_state_t *state, motion_hold_t *hold) {
+    // Bias Compensation
+    float ax = data.ax - bias.ax_bias;
+    float ay = data.ay - bias.ay_bias;
+    float az = data.az - bias.az_bias;
+
+    // Noise Filtering
+    if (fabsf(ax) < noise_threshold) ax = 0;
+    if (fabsf(ay) < noise_threshold) ay = 0;
+    if (fabsf(az) < noise_threshold) az = 0;
+
+    // Stillness Detection with Hold Time 
+    float stationary_threshold = MOTION_STATIONARY_THRESHOLD;
+    int hold_cycles = MOTION_HOLD_CYCLES;  // Number of consecutive samples to confirm stillness
+
+    // X-axis
+    if (fabsf(ax) < stationary_threshold) {
+        if (hold->ax_still_count < hold_cycles) { hold->ax_still_count++; }
+        if (hold->ax_still_count >= hold_cycles) {
+            state->vx = 0;
+        }
+    } else {
+        hold->ax_still_count = 0;
+        state->vx += ax * dt;
+        state->dx += state->vx * dt;
+    }
+
+    // Y-axis
+    if (fabsf(ay) < stationary_threshold) {
+        if (hold->ay_still_count < hold_cycles) { hold->ay_still_count++; }
+        if (hold->ay_still_count >= hold_cycles) {
+            state->vy = 0;
+        }
+    } else {
+        hold->ay_still_count = 0;
+        state->vy += ay * dt;
+        state->dy += state->vy * dt;
+    }
+
+    // Z-axis
+    if (fabsf(az) < stationary_threshold) {
+        if (hold->az_still_count < hold_cycles) { hold->az_still_count++; }
+        if (hold->az_still_count >= hold_cycles) {
+            state->vz = 0;
+        }
+    } else {
+        hold->az_still_count = 0;
+        state->vz += az * dt;
+        state->dz += state->vz * dt;
+    }
+
+    // Store acceleration in state
+    state->ax = ax;
+    state->ay = ay;
+    state->az = az;
+}
+
+/**
+ * @brief process_accel_data for one axis over a run of samples
+ *
+ * @param a_in              Acceleration before bias compensation (m/s²)
+ * @param dt                Time step of each sample (s)
+ * @param n                 Number of samples
+ * @param bias              Axis bias (m/s²)
+ * @param noise_threshold   Noise floor (m/s²)
+ * @param a, v, d           Axis state (last acceleration, velocity, displacement), updated
+ * @param still_count       Axis stillness counter, updated
+ * @param a_out, v_out, d_out Per-sample output or NULL
+ */
+static void motion_axis_block(const float *a_in, const float *dt, size_t n, float bias, float noise_threshold,
+                              float *a, float *v, float *d, uint16_t *still_count,
+                              float *a_out, float *v_out, float *d_out) {
+    float ai = *a, vi = *v, di = *d;
+    uint16_t count = *still_count;
+
+    for (size_t i = 0; i < n; i++) {
+        ai = a_in[i] - bias;
+        if (fabsf(ai) < noise_threshold) { ai = 0; }
+
+        if (fabsf(ai) < MOTION_STATIONARY_THRESHOLD) {
+            if (count < MOTION_HOLD_CYCLES) { count++; }
+            if (count >= MOTION_HOLD_CYCLES) { vi = 0; }
+        } else {
+            count = 0;
+            vi += ai * dt[i];
+            di += vi * dt[i];
+        }
+
+        if (a_out) { a_out[i] = ai; }
+        if (v_out) { v_out[i] = vi; }
+        if (d_out) { d_out[i] = di; }
+    }
+
+    *a = ai;
+    *v = vi;
+    *d = di;
+    *still_count = count;
+}
+
+void process_accel_block(const motion_block_t *block, const mpu6050_cal_data_t *bias, float noise_threshold,
+                         motion_state_t *state, motion_hold_t *hold, const motion_track_t *track) {
+    static const motion_track_t no_track = {0};
+    if (track == NULL) { track = &no_track; }
+
+    int64_t t_prev = block->t_prev_us;
+    uint32_t last_dt_us = 0;
+    float last_dt = 0.0f;
+    for (size_t start = 0; start < block->n; start += MOTION_BLOCK_STEPS) {
+        size_t n = block->n - start < MOTION_BLOCK_STEPS ? block->n - start : MOTION_BLOCK_STEPS;
+
+        // Time steps as process_sample computes them (whole microseconds, then
+        // seconds), with one division per distinct step: FIFO drains have one
+        float dt[MOTION_BLOCK_STEPS];
+        for (size_t i = 0; i < n; i++) {
+            uint32_t dt_us = (uint32_t)(block->t_us[start + i] - t_prev);
+            t_prev = block->t_us[start + i];
+            if (dt_us != last_dt_us) {
+                last_dt_us = dt_us;
+                last_dt = dt_us / 1e6f;
+            }
+            dt[i] = last_dt;
+        }
+
+#define MOTION_TRACK(member) (track->member ? track->member + start : NULL)
+        motion_axis_block(block->ax + start, dt, n, bias->ax_bias, noise_threshold, &state->ax, &state->vx, &state->dx,
+                          &hold->ax_still_count, MOTION_TRACK(ax), MOTION_TRACK(vx), MOTION_TRACK(dx));
+        motion_axis_block(block->ay + start, dt, n, bias->ay_bias, noise_threshold, &state->ay, &state->vy, &state->dy,
+                          &hold->ay_still_count, MOTION_TRACK(ay), MOTION_TRACK(vy), MOTION_TRACK(dy));
+        motion_axis_block(block->az + start, dt, n, bias->az_bias, noise_threshold, &state->az, &state->vz, &state->dz,
+                          &hold->az_still_count, MOTION_TRACK(az), MOTION_TRACK(vz), MOTION_TRACK(dz));
+#undef MOTION_TRACK
+    }
+}
+
+static int32_t motion_fx_from_float(float value, int frac_bits) {
+    return (int32_t)lroundf(value * (float)(1L << frac_bits));
+}
+
+static int64_t motion_fx_clamp(int64_t value, int64_t limit, uint32_t *saturations) {
+    if (value > limit)  { (*saturations)++; return limit; }
+    if (value < -limit) { (*saturations)++; return -limit; }
+    return value;
+}
+
+static inline int32_t motion_fx_accel(int16_t counts, int32_t scale, int32_t bias, int32_t noise_threshold) {
+    // counts * Q8.24 scale -> Q16.16 m/s²
+    int32_t a = (int32_t)(((int64_t)counts * scale) >> (MOTION_FX_SCALE_FRAC - MOTION_FX_ACCEL_FRAC)) - bias;
+
+    // Noise Filtering
+    return (a < noise_threshold && a > -noise_threshold) ? 0 : a;
+}
+
+static inline void motion_fx_axis(int32_t a, int64_t dt_q32, const motion_fx_params_t *params,
+                                  uint16_t *still_count, int64_t *v, int64_t *d, uint32_t *saturations) {
+    // Stillness Detection with Hold Time
+    if (a < params->stationary_threshold && a > -params->stationary_threshold) {
+        if (*still_count < MOTION_HOLD_CYCLES) { (*still_count)++; }
+        if (*still_count >= MOTION_HOLD_CYCLES) {
+            *v = 0;
+        }
+        return;
+    }
+
+    *still_count = 0;
+
+    // Q16.16 * Q0.32 = Q16.48 -> Q40.24
+    *v = motion_fx_clamp(*v + (((int64_t)a * dt_q32) >> (MOTION_FX_ACCEL_FRAC + 32 - MOTION_FX_VEL_FRAC)),
+                         MOTION_FX_V_MAX, saturations);
+
+    // Q40.24 * Q0.32 = Q8.56 -> Q32.32
+    *d = motion_fx_clamp(*d + ((*v * dt_q32) >> (MOTION_FX_VEL_FRAC + 32 - MOTION_FX_DISP_FRAC)),
+                         MOTION_FX_D_MAX, saturations);
+}
+
+void motion_fx_params_init(motion_fx_params_t *params, const mpu6050_cal_data_t *bias, float noise_threshold, uint8_t accel_range) {
+    params->accel_scale          = motion_fx_from_float(ACCEL_SCALE * (1 << accel_range), MOTION_FX_SCALE_FRAC);
+    params->ax_bias              = motion_fx_from_float(bias->ax_bias, MOTION_FX_ACCEL_FRAC);
+    params->ay_bias              = motion_fx_from_float(bias->ay_bias, MOTION_FX_ACCEL_FRAC);
+    params->az_bias              = motion_fx_from_float(bias->az_bias, MOTION_FX_ACCEL_FRAC);
+    params->noise_threshold      = motion_fx_from_float(noise_threshold, MOTION_FX_ACCEL_FRAC);
+    params->stationary_threshold = motion_fx_from_float(MOTION_STATIONARY_THRESHOLD, MOTION_FX_ACCEL_FRAC);
+}
+
+void process_accel_data_fx(const mpu6050_raw_t *raw, const motion_fx_params_t *params, uint32_t dt_us, motion_fx_state_t *state) {
+    if (dt_us > MOTION_FX_MAX_DT_US) { dt_us = MOTION_FX_MAX_DT_US; }
+
+    // Microseconds to Q0.32 seconds: dt_us * 2^32 / 1e6 == (dt_us * 281474977) >> 16
+    int64_t dt_q32 = ((int64_t)dt_us * 281474977) >> 16;
+
+    // Bias Compensation and Noise Filtering
+    state->ax = motion_fx_accel(raw->ax, params->accel_scale, params->ax_bias, params->noise_threshold);
+    state->ay = motion_fx_accel(raw->ay, params->accel_scale, params->ay_bias, params->noise_threshold);
+    state->az = motion_fx_accel(raw->az, params->accel_scale, params->az_bias, params->noise_threshold);
+
+    motion_fx_axis(state->ax, dt_q32, params, &state->hold.ax_still_count, &state->vx, &state->dx, &state->saturations);
+    motion_fx_axis(state->ay, dt_q32, params, &state->hold.ay_still_count, &state->vy, &state->dy, &state->saturations);
+    motion_fx_axis(state->az, dt_q32, params, &state->hold.az_still_count, &state->vz, &state->dz, &state->saturations);
+}
+
+void motion_fx_to_state(const motion_fx_state_t *fx, motion_state_t *state) {
+    state->ax = fx->ax / (float)(1L << MOTION_FX_ACCEL_FRAC);
+    state->ay = fx->ay / (float)(1L << MOTION_FX_ACCEL_FRAC);
+    state->az = fx->az / (float)(1L << MOTION_FX_ACCEL_FRAC);
+    state->vx = fx->vx / (float)(1LL << MOTION_FX_VEL_FRAC);
+    state->vy = fx->vy / (float)(1LL << MOTION_FX_VEL_FRAC);
+    state->vz = fx->vz / (float)(1LL << MOTION_FX_VEL_FRAC);
+    state->dx = fx->dx / (float)(1LL << MOTION_FX_DISP_FRAC);
+    state->dy = fx->dy / (float)(1LL << MOTION_FX_DISP_FRAC);
+    state->dz = fx->dz / (float)(1LL << MOTION_FX_DISP_FRAC);
+}
@@ -1,136 +1,594 @@
+#include <string.h>
+
 #include "mpu6050.h"
+#include "esp_timer.h"
+
+// A wait of n ticks ends on the n-th tick interrupt, which can be almost
+// immediately for n = 1: round up and add one so it never expires early
+#define MPU6050_TIMEOUT_TICKS(ms)   (((ms) + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS + 1)
+
+const float mpu6050_accel_scale[MPU6050_RANGES] = {ACCEL_SCALE, 2.0f * ACCEL_SCALE, 4.0f * ACCEL_SCALE, 8.0f * ACCEL_SCALE};
+const float mpu6050_gyro_scale[MPU6050_RANGES] = {1.0f / 131.0f, 1.0f / 65.5f, 1.0f / 32.8f, 1.0f / 16.4f};
+
+esp_err_t mpu6050_bus_init(mpu6050_bus_t *gate) {
+    memset(gate, 0, sizeof(*gate));
+    gate->hk_lock = xSemaphoreCreateMutex();
+
+    return gate->hk_lock != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void mpu6050_bus_set_sampler(mpu6050_bus_t *gate) {
+    gate->sampler = xTaskGetCurrentTaskHandle();
+}
+
+void mpu6050_bus_claim(mpu6050_bus_t *gate) {
+    gate->claimed = true;
+
+    // Taking the lock waits out the housekeeping transfer on the wire, if any
+    bool taken = xSemaphoreTake(gate->hk_lock, 0) == pdTRUE;
+    if (!taken) {
+        int64_t start = esp_timer_get_time();
+        taken = xSemaphoreTake(gate->hk_lock, MPU6050_TIMEOUT_TICKS(MPU6050_TIMEOUT_MS)) == pdTRUE;
+        int64_t wait = esp_timer_get_time() - start;
+        gate->preempts++;
+        if (wait > gate->preempt_max_us) { gate->preempt_max_us = wait; }
+    }
+    if (taken) { xSemaphoreGive(gate->hk_lock); }
+}
+
+void mpu6050_bus_yield(mpu6050_bus_t *gate, int64_t until_us) {
+    gate->window_end_us = until_us;
+    gate->claimed = false;
+}
+
+/**
+ * @brief Housekeeping: wait until a transfer can run without delaying the sampler
+ *
+ * @param gate           Bus gate, NULL for none
+ * @return true          The transfer may start; hk_lock is held when gated
+ */
+static bool mpu6050_bus_enter(mpu6050_bus_t *gate) {
+    if (gate == NULL || gate->sampler == xTaskGetCurrentTaskHandle()) { return true; }
+
+    TickType_t start = xTaskGetTickCount();
+    while (xSemaphoreTake(gate->hk_lock, MPU6050_TIMEOUT_TICKS(MPU6050_BUS_WAIT_MS)) == pdTRUE) {
+        int64_t end = gate->window_end_us;
+        if (!gate->claimed && (end == 0 || esp_timer_get_time() + MPU6050_BUS_SLOT_US <= end)) {
+            gate->granted++;
+            return true;
+        }
+        xSemaphoreGive(gate->hk_lock);
+        gate->deferred++;
+
+        if (xTaskGetTickCount() - start >= MPU6050_TIMEOUT_TICKS(MPU6050_BUS_WAIT_MS)) { break; }
+        vTaskDelay(1);
+    }
+    gate->timeouts++;
+
+    return false;
+}
+
+static void mpu6050_bus_leave(mpu6050_bus_t *gate) {
+    if (gate == NULL || gate->sampler == xTaskGetCurrentTaskHandle()) { return; }
+    xSemaphoreGive(gate->hk_lock);
+}
+
+static bool IRAM_ATTR mpu6050_on_trans_done(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *evt, void *arg) {
+    (void)handle;
+    mpu6050_dev_t *dev = (mpu6050_dev_t *)arg;
+    BaseType_t higher_prio_woken = pdFALSE;
+
+    if (evt->event == I2C_EVENT_ALIVE) { return false; }
+
+    dev->status = (evt->event == I2C_EVENT_DONE) ? ESP_OK : (evt->event == I2C_EVENT_TIMEOUT) ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    xSemaphoreGiveFromISR(dev->done, &higher_prio_woken);
+
+    return higher_prio_woken == pdTRUE;
+}
+
+/**
+ * @brief Queue a transfer, holding the sensor until mpu6050_transfer_finish
+ *
+ * The register bytes are copied to dev->tx, so tx may be the caller's.
+ *
+ * @param rx             Receive buffer that outlives the transfer, NULL for dev->rx
+ */
+static esp_err_t mpu6050_transfer_start(mpu6050_dev_t *dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len, uint32_t timeout_ms) {
+    if (tx_len > sizeof(dev->tx) || (rx == NULL && rx_len > sizeof(dev->rx))) { return ESP_ERR_INVALID_SIZE; }
+
+    if (!mpu6050_bus_enter(dev->gate)) { return ESP_ERR_TIMEOUT; }
+    if (xSemaphoreTake(dev->lock, MPU6050_TIMEOUT_TICKS(timeout_ms)) != pdTRUE) {
+        mpu6050_bus_leave(dev->gate);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // The buffers still belong to an aborted transfer until its completion is in
+    if (dev->busy) {
+        if (xSemaphoreTake(dev->done, 0) != pdTRUE) {
+            xSemaphoreGive(dev->lock);
+            mpu6050_bus_leave(dev->gate);
+            return ESP_ERR_TIMEOUT;
+        }
+        dev->busy = false;
+    }
+
+    memcpy(dev->tx, tx, tx_len);
+    if (rx == NULL) { rx = dev->rx; }
+
+    esp_err_t res = rx_len ? i2c_master_transmit_receive(dev->handle, dev->tx, tx_len, rx, rx_len, timeout_ms)
+                           : i2c_master_transmit(dev->handle, dev->tx, tx_len, timeout_ms);
+    if (res != ESP_OK) {
+        xSemaphoreGive(dev->lock);
+        mpu6050_bus_leave(dev->gate);
+    }
+
+    return res;
+}
+
+static esp_err_t mpu6050_transfer_finish(mpu6050_dev_t *dev, uint32_t timeout_ms) {
+    esp_err_t res = ESP_ERR_TIMEOUT;
+
+    if (xSemaphoreTake(dev->done, MPU6050_TIMEOUT_TICKS(timeout_ms)) == pdTRUE) {
+        res = dev->status;
+    } else {
+        // Still on the wire: stop it before the buffers or the lock are handed on
+        dev->resets++;
+        i2c_master_bus_reset(dev->bus);
+        dev->busy = xSemaphoreTake(dev->done, MPU6050_TIMEOUT_TICKS(MPU6050_ABORT_MS)) != pdTRUE;
+    }
+    xSemaphoreGive(dev->lock);
+    mpu6050_bus_leave(dev->gate);
+
+    return res;
+}
+
+/**
+ * @brief Blocking transfer, received bytes are copied out of dev->rx on success
+ */
+static esp_err_t mpu6050_transfer(mpu6050_dev_t *dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len, uint32_t timeout_ms) {
+    esp_err_t res = mpu6050_transfer_start(dev, tx, tx_len, NULL, rx_len, timeout_ms);
+    if (res != ESP_OK) { return res; }
+
+    res = mpu6050_transfer_finish(dev, timeout_ms);
+    if (res == ESP_OK && rx_len > 0) { memcpy(rx, dev->rx, rx_len); }
+
+    return res;
+}
+
+static esp_err_t mpu6050_write_reg(mpu6050_dev_t *dev, uint8_t reg, uint8_t value) {
+    uint8_t data[2] = {reg, value};
+    return mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
+}
+
+static esp_err_t mpu6050_read_regs(mpu6050_dev_t *dev, uint8_t reg, uint8_t *buf, size_t len) {
+    return mpu6050_transfer(dev, &reg, 1, buf, len, MPU6050_TIMEOUT_MS);
+}
+
+static void mpu6050_decode_accel(const mpu6050_dev_t *dev, const uint8_t *raw, mpu6050_data_t *data) {
+    int16_t ax = (int16_t)(raw[0] << 8 | raw[1]);
+    int16_t ay = (int16_t)(raw[2] << 8 | raw[3]);
+    int16_t az = (int16_t)(raw[4] << 8 | raw[5]);
 
-esp_err_t mpu6050_config(i2c_port_t port, const mpu6050_config_t *cfg) {
+    float scale = mpu6050_accel_scale[dev->accel_range & 0x03];
+    data->ax = (float)ax * scale;
+    data->ay = (float)ay * scale;
+    data->az = (float)az * scale;
+}
+
+static void mpu6050_decode_gyro(const mpu6050_dev_t *dev, const uint8_t *raw, mpu6050_data_t *data) {
+    int16_t gx = (int16_t)(raw[0] << 8 | raw[1]);
+    int16_t gy = (int16_t)(raw[2] << 8 | raw[3]);
+    int16_t gz = (int16_t)(raw[4] << 8 | raw[5]);
+
+    float scale = mpu6050_gyro_scale[dev->gyro_range & 0x03];
+    data->gx = gx * scale;
+    data->gy = gy * scale;
+    data->gz = gz * scale;
+}
+
+static void mpu6050_decode_temp(const uint8_t *raw, mpu6050_data_t *data) {
+    int16_t temp_raw = (int16_t)(raw[0] << 8 | raw[1]);
+    data->temp = (temp_raw / 340.0f) + 36.53f;
+}
+
+static void mpu6050_decode_raw(const mpu6050_dev_t *dev, const uint8_t *buf, size_t len, mpu6050_raw_t *raw) {
+    raw->accel_range = dev->accel_range;
+    raw->gyro_range = dev->gyro_range;
+    raw->ax = (int16_t)(buf[0] << 8 | buf[1]);
+    raw->ay = (int16_t)(buf[2] << 8 | buf[3]);
+    raw->az = (int16_t)(buf[4] << 8 | buf[5]);
+
+    if (len == MPU6050_BURST_SIZE) {
+        raw->temp = (int16_t)(buf[6] << 8 | buf[7]);
+        buf += 8;
+    } else {
+        raw->temp = 0;
+        buf += 6;
+    }
+
+    if (len > MPU6050_FIFO_FRAME_ACCEL) {
+        raw->gx = (int16_t)(buf[0] << 8 | buf[1]);
+        raw->gy = (int16_t)(buf[2] << 8 | buf[3]);
+        raw->gz = (int16_t)(buf[4] << 8 | buf[5]);
+    } else {
+        raw->gx = raw->gy = raw->gz = 0;
+    }
+}
+
+esp_err_t mpu6050_config(mpu6050_dev_t *dev, const mpu6050_config_t *cfg) {
     esp_err_t res;
     uint8_t data[2];
 
     // SMPLRT_DIV
     data[0] = MPU6050_SMPLRT_DIV;
     data[1] = cfg->smplrt_div;
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(100));
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
     // CONFIG
     data[0] = MPU6050_CONFIG;
     data[1] = cfg->dlpf_cfg;
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(100));
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
     // GYRO_CONFIG
     data[0] = MPU6050_GYRO_CONFIG;
-    data[1] = cfg->gyro_range << 3;
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(100));
+    data[1] = cfg->gyro_range << MPU6050_FS_SEL_SHIFT;
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
+    dev->gyro_range = cfg->gyro_range;
 
     // ACCEL_CONFIG
     data[0] = MPU6050_ACCEL_CONFIG;
-    data[1] = cfg->accel_range << 3;
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(100));
+    data[1] = cfg->accel_range << MPU6050_FS_SEL_SHIFT;
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
+    dev->accel_range = cfg->accel_range;
+
+    return ESP_OK;
+}
+
+esp_err_t mpu6050_set_range(mpu6050_dev_t *dev, uint8_t accel_range, uint8_t gyro_range) {
+    esp_err_t res;
+
+    if (accel_range != dev->accel_range) {
+        res = mpu6050_write_reg(dev, MPU6050_ACCEL_CONFIG, accel_range << MPU6050_FS_SEL_SHIFT);
+        if (res != ESP_OK) { return res; }
+        dev->accel_range = accel_range;
+    }
+
+    if (gyro_range != dev->gyro_range) {
+        res = mpu6050_write_reg(dev, MPU6050_GYRO_CONFIG, gyro_range << MPU6050_FS_SEL_SHIFT);
+        if (res != ESP_OK) { return res; }
+        dev->gyro_range = gyro_range;
+    }
 
     return ESP_OK;
 }
 
-esp_err_t mpu6050_init(i2c_port_t port) {
+esp_err_t mpu6050_add_device(i2c_master_bus_handle_t bus, mpu6050_bus_t *gate, uint8_t addr, mpu6050_dev_t *dev) {
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address  = addr,
+        .scl_speed_hz    = MPU6050_SCL_SPEED_HZ,
+    };
+    i2c_master_event_callbacks_t cbs = {
+        .on_trans_done = mpu6050_on_trans_done,
+    };
+    esp_err_t res;
+
+    dev->bus = bus;
+    dev->addr = addr;
+    dev->gate = gate;
+    dev->busy = false;
+    dev->lock = xSemaphoreCreateMutex();
+    dev->done = xSemaphoreCreateBinary();
+    if (dev->lock == NULL || dev->done == NULL) { return ESP_ERR_NO_MEM; }
+
+    res = i2c_master_bus_add_device(bus, &dev_cfg, &dev->handle);
+    if (res != ESP_OK) { return res; }
+
+    // With a callback registered every transfer on this device is asynchronous
+    return i2c_master_register_event_callbacks(dev->handle, &cbs, dev);
+}
+
+esp_err_t mpu6050_who_am_i(mpu6050_dev_t *dev, uint8_t *who_am_i) {
+    return mpu6050_read_regs(dev, MPU6050_WHO_AM_I, who_am_i, 1);
+}
+
+esp_err_t mpu6050_init(mpu6050_dev_t *dev) {
     uint8_t who_am_i = 0;
     uint8_t reg = MPU6050_WHO_AM_I;
     esp_err_t res;
 
     // WHO_AM_I check
-    res = i2c_master_write_read_device(port, MPU6050_ADDR, &reg, 1, &who_am_i, 1, pdMS_TO_TICKS(1000));
+    res = mpu6050_transfer(dev, &reg, 1, &who_am_i, 1, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) {  return res; }
 
     if (who_am_i != MPU6050_DEVICE_ID) { return ESP_FAIL; }
 
     // Wake up (clear sleep bit)
     uint8_t data[2] = {MPU6050_PWR_MGMT_1, MPU6050_WAKE_UP};
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(1000));
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
     // Set clock source to PLL with X axis gyroscope reference
     data[0] = MPU6050_PWR_MGMT_1;
     data[1] = MPU6050_CLKSEL_PLL;
-    res = i2c_master_write_to_device(port, MPU6050_ADDR, data, 2, pdMS_TO_TICKS(1000));
+    res = mpu6050_transfer(dev, data, 2, NULL, 0, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
     
     return ESP_OK;
 }
 
-esp_err_t mpu6050_read_accel(i2c_port_t port, mpu6050_data_t *data) {
+esp_err_t mpu6050_read_accel(mpu6050_dev_t *dev, mpu6050_data_t *data) {
     uint8_t reg = MPU6050_ACCEL_XOUT_H;
     uint8_t raw[6];
-    int16_t ax, ay, az;
 
-    esp_err_t res = i2c_master_write_read_device(port, MPU6050_ADDR, &reg, 1, raw, 6, pdMS_TO_TICKS(1000));
+    esp_err_t res = mpu6050_transfer(dev, &reg, 1, raw, 6, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
-    ax = (int16_t)(raw[0] << 8 | raw[1]);
-    ay = (int16_t)(raw[2] << 8 | raw[3]);
-    az = (int16_t)(raw[4] << 8 | raw[5]);
-
-    data->ax = (float)ax * ACCEL_SCALE;
-    data->ay = (float)ay * ACCEL_SCALE;
-    data->az = (float)az * ACCEL_SCALE;
+    mpu6050_decode_accel(dev, raw, data);
 
     return ESP_OK;
 }
 
-esp_err_t mpu6050_read_gyro(i2c_port_t port, mpu6050_data_t *data) {
+esp_err_t mpu6050_read_gyro(mpu6050_dev_t *dev, mpu6050_data_t *data) {
     uint8_t reg = MPU6050_GYRO_XOUT_H;
     uint8_t raw[6];
-    int16_t gx, gy, gz;
 
-    esp_err_t res = i2c_master_write_read_device(port, MPU6050_ADDR, &reg, 1, raw, 6, pdMS_TO_TICKS(1000));
+    esp_err_t res = mpu6050_transfer(dev, &reg, 1, raw, 6, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
-    gx = (int16_t)(raw[0] << 8 | raw[1]);
-    gy = (int16_t)(raw[2] << 8 | raw[3]);
-    gz = (int16_t)(raw[4] << 8 | raw[5]);
-
-    data->gx = gx * GYRO_SCALE;
-    data->gy = gy * GYRO_SCALE;
-    data->gz = gz * GYRO_SCALE;
+    mpu6050_decode_gyro(dev, raw, data);
 
     return ESP_OK;
 }
 
-esp_err_t mpu6050_read_temp(i2c_port_t port, mpu6050_data_t *data) {
+esp_err_t mpu6050_read_temp(mpu6050_dev_t *dev, mpu6050_data_t *data) {
     uint8_t reg = MPU6050_TEMP_OUT_H;
     uint8_t raw[2];
-    int16_t temp_raw;
 
-    esp_err_t res = i2c_master_write_read_device(port, MPU6050_ADDR, &reg, 1, raw, 2, pdMS_TO_TICKS(1000));
+    esp_err_t res = mpu6050_transfer(dev, &reg, 1, raw, 2, MPU6050_TIMEOUT_MS);
     if (res != ESP_OK) { return res; }
 
-    temp_raw = (int16_t)(raw[0] << 8 | raw[1]);
-    data->temp = (temp_raw / 340.0f) + 36.53f;
+    mpu6050_decode_temp(raw, data);
 
     return ESP_OK;
 }
 
-esp_err_t mpu6050_calibrate_accel(i2c_port_t port, mpu6050_cal_data_t *cal_data) {
-    mpu6050_data_t accel_data;
+esp_err_t mpu6050_read_raw(mpu6050_dev_t *dev, mpu6050_raw_t *raw) {
+    uint8_t reg = MPU6050_ACCEL_XOUT_H;
+    uint8_t buf[MPU6050_BURST_SIZE];
+
+    esp_err_t res = mpu6050_transfer(dev, &reg, 1, buf, MPU6050_BURST_SIZE, MPU6050_TIMEOUT_MS);
+    if (res != ESP_OK) { return res; }
+
+    mpu6050_decode_raw(dev, buf, MPU6050_BURST_SIZE, raw);
+
+    return ESP_OK;
+}
+
+esp_err_t mpu6050_read_raw_start(mpu6050_dev_t *dev) {
+    uint8_t reg = MPU6050_ACCEL_XOUT_H;
+    return mpu6050_transfer_start(dev, &reg, 1, NULL, MPU6050_BURST_SIZE, MPU6050_TIMEOUT_MS);
+}
+
+esp_err_t mpu6050_read_raw_finish(mpu6050_dev_t *dev, mpu6050_raw_t *raw, uint32_t timeout_ms) {
+    esp_err_t res = mpu6050_transfer_finish(dev, timeout_ms);
+    if (res != ESP_OK) { return res; }
+
+    mpu6050_decode_raw(dev, dev->rx, MPU6050_BURST_SIZE, raw);
+
+    return ESP_OK;
+}
+
+void mpu6050_raw_to_data(const mpu6050_raw_t *raw, mpu6050_data_t *data) {
+    float accel_scale = mpu6050_accel_scale[raw->accel_range & 0x03];
+    float gyro_scale = mpu6050_gyro_scale[raw->gyro_range & 0x03];
+
+    data->ax = raw->ax * accel_scale;
+    data->ay = raw->ay * accel_scale;
+    data->az = raw->az * accel_scale;
+    data->gx = raw->gx * gyro_scale;
+    data->gy = raw->gy * gyro_scale;
+    data->gz = raw->gz * gyro_scale;
+    data->temp = (raw->temp / 340.0f) + 36.53f;
+}
+
+esp_err_t mpu6050_read_all(mpu6050_dev_t *dev, mpu6050_data_t *data) {
+    mpu6050_raw_t raw;
+
+    esp_err_t res = mpu6050_read_raw(dev, &raw);
+    if (res != ESP_OK) { return res; }
+
+    mpu6050_raw_to_data(&raw, data);
+
+    return ESP_OK;
+}
+
+esp_err_t mpu6050_calibrate(mpu6050_dev_t *dev, mpu6050_cal_data_t *cal_data) {
+    mpu6050_data_t data;
     esp_err_t res;
 
-    cal_data->samples = 100;
-    cal_data->ax_bias = 0;
-    cal_data->ay_bias = 0;
-    cal_data->az_bias = 0;
+    memset(cal_data, 0, sizeof(*cal_data));
+    cal_data->samples = MPU6050_CAL_SAMPLES;
 
     for (int i = 0; i < cal_data->samples; i++) {
-        res = mpu6050_read_accel(port, &accel_data);
+        // Accel, gyro and temperature of the same sample in one transaction
+        res = mpu6050_read_all(dev, &data);
         if(res != ESP_OK) { return res; }
 
-        cal_data->ax_bias += accel_data.ax;
-        cal_data->ay_bias += accel_data.ay;
-        cal_data->az_bias += accel_data.az;
+        cal_data->ax_bias += data.ax;
+        cal_data->ay_bias += data.ay;
+        cal_data->az_bias += data.az;
+        cal_data->gx_bias += data.gx;
+        cal_data->gy_bias += data.gy;
+        cal_data->gz_bias += data.gz;
+        cal_data->temp    += data.temp;
         
-        vTaskDelay(pdMS_TO_TICKS(10)); // 100 Hz sampling
+        vTaskDelay(pdMS_TO_TICKS(MPU6050_CAL_PERIOD_MS));
     }
 
     cal_data->ax_bias /= cal_data->samples;
     cal_data->ay_bias /= cal_data->samples;
     cal_data->az_bias /= cal_data->samples;
+    cal_data->gx_bias /= cal_data->samples;
+    cal_data->gy_bias /= cal_data->samples;
+    cal_data->gz_bias /= cal_data->samples;
+    cal_data->temp    /= cal_data->samples;
 
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+float mpu6050_sample_rate_hz(const mpu6050_config_t *cfg) {
+    float gyro_rate_hz = (cfg->dlpf_cfg == 0 || cfg->dlpf_cfg == 7) ? 8000.0f : 1000.0f;
+    return gyro_rate_hz / (1 + cfg->smplrt_div);
+}
+
+esp_err_t mpu6050_data_ready_int(mpu6050_dev_t *dev, bool enable) {
+    esp_err_t res;
+
+    // Active high, push-pull, 50us pulse
+    res = mpu6050_write_reg(dev, MPU6050_INT_PIN_CFG, MPU6050_INT_PIN_RD_CLEAR);
+    if (res != ESP_OK) { return res; }
+
+    return mpu6050_write_reg(dev, MPU6050_INT_ENABLE, enable ? MPU6050_INT_DATA_RDY : 0x00);
+}
+
+esp_err_t mpu6050_motion_standby(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t lp_wake) {
+    uint8_t accel_config = dev->accel_range << MPU6050_FS_SEL_SHIFT;
+    uint8_t status;
+    esp_err_t res;
+
+    // Gyroscope off first: the accelerometer keeps sampling at the configured rate
+    res = mpu6050_write_reg(dev, MPU6050_PWR_MGMT_2, MPU6050_PWR_STBY_GYRO);
+    if (res != ESP_OK) { return res; }
+
+    if (threshold_mg > 0) {
+        uint16_t thr = (threshold_mg + MPU6050_MOT_THR_MG - 1) / MPU6050_MOT_THR_MG;
+
+        res = mpu6050_write_reg(dev, MPU6050_MOT_THR, thr > UINT8_MAX ? UINT8_MAX : (uint8_t)thr);
+        if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_MOT_DUR, 1); }
+
+        // Latched, active high: a wake source that cannot be missed between samples
+        if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_INT_PIN_CFG, MPU6050_INT_PIN_LATCH); }
+        if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_INT_ENABLE, MPU6050_INT_MOT); }
+
+        // Let the high-pass settle on the still sensor, then hold that sample as the reference
+        if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_ACCEL_CONFIG, accel_config | MPU6050_ACCEL_HPF_5HZ); }
+        if (res != ESP_OK) { return res; }
+        vTaskDelay(1);
+        res = mpu6050_write_reg(dev, MPU6050_ACCEL_CONFIG, accel_config | MPU6050_ACCEL_HPF_HOLD);
+        if (res != ESP_OK) { return res; }
+
+        // Start without an interrupt pending
+        res = mpu6050_read_regs(dev, MPU6050_INT_STATUS, &status, 1);
+        if (res != ESP_OK) { return res; }
+    }
+
+    res = mpu6050_write_reg(dev, MPU6050_PWR_MGMT_2, (lp_wake & 0x03) << MPU6050_LP_WAKE_SHIFT | MPU6050_PWR_STBY_GYRO);
+    if (res != ESP_OK) { return res; }
+
+    // The PLL needs the gyroscope: cycle on the internal oscillator
+    return mpu6050_write_reg(dev, MPU6050_PWR_MGMT_1, MPU6050_PWR_CYCLE | MPU6050_PWR_TEMP_DIS);
+}
+
+esp_err_t mpu6050_motion_wake(mpu6050_dev_t *dev) {
+    uint8_t status;
+    esp_err_t res;
+
+    res = mpu6050_write_reg(dev, MPU6050_PWR_MGMT_2, 0x00);
+    if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_PWR_MGMT_1, MPU6050_CLKSEL_PLL); }
+    if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_ACCEL_CONFIG, dev->accel_range << MPU6050_FS_SEL_SHIFT); }
+    if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_INT_ENABLE, 0x00); }
+    if (res == ESP_OK) { res = mpu6050_write_reg(dev, MPU6050_INT_PIN_CFG, MPU6050_INT_PIN_RD_CLEAR); }
+    if (res != ESP_OK) { return res; }
+
+    return mpu6050_read_regs(dev, MPU6050_INT_STATUS, &status, 1);
+}
+
+esp_err_t mpu6050_fifo_enable(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo) {
+    esp_err_t res;
+
+    fifo->frame_size = fifo->with_gyro ? MPU6050_FIFO_FRAME_ACCEL_GYRO : MPU6050_FIFO_FRAME_ACCEL;
+
+    // Stop buffering and flush whatever is left from a previous session
+    res = mpu6050_write_reg(dev, MPU6050_FIFO_EN, 0x00);
+    if (res != ESP_OK) { return res; }
+
+    res = mpu6050_write_reg(dev, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    if (res != ESP_OK) { return res; }
+
+    // Enable the FIFO first, then select the sources so the first frame is aligned
+    res = mpu6050_write_reg(dev, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+    if (res != ESP_OK) { return res; }
+
+    uint8_t sources = MPU6050_FIFO_EN_ACCEL;
+    if (fifo->with_gyro) { sources |= MPU6050_FIFO_EN_GYRO; }
+
+    return mpu6050_write_reg(dev, MPU6050_FIFO_EN, sources);
+}
+
+esp_err_t mpu6050_fifo_disable(mpu6050_dev_t *dev) {
+    esp_err_t res = mpu6050_write_reg(dev, MPU6050_FIFO_EN, 0x00);
+    if (res != ESP_OK) { return res; }
+
+    return mpu6050_write_reg(dev, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+}
+
+esp_err_t mpu6050_fifo_reset(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo) {
+    fifo->resyncs++;
+    return mpu6050_fifo_enable(dev, fifo);
+}
+
+esp_err_t mpu6050_fifo_read(mpu6050_dev_t *dev, mpu6050_fifo_t *fifo, mpu6050_raw_t *frames, size_t max_frames, size_t *n_frames) {
+    uint8_t raw[2];
+    uint8_t int_status;
+    uint16_t count;
+    esp_err_t res;
+
+    *n_frames = 0;
+
+    // Reading INT_STATUS also clears the overflow flag
+    res = mpu6050_read_regs(dev, MPU6050_INT_STATUS, &int_status, 1);
+    if (res != ESP_OK) { return res; }
+
+    if (int_status & MPU6050_INT_FIFO_OFLOW) {
+        fifo->overflows++;
+        res = mpu6050_fifo_reset(dev, fifo);
+        return res != ESP_OK ? res : ESP_ERR_INVALID_STATE;
+    }
+
+    res = mpu6050_read_regs(dev, MPU6050_FIFO_COUNT_H, raw, 2);
+    if (res != ESP_OK) { return res; }
+
+    count = (uint16_t)(raw[0] << 8 | raw[1]);
+
+    // A full FIFO has dropped its oldest bytes and lost the frame boundary: resync
+    if (count >= MPU6050_FIFO_SIZE) {
+        fifo->overflows++;
+        res = mpu6050_fifo_reset(dev, fifo);
+        return res != ESP_OK ? res : ESP_ERR_INVALID_STATE;
+    }
+
+    // A count that is not frame aligned caught the sensor writing a frame: its
+    // bytes stay in the FIFO and are drained with the next call
+    size_t n = count / fifo->frame_size;
+    if (n > max_frames) { n = max_frames; }
+    if (n == 0) { return ESP_OK; }
+
+    // Drain all complete frames in one burst, straight into the FIFO state
+    uint8_t reg = MPU6050_FIFO_R_W;
+    res = mpu6050_transfer_start(dev, &reg, 1, fifo->buf, n * fifo->frame_size, MPU6050_FIFO_TIMEOUT_MS);
+    if (res == ESP_OK) { res = mpu6050_transfer_finish(dev, MPU6050_FIFO_TIMEOUT_MS); }
+    if (res != ESP_OK) { return res; }
+
+    for (size_t i = 0; i < n; i++) {
+        mpu6050_decode_raw(dev, &fifo->buf[i * fifo->frame_size], fifo->frame_size, &frames[i]);
+    }
+
+    *n_frames = n;
+
+    return ESP_OK;
+}
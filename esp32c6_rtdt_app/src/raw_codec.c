@@ -0,0 +1,173 @@
+#include <string.h>
+
+#include "raw_codec.h"
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    uint32_t acc;               // Pending bits, right aligned
+    int bits;                   // Number of pending bits (< 8 between calls)
+    bool overflow;
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    uint32_t acc;
+    int bits;
+} bit_reader_t;
+
+static void bit_put(bit_writer_t *w, uint32_t value, int count) {
+    w->acc = (w->acc << count) | (value & ((1u << count) - 1));
+    w->bits += count;
+
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        if (w->len == w->cap) {
+            w->overflow = true;
+            return;
+        }
+        w->buf[w->len++] = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static bool bit_get(bit_reader_t *r, int count, uint32_t *value) {
+    while (r->bits < count) {
+        if (r->pos == r->len) { return false; }
+        r->acc = (r->acc << 8) | r->buf[r->pos++];
+        r->bits += 8;
+    }
+
+    r->bits -= count;
+    *value = (r->acc >> r->bits) & ((1u << count) - 1);
+
+    return true;
+}
+
+static inline uint16_t zigzag(int16_t v) {
+    return (uint16_t)(((uint16_t)v << 1) ^ (uint16_t)(v >> 15));
+}
+
+static inline int16_t unzigzag(uint16_t z) {
+    return (int16_t)((z >> 1) ^ (uint16_t)-(int16_t)(z & 1));
+}
+
+static void put_le16(uint8_t *p, int16_t v) {
+    p[0] = (uint16_t)v & 0xFF;
+    p[1] = (uint16_t)v >> 8;
+}
+
+static int16_t get_le16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static size_t raw_codec_verbatim(const int16_t samples[][RAW_CODEC_CHANNELS], size_t n, uint8_t *out) {
+    for (size_t i = 0; i < n; i++) {
+        for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+            put_le16(&out[(i * RAW_CODEC_CHANNELS + ch) * 2], samples[i][ch]);
+        }
+    }
+
+    return n * RAW_CODEC_CHANNELS * 2;
+}
+
+size_t raw_codec_encode(const int16_t samples[][RAW_CODEC_CHANNELS], size_t n, uint8_t *out, raw_codec_mode_t *mode) {
+    size_t verbatim = n * RAW_CODEC_CHANNELS * 2;
+    bit_writer_t w = {.buf = out, .cap = verbatim};
+
+    for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+        put_le16(&out[ch * 2], samples[0][ch]);
+    }
+    w.len = RAW_CODEC_CHANNELS * 2;
+
+    for (int ch = 0; ch < RAW_CODEC_CHANNELS && !w.overflow; ch++) {
+        uint16_t z[RAW_CODEC_BLOCK];
+        uint32_t sum = 0;
+
+        // Deltas wrap modulo 2^16 so the zigzag value always fits in 16 bits
+        for (size_t i = 1; i < n; i++) {
+            z[i] = zigzag((int16_t)(samples[i][ch] - samples[i - 1][ch]));
+            sum += z[i];
+        }
+
+        // k ~ log2(mean), the optimum for geometrically distributed residuals
+        int k = 0;
+        while (k < RAW_CODEC_MAX_K && ((uint32_t)(n - 1) << (k + 1)) <= sum) { k++; }
+        bit_put(&w, k, RAW_CODEC_K_BITS);
+
+        for (size_t i = 1; i < n && !w.overflow; i++) {
+            uint32_t q = z[i] >> k;
+
+            if (q >= RAW_CODEC_ESCAPE) {
+                bit_put(&w, (1u << RAW_CODEC_ESCAPE) - 1, RAW_CODEC_ESCAPE);
+                bit_put(&w, z[i], 16);
+            } else {
+                bit_put(&w, ((1u << q) - 1) << 1, q + 1);
+                if (k > 0) { bit_put(&w, z[i], k); }
+            }
+        }
+    }
+
+    if (w.bits > 0) { bit_put(&w, 0, 8 - w.bits); }
+
+    // Noisy blocks can code larger than they are, send those as they are
+    if (w.overflow || w.len >= verbatim) {
+        *mode = RAW_CODEC_VERBATIM;
+        return raw_codec_verbatim(samples, n, out);
+    }
+
+    *mode = RAW_CODEC_RICE;
+    return w.len;
+}
+
+bool raw_codec_decode(const uint8_t *in, size_t len, raw_codec_mode_t mode, int16_t samples[][RAW_CODEC_CHANNELS], size_t n) {
+    if (n < 1 || n > RAW_CODEC_BLOCK) { return false; }
+
+    if (mode == RAW_CODEC_VERBATIM) {
+        if (len < n * RAW_CODEC_CHANNELS * 2) { return false; }
+        for (size_t i = 0; i < n; i++) {
+            for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+                samples[i][ch] = get_le16(&in[(i * RAW_CODEC_CHANNELS + ch) * 2]);
+            }
+        }
+        return true;
+    }
+
+    if (mode != RAW_CODEC_RICE || len < RAW_CODEC_CHANNELS * 2) { return false; }
+
+    for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+        samples[0][ch] = get_le16(&in[ch * 2]);
+    }
+
+    bit_reader_t r = {.buf = in, .len = len, .pos = RAW_CODEC_CHANNELS * 2};
+
+    for (int ch = 0; ch < RAW_CODEC_CHANNELS; ch++) {
+        uint32_t k, bit, z;
+
+        if (!bit_get(&r, RAW_CODEC_K_BITS, &k)) { return false; }
+
+        for (size_t i = 1; i < n; i++) {
+            uint32_t q = 0;
+
+            for (;;) {
+                if (!bit_get(&r, 1, &bit)) { return false; }
+                if (bit == 0) { break; }
+                if (++q == RAW_CODEC_ESCAPE) { break; }
+            }
+
+            if (q == RAW_CODEC_ESCAPE) {
+                if (!bit_get(&r, 16, &z)) { return false; }
+            } else {
+                uint32_t low = 0;
+                if (k > 0 && !bit_get(&r, k, &low)) { return false; }
+                z = (q << k) | low;
+            }
+
+            samples[i][ch] = (int16_t)(samples[i - 1][ch] + unzigzag((uint16_t)z));
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,45 @@
+#include "sample_ring.h"
+
+void sample_ring_init(sample_ring_t *ring) {
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    ring->overruns   = 0;
+    ring->high_water = 0;
+}
+
+bool sample_ring_push(sample_ring_t *ring, const telemetry_sample_t *sample) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t used = head - tail;
+
+    if (used >= SAMPLE_RING_SIZE) {
+        ring->overruns++;
+        return false;
+    }
+
+    ring->slots[head & (SAMPLE_RING_SIZE - 1)] = *sample;
+
+    // Publish the slot to the consumer
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    if (used + 1 > ring->high_water) { ring->high_water = used + 1; }
+
+    return true;
+}
+
+size_t sample_ring_pop(sample_ring_t *ring, telemetry_sample_t *out, size_t max) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t n = head - tail;
+
+    if (n > max) { n = max; }
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ring->slots[(tail + i) & (SAMPLE_RING_SIZE - 1)];
+    }
+
+    // Hand the slots back to the producer
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+
+    return n;
+}
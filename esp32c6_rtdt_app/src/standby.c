@@ -0,0 +1,37 @@
+#include "standby.h"
+
+void standby_quiet_reset(standby_quiet_t *q) {
+    q->primed = false;
+    q->quiet_s = 0.0f;
+}
+
+bool standby_quiet_update(standby_quiet_t *q, const mpu6050_raw_t *raw, float dt) {
+    const int16_t a[3] = {raw->ax, raw->ay, raw->az};
+    int32_t threshold = (int32_t)(STANDBY_MOTION_MG * 16384 / 1000) >> raw->accel_range;
+    bool moved = false;
+
+    // The mean restarts at a range switch rather than being converted
+    if (!q->primed || q->range != raw->accel_range) {
+        for (int k = 0; k < 3; k++) { q->mean[k] = (int32_t)a[k] << STANDBY_QUIET_SHIFT; }
+        q->range = raw->accel_range;
+        q->primed = true;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        int32_t d = a[k] - (q->mean[k] >> STANDBY_QUIET_SHIFT);
+        if (d > threshold || d < -threshold) { moved = true; }
+        q->mean[k] += a[k] - (q->mean[k] >> STANDBY_QUIET_SHIFT);
+    }
+
+    q->quiet_s = moved ? 0.0f : q->quiet_s + dt;
+
+    return q->quiet_s >= STANDBY_QUIET_S;
+}
+
+float standby_current_ua(float busy, uint32_t n_sensors) {
+    return n_sensors * STANDBY_SENSOR_UA + busy * STANDBY_CHIP_ACTIVE_UA + (1.0f - busy) * STANDBY_CHIP_SLEEP_UA;
+}
+
+float standby_awake_current_ua(uint32_t n_sensors) {
+    return n_sensors * STANDBY_SENSOR_ACTIVE_UA + STANDBY_CHIP_ACTIVE_UA;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "stats.h"
+
+void stats_hist_reset(stats_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void stats_hist_add(stats_hist_t *hist, uint32_t cycles) {
+    // Bit length of the duration selects the bucket
+    int bits = cycles ? 32 - __builtin_clz(cycles) : 0;
+    int bucket = bits - STATS_HIST_MIN_SHIFT;
+
+    if (bucket < 0) { bucket = 0; }
+    if (bucket >= STATS_HIST_BUCKETS) { bucket = STATS_HIST_BUCKETS - 1; }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum += cycles;
+    if (cycles > hist->max) { hist->max = cycles; }
+}
+
+void stats_hist_log(const char *tag, const char *name, const stats_hist_t *hist, uint32_t cycles_per_us) {
+    char line[STATS_HIST_BUCKETS * 16];
+    size_t len = 0;
+
+    if (hist->count == 0) {
+        ESP_LOGI(tag, "%-8s n=0", name);
+        return;
+    }
+
+    // "<bound:count" for every non-empty bucket, the last one is open ended
+    for (int i = 0; i < STATS_HIST_BUCKETS && len < sizeof(line); i++) {
+        if (hist->buckets[i] == 0) { continue; }
+
+        if (i == STATS_HIST_BUCKETS - 1) {
+            len += snprintf(&line[len], sizeof(line) - len, " >=%lu:%lu",
+                            (unsigned long)((1UL << (STATS_HIST_MIN_SHIFT + i - 1)) / cycles_per_us),
+                            (unsigned long)hist->buckets[i]);
+        } else {
+            len += snprintf(&line[len], sizeof(line) - len, " <%lu:%lu",
+                            (unsigned long)((1UL << (STATS_HIST_MIN_SHIFT + i)) / cycles_per_us),
+                            (unsigned long)hist->buckets[i]);
+        }
+    }
+
+    ESP_LOGI(tag, "%-8s n=%lu mean=%lu us max=%lu us |%s",
+             name, (unsigned long)hist->count,
+             (unsigned long)(hist->sum / hist->count / cycles_per_us),
+             (unsigned long)(hist->max / cycles_per_us), line);
+}
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry.h"
+#include "esp_timer.h"
+
+uint16_t telemetry_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+size_t telemetry_encode_frame(uint8_t *buf, uint8_t type, const void *payload, uint8_t len) {
+    buf[0] = TELEMETRY_SYNC_0;
+    buf[1] = TELEMETRY_SYNC_1;
+    buf[2] = type;
+    buf[3] = len;
+    memcpy(&buf[TELEMETRY_HEADER_SIZE], payload, len);
+
+    // CRC over type, length and payload
+    uint16_t crc = telemetry_crc16(&buf[2], 2 + len);
+    buf[TELEMETRY_HEADER_SIZE + len]     = crc & 0xFF;
+    buf[TELEMETRY_HEADER_SIZE + len + 1] = crc >> 8;
+
+    return TELEMETRY_HEADER_SIZE + len + TELEMETRY_CRC_SIZE;
+}
+
+typedef struct {
+    int16_t samples[RAW_CODEC_BLOCK][RAW_CODEC_CHANNELS];
+    uint8_t n;
+    uint8_t accel_range;        // Ranges every sample of the block was measured at
+    uint8_t gyro_range;
+    uint32_t seq;               // Sequence number of samples[0]
+    int64_t t_first_us;
+    int64_t t_last_us;
+} raw_block_t;
+
+static raw_block_t raw_blocks[IMU_MAX_CHANNELS];
+
+static void telemetry_write_raw(uint8_t dev) {
+    raw_block_t *block = &raw_blocks[dev];
+    uint8_t payload[sizeof(telemetry_raw_header_t) + RAW_CODEC_MAX_BYTES];
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    raw_codec_mode_t mode;
+
+    if (block->n == 0) { return; }
+
+    size_t len = raw_codec_encode(block->samples, block->n, &payload[sizeof(telemetry_raw_header_t)], &mode);
+    telemetry_raw_header_t header = {
+        .dev     = dev,
+        .mode    = mode,
+        .n       = block->n,
+        .seq     = block->seq,
+        .t_us    = (uint64_t)block->t_first_us,
+        .span_us = (uint32_t)(block->t_last_us - block->t_first_us),
+        .accel_range = block->accel_range,
+        .gyro_range  = block->gyro_range,
+    };
+    memcpy(payload, &header, sizeof(header));
+
+    len = telemetry_encode_frame(frame, TELEMETRY_FRAME_RAW, payload, sizeof(header) + len);
+    fwrite(frame, 1, len, stdout);
+
+    block->n = 0;
+}
+
+static void telemetry_add_raw(const telemetry_sample_t *sample) {
+    if (sample->dev >= IMU_MAX_CHANNELS) { return; }
+    raw_block_t *block = &raw_blocks[sample->dev];
+
+    const mpu6050_raw_t *raw = &sample->raw;
+
+    // A block only holds consecutive samples measured at the same ranges
+    if (block->n > 0 && (sample->seq != block->seq + block->n || raw->accel_range != block->accel_range ||
+                         raw->gyro_range != block->gyro_range)) {
+        telemetry_write_raw(sample->dev);
+    }
+
+    if (block->n == 0) {
+        block->seq = sample->seq;
+        block->t_first_us = sample->t_us;
+        block->accel_range = raw->accel_range;
+        block->gyro_range = raw->gyro_range;
+    }
+
+    int16_t *dst = block->samples[block->n++];
+    dst[0] = raw->ax; dst[1] = raw->ay; dst[2] = raw->az;
+    dst[3] = raw->gx; dst[4] = raw->gy; dst[5] = raw->gz;
+    block->t_last_us = sample->t_us;
+
+    if (block->n == RAW_CODEC_BLOCK) { telemetry_write_raw(sample->dev); }
+}
+
+void telemetry_flush_raw(void) {
+    bool written = false;
+
+    for (uint8_t dev = 0; dev < IMU_MAX_CHANNELS; dev++) {
+        written |= raw_blocks[dev].n > 0;
+        telemetry_write_raw(dev);
+    }
+
+    if (written) { fflush(stdout); }
+}
+
+size_t telemetry_encode_motion(uint8_t *buf, const telemetry_sample_t *sample) {
+    const motion_state_t *state = &sample->state;
+    telemetry_motion_payload_t payload = {
+        .dev  = sample->dev,
+        .seq  = sample->seq,
+        .t_us = (uint64_t)sample->t_us,
+        .ax = state->ax, .ay = state->ay, .az = state->az,
+        .vx = state->vx, .vy = state->vy, .vz = state->vz,
+        .dx = state->dx, .dy = state->dy, .dz = state->dz,
+    };
+
+    return telemetry_encode_frame(buf, TELEMETRY_FRAME_MOTION, &payload, sizeof(payload));
+}
+
+void telemetry_emit_batch(output_format_t format, const telemetry_sample_t *samples, size_t n) {
+    if (format == OUTPUT_TEXT) {
+        for (size_t i = 0; i < n; i++) {
+            const motion_state_t *state = &samples[i].state;
+
+            // The text format has no device field: only the primary sensor is logged
+            if (samples[i].dev != 0) { continue; }
+
+            ESP_LOGI("Acceleration", "%.2f,%.2f,%.2f", state->ax, state->ay, state->az);
+            ESP_LOGI("Velocity", "%.2f,%.2f,%.2f", state->vx, state->vy, state->vz);
+            ESP_LOGI("Displacement", "%.2f,%.2f,%.2f", state->dx, state->dy, state->dz);
+        }
+        return;
+    }
+
+    if (format == OUTPUT_RAW) {
+        // Every frame is a single write, so frames stay contiguous with respect to log output
+        for (size_t i = 0; i < n; i++) {
+            telemetry_add_raw(&samples[i]);
+        }
+        fflush(stdout);
+        return;
+    }
+
+    static uint8_t batch[TELEMETRY_BATCH_SIZE * TELEMETRY_MOTION_FRAME];
+    size_t len = 0;
+
+    for (size_t i = 0; i < n && i < TELEMETRY_BATCH_SIZE; i++) {
+        len += telemetry_encode_motion(&batch[len], &samples[i]);
+    }
+
+    // A single fwrite keeps the frames contiguous with respect to log output
+    fwrite(batch, 1, len, stdout);
+    fflush(stdout);
+}
+
+void telemetry_emit_state(const telemetry_state_payload_t *states, size_t n) {
+    uint8_t batch[IMU_MAX_CHANNELS * TELEMETRY_STATE_FRAME];
+    size_t len = 0;
+
+    for (size_t i = 0; i < n && i < IMU_MAX_CHANNELS; i++) {
+        len += telemetry_encode_frame(&batch[len], TELEMETRY_FRAME_STATE, &states[i], sizeof(states[i]));
+    }
+
+    fwrite(batch, 1, len, stdout);
+    fflush(stdout);
+}
+
+void telemetry_emit_sync(uint32_t id, int64_t rx_us) {
+    uint8_t frame[TELEMETRY_HEADER_SIZE + sizeof(telemetry_sync_payload_t) + TELEMETRY_CRC_SIZE];
+    telemetry_sync_payload_t sync = {
+        .id    = id,
+        .rx_us = rx_us,
+        .tx_us = esp_timer_get_time(),
+    };
+
+    size_t len = telemetry_encode_frame(frame, TELEMETRY_FRAME_SYNC, &sync, sizeof(sync));
+    fwrite(frame, 1, len, stdout);
+    fflush(stdout);
+}
+
+void telemetry_emit_info(const task_config_t *config, const imu_channel_t *channels, size_t n) {
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+
+    for (size_t i = 0; i < n; i++) {
+        const mpu6050_cal_data_t *cal = &channels[i].cal;
+        telemetry_info_payload_t info = {
+            .dev            = i,
+            .addr           = channels[i].dev.addr,
+            .accel_range    = config->cfg.accel_range,
+            .gyro_range     = config->cfg.gyro_range,
+            .dlpf_cfg       = config->cfg.dlpf_cfg,
+            .smplrt_div     = config->cfg.smplrt_div,
+            .acq_mode       = config->acq_mode,
+            .output         = config->output,
+            .math           = config->math,
+            .decim          = config->decim,
+            .update_rate_ms = config->update_rate_ms,
+            .sample_rate_hz = mpu6050_sample_rate_hz(&config->cfg),
+            .ax_bias = cal->ax_bias, .ay_bias = cal->ay_bias, .az_bias = cal->az_bias,
+            .gx_bias = cal->gx_bias, .gy_bias = cal->gy_bias, .gz_bias = cal->gz_bias,
+            .cal_temp = cal->temp,
+        };
+
+        size_t len = telemetry_encode_frame(frame, TELEMETRY_FRAME_INFO, &info, sizeof(info));
+        fwrite(frame, 1, len, stdout);
+    }
+
+    fflush(stdout);
+}
+
+size_t telemetry_emit_event(const event_capture_t *ec, uint8_t dev, uint16_t rate_hz) {
+    static uint8_t batch[TELEMETRY_EVENT_BATCH * TELEMETRY_MAX_FRAME];
+    telemetry_event_data_payload_t data = {.dev = dev};
+    size_t total = 0, len = 0;
+    uint16_t n;
+
+    if (atomic_load_explicit(&ec->state, memory_order_acquire) != CAPTURE_FROZEN) { return 0; }
+
+    telemetry_event_payload_t header = {
+        .dev         = dev,
+        .event       = ec->events,
+        .t_us        = (uint64_t)ec->trigger_t_us,
+        .rate_hz     = rate_hz,
+        .pre         = ec->pre,
+        .post        = CAPTURE_POST_SAMPLES,
+        .duration    = ec->duration,
+        .peak_ratio  = ec->peak_ratio,
+        .accel_range = ec->range,
+    };
+    len = telemetry_encode_frame(batch, TELEMETRY_FRAME_EVENT, &header, sizeof(header));
+
+    // Raw int16 samples straight from the ring, no conversion on the way out
+    while ((n = event_capture_read(ec, data.offset, data.samples, TELEMETRY_EVENT_CHUNK)) > 0) {
+        uint8_t size = offsetof(telemetry_event_data_payload_t, samples) + n * sizeof(capture_sample_t);
+
+        len += telemetry_encode_frame(&batch[len], TELEMETRY_FRAME_EVENT_DATA, &data, size);
+        data.offset += n;
+
+        if (len + TELEMETRY_MAX_FRAME > sizeof(batch)) {
+            fwrite(batch, 1, len, stdout);
+            total += len;
+            len = 0;
+        }
+    }
+
+    fwrite(batch, 1, len, stdout);
+    fflush(stdout);
+
+    return total + len;
+}
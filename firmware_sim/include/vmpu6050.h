@@ -0,0 +1,129 @@
+#ifndef VMPU6050_H
+#define VMPU6050_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "sim_port.h"
+#include "waveform.h"
+
+// --- Virtual MPU6050 ---
+//
+// Register-level model of the sensor behind sim_i2c_attach. A sensor
+// thread latches a new sample at the output data rate set by SMPLRT_DIV
+// and CONFIG, like the real device:
+//
+//   ground motion -> + gravity on z -> tilt -> DLPF (CONFIG) -> + white noise
+//   -> quantization (ACCEL_CONFIG range) -> data registers, FIFO, INT
+//
+// Modelled: WHO_AM_I, sleep after reset, register auto-increment, burst
+// reads of one coherent sample, the 1 KB FIFO with FIFO_COUNT, overflow
+// (oldest data replaced) and reset, INT_STATUS clear on read (or on any
+// read with INT_PIN_CFG.INT_RD_CLEAR) and a data-ready pulse on the INT
+// pin. The gyroscope reads the tilt rate plus noise, the temperature 25 °C.
+// Low-power cycle mode samples the accelerometer at the LP_WAKE_CTRL rate
+// with the gyroscope in standby; motion detection compares against the
+// sample held by the ACCEL_HPF hold setting, and a latched INT pin
+// (INT_PIN_CFG.LATCH_INT_EN) stays high until the interrupt is cleared.
+// The tilt turns the sensor about its y axis, ramped in with a raised
+// cosine over VMPU6050_TILT_RAMP_S from the motion start; the ground truth
+// stays in the level frame.
+
+#define VMPU6050_TRUTH_DEPTH        16384   // Latched samples kept for ground truth lookups (16 s at 1 kHz)
+#define VMPU6050_FIFO_SIZE          1024    // FIFO capacity in bytes
+#define VMPU6050_GRAVITY            9.80665 // Gravity on the z axis (m/s²)
+#define VMPU6050_TEMP_C             25.0    // Die temperature reported by TEMP_OUT
+#define VMPU6050_TILT_RAMP_S        1.0     // Duration of the tilt ramp (s)
+
+/**
+ * @brief Ground truth of one latched sample
+ *
+ * t_us:                 Latch time (esp_timer)
+ * a, v, d:              Ground acceleration, velocity and displacement at t_us
+ */
+typedef struct {
+    int64_t t_us;
+    double a[WAVEFORM_AXES];
+    double v[WAVEFORM_AXES];
+    double d[WAVEFORM_AXES];
+} vmpu6050_truth_t;
+
+/**
+ * @brief Virtual sensor
+ *
+ * addr:                 I2C address
+ * int_pin:              GPIO driven by the INT output (-1 = not connected)
+ * wf:                   Ground motion
+ * noise_rms:            Accelerometer white noise per axis (m/s² rms)
+ * clock_ppm:            Sample clock error (positive = slow)
+ * tilt_deg:             Final tilt about y (degrees)
+ * rng:                  Noise generator state
+ * motion_start_us:      esp_timer time of waveform t = 0 (0 = at rest)
+ * lock:                 Guards registers, FIFO and truth
+ * regs:                 Register file
+ * ptr:                  Register pointer
+ * fifo, fifo_head, fifo_count: FIFO ring buffer
+ * count_l:              FIFO_COUNT_L latched by reading FIFO_COUNT_H
+ * lp:                   DLPF state (m/s²)
+ * hold:                 Motion detection reference (counts)
+ * mot_count:            Consecutive samples above the motion threshold
+ * int_level:            Latched INT pin is high
+ * truth, truth_head, latches: Ground truth ring and number of latched samples
+ */
+typedef struct {
+    uint8_t addr;
+    gpio_num_t int_pin;
+    const waveform_t *wf;
+    double noise_rms;
+    double clock_ppm;
+    double tilt_deg;
+    uint64_t rng;
+    _Atomic int64_t motion_start_us;
+    pthread_mutex_t lock;
+    pthread_t thread;
+    uint8_t regs[128];
+    uint8_t ptr;
+    uint8_t fifo[VMPU6050_FIFO_SIZE];
+    size_t fifo_head;
+    size_t fifo_count;
+    uint8_t count_l;
+    double lp[3];
+    int16_t hold[3];
+    uint8_t mot_count;
+    bool int_level;
+    vmpu6050_truth_t *truth;
+    size_t truth_head;
+    uint64_t latches;
+} vmpu6050_t;
+
+/**
+ * @brief Power on a sensor, attach it to the bus and start its sample clock
+ *
+ * @param s Sensor, addr, int_pin, wf, noise_rms, clock_ppm and tilt_deg set by the caller
+ * @param seed Noise seed
+ * @return true on success
+ */
+bool vmpu6050_start(vmpu6050_t *s, uint64_t seed);
+
+/**
+ * @brief Start the ground motion
+ *
+ * @param s Sensor
+ * @param t_us esp_timer time of waveform t = 0
+ */
+void vmpu6050_set_motion_start(vmpu6050_t *s, int64_t t_us);
+
+/**
+ * @brief Ground truth of the latest sample latched at or before a time
+ *
+ * @param s Sensor
+ * @param t_us esp_timer time
+ * @param out Truth of that sample
+ * @return false if no such sample is still in the truth ring
+ */
+bool vmpu6050_truth_at(vmpu6050_t *s, int64_t t_us, vmpu6050_truth_t *out);
+
+#endif // VMPU6050_H
@@ -0,0 +1,100 @@
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Ground Motion ---
+//
+// Synthetic waveforms are defined by their displacement, with velocity and
+// acceleration as its exact derivatives, so the simulated sensor output and
+// the ground truth come from the same expression. Recorded waveforms are
+// accelerograms, integrated to velocity and displacement on load.
+//
+//   sine:     d = A/2 (1 - cos 2 pi f t) for whole periods, starts and
+//             ends at rest
+//   pulse:    Gaussian displacement step-and-return of width 1 / (2 pi f)
+//   quake:    sum of three Gabor wavelets (f, 2.3 f, 4.1 f) with decaying
+//             amplitudes, a short strong-motion record
+//   file:     CSV "t_s,ax,ay,az" in m/s² at any constant rate
+
+#define WAVEFORM_AXES       3
+
+typedef enum {
+    WAVEFORM_SINE = 0,
+    WAVEFORM_PULSE,
+    WAVEFORM_QUAKE,
+    WAVEFORM_FILE,
+} waveform_kind_t;
+
+/**
+ * @brief Ground motion source
+ *
+ * kind:                 Waveform type
+ * axis:                 Axis driven by synthetic waveforms (0 = x)
+ * amplitude:            Peak displacement of synthetic waveforms (m)
+ * freq_hz:              Dominant frequency of synthetic waveforms
+ * duration_s:           Length of the motion, at rest afterwards
+ * t, a:                 Recorded samples (file): times and accelerations
+ * v, d:                 Recorded velocity and displacement, integrated on load
+ * n:                    Number of recorded samples
+ */
+typedef struct {
+    waveform_kind_t kind;
+    int axis;
+    double amplitude;
+    double freq_hz;
+    double duration_s;
+    double *t;
+    double (*a)[WAVEFORM_AXES];
+    double (*v)[WAVEFORM_AXES];
+    double (*d)[WAVEFORM_AXES];
+    size_t n;
+} waveform_t;
+
+/**
+ * @brief Ground motion at one instant
+ */
+typedef struct {
+    double a[WAVEFORM_AXES];    // acceleration in m/s²
+    double v[WAVEFORM_AXES];    // velocity in m/s
+    double d[WAVEFORM_AXES];    // displacement in meters
+} waveform_state_t;
+
+/**
+ * @brief Set up a synthetic waveform
+ *
+ * @param wf Output waveform
+ * @param kind WAVEFORM_SINE, WAVEFORM_PULSE or WAVEFORM_QUAKE
+ * @param axis Driven axis (0..2)
+ * @param amplitude Peak displacement (m)
+ * @param freq_hz Dominant frequency
+ * @param cycles Length in periods of freq_hz (sine only)
+ */
+void waveform_synthetic(waveform_t *wf, waveform_kind_t kind, int axis, double amplitude, double freq_hz, int cycles);
+
+/**
+ * @brief Load a recorded accelerogram
+ *
+ * @param wf Output waveform
+ * @param path CSV file with "t_s,ax,ay,az" rows, lines starting with '#' or
+ *             a letter are skipped
+ * @return true on success
+ */
+bool waveform_load(waveform_t *wf, const char *path);
+
+/**
+ * @brief Ground motion at a time since the motion started
+ *
+ * @param wf Waveform
+ * @param t_s Time (s), at rest before 0 and after the end
+ * @param out Acceleration, velocity and displacement
+ */
+void waveform_eval(const waveform_t *wf, double t_s, waveform_state_t *out);
+
+/**
+ * @brief Free the samples of a recorded waveform
+ */
+void waveform_free(waveform_t *wf);
+
+#endif // WAVEFORM_H
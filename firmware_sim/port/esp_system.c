@@ -0,0 +1,423 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_rom_sys.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+
+#include "sim_port.h"
+#include "port_internal.h"
+
+#define NVS_MAX_ENTRIES             32
+#define NVS_MAX_BLOB                256
+#define LOG_MAX_TAGS                8
+
+static struct timespec epoch;
+static bool realtime;
+static int console_fd = STDIN_FILENO;
+static esp_line_endings_t console_tx_endings = ESP_LINE_ENDINGS_CRLF;   // CONFIG_NEWLIB_STDOUT_LINE_ENDING_CRLF
+
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static esp_log_level_t log_default_level = ESP_LOG_INFO;
+static struct {
+    char tag[16];
+    esp_log_level_t level;
+} log_levels[LOG_MAX_TAGS];              // Per-tag levels, unused entries have an empty tag
+
+static ssize_t console_write(void *cookie, const char *buf, size_t size);
+
+bool sim_port_init(bool rt) {
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    realtime = rt;
+
+    // stdout goes through the console's line ending translation like the IDF VFS
+    static char console_buf[BUFSIZ];
+    FILE *console = fopencookie(NULL, "w", (cookie_io_functions_t){.write = console_write});
+    if (console == NULL) { port_fatal("console: %s", strerror(errno)); }
+    setvbuf(console, console_buf, _IOFBF, sizeof(console_buf));
+    stdout = console;
+
+    if (!realtime) { return true; }
+
+    // Probe once: SCHED_FIFO needs CAP_SYS_NICE
+    struct sched_param param = {.sched_priority = SIM_PRIO_BASE};
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+        realtime = false;
+        return false;
+    }
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    return true;
+}
+
+void sim_thread_setup(int priority) {
+    // Default timer slack (50 us) would dominate sub-millisecond waits
+    prctl(PR_SET_TIMERSLACK, 1UL);
+
+    if (!realtime) { return; }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    struct sched_param param = {.sched_priority = priority};
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+void port_thread_priority(pthread_t thread, int priority) {
+    if (!realtime) { return; }
+
+    struct sched_param param = {.sched_priority = priority};
+    pthread_setschedparam(thread, SCHED_FIFO, &param);
+}
+
+void port_timespec(int64_t t_us, struct timespec *ts) {
+    int64_t ns = epoch.tv_nsec + (t_us % 1000000) * 1000;
+
+    ts->tv_sec = epoch.tv_sec + t_us / 1000000 + ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+}
+
+void sim_sleep_until(int64_t t_us) {
+    struct timespec ts;
+
+    port_timespec(t_us, &ts);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+void port_fatal(const char *format, ...) {
+    va_list args;
+
+    va_start(args, format);
+    fprintf(stderr, "firmware_sim: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+
+    exit(2);
+}
+
+// --- Time and CPU ---
+
+static int64_t elapsed_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - epoch.tv_sec) * 1000000000LL + (now.tv_nsec - epoch.tv_nsec);
+}
+
+int64_t esp_timer_get_time(void) {
+    return elapsed_ns() / 1000;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    return (esp_cpu_cycle_count_t)(elapsed_ns() * SIM_CPU_MHZ / 1000);
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return SIM_CPU_MHZ;
+}
+
+void esp_restart(void) {
+    sim_log_write('I', "Sim", "esp_restart: simulation ends");
+    fflush(stdout);
+    exit(0);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    return (size_t)sysconf(_SC_AVPHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:                        return "ESP_OK";
+    case ESP_FAIL:                      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:      return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:           return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:       return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:                            return "UNKNOWN ERROR";
+    }
+}
+
+// --- Power Management ---
+
+esp_err_t esp_pm_configure(const void *config) {
+    (void)config;
+    // Light sleep has no effect on the host: a wake-up takes no time
+    return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void) {
+    return ESP_OK;
+}
+
+// --- Console ---
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    pthread_mutex_lock(&log_lock);
+
+    // Like the IDF, "*" sets the default and keeps the per-tag levels
+    if (strcmp(tag, "*") == 0) {
+        log_default_level = level;
+    } else {
+        for (size_t i = 0; i < LOG_MAX_TAGS; i++) {
+            if (log_levels[i].tag[0] == '\0') { strncpy(log_levels[i].tag, tag, sizeof(log_levels[i].tag) - 1); }
+            if (strcmp(log_levels[i].tag, tag) == 0) {
+                log_levels[i].level = level;
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&log_lock);
+}
+
+static bool log_enabled(char level, const char *tag) {
+    esp_log_level_t line_level = level == 'E' ? ESP_LOG_ERROR : level == 'W' ? ESP_LOG_WARN : ESP_LOG_INFO;
+
+    pthread_mutex_lock(&log_lock);
+    esp_log_level_t tag_level = log_default_level;
+    for (size_t i = 0; i < LOG_MAX_TAGS && log_levels[i].tag[0] != '\0'; i++) {
+        if (strcmp(log_levels[i].tag, tag) == 0) { tag_level = log_levels[i].level; }
+    }
+    pthread_mutex_unlock(&log_lock);
+
+    return line_level <= tag_level;
+}
+
+void sim_log_write(char level, const char *tag, const char *format, ...) {
+    char line[512];
+    va_list args;
+
+    if (!log_enabled(level, tag)) { return; }
+
+    int len = snprintf(line, sizeof(line), "%c (%lld) %s: ", level, (long long)(esp_timer_get_time() / 1000), tag);
+    va_start(args, format);
+    vsnprintf(line + len, sizeof(line) - len, format, args);
+    va_end(args);
+
+    // One write per line, like the IDF log lock
+    flockfile(stdout);
+    fputs(line, stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+    funlockfile(stdout);
+}
+
+void sim_console_input(int fd) {
+    console_fd = fd;
+}
+
+static bool console_write_all(const char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(STDOUT_FILENO, buf, size);
+        if (n < 0 && errno == EINTR) { continue; }
+        if (n <= 0) { return false; }
+        buf += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+static ssize_t console_write(void *cookie, const char *buf, size_t size) {
+    (void)cookie;
+    esp_line_endings_t mode = __atomic_load_n(&console_tx_endings, __ATOMIC_RELAXED);
+    size_t start = 0;
+
+    if (mode == ESP_LINE_ENDINGS_LF) { return console_write_all(buf, size) ? (ssize_t)size : -1; }
+
+    // Every '\n' byte becomes "\r\n" (or "\r"), binary or not
+    for (size_t i = 0; i < size; i++) {
+        if (buf[i] != '\n') { continue; }
+        if (!console_write_all(&buf[start], i - start)) { return -1; }
+        if (!console_write_all(mode == ESP_LINE_ENDINGS_CRLF ? "\r\n" : "\r", mode == ESP_LINE_ENDINGS_CRLF ? 2 : 1)) {
+            return -1;
+        }
+        start = i + 1;
+    }
+
+    return console_write_all(&buf[start], size - start) ? (ssize_t)size : -1;
+}
+
+esp_err_t usb_serial_jtag_driver_install(usb_serial_jtag_driver_config_t *config) {
+    (void)config;
+    return ESP_OK;
+}
+
+void usb_serial_jtag_vfs_use_driver(void) {
+}
+
+void usb_serial_jtag_vfs_set_tx_line_endings(esp_line_endings_t mode) {
+    __atomic_store_n(&console_tx_endings, mode, __ATOMIC_RELAXED);
+}
+
+void usb_serial_jtag_vfs_set_rx_line_endings(esp_line_endings_t mode) {
+    (void)mode;
+    // Commands are read from the driver, past the VFS: nothing to translate
+}
+
+int usb_serial_jtag_read_bytes(void *buf, uint32_t length, TickType_t ticks_to_wait) {
+    struct pollfd pfd = {.fd = console_fd, .events = POLLIN};
+    int timeout_ms = ticks_to_wait == portMAX_DELAY ? -1 : (int)(ticks_to_wait * portTICK_PERIOD_MS);
+
+    if (poll(&pfd, 1, timeout_ms) <= 0) { return 0; }
+
+    ssize_t n = read(console_fd, buf, length);
+    if (n <= 0) {
+        // Console closed: block like a device nobody types into
+        pause();
+        return 0;
+    }
+
+    return (int)n;
+}
+
+// --- NVS (in memory) ---
+
+typedef struct {
+    char space[NVS_KEY_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    uint8_t blob[NVS_MAX_BLOB];
+    size_t length;
+} nvs_entry_t;
+
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static nvs_entry_t nvs_entries[NVS_MAX_ENTRIES];
+static size_t nvs_count;
+static char nvs_spaces[NVS_MAX_ENTRIES][NVS_KEY_NAME_MAX_SIZE];
+static size_t nvs_space_count;
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    pthread_mutex_lock(&nvs_lock);
+    nvs_count = 0;
+    nvs_space_count = 0;
+    pthread_mutex_unlock(&nvs_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle) {
+    esp_err_t res = ESP_OK;
+    size_t i;
+
+    pthread_mutex_lock(&nvs_lock);
+    for (i = 0; i < nvs_space_count && strcmp(nvs_spaces[i], name) != 0; i++) {}
+
+    if (i == nvs_space_count) {
+        // Read-only opens do not create namespaces
+        if (mode == NVS_READONLY) {
+            res = ESP_ERR_NVS_NOT_FOUND;
+        } else if (nvs_space_count == NVS_MAX_ENTRIES) {
+            res = ESP_ERR_NVS_NO_FREE_PAGES;
+        } else {
+            strncpy(nvs_spaces[nvs_space_count++], name, NVS_KEY_NAME_MAX_SIZE - 1);
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+
+    if (res == ESP_OK) { *handle = (nvs_handle_t)(i + 1); }
+
+    return res;
+}
+
+static nvs_entry_t *nvs_find(nvs_handle_t handle, const char *key) {
+    for (size_t i = 0; i < nvs_count; i++) {
+        if (strcmp(nvs_entries[i].space, nvs_spaces[handle - 1]) == 0 && strcmp(nvs_entries[i].key, key) == 0) {
+            return &nvs_entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *length) {
+    esp_err_t res = ESP_OK;
+
+    if (handle == 0 || handle > nvs_space_count) { return ESP_ERR_NVS_INVALID_HANDLE; }
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = nvs_find(handle, key);
+    if (entry == NULL) {
+        res = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out == NULL) {
+        *length = entry->length;
+    } else if (*length < entry->length) {
+        res = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out, entry->blob, entry->length);
+        *length = entry->length;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+
+    return res;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    esp_err_t res = ESP_OK;
+
+    if (handle == 0 || handle > nvs_space_count) { return ESP_ERR_NVS_INVALID_HANDLE; }
+    if (length > NVS_MAX_BLOB) { return ESP_ERR_NVS_INVALID_LENGTH; }
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *entry = nvs_find(handle, key);
+    if (entry == NULL && nvs_count < NVS_MAX_ENTRIES) {
+        entry = &nvs_entries[nvs_count++];
+        strncpy(entry->space, nvs_spaces[handle - 1], NVS_KEY_NAME_MAX_SIZE - 1);
+        strncpy(entry->key, key, NVS_KEY_NAME_MAX_SIZE - 1);
+    }
+    if (entry != NULL) {
+        memcpy(entry->blob, value, length);
+        entry->length = length;
+    } else {
+        res = ESP_ERR_NVS_NO_FREE_PAGES;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+
+    return res;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
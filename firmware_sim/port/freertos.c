@@ -0,0 +1,397 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sim_port.h"
+#include "port_internal.h"
+
+struct sim_task {
+    pthread_t thread;
+    char name[16];
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    struct sim_task *next;
+};
+
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t length;
+    UBaseType_t item_size;          // 0 for semaphores
+    UBaseType_t count;
+    UBaseType_t head;
+    uint8_t *items;
+};
+
+static __thread struct sim_task *current_task;
+static pthread_mutex_t tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct sim_task *tasks;
+static UBaseType_t n_tasks;
+static struct sim_task idle_task = {.name = "IDLE"};
+
+void port_cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+void port_tick_deadline(TickType_t ticks, struct timespec *deadline) {
+    // A wait of n ticks ends on the n-th tick interrupt from now
+    int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+    int64_t t_us = (esp_timer_get_time() / tick_us + ticks) * tick_us;
+
+    port_timespec(t_us, deadline);
+}
+
+bool port_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline) {
+    if (ticks == 0) { return false; }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static void task_register(struct sim_task *task) {
+    pthread_mutex_init(&task->lock, NULL);
+    port_cond_init(&task->cond);
+
+    pthread_mutex_lock(&tasks_lock);
+    task->next = tasks;
+    tasks = task;
+    n_tasks++;
+    pthread_mutex_unlock(&tasks_lock);
+}
+
+static void *task_entry(void *arg) {
+    struct sim_task *task = arg;
+
+    current_task = task;
+    sim_thread_setup(SIM_PRIO_BASE + task->priority);
+    task->fn(task->arg);
+
+    // Returning from a task function is an error in FreeRTOS
+    port_fatal("task %s returned", task->name);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+    struct sim_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) { return pdFAIL; }
+
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    task->priority = priority;
+    task->stack_depth = stack_depth;
+    task->fn = fn;
+    task->arg = arg;
+    task_register(task);
+
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        port_fatal("cannot start task %s", name);
+    }
+    pthread_detach(task->thread);
+
+    if (handle != NULL) { *handle = task; }
+
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task != NULL && task != current_task) { port_fatal("only self deletion is supported"); }
+
+    task = current_task;
+    pthread_mutex_lock(&tasks_lock);
+    for (struct sim_task **p = &tasks; *p != NULL; p = &(*p)->next) {
+        if (*p == task) {
+            *p = task->next;
+            n_tasks--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tasks_lock);
+
+    pthread_mutex_destroy(&task->lock);
+    pthread_cond_destroy(&task->cond);
+    free(task);
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec deadline;
+
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+
+    port_tick_deadline(ticks, &deadline);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+    if (task != NULL && task != current_task) { port_fatal("only self suspension is supported"); }
+
+    sim_log_write('W', "Sim", "task %s suspended", current_task ? current_task->name : "?");
+    for (;;) { pause(); }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000000 / configTICK_RATE_HZ));
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    if (task == NULL) { task = current_task; }
+
+    task->priority = priority;
+    port_thread_priority(task->thread, SIM_PRIO_BASE + priority);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandle(void) {
+    return &idle_task;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct sim_task *task = current_task;
+    struct timespec deadline;
+    uint32_t value;
+
+    port_tick_deadline(ticks, &deadline);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0) {
+        if (!port_wait(&task->cond, &task->lock, ticks, &deadline)) { break; }
+    }
+    value = task->notify;
+    if (value != 0) { task->notify = clear_on_exit ? 0 : value - 1; }
+    pthread_mutex_unlock(&task->lock);
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_prio_woken) {
+    xTaskNotifyGive(task);
+    if (higher_prio_woken != NULL) { *higher_prio_woken = pdTRUE; }
+}
+
+static uint32_t thread_cpu_us(pthread_t thread) {
+    clockid_t clock;
+    struct timespec ts;
+
+    if (pthread_getcpuclockid(thread, &clock) != 0 || clock_gettime(clock, &ts) != 0) { return 0; }
+
+    return (uint32_t)(ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, configRUN_TIME_COUNTER_TYPE *total_run_time) {
+    UBaseType_t n = 0;
+    uint32_t busy = 0;
+
+    pthread_mutex_lock(&tasks_lock);
+    if (size < n_tasks + 1) {
+        pthread_mutex_unlock(&tasks_lock);
+        return 0;
+    }
+
+    for (struct sim_task *task = tasks; task != NULL; task = task->next, n++) {
+        status[n] = (TaskStatus_t){
+            .xHandle = task,
+            .pcTaskName = task->name,
+            .xTaskNumber = n + 1,
+            .eCurrentState = task == current_task ? eRunning : eBlocked,
+            .uxCurrentPriority = task->priority,
+            .uxBasePriority = task->priority,
+            .ulRunTimeCounter = thread_cpu_us(task->thread),
+            .usStackHighWaterMark = task->stack_depth,
+        };
+        busy += status[n].ulRunTimeCounter;
+    }
+    pthread_mutex_unlock(&tasks_lock);
+
+    // Single core accounting: whatever the tasks did not use was idle time
+    uint32_t total = (uint32_t)esp_timer_get_time();
+    status[n++] = (TaskStatus_t){
+        .xHandle = &idle_task,
+        .pcTaskName = idle_task.name,
+        .eCurrentState = eReady,
+        .ulRunTimeCounter = total > busy ? total - busy : 0,
+    };
+
+    if (total_run_time != NULL) { *total_run_time = total; }
+
+    return n;
+}
+
+configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter(void) {
+    uint32_t busy = 0;
+
+    pthread_mutex_lock(&tasks_lock);
+    for (struct sim_task *task = tasks; task != NULL; task = task->next) { busy += thread_cpu_us(task->thread); }
+    pthread_mutex_unlock(&tasks_lock);
+
+    // Same accounting as uxTaskGetSystemState
+    uint32_t total = (uint32_t)esp_timer_get_time();
+
+    return total > busy ? total - busy : 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    return n_tasks + 1;
+}
+
+// --- Queues and Semaphores ---
+
+static struct sim_queue *queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t count) {
+    struct sim_queue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL) { return NULL; }
+
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->count = count;
+    if (item_size > 0) {
+        queue->items = calloc(length, item_size);
+        if (queue->items == NULL) {
+            free(queue);
+            return NULL;
+        }
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    port_cond_init(&queue->cond);
+
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return queue_create(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->cond);
+    free(queue->items);
+    free(queue);
+}
+
+static BaseType_t queue_send(struct sim_queue *queue, const void *item, TickType_t ticks, bool overwrite) {
+    struct timespec deadline;
+
+    port_tick_deadline(ticks, &deadline);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && !overwrite) {
+        if (!port_wait(&queue->cond, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    if (queue->item_size > 0 && item != NULL) {
+        // Overwrite only exists for length 1 queues, it replaces the item
+        UBaseType_t slot = overwrite && queue->count == queue->length ? queue->head
+                                                                      : (queue->head + queue->count) % queue->length;
+        memcpy(&queue->items[slot * queue->item_size], item, queue->item_size);
+    }
+    if (queue->count < queue->length) { queue->count++; }
+
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+static BaseType_t queue_receive(struct sim_queue *queue, void *item, TickType_t ticks, bool peek) {
+    struct timespec deadline;
+
+    port_tick_deadline(ticks, &deadline);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!port_wait(&queue->cond, &queue->lock, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    if (queue->item_size > 0) { memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size); }
+    if (!peek) {
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    return queue_send(queue, item, 0, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return queue_create(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return queue_create(1, 0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    return queue_receive(sem, NULL, ticks, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return queue_send(sem, NULL, 0, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_prio_woken) {
+    BaseType_t res = queue_send(sem, NULL, 0, false);
+
+    if (higher_prio_woken != NULL) { *higher_prio_woken = res; }
+
+    return res;
+}
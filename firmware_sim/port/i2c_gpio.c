@@ -0,0 +1,362 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "esp_timer.h"
+
+#include "sim_port.h"
+#include "port_internal.h"
+
+#define SIM_I2C_MAX_TARGETS         4
+#define SIM_GPIO_PINS               32
+
+typedef struct {
+    uint16_t addr;
+    const sim_i2c_target_t *target;
+    void *ctx;
+} i2c_target_slot_t;
+
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    uint8_t tx[SIM_I2C_MAX_TRANSFER];
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+} i2c_job_t;
+
+struct i2c_master_bus_t {
+    pthread_mutex_t lock;           // Held while the bus is busy
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_cond;
+    i2c_job_t *jobs;
+    size_t depth;
+    size_t head;
+    size_t count;
+    bool active;                    // The head job is on the wire
+    bool abort;                     // i2c_master_bus_reset cut the head job off
+    uint8_t rx[SIM_I2C_MAX_TRANSFER];   // Read phase of the head job, handed over on completion
+    pthread_t thread;
+};
+
+struct i2c_master_dev_t {
+    struct i2c_master_bus_t *bus;
+    uint16_t addr;
+    uint32_t scl_speed_hz;
+    i2c_master_callback_t on_done;
+    void *cb_arg;
+};
+
+typedef struct {
+    gpio_isr_t handler;
+    void *arg;
+    bool enabled;
+    bool high_level;
+    int level;
+} gpio_pin_t;
+
+static i2c_target_slot_t i2c_targets[SIM_I2C_MAX_TARGETS];
+static size_t n_i2c_targets;
+static pthread_mutex_t gpio_lock = PTHREAD_MUTEX_INITIALIZER;
+static gpio_pin_t gpio_pins[SIM_GPIO_PINS];
+static bool gpio_isr_installed;
+
+void sim_i2c_attach(uint16_t addr, const sim_i2c_target_t *target, void *ctx) {
+    if (n_i2c_targets == SIM_I2C_MAX_TARGETS) { port_fatal("too many I2C targets"); }
+
+    i2c_targets[n_i2c_targets++] = (i2c_target_slot_t){.addr = addr, .target = target, .ctx = ctx};
+}
+
+static const i2c_target_slot_t *i2c_find(uint16_t addr) {
+    for (size_t i = 0; i < n_i2c_targets; i++) {
+        if (i2c_targets[i].addr == addr) { return &i2c_targets[i]; }
+    }
+
+    return NULL;
+}
+
+static int64_t i2c_bits_us(size_t bits, uint32_t scl_hz) {
+    return (int64_t)bits * 1000000 / scl_hz;
+}
+
+/**
+ * @brief Run one transfer on the bus, taking the time the wire would take
+ *
+ * Write phase: start, address, tx bytes. Read phase: repeated start,
+ * address, rx bytes. Every byte is 9 clocks with its acknowledge. The
+ * target sees the write when it is complete and is read at the start of
+ * the read phase, the sensor's shadow registers are latched there too.
+ */
+static esp_err_t i2c_execute(struct i2c_master_bus_t *bus, struct i2c_master_dev_t *dev,
+                             const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    const i2c_target_slot_t *slot = i2c_find(dev->addr);
+    int64_t t = esp_timer_get_time() + SIM_I2C_OVERHEAD_US;
+
+    pthread_mutex_lock(&bus->lock);
+
+    // Address byte only when the target does not acknowledge
+    if (slot == NULL) {
+        sim_sleep_until(t + i2c_bits_us(1 + 9 + 1, dev->scl_speed_hz));
+        pthread_mutex_unlock(&bus->lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    t += i2c_bits_us(1 + 9 * (1 + tx_len), dev->scl_speed_hz);
+    sim_sleep_until(t);
+    if (tx_len > 0) { slot->target->write(slot->ctx, tx, tx_len); }
+
+    if (rx_len > 0) {
+        t += i2c_bits_us(1 + 9, dev->scl_speed_hz);
+        slot->target->read(slot->ctx, rx, rx_len);
+        t += i2c_bits_us(9 * rx_len, dev->scl_speed_hz);
+    }
+    sim_sleep_until(t + i2c_bits_us(1, dev->scl_speed_hz));
+
+    pthread_mutex_unlock(&bus->lock);
+
+    return ESP_OK;
+}
+
+static void *i2c_bus_thread(void *arg) {
+    struct i2c_master_bus_t *bus = arg;
+
+    sim_thread_setup(SIM_PRIO_ISR);
+
+    for (;;) {
+        pthread_mutex_lock(&bus->queue_lock);
+        while (bus->count == 0) { pthread_cond_wait(&bus->queue_cond, &bus->queue_lock); }
+        i2c_job_t job = bus->jobs[bus->head];
+        bus->active = true;
+        pthread_mutex_unlock(&bus->queue_lock);
+
+        esp_err_t res = i2c_execute(bus, job.dev, job.tx, job.tx_len, bus->rx, job.rx_len);
+
+        pthread_mutex_lock(&bus->queue_lock);
+        bool aborted = bus->abort;
+        bus->active = false;
+        bus->abort = false;
+        bus->head = (bus->head + 1) % bus->depth;
+        bus->count--;
+        pthread_cond_broadcast(&bus->queue_cond);
+        pthread_mutex_unlock(&bus->queue_lock);
+
+        // Completion interrupt: the received bytes land in the caller's buffer only now
+        i2c_master_event_data_t evt = {.event = aborted ? I2C_EVENT_TIMEOUT : res == ESP_OK ? I2C_EVENT_DONE : I2C_EVENT_NACK};
+        if (evt.event == I2C_EVENT_DONE && job.rx_len > 0) { memcpy(job.rx, bus->rx, job.rx_len); }
+        job.dev->on_done(job.dev, &evt, job.dev->cb_arg);
+    }
+
+    return NULL;
+}
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *config, i2c_master_bus_handle_t *handle) {
+    struct i2c_master_bus_t *bus = calloc(1, sizeof(*bus));
+    if (bus == NULL) { return ESP_ERR_NO_MEM; }
+
+    bus->depth = config->trans_queue_depth ? config->trans_queue_depth : 1;
+    bus->jobs = calloc(bus->depth, sizeof(i2c_job_t));
+    if (bus->jobs == NULL) { return ESP_ERR_NO_MEM; }
+
+    pthread_mutex_init(&bus->lock, NULL);
+    pthread_mutex_init(&bus->queue_lock, NULL);
+    pthread_cond_init(&bus->queue_cond, NULL);
+    if (pthread_create(&bus->thread, NULL, i2c_bus_thread, bus) != 0) { return ESP_FAIL; }
+    pthread_detach(bus->thread);
+
+    *handle = bus;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *config, i2c_master_dev_handle_t *handle) {
+    struct i2c_master_dev_t *dev = calloc(1, sizeof(*dev));
+    if (dev == NULL) { return ESP_ERR_NO_MEM; }
+
+    dev->bus = bus;
+    dev->addr = config->device_address;
+    dev->scl_speed_hz = config->scl_speed_hz ? config->scl_speed_hz : 100000;
+    *handle = dev;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev) {
+    free(dev);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_register_event_callbacks(i2c_master_dev_handle_t dev, const i2c_master_event_callbacks_t *cbs, void *arg) {
+    dev->on_done = cbs->on_trans_done;
+    dev->cb_arg = arg;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus) {
+    // Cuts off the transfer on the wire, which then completes with a timeout and no data
+    pthread_mutex_lock(&bus->queue_lock);
+    bus->abort = bus->active;
+    pthread_mutex_unlock(&bus->queue_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t address, int timeout_ms) {
+    (void)timeout_ms;
+    struct i2c_master_dev_t probe = {.bus = bus, .addr = address, .scl_speed_hz = 100000};
+
+    return i2c_execute(bus, &probe, NULL, 0, NULL, 0);
+}
+
+static esp_err_t i2c_transfer(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len) {
+    struct i2c_master_bus_t *bus = dev->bus;
+
+    if (tx_len > SIM_I2C_MAX_TRANSFER || rx_len > SIM_I2C_MAX_TRANSFER) { return ESP_ERR_INVALID_SIZE; }
+
+    // Without a callback the caller waits for the transfer
+    if (dev->on_done == NULL) {
+        esp_err_t res = i2c_execute(bus, dev, tx, tx_len, rx, rx_len);
+        return res == ESP_ERR_NOT_FOUND ? ESP_ERR_INVALID_STATE : res;
+    }
+
+    pthread_mutex_lock(&bus->queue_lock);
+    while (bus->count == bus->depth) { pthread_cond_wait(&bus->queue_cond, &bus->queue_lock); }
+
+    i2c_job_t *job = &bus->jobs[(bus->head + bus->count) % bus->depth];
+    job->dev = dev;
+    memcpy(job->tx, tx, tx_len);
+    job->tx_len = tx_len;
+    job->rx = rx;
+    job->rx_len = rx_len;
+    bus->count++;
+
+    pthread_cond_broadcast(&bus->queue_cond);
+    pthread_mutex_unlock(&bus->queue_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, int timeout_ms) {
+    (void)timeout_ms;
+    return i2c_transfer(dev, tx, tx_len, NULL, 0);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len, int timeout_ms) {
+    (void)timeout_ms;
+    return i2c_transfer(dev, tx, tx_len, rx, rx_len);
+}
+
+// --- GPIO ---
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    pthread_mutex_lock(&gpio_lock);
+    for (int pin = 0; pin < SIM_GPIO_PINS; pin++) {
+        if (config->pin_bit_mask & (1ULL << pin)) {
+            gpio_pins[pin].enabled = config->intr_type != GPIO_INTR_DISABLE;
+            gpio_pins[pin].high_level = config->intr_type == GPIO_INTR_HIGH_LEVEL;
+        }
+    }
+    pthread_mutex_unlock(&gpio_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    (void)flags;
+    if (gpio_isr_installed) { return ESP_ERR_INVALID_STATE; }
+    gpio_isr_installed = true;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg) {
+    if (pin < 0 || pin >= SIM_GPIO_PINS) { return ESP_ERR_INVALID_ARG; }
+
+    pthread_mutex_lock(&gpio_lock);
+    gpio_pins[pin].handler = handler;
+    gpio_pins[pin].arg = arg;
+    pthread_mutex_unlock(&gpio_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    return gpio_isr_handler_add(pin, NULL, NULL);
+}
+
+static esp_err_t gpio_intr_set(gpio_num_t pin, bool enabled) {
+    gpio_isr_t handler = NULL;
+    void *arg = NULL;
+
+    if (pin < 0 || pin >= SIM_GPIO_PINS) { return ESP_ERR_INVALID_ARG; }
+
+    pthread_mutex_lock(&gpio_lock);
+    gpio_pin_t *p = &gpio_pins[pin];
+    p->enabled = enabled;
+
+    // A level interrupt enabled while its level is present fires right away
+    if (enabled && p->high_level && p->level && gpio_isr_installed) {
+        handler = p->handler;
+        arg = p->arg;
+    }
+    pthread_mutex_unlock(&gpio_lock);
+
+    if (handler != NULL) { handler(arg); }
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin) {
+    return gpio_intr_set(pin, true);
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t pin) {
+    return gpio_intr_set(pin, false);
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+    if (pin < 0 || pin >= SIM_GPIO_PINS) { return ESP_ERR_INVALID_ARG; }
+    if (type != GPIO_INTR_HIGH_LEVEL && type != GPIO_INTR_LOW_LEVEL) { return ESP_ERR_INVALID_ARG; }
+
+    // Like the device, the wake-up level becomes the pin's interrupt type
+    pthread_mutex_lock(&gpio_lock);
+    gpio_pins[pin].high_level = type == GPIO_INTR_HIGH_LEVEL;
+    pthread_mutex_unlock(&gpio_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t pin) {
+    if (pin < 0 || pin >= SIM_GPIO_PINS) { return ESP_ERR_INVALID_ARG; }
+
+    pthread_mutex_lock(&gpio_lock);
+    gpio_pins[pin].high_level = false;
+    pthread_mutex_unlock(&gpio_lock);
+
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {
+    return (pin >= 0 && pin < SIM_GPIO_PINS) ? gpio_pins[pin].level : 0;
+}
+
+void sim_gpio_set(gpio_num_t pin, int level) {
+    gpio_isr_t handler = NULL;
+    void *arg = NULL;
+
+    if (pin < 0 || pin >= SIM_GPIO_PINS) { return; }
+
+    pthread_mutex_lock(&gpio_lock);
+    gpio_pin_t *p = &gpio_pins[pin];
+    if (level && !p->level && p->enabled && gpio_isr_installed) {
+        handler = p->handler;
+        arg = p->arg;
+    }
+    p->level = level;
+    pthread_mutex_unlock(&gpio_lock);
+
+    // Rising edge interrupt, runs on the thread that drives the pin
+    if (handler != NULL) { handler(arg); }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/i2c_types.h"
+
+typedef struct i2c_master_bus_t *i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t *i2c_master_dev_handle_t;
+
+typedef struct {
+    i2c_port_num_t i2c_port;
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    i2c_clock_source_t clk_source;
+    uint8_t glitch_ignore_cnt;
+    int intr_priority;
+    size_t trans_queue_depth;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+        uint32_t allow_pd : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+    struct {
+        uint32_t disable_ack_check : 1;
+    } flags;
+} i2c_device_config_t;
+
+typedef enum {
+    I2C_EVENT_ALIVE,
+    I2C_EVENT_DONE,
+    I2C_EVENT_NACK,
+    I2C_EVENT_TIMEOUT,
+} i2c_master_event_t;
+
+typedef struct {
+    i2c_master_event_t event;
+} i2c_master_event_data_t;
+
+typedef bool (*i2c_master_callback_t)(i2c_master_dev_handle_t dev, const i2c_master_event_data_t *evt, void *arg);
+
+typedef struct {
+    i2c_master_callback_t on_trans_done;
+} i2c_master_event_callbacks_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *config, i2c_master_bus_handle_t *bus);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t *config, i2c_master_dev_handle_t *dev);
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev);
+esp_err_t i2c_master_register_event_callbacks(i2c_master_dev_handle_t dev, const i2c_master_event_callbacks_t *cbs, void *arg);
+esp_err_t i2c_master_bus_reset(i2c_master_bus_handle_t bus);
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t address, int timeout_ms);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, int timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len, int timeout_ms);
@@ -0,0 +1,17 @@
+#pragma once
+
+typedef int i2c_port_num_t;
+
+typedef enum {
+    I2C_NUM_0 = 0,
+    I2C_NUM_MAX,
+} i2c_port_t;
+
+typedef enum {
+    I2C_CLK_SRC_DEFAULT = 0,
+} i2c_clock_source_t;
+
+typedef enum {
+    I2C_ADDR_BIT_LEN_7 = 0,
+    I2C_ADDR_BIT_LEN_10,
+} i2c_addr_bit_len_t;
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "esp_vfs_common.h"
+
+void usb_serial_jtag_vfs_use_driver(void);
+void usb_serial_jtag_vfs_set_tx_line_endings(esp_line_endings_t mode);
+void usb_serial_jtag_vfs_set_rx_line_endings(esp_line_endings_t mode);
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+// Host time scaled to the 160 MHz CPU clock, wraps like the real counter
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE = 0,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+/**
+ * @brief Set the log level of a tag, "*" for the default of all other tags
+ */
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+// Same line format as the IDF console: "I (<ms>) <tag>: <message>"
+void sim_log_write(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...)  sim_log_write('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  sim_log_write('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  sim_log_write('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  do { } while (0)
+#define ESP_LOGV(tag, format, ...)  do { } while (0)
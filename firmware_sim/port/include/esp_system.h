@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define MALLOC_CAP_DEFAULT          (1 << 12)
+
+void esp_restart(void) __attribute__((noreturn));
+size_t heap_caps_get_free_size(uint32_t caps);
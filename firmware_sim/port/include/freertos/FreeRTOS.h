@@ -0,0 +1,28 @@
+#pragma once
+
+// Host port of the FreeRTOS API used by the firmware (see firmware_sim/port)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>          // Pulled in by the IDF port layer, the firmware relies on it
+
+#include "esp_attr.h"
+
+#define configTICK_RATE_HZ          100     // CONFIG_FREERTOS_HZ of the firmware's sdkconfig
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE                     ((BaseType_t)0)
+#define pdTRUE                      ((BaseType_t)1)
+#define pdPASS                      pdTRUE
+#define pdFAIL                      pdFALSE
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS          ((TickType_t)(1000 / configTICK_RATE_HZ))
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+// ISRs run on host threads, there is no context switch to request
+#define portYIELD_FROM_ISR(woken)   ((void)(woken))
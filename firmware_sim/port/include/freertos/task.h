@@ -0,0 +1,44 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;   // Thread CPU time (us)
+    void *pxStackBase;
+    uint32_t usStackHighWaterMark;                  // Not measured on the host, reports the stack size
+} TaskStatus_t;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority, TaskHandle_t *handle);
+void vTaskDelete(TaskHandle_t task) __attribute__((noreturn));
+void vTaskDelay(TickType_t ticks);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TaskHandle_t xTaskGetIdleTaskHandle(void);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_prio_woken);
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size, configRUN_TIME_COUNTER_TYPE *total_run_time);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter(void);
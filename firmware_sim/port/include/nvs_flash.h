@@ -0,0 +1,7 @@
+#pragma once
+
+#include "nvs.h"
+
+// Flash is kept in memory: every simulation boots with an empty NVS
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
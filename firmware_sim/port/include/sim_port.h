@@ -0,0 +1,104 @@
+#ifndef SIM_PORT_H
+#define SIM_PORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+
+// --- Host Port ---
+//
+// The firmware runs unmodified on Linux threads:
+//
+//   Tasks:        one thread per task, blocking calls wait on condition
+//                 variables. Timeouts and vTaskDelay end on 10 ms tick
+//                 boundaries like the FreeRTOS tick interrupt.
+//   Time:         esp_timer and the cycle counter follow CLOCK_MONOTONIC
+//                 from sim_port_init, the cycle counter at 160 MHz.
+//   I2C:          transfers go to the targets registered with
+//                 sim_i2c_attach and take the time the bus would need at
+//                 the device's SCL clock. Devices with a callback complete
+//                 on a bus thread, like the asynchronous IDF driver, and
+//                 receive their read bytes with the completion. A bus
+//                 reset cuts the transfer on the wire off with a timeout.
+//   GPIO:         sim_gpio_set on an input with a handler calls the ISR
+//                 on the calling thread, on rising edges. A high level
+//                 interrupt (the light sleep wake-up pin) also fires when
+//                 it is enabled while the pin is high.
+//   Power:        esp_pm_configure is accepted, the host never sleeps and
+//                 a light sleep wake-up takes no time.
+//   Console:      ESP_LOG lines and telemetry go to stdout, commands are
+//                 read from the descriptor given to sim_console_input.
+//                 stdout translates '\n' to "\r\n" until the firmware sets
+//                 other TX line endings, like the VFS with the sdkconfig.
+//
+// Realtime mode pins every simulation thread to one CPU under SCHED_FIFO,
+// with the task priorities of the firmware above SIM_PRIO_BASE and bus and
+// sensor threads above all tasks, so preemption follows the device's
+// single core scheduler. Without it threads share the host like any process.
+
+#define SIM_CPU_MHZ                 160     // Cycle counter rate (ESP32-C6 CPU clock)
+#define SIM_PRIO_BASE               10      // SCHED_FIFO priority of FreeRTOS priority 0
+#define SIM_PRIO_ISR                60      // SCHED_FIFO priority of bus and sensor threads
+#define SIM_I2C_OVERHEAD_US         15      // Driver and interrupt time per transfer on top of the bus time
+#define SIM_I2C_MAX_TRANSFER        1100    // Largest read or write (a full FIFO burst)
+
+/**
+ * @brief Register-level I2C target
+ *
+ * write:                Master write phase (register pointer first, then data)
+ * read:                 Master read phase, len bytes from the register pointer
+ */
+typedef struct {
+    void (*write)(void *ctx, const uint8_t *data, size_t len);
+    void (*read)(void *ctx, uint8_t *data, size_t len);
+} sim_i2c_target_t;
+
+/**
+ * @brief Start the clocks, must run before any other port call
+ *
+ * @param realtime Pin threads to one CPU with SCHED_FIFO priorities
+ * @return true if the requested scheduling is in effect
+ */
+bool sim_port_init(bool realtime);
+
+/**
+ * @brief Apply the simulation scheduling to the calling thread
+ *
+ * @param priority SCHED_FIFO priority in realtime mode
+ */
+void sim_thread_setup(int priority);
+
+/**
+ * @brief Sleep until an absolute esp_timer time
+ *
+ * @param t_us Wake-up time (us)
+ */
+void sim_sleep_until(int64_t t_us);
+
+/**
+ * @brief Connect a target to the I2C bus
+ *
+ * @param addr 7-bit address
+ * @param target Register access callbacks
+ * @param ctx Target context
+ */
+void sim_i2c_attach(uint16_t addr, const sim_i2c_target_t *target, void *ctx);
+
+/**
+ * @brief Drive a GPIO input, a rising edge runs its interrupt handler
+ *
+ * @param pin GPIO number
+ * @param level New level
+ */
+void sim_gpio_set(gpio_num_t pin, int level);
+
+/**
+ * @brief Read console input (commands) from a file descriptor
+ *
+ * @param fd Descriptor, stdin by default
+ */
+void sim_console_input(int fd);
+
+#endif // SIM_PORT_H
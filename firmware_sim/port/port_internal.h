@@ -0,0 +1,44 @@
+#ifndef PORT_INTERNAL_H
+#define PORT_INTERNAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief Log a port error and terminate the simulation
+ */
+void port_fatal(const char *format, ...) __attribute__((format(printf, 1, 2), noreturn));
+
+/**
+ * @brief Change the SCHED_FIFO priority of a task thread in realtime mode
+ */
+void port_thread_priority(pthread_t thread, int priority);
+
+/**
+ * @brief Convert an esp_timer time to an absolute CLOCK_MONOTONIC time
+ */
+void port_timespec(int64_t t_us, struct timespec *ts);
+
+/**
+ * @brief Initialize a condition variable on CLOCK_MONOTONIC
+ */
+void port_cond_init(pthread_cond_t *cond);
+
+/**
+ * @brief Absolute deadline of a wait of a number of ticks
+ */
+void port_tick_deadline(TickType_t ticks, struct timespec *deadline);
+
+/**
+ * @brief Wait on a condition with a FreeRTOS timeout
+ *
+ * @param ticks 0 = do not wait, portMAX_DELAY = no timeout
+ * @param deadline From port_tick_deadline
+ * @return false if the wait timed out
+ */
+bool port_wait(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks, const struct timespec *deadline);
+
+#endif // PORT_INTERNAL_H
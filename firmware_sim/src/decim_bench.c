@@ -0,0 +1,83 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "decimator.h"
+
+// Host cost of the decimation filters, per input sample over all axes: the
+// same tone replay as the firmware's bench:decim, at several factors since
+// the FIR's work grows with the factor and the CIC's does not.
+
+#define DECIM_BENCH_SAMPLES     2000000     // Input samples fed to each decimator
+#define DECIM_BENCH_RATE_HZ     1000        // Input rate of the replay
+#define DECIM_BENCH_TONE_HZ     33          // Test tone, passband at /5 and /10, aliased from /20 on
+#define DECIM_BENCH_AMPLITUDE   8000        // Test tone amplitude (counts)
+#define DECIM_BENCH_TONE_LEN    1000        // Replayed tone period (whole cycles at the input rate)
+
+static const uint16_t factors[] = {5, 10, 20, 50};
+
+static int16_t tone[DECIM_BENCH_TONE_LEN];
+static decim_fir_kernel_t kernel;
+static decim_fir_t fir;
+static decim_cic_t cic;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_factor(uint16_t factor, long samples) {
+    int16_t in[DECIM_AXES], out[DECIM_AXES];
+    int32_t fir_peak = 0, cic_peak = 0;
+
+    decim_fir_design(&kernel, factor);
+    decim_fir_reset(&fir);
+    decim_cic_reset(&cic, factor);
+
+    // Filters run separately so each one has the caches to itself
+    double start = now_ns();
+    for (long i = 0; i < samples; i++) {
+        in[0] = in[1] = in[2] = tone[i % DECIM_BENCH_TONE_LEN];
+        if (decim_fir_push(&fir, &kernel, in, out) && i >= kernel.taps && abs(out[0]) > fir_peak) { fir_peak = abs(out[0]); }
+    }
+    double fir_ns = now_ns() - start;
+
+    start = now_ns();
+    for (long i = 0; i < samples; i++) {
+        in[0] = in[1] = in[2] = tone[i % DECIM_BENCH_TONE_LEN];
+        if (decim_cic_push(&cic, in, out) && i >= DECIM_CIC_ORDER * factor && abs(out[0]) > cic_peak) { cic_peak = abs(out[0]); }
+    }
+    double cic_ns = now_ns() - start;
+
+    printf("/%-3u fir %6.2f ns/sample (%3u taps)  cic %6.2f ns/sample  %d Hz out: fir=%" PRId32 " cic=%" PRId32 " (peak counts)\n",
+           factor, fir_ns / samples, kernel.taps, cic_ns / samples, DECIM_BENCH_TONE_HZ, fir_peak, cic_peak);
+}
+
+int main(int argc, char **argv) {
+    long samples = DECIM_BENCH_SAMPLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--samples N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    for (int i = 0; i < DECIM_BENCH_TONE_LEN; i++) {
+        tone[i] = (int16_t)(DECIM_BENCH_AMPLITUDE * sin(2.0 * M_PI * DECIM_BENCH_TONE_HZ * i / DECIM_BENCH_RATE_HZ));
+    }
+
+    printf("%d axes, %d Hz input, tone of %d counts at %d Hz\n",
+           DECIM_AXES, DECIM_BENCH_RATE_HZ, DECIM_BENCH_AMPLITUDE, DECIM_BENCH_TONE_HZ);
+    for (size_t i = 0; i < sizeof(factors) / sizeof(factors[0]); i++) { bench_factor(factors[i], samples); }
+
+    return 0;
+}
@@ -0,0 +1,579 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include "app_tasks.h"
+#include "telemetry.h"
+
+#include "sim_port.h"
+#include "vmpu6050.h"
+#include "waveform.h"
+
+#define SIM_MAX_SENSORS         2
+#define SIM_BOOT_TIMEOUT_US     10000000    // Boot and calibration must finish within this
+#define SIM_TAIL_US             1000000     // Recording time after the motion ends
+#define SIM_DRAIN_US            300000      // Wait for the console after the last command
+#define SIM_PIPE_SIZE           (1 << 20)   // Console pipe capacity, the host never stalls the firmware
+#define SIM_RX_CHUNK            4096        // Console bytes read per host wake-up
+
+void app_main(void);
+
+/**
+ * @brief Scenario options
+ */
+typedef struct {
+    const char *mode;
+    const char *math;
+    const char *decim;
+    const char *tilt_comp;
+    const char *drift;
+    const char *autorange;
+    const char *standby;
+    const char *sensor_config;
+    const char *wave;
+    const char *csv_path;
+    int rate_ms;
+    double noise_floor;
+    double amplitude;
+    double freq_hz;
+    int cycles;
+    int axis;
+    double noise_rms;
+    double clock_ppm;
+    double tilt_deg;
+    double settle_s;
+    int sensors;
+    bool realtime;
+    bool verbose;
+} sim_options_t;
+
+/**
+ * @brief Running mean, standard deviation and maximum (of the magnitude)
+ */
+typedef struct {
+    uint64_t n;
+    double sum;
+    double sum_sq;
+    double max;
+} sim_acc_t;
+
+/**
+ * @brief Measurements of the received stream
+ *
+ * samples, lost, crc_errors: Motion frames received, sequence gaps, bad frames
+ * latency_us, n_latency, cap_latency: Host receive time - sensor latch, every sample
+ * stamp_age:            Firmware timestamp - latest sensor latch at or before it (us)
+ * interval:             Timestamp spacing of consecutive samples of a sensor (us)
+ * d_err, v_err:         Displacement and velocity error against ground truth per axis
+ * d_peak:               Largest true displacement per axis
+ * last_seq, last_t_us, seen: Previous sample of each sensor
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    uint64_t samples;
+    uint64_t lost;
+    uint64_t crc_errors;
+    uint32_t *latency_us;
+    size_t n_latency;
+    size_t cap_latency;
+    sim_acc_t stamp_age;
+    sim_acc_t interval;
+    sim_acc_t d_err[WAVEFORM_AXES];
+    sim_acc_t v_err[WAVEFORM_AXES];
+    double d_peak[WAVEFORM_AXES];
+    uint32_t last_seq[SIM_MAX_SENSORS];
+    int64_t last_t_us[SIM_MAX_SENSORS];
+    bool seen[SIM_MAX_SENSORS];
+} sim_report_t;
+
+static sim_options_t options = {
+    .mode        = "drdy",
+    .math        = "float",
+    .decim       = "fir",
+    .tilt_comp   = "on",
+    .drift       = "hold",
+    .autorange   = "off",
+    .standby     = "off",
+    .wave        = "sine",
+    .rate_ms     = 10,
+    .noise_floor = 0.1,
+    .amplitude   = 0.01,
+    .freq_hz     = 1.0,
+    .cycles      = 3,
+    .noise_rms   = 0.03,
+    .settle_s    = 1.0,
+    .sensors     = 1,
+};
+
+static vmpu6050_t sensors[SIM_MAX_SENSORS];
+static waveform_t waveform;
+static sim_report_t report = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static FILE *csv;
+static int console_fd;
+static int command_fd;
+
+static pthread_mutex_t ready_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ready_cond = PTHREAD_COND_INITIALIZER;
+static bool firmware_ready;
+
+static void acc_add(sim_acc_t *acc, double value) {
+    acc->n++;
+    acc->sum += value;
+    acc->sum_sq += value * value;
+    if (fabs(value) > acc->max) { acc->max = fabs(value); }
+}
+
+static double acc_mean(const sim_acc_t *acc) {
+    return acc->n ? acc->sum / acc->n : 0.0;
+}
+
+static double acc_std(const sim_acc_t *acc) {
+    if (acc->n < 2) { return 0.0; }
+
+    double mean = acc_mean(acc);
+    double var = acc->sum_sq / acc->n - mean * mean;
+
+    return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+static double acc_rms(const sim_acc_t *acc) {
+    return acc->n ? sqrt(acc->sum_sq / acc->n) : 0.0;
+}
+
+// --- Console Receiver ---
+
+static void on_motion(const telemetry_motion_payload_t *m, int64_t rx_us) {
+    vmpu6050_truth_t truth;
+
+    if (m->dev >= options.sensors) { return; }
+    if (!vmpu6050_truth_at(&sensors[m->dev], (int64_t)m->t_us, &truth)) { return; }
+
+    const float fw_v[WAVEFORM_AXES] = {m->vx, m->vy, m->vz};
+    const float fw_d[WAVEFORM_AXES] = {m->dx, m->dy, m->dz};
+
+    pthread_mutex_lock(&report.lock);
+    report.samples++;
+
+    if (report.seen[m->dev]) {
+        if (m->seq != report.last_seq[m->dev] + 1) { report.lost += m->seq - report.last_seq[m->dev] - 1; }
+        acc_add(&report.interval, (double)((int64_t)m->t_us - report.last_t_us[m->dev]));
+    }
+    report.seen[m->dev] = true;
+    report.last_seq[m->dev] = m->seq;
+    report.last_t_us[m->dev] = (int64_t)m->t_us;
+
+    if (report.n_latency == report.cap_latency) {
+        report.cap_latency = report.cap_latency ? 2 * report.cap_latency : 4096;
+        report.latency_us = realloc(report.latency_us, report.cap_latency * sizeof(*report.latency_us));
+    }
+    report.latency_us[report.n_latency++] = (uint32_t)(rx_us - truth.t_us);
+    acc_add(&report.stamp_age, (double)((int64_t)m->t_us - truth.t_us));
+
+    for (int k = 0; k < WAVEFORM_AXES; k++) {
+        acc_add(&report.d_err[k], fw_d[k] - truth.d[k]);
+        acc_add(&report.v_err[k], fw_v[k] - truth.v[k]);
+        if (fabs(truth.d[k]) > report.d_peak[k]) { report.d_peak[k] = fabs(truth.d[k]); }
+    }
+
+    if (csv != NULL) {
+        fprintf(csv, "%u,%u,%llu,%lld,%lld,%.6e,%.6e,%.6e,%.6e,%.6e,%.6e\n", m->dev, m->seq,
+                (unsigned long long)m->t_us, (long long)truth.t_us, (long long)rx_us,
+                fw_d[0], fw_d[1], fw_d[2], truth.d[0], truth.d[1], truth.d[2]);
+    }
+    pthread_mutex_unlock(&report.lock);
+}
+
+static void on_line(char *line) {
+    // "L (ms) Tag: message"
+    char level = line[0];
+    char *tag = strchr(line, ')');
+    tag = tag ? tag + 2 : line;
+
+    if (strncmp(tag, "System: Ready", 13) == 0) {
+        pthread_mutex_lock(&ready_lock);
+        firmware_ready = true;
+        pthread_cond_signal(&ready_cond);
+        pthread_mutex_unlock(&ready_lock);
+    }
+
+    if (options.verbose || level == 'E' || level == 'W' || strncmp(tag, "Stats:", 6) == 0) {
+        fprintf(stderr, "  fw: %s\n", line);
+    }
+}
+
+/**
+ * @brief Split the console stream into log lines and telemetry frames
+ *
+ * @return Number of bytes consumed from the start of buf
+ */
+static size_t console_parse(uint8_t *buf, size_t len, int64_t rx_us) {
+    size_t pos = 0;
+
+    while (pos < len) {
+        uint8_t *p = &buf[pos];
+        size_t avail = len - pos;
+
+        if (p[0] == TELEMETRY_SYNC_0) {
+            if (avail < TELEMETRY_HEADER_SIZE) { break; }
+            if (p[1] != TELEMETRY_SYNC_1) {
+                pos++;
+                continue;
+            }
+
+            size_t frame_len = TELEMETRY_HEADER_SIZE + p[3] + TELEMETRY_CRC_SIZE;
+            if (avail < frame_len) { break; }
+
+            uint16_t crc = p[frame_len - 2] | (uint16_t)p[frame_len - 1] << 8;
+            if (crc != telemetry_crc16(&p[2], 2 + p[3])) {
+                // Resynchronize on the next sync word
+                pthread_mutex_lock(&report.lock);
+                report.crc_errors++;
+                pthread_mutex_unlock(&report.lock);
+                pos++;
+                continue;
+            }
+
+            if (p[2] == TELEMETRY_FRAME_MOTION && p[3] == sizeof(telemetry_motion_payload_t)) {
+                telemetry_motion_payload_t m;
+                memcpy(&m, &p[TELEMETRY_HEADER_SIZE], sizeof(m));
+                on_motion(&m, rx_us);
+            } else if (p[2] == TELEMETRY_FRAME_STATE && p[3] == sizeof(telemetry_state_payload_t)) {
+                // Control mode: the period number stands in for the sequence number
+                telemetry_state_payload_t st;
+                memcpy(&st, &p[TELEMETRY_HEADER_SIZE], sizeof(st));
+                telemetry_motion_payload_t m = {.dev = st.dev, .seq = st.period, .t_us = st.t_us,
+                                                .vx = st.vx, .vy = st.vy, .vz = st.vz,
+                                                .dx = st.dx, .dy = st.dy, .dz = st.dz};
+                on_motion(&m, rx_us);
+            }
+            pos += frame_len;
+            continue;
+        }
+
+        uint8_t *end = memchr(p, '\n', avail);
+        if (end == NULL) { break; }
+
+        *end = '\0';
+        if (end > p && end[-1] == '\r') { end[-1] = '\0'; }
+        on_line((char *)p);
+        pos += end - p + 1;
+    }
+
+    return pos;
+}
+
+static void *console_thread(void *arg) {
+    static uint8_t buf[4 * SIM_RX_CHUNK];
+    size_t len = 0;
+
+    for (;;) {
+        ssize_t n = read(console_fd, &buf[len], SIM_RX_CHUNK);
+        if (n <= 0) { break; }
+
+        int64_t rx_us = esp_timer_get_time();
+        len += n;
+
+        size_t used = console_parse(buf, len, rx_us);
+        memmove(buf, &buf[used], len - used);
+        len -= used;
+
+        // A line without an end never completes, drop it
+        if (len > sizeof(buf) - SIM_RX_CHUNK) { len = 0; }
+    }
+
+    return NULL;
+}
+
+// --- Scenario ---
+
+static void send_command(const char *format, ...) {
+    char line[128];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+
+    line[len++] = '\n';
+    if (write(command_fd, line, len) != len) { fprintf(stderr, "firmware_sim: console write failed\n"); }
+
+    // One command per console read, like a person typing
+    usleep(20000);
+}
+
+static void main_task(void *arg) {
+    // Like the IDF main task: run app_main, then go away
+    app_main();
+    vTaskDelete(NULL);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(const uint32_t *sorted, size_t n, double p) {
+    return n ? sorted[(size_t)(p * (n - 1))] / 1000.0 : 0.0;
+}
+
+static void report_print(FILE *out) {
+    static const char axes[] = "xyz";
+
+    pthread_mutex_lock(&report.lock);
+    qsort(report.latency_us, report.n_latency, sizeof(*report.latency_us), compare_u32);
+
+    fprintf(out, "firmware_sim: mode=%s rate=%d ms math=%s decim=%s drift=%s autorange=%s standby=%s tilt=%.1f deg (compensation %s) wave=%s sensors=%d realtime=%s\n",
+            options.mode, options.rate_ms, options.math, options.decim, options.drift, options.autorange, options.standby, options.tilt_deg, options.tilt_comp,
+            options.wave, options.sensors, options.realtime ? "yes" : "no");
+    fprintf(out, "  samples       %llu received, %llu lost, %llu crc errors\n",
+            (unsigned long long)report.samples, (unsigned long long)report.lost,
+            (unsigned long long)report.crc_errors);
+    fprintf(out, "  latency       p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms  (host receive - sensor latch)\n",
+            percentile_ms(report.latency_us, report.n_latency, 0.50),
+            percentile_ms(report.latency_us, report.n_latency, 0.90),
+            percentile_ms(report.latency_us, report.n_latency, 0.99),
+            percentile_ms(report.latency_us, report.n_latency, 1.00));
+    fprintf(out, "  stamp age     mean %.0f us  std %.0f us  max %.0f us  (timestamp - sensor latch)\n",
+            acc_mean(&report.stamp_age), acc_std(&report.stamp_age), report.stamp_age.max);
+    fprintf(out, "  interval      mean %.3f ms  jitter %.3f ms rms  max %.3f ms\n",
+            acc_mean(&report.interval) / 1000.0, acc_std(&report.interval) / 1000.0, report.interval.max / 1000.0);
+    for (int k = 0; k < WAVEFORM_AXES; k++) {
+        fprintf(out, "  %c             displacement error rms %.3f mm max %.3f mm (peak %.3f mm), velocity error rms %.2f mm/s\n",
+                axes[k], acc_rms(&report.d_err[k]) * 1e3, report.d_err[k].max * 1e3, report.d_peak[k] * 1e3,
+                acc_rms(&report.v_err[k]) * 1e3);
+    }
+    fflush(out);
+
+    pthread_mutex_unlock(&report.lock);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --mode <poll|fifo|drdy|control>  acquisition mode (default %s)\n"
+            "  --rate <ms>               output period (default %d)\n"
+            "  --math <float|fixed>      processing arithmetic (default %s)\n"
+            "  --decim <off|fir|cic>     decimation filter (default %s)\n"
+            "  --tilt-comp <on|off>      firmware tilt compensation (default %s)\n"
+            "  --drift <hold|kalman>     firmware drift control (default %s)\n"
+            "  --autorange <on|off>      firmware auto-ranging (default %s)\n"
+            "  --standby <on|off>        stay stopped in wake-on-motion standby, the motion wakes it (default %s)\n"
+            "  --noise-floor <m/s2>      firmware acceleration noise floor (default %.2f)\n"
+            "  --config <a,g,d,s>        MPU6050 configuration command (default firmware setting)\n"
+            "  --wave <sine|pulse|quake|file:path>  ground motion (default %s)\n"
+            "  --amp <m>                 peak displacement of synthetic motion (default %.3f)\n"
+            "  --freq <Hz>               dominant frequency (default %.2f)\n"
+            "  --cycles <n>              sine periods (default %d)\n"
+            "  --axis <x|y|z>            driven axis (default x)\n"
+            "  --noise <m/s2>            sensor noise rms (default %.3f)\n"
+            "  --clock-ppm <ppm>         sensor sample clock error (default 0)\n"
+            "  --tilt <deg>              sensor tilt about y, ramped in as the motion starts (default 0)\n"
+            "  --settle <s>              rest between start and motion (default %.1f)\n"
+            "  --sensors <1|2>           sensors on the bus (default %d)\n"
+            "  --csv <path>              per-sample firmware output and ground truth\n"
+            "  --rt                      SCHED_FIFO on one CPU (needs CAP_SYS_NICE)\n"
+            "  --verbose                 echo every firmware log line\n",
+            argv0, options.mode, options.rate_ms, options.math, options.decim, options.tilt_comp, options.drift, options.autorange, options.standby, options.noise_floor, options.wave,
+            options.amplitude, options.freq_hz, options.cycles, options.noise_rms, options.settle_s, options.sensors);
+}
+
+static bool parse_args(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(opt, "--rt") == 0) {
+            options.realtime = true;
+            continue;
+        } else if (strcmp(opt, "--verbose") == 0) {
+            options.verbose = true;
+            continue;
+        } else if (val == NULL) {
+            return false;
+        }
+
+        if (strcmp(opt, "--mode") == 0) {
+            options.mode = val;
+        } else if (strcmp(opt, "--rate") == 0) {
+            options.rate_ms = atoi(val);
+        } else if (strcmp(opt, "--math") == 0) {
+            options.math = val;
+        } else if (strcmp(opt, "--decim") == 0) {
+            options.decim = val;
+        } else if (strcmp(opt, "--tilt-comp") == 0) {
+            options.tilt_comp = val;
+        } else if (strcmp(opt, "--drift") == 0) {
+            options.drift = val;
+        } else if (strcmp(opt, "--autorange") == 0) {
+            options.autorange = val;
+        } else if (strcmp(opt, "--standby") == 0) {
+            options.standby = val;
+        } else if (strcmp(opt, "--noise-floor") == 0) {
+            options.noise_floor = atof(val);
+        } else if (strcmp(opt, "--config") == 0) {
+            options.sensor_config = val;
+        } else if (strcmp(opt, "--wave") == 0) {
+            options.wave = val;
+        } else if (strcmp(opt, "--amp") == 0) {
+            options.amplitude = atof(val);
+        } else if (strcmp(opt, "--freq") == 0) {
+            options.freq_hz = atof(val);
+        } else if (strcmp(opt, "--cycles") == 0) {
+            options.cycles = atoi(val);
+        } else if (strcmp(opt, "--axis") == 0 && val[0] >= 'x' && val[0] <= 'z') {
+            options.axis = val[0] - 'x';
+        } else if (strcmp(opt, "--noise") == 0) {
+            options.noise_rms = atof(val);
+        } else if (strcmp(opt, "--clock-ppm") == 0) {
+            options.clock_ppm = atof(val);
+        } else if (strcmp(opt, "--tilt") == 0) {
+            options.tilt_deg = atof(val);
+        } else if (strcmp(opt, "--settle") == 0) {
+            options.settle_s = atof(val);
+        } else if (strcmp(opt, "--sensors") == 0) {
+            options.sensors = atoi(val);
+        } else if (strcmp(opt, "--csv") == 0) {
+            options.csv_path = val;
+        } else {
+            return false;
+        }
+        i++;
+    }
+
+    return options.rate_ms > 0 && options.freq_hz > 0 && options.cycles > 0 &&
+           options.sensors >= 1 && options.sensors <= SIM_MAX_SENSORS;
+}
+
+static bool waveform_setup(void) {
+    if (strncmp(options.wave, "file:", 5) == 0) { return waveform_load(&waveform, options.wave + 5); }
+
+    waveform_kind_t kind;
+    if (strcmp(options.wave, "sine") == 0) {
+        kind = WAVEFORM_SINE;
+    } else if (strcmp(options.wave, "pulse") == 0) {
+        kind = WAVEFORM_PULSE;
+    } else if (strcmp(options.wave, "quake") == 0) {
+        kind = WAVEFORM_QUAKE;
+    } else {
+        return false;
+    }
+    waveform_synthetic(&waveform, kind, options.axis, options.amplitude, options.freq_hz, options.cycles);
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int out_pipe[2];
+    int cmd_pipe[2];
+    pthread_t rx_thread;
+
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (!waveform_setup()) {
+        fprintf(stderr, "firmware_sim: cannot load waveform %s\n", options.wave);
+        return 2;
+    }
+    if (options.csv_path != NULL) {
+        csv = fopen(options.csv_path, "w");
+        if (csv == NULL) {
+            perror(options.csv_path);
+            return 2;
+        }
+        fprintf(csv, "dev,seq,t_us,latch_us,rx_us,dx,dy,dz,true_dx,true_dy,true_dz\n");
+    }
+
+    if (!sim_port_init(options.realtime)) {
+        fprintf(stderr, "firmware_sim: SCHED_FIFO not permitted, running with normal scheduling\n");
+        options.realtime = false;
+    }
+
+    // The firmware console: stdout to the receiver, commands from a pipe
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL || pipe(out_pipe) != 0 || pipe(cmd_pipe) != 0) {
+        perror("firmware_sim");
+        return 2;
+    }
+    fcntl(out_pipe[1], F_SETPIPE_SZ, SIM_PIPE_SIZE);
+    dup2(out_pipe[1], STDOUT_FILENO);
+    console_fd = out_pipe[0];
+    command_fd = cmd_pipe[1];
+    sim_console_input(cmd_pipe[0]);
+    pthread_create(&rx_thread, NULL, console_thread, NULL);
+
+    // The sensors are powered before the firmware boots
+    for (int i = 0; i < options.sensors; i++) {
+        sensors[i].addr = i == 0 ? MPU6050_ADDR : MPU6050_ADDR_ALT;
+        sensors[i].int_pin = i == 0 ? MPU6050_INT_IO : -1;
+        sensors[i].wf = &waveform;
+        sensors[i].noise_rms = options.noise_rms;
+        sensors[i].clock_ppm = options.clock_ppm;
+        sensors[i].tilt_deg = options.tilt_deg;
+        if (!vmpu6050_start(&sensors[i], 0x9E3779B97F4A7C15ULL * (i + 1))) {
+            fprintf(stderr, "firmware_sim: sensor %d failed to start\n", i);
+            return 2;
+        }
+    }
+
+    xTaskCreate(main_task, "main", 3584, NULL, 1, NULL);
+
+    // Boot ends when calibration is done
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SIM_BOOT_TIMEOUT_US / 1000000;
+    pthread_mutex_lock(&ready_lock);
+    while (!firmware_ready) {
+        if (pthread_cond_timedwait(&ready_cond, &ready_lock, &deadline) != 0) { break; }
+    }
+    pthread_mutex_unlock(&ready_lock);
+    if (!firmware_ready) {
+        fprintf(stderr, "firmware_sim: firmware did not become ready\n");
+        _exit(1);
+    }
+
+    send_command("set_output:binary");
+    send_command("set_mode:%s", options.mode);
+    send_command("set_rate:%d", options.rate_ms);
+    send_command("set_math:%s", options.math);
+    send_command("set_decim:%s", options.decim);
+    send_command("set_tilt:%s", options.tilt_comp);
+    send_command("set_drift:%s", options.drift);
+    send_command("set_autorange:%s", options.autorange);
+    send_command("set_accel_noise_floor:%.4f", options.noise_floor);
+    if (options.sensor_config != NULL) { send_command("set_mpu6050_config:%s", options.sensor_config); }
+    send_command("stats:reset");
+    if (strcmp(options.standby, "on") == 0) {
+        send_command("set_standby:on");
+    } else {
+        send_command("start");
+    }
+
+    int64_t motion_start = esp_timer_get_time() + (int64_t)(options.settle_s * 1e6);
+    for (int i = 0; i < options.sensors; i++) { vmpu6050_set_motion_start(&sensors[i], motion_start); }
+
+    sim_sleep_until(motion_start + (int64_t)(waveform.duration_s * 1e6) + SIM_TAIL_US);
+
+    send_command("stats");
+    send_command("stop");
+    usleep(SIM_DRAIN_US);
+
+    report_print(out);
+    pthread_mutex_lock(&report.lock);
+    if (csv != NULL) { fclose(csv); }
+
+    // Firmware tasks never return, leave without running their destructors
+    _exit(report.samples > 0 ? 0 : 1);
+}
@@ -0,0 +1,128 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sample_ring.h"
+
+// Host cost of the sampler-to-telemetry ring: the same fill-and-drain
+// pattern as the firmware's bench:ring, then a producer and a consumer
+// thread running flat out, which adds the cache line traffic between them.
+// Here the producer yields and retries on a full ring and the consumer
+// yields on an empty one; every retry counts as an overrun.
+
+#define RING_BENCH_LAPS         20000       // Fill-and-drain rounds of the single thread benchmark
+#define RING_BENCH_SAMPLES      10000000    // Samples pushed by the two-thread benchmark
+
+static sample_ring_t ring;
+static atomic_bool producer_done;
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_single(long laps) {
+    telemetry_sample_t sample = {0};
+    telemetry_sample_t batch[TELEMETRY_BATCH_SIZE];
+    double push_ns = 0.0, pop_ns = 0.0;
+    size_t popped = 0;
+
+    sample_ring_init(&ring);
+
+    for (long i = 0; i < laps; i++) {
+        // Fill the ring completely, then drain it in telemetry sized batches
+        double start = now_ns();
+        for (int j = 0; j < SAMPLE_RING_SIZE; j++) {
+            sample.seq++;
+            sample_ring_push(&ring, &sample);
+        }
+        push_ns += now_ns() - start;
+
+        start = now_ns();
+        size_t n;
+        while ((n = sample_ring_pop(&ring, batch, TELEMETRY_BATCH_SIZE)) > 0) { popped += n; }
+        pop_ns += now_ns() - start;
+    }
+
+    double samples = (double)laps * SAMPLE_RING_SIZE;
+    printf("single thread  push %6.2f ns/sample  pop %6.2f ns/sample (batch=%d, popped=%zu)\n",
+           push_ns / samples, pop_ns / samples, TELEMETRY_BATCH_SIZE, popped);
+}
+
+static void *producer(void *arg) {
+    long samples = *(const long *)arg;
+    telemetry_sample_t sample = {0};
+
+    for (long i = 0; i < samples; i++) {
+        sample.seq = (uint32_t)i;
+        while (!sample_ring_push(&ring, &sample)) { sched_yield(); }
+    }
+    atomic_store(&producer_done, true);
+
+    return NULL;
+}
+
+static void bench_threads(long samples) {
+    telemetry_sample_t batch[TELEMETRY_BATCH_SIZE];
+    uint64_t received = 0, batches = 0;
+    pthread_t thread;
+
+    sample_ring_init(&ring);
+    atomic_store(&producer_done, false);
+
+    double start = now_ns();
+    if (pthread_create(&thread, NULL, producer, &samples) != 0) {
+        fprintf(stderr, "cannot start the producer thread\n");
+        return;
+    }
+
+    for (;;) {
+        bool done = atomic_load(&producer_done);
+        size_t n = sample_ring_pop(&ring, batch, TELEMETRY_BATCH_SIZE);
+
+        if (n > 0) {
+            received += n;
+            batches++;
+        } else if (done) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    double elapsed_ns = now_ns() - start;
+
+    printf("two threads    %6.2f ns/sample  %.1f M samples/s  received=%llu full=%u mean batch=%.1f high water=%u\n",
+           elapsed_ns / samples, samples / elapsed_ns * 1e3, (unsigned long long)received, (unsigned)ring.overruns,
+           batches ? (double)received / batches : 0.0, (unsigned)ring.high_water);
+}
+
+int main(int argc, char **argv) {
+    long laps = RING_BENCH_LAPS;
+    long samples = RING_BENCH_SAMPLES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--laps") == 0 && i + 1 < argc) {
+            laps = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            samples = atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: %s [--laps N] [--samples N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("ring of %d slots, %zu bytes per sample\n", SAMPLE_RING_SIZE, sizeof(telemetry_sample_t));
+    bench_single(laps);
+    bench_threads(samples);
+
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "mpu6050.h"
+
+#include "vmpu6050.h"
+
+#define VMPU6050_PWR_SLEEP          0x40    // PWR_MGMT_1: sleep bit, set after reset
+#define VMPU6050_PWR_RESET          0x80    // PWR_MGMT_1: device reset (self clearing)
+#define VMPU6050_CYCLE_POLL_US      1000    // Check for the end of cycle mode while waiting out its period
+#define VMPU6050_GYRO_NOISE_LSB     4.0     // Gyroscope noise at +-250 deg/s (counts rms)
+
+// DLPF bandwidth of the accelerometer by CONFIG.DLPF_CFG (Hz)
+static const double dlpf_bandwidth_hz[8] = {260, 184, 94, 44, 21, 10, 5, 260};
+
+// Cycle mode sample rate by PWR_MGMT_2.LP_WAKE_CTRL (Hz)
+static const double lp_wake_hz[4] = {1.25, 5, 20, 40};
+
+static const sim_i2c_target_t vmpu6050_target;
+
+static void vmpu6050_reset(vmpu6050_t *s) {
+    memset(s->regs, 0, sizeof(s->regs));
+    s->regs[MPU6050_PWR_MGMT_1] = VMPU6050_PWR_SLEEP;
+    s->regs[MPU6050_WHO_AM_I] = MPU6050_DEVICE_ID;
+    s->ptr = 0;
+    s->fifo_head = 0;
+    s->fifo_count = 0;
+    s->mot_count = 0;
+}
+
+// --- Sample Clock ---
+
+static double vmpu6050_gauss(vmpu6050_t *s) {
+    double u[2];
+
+    // xorshift64*, then Box-Muller
+    for (int i = 0; i < 2; i++) {
+        s->rng ^= s->rng >> 12;
+        s->rng ^= s->rng << 25;
+        s->rng ^= s->rng >> 27;
+        u[i] = ((s->rng * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    return sqrt(-2.0 * log(u[0] + 1e-300)) * cos(2.0 * M_PI * u[1]);
+}
+
+static int16_t vmpu6050_quantize(double value, double lsb) {
+    double counts = round(value * lsb);
+
+    if (counts > INT16_MAX) { return INT16_MAX; }
+    if (counts < INT16_MIN) { return INT16_MIN; }
+
+    return (int16_t)counts;
+}
+
+static void vmpu6050_put16(uint8_t *dst, int16_t value) {
+    dst[0] = (uint8_t)((uint16_t)value >> 8);
+    dst[1] = (uint8_t)value;
+}
+
+static void vmpu6050_fifo_push(vmpu6050_t *s, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        // A full FIFO replaces its oldest byte
+        if (s->fifo_count == VMPU6050_FIFO_SIZE) {
+            s->fifo_head = (s->fifo_head + 1) % VMPU6050_FIFO_SIZE;
+            s->fifo_count--;
+            s->regs[MPU6050_INT_STATUS] |= MPU6050_INT_FIFO_OFLOW;
+        }
+        s->fifo[(s->fifo_head + s->fifo_count) % VMPU6050_FIFO_SIZE] = data[i];
+        s->fifo_count++;
+    }
+}
+
+static bool vmpu6050_cycling(const vmpu6050_t *s) {
+    return (s->regs[MPU6050_PWR_MGMT_1] & (VMPU6050_PWR_SLEEP | MPU6050_PWR_CYCLE)) == MPU6050_PWR_CYCLE;
+}
+
+static double vmpu6050_period_us(const vmpu6050_t *s) {
+    uint8_t dlpf = s->regs[MPU6050_CONFIG] & 0x07;
+    double gyro_rate_hz = (dlpf == 0 || dlpf == 7) ? 8000.0 : 1000.0;
+
+    // Cycle mode wakes up for single samples at its own rate
+    if (vmpu6050_cycling(s)) { return 1e6 / lp_wake_hz[s->regs[MPU6050_PWR_MGMT_2] >> MPU6050_LP_WAKE_SHIFT] * (1.0 + s->clock_ppm * 1e-6); }
+
+    return 1e6 * (1 + s->regs[MPU6050_SMPLRT_DIV]) / gyro_rate_hz * (1.0 + s->clock_ppm * 1e-6);
+}
+
+static int16_t vmpu6050_get16(const uint8_t *src) {
+    return (int16_t)((uint16_t)src[0] << 8 | src[1]);
+}
+
+/**
+ * @brief Motion detection on a new sample, against the held reference
+ *
+ * Only the high-pass hold setting is modelled: a sample differing from the
+ * one held when ACCEL_CONFIG.ACCEL_HPF was set to hold by more than MOT_THR
+ * on any axis, for MOT_DUR samples in a row, raises the motion interrupt.
+ */
+static void vmpu6050_motion(vmpu6050_t *s, const uint8_t *sample, double accel_lsb) {
+    if (!(s->regs[MPU6050_INT_ENABLE] & MPU6050_INT_MOT)) { return; }
+    if ((s->regs[MPU6050_ACCEL_CONFIG] & 0x07) != MPU6050_ACCEL_HPF_HOLD) { return; }
+
+    double threshold = s->regs[MPU6050_MOT_THR] * MPU6050_MOT_THR_MG * 1e-3 * VMPU6050_GRAVITY * accel_lsb;
+    bool moved = false;
+    for (int k = 0; k < 3; k++) {
+        if (fabs((double)vmpu6050_get16(&sample[2 * k]) - s->hold[k]) > threshold) { moved = true; }
+    }
+
+    s->mot_count = moved ? s->mot_count + 1 : 0;
+    uint8_t duration = s->regs[MPU6050_MOT_DUR] ? s->regs[MPU6050_MOT_DUR] : 1;
+    if (s->mot_count >= duration) { s->regs[MPU6050_INT_STATUS] |= MPU6050_INT_MOT; }
+}
+
+static bool vmpu6050_latched(const vmpu6050_t *s) {
+    return (s->regs[MPU6050_INT_PIN_CFG] & MPU6050_INT_PIN_LATCH) != 0;
+}
+
+static bool vmpu6050_int_pending(const vmpu6050_t *s) {
+    return (s->regs[MPU6050_INT_STATUS] & s->regs[MPU6050_INT_ENABLE]) != 0;
+}
+
+/**
+ * @brief Latch one sample into the data registers and the FIFO
+ *
+ * @return true if an enabled interrupt was raised
+ */
+static bool vmpu6050_latch(vmpu6050_t *s, int64_t t_us, double dt_s) {
+    vmpu6050_truth_t *truth = &s->truth[s->truth_head];
+    int64_t start = atomic_load(&s->motion_start_us);
+    waveform_state_t ground;
+
+    waveform_eval(s->wf, start ? (t_us - start) * 1e-6 : -1.0, &ground);
+
+    truth->t_us = t_us;
+    memcpy(truth->a, ground.a, sizeof(truth->a));
+    memcpy(truth->v, ground.v, sizeof(truth->v));
+    memcpy(truth->d, ground.d, sizeof(truth->d));
+    s->truth_head = (s->truth_head + 1) % VMPU6050_TRUTH_DEPTH;
+    s->latches++;
+
+    // A sleeping sensor keeps its clock but does not update its outputs
+    if (s->regs[MPU6050_PWR_MGMT_1] & VMPU6050_PWR_SLEEP) { return false; }
+
+    double bw = dlpf_bandwidth_hz[s->regs[MPU6050_CONFIG] & 0x07];
+    double alpha = 1.0 - exp(-2.0 * M_PI * bw * dt_s);
+    double accel_lsb = 16384.0 / (1 << ((s->regs[MPU6050_ACCEL_CONFIG] >> 3) & 0x03)) / VMPU6050_GRAVITY;
+    double gyro_noise = VMPU6050_GYRO_NOISE_LSB / (1 << ((s->regs[MPU6050_GYRO_CONFIG] >> 3) & 0x03));
+    double gyro_lsb = 131.0 / (1 << ((s->regs[MPU6050_GYRO_CONFIG] >> 3) & 0x03));
+    uint8_t sample[MPU6050_BURST_SIZE];
+
+    // Tilt about y: angle and rate of the ramp at this sample
+    double theta = 0.0, rate = 0.0;
+    double r = start ? (t_us - start) * 1e-6 / VMPU6050_TILT_RAMP_S : 0.0;
+    double tilt = s->tilt_deg * M_PI / 180.0;
+    if (r >= 1.0) {
+        theta = tilt;
+    } else if (r > 0.0) {
+        theta = 0.5 * tilt * (1.0 - cos(M_PI * r));
+        rate = 0.5 * tilt * M_PI * sin(M_PI * r) / VMPU6050_TILT_RAMP_S;
+    }
+
+    // Specific force in the level frame, then in the sensor frame
+    double f[3] = {ground.a[0], ground.a[1], ground.a[2] + VMPU6050_GRAVITY};
+    double body[3] = {cos(theta) * f[0] - sin(theta) * f[2], f[1], sin(theta) * f[0] + cos(theta) * f[2]};
+    double gyro[3] = {0.0, rate * 180.0 / M_PI, 0.0};
+
+    // Gyroscope axes in standby read zero
+    bool gyro_on = !(s->regs[MPU6050_PWR_MGMT_2] & MPU6050_PWR_STBY_GYRO);
+    for (int k = 0; k < 3; k++) {
+        s->lp[k] += alpha * (body[k] - s->lp[k]);
+        vmpu6050_put16(&sample[2 * k], vmpu6050_quantize(s->lp[k] + s->noise_rms * vmpu6050_gauss(s), accel_lsb));
+        vmpu6050_put16(&sample[8 + 2 * k], gyro_on ? vmpu6050_quantize(gyro[k] * gyro_lsb + gyro_noise * vmpu6050_gauss(s), 1.0) : 0);
+    }
+    vmpu6050_put16(&sample[6], vmpu6050_quantize(VMPU6050_TEMP_C - 36.53, 340.0));
+
+    memcpy(&s->regs[MPU6050_ACCEL_XOUT_H], sample, sizeof(sample));
+
+    // FIFO order: accel, temperature, gyro x, y, z
+    if (s->regs[MPU6050_USER_CTRL] & MPU6050_USER_CTRL_FIFO_EN) {
+        uint8_t sources = s->regs[MPU6050_FIFO_EN];
+
+        if (sources & MPU6050_FIFO_EN_ACCEL) { vmpu6050_fifo_push(s, &sample[0], 6); }
+        if (sources & 0x80) { vmpu6050_fifo_push(s, &sample[6], 2); }
+        if (sources & 0x40) { vmpu6050_fifo_push(s, &sample[8], 2); }
+        if (sources & 0x20) { vmpu6050_fifo_push(s, &sample[10], 2); }
+        if (sources & 0x10) { vmpu6050_fifo_push(s, &sample[12], 2); }
+    }
+
+    // Data ready interrupts on every sample, motion once until cleared
+    bool moved = s->regs[MPU6050_INT_STATUS] & MPU6050_INT_MOT;
+    s->regs[MPU6050_INT_STATUS] |= MPU6050_INT_DATA_RDY;
+    vmpu6050_motion(s, sample, accel_lsb);
+    bool motion = !moved && (s->regs[MPU6050_INT_STATUS] & MPU6050_INT_MOT);
+    uint8_t raised = MPU6050_INT_DATA_RDY | (motion ? MPU6050_INT_MOT : 0);
+
+    return (raised & s->regs[MPU6050_INT_ENABLE]) != 0;
+}
+
+static void *vmpu6050_thread(void *arg) {
+    vmpu6050_t *s = arg;
+    double next_us = (double)esp_timer_get_time();
+
+    sim_thread_setup(SIM_PRIO_ISR);
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        double period_us = vmpu6050_period_us(s);
+        bool cycling = vmpu6050_cycling(s);
+        pthread_mutex_unlock(&s->lock);
+
+        next_us += period_us;
+
+        // A cycle mode period is long: leaving cycle mode restarts the sample clock
+        while (cycling && esp_timer_get_time() < (int64_t)next_us) {
+            int64_t now = esp_timer_get_time();
+            sim_sleep_until(now + VMPU6050_CYCLE_POLL_US < (int64_t)next_us ? now + VMPU6050_CYCLE_POLL_US : (int64_t)next_us);
+
+            pthread_mutex_lock(&s->lock);
+            cycling = vmpu6050_cycling(s);
+            if (!cycling) {
+                period_us = vmpu6050_period_us(s);
+                next_us = (double)esp_timer_get_time() + period_us;
+            }
+            pthread_mutex_unlock(&s->lock);
+        }
+        sim_sleep_until((int64_t)next_us);
+
+        pthread_mutex_lock(&s->lock);
+        bool interrupt = vmpu6050_latch(s, (int64_t)next_us, period_us * 1e-6);
+        bool latched = vmpu6050_latched(s);
+        bool raise = interrupt && !(latched && s->int_level);
+        if (raise && latched) { s->int_level = true; }
+        pthread_mutex_unlock(&s->lock);
+
+        // Latched: high until the status is cleared. Otherwise a 50 us
+        // pulse, the edge is what the GPIO interrupt sees.
+        if (raise && s->int_pin >= 0) {
+            sim_gpio_set(s->int_pin, 1);
+            if (!latched) { sim_gpio_set(s->int_pin, 0); }
+        }
+    }
+
+    return NULL;
+}
+
+// --- I2C Target ---
+
+static void vmpu6050_write_reg(vmpu6050_t *s, uint8_t reg, uint8_t value) {
+    switch (reg) {
+    case MPU6050_PWR_MGMT_1:
+        if (value & VMPU6050_PWR_RESET) {
+            vmpu6050_reset(s);
+            return;
+        }
+        break;
+    case MPU6050_ACCEL_CONFIG:
+        // Entering the high-pass hold keeps the current sample as the motion reference
+        if ((value & 0x07) == MPU6050_ACCEL_HPF_HOLD && (s->regs[reg] & 0x07) != MPU6050_ACCEL_HPF_HOLD) {
+            for (int k = 0; k < 3; k++) { s->hold[k] = vmpu6050_get16(&s->regs[MPU6050_ACCEL_XOUT_H + 2 * k]); }
+            s->mot_count = 0;
+        }
+        break;
+    case MPU6050_USER_CTRL:
+        if (value & MPU6050_USER_CTRL_FIFO_RESET) {
+            s->fifo_head = 0;
+            s->fifo_count = 0;
+        }
+        value &= ~MPU6050_USER_CTRL_FIFO_RESET;
+        break;
+    case MPU6050_INT_STATUS:
+    case MPU6050_FIFO_COUNT_H:
+    case MPU6050_FIFO_COUNT_H + 1:
+    case MPU6050_FIFO_R_W:
+    case MPU6050_WHO_AM_I:
+        return;
+    default:
+        // Sensor data registers are read only
+        if (reg >= MPU6050_ACCEL_XOUT_H && reg < MPU6050_ACCEL_XOUT_H + MPU6050_BURST_SIZE) { return; }
+        break;
+    }
+
+    s->regs[reg] = value;
+}
+
+static uint8_t vmpu6050_read_reg(vmpu6050_t *s, uint8_t reg) {
+    uint8_t value;
+
+    switch (reg) {
+    case MPU6050_INT_STATUS:
+        value = s->regs[reg];
+        s->regs[reg] = 0;
+        return value;
+    case MPU6050_FIFO_COUNT_H:
+        // Reading the high byte latches the low byte
+        s->count_l = (uint8_t)s->fifo_count;
+        return (uint8_t)(s->fifo_count >> 8);
+    case MPU6050_FIFO_COUNT_H + 1:
+        return s->count_l;
+    case MPU6050_FIFO_R_W:
+        if (s->fifo_count == 0) { return 0xFF; }
+        value = s->fifo[s->fifo_head];
+        s->fifo_head = (s->fifo_head + 1) % VMPU6050_FIFO_SIZE;
+        s->fifo_count--;
+        return value;
+    default:
+        return s->regs[reg & 0x7F];
+    }
+}
+
+/**
+ * @brief Drop a latched INT pin once no enabled interrupt is pending
+ *
+ * Called with the lock held; the pin is driven after unlocking.
+ *
+ * @return true if the pin must go low
+ */
+static bool vmpu6050_int_release(vmpu6050_t *s) {
+    if (!s->int_level || (vmpu6050_latched(s) && vmpu6050_int_pending(s))) { return false; }
+
+    s->int_level = false;
+
+    return true;
+}
+
+static void vmpu6050_i2c_write(void *ctx, const uint8_t *data, size_t len) {
+    vmpu6050_t *s = ctx;
+
+    pthread_mutex_lock(&s->lock);
+    s->ptr = data[0] & 0x7F;
+    for (size_t i = 1; i < len; i++) {
+        vmpu6050_write_reg(s, s->ptr, data[i]);
+        if (s->ptr != MPU6050_FIFO_R_W) { s->ptr = (s->ptr + 1) & 0x7F; }
+    }
+    bool release = vmpu6050_int_release(s);
+    pthread_mutex_unlock(&s->lock);
+
+    if (release && s->int_pin >= 0) { sim_gpio_set(s->int_pin, 0); }
+}
+
+static void vmpu6050_i2c_read(void *ctx, uint8_t *data, size_t len) {
+    vmpu6050_t *s = ctx;
+
+    // One lock for the whole burst: the shadow registers keep it coherent
+    pthread_mutex_lock(&s->lock);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = vmpu6050_read_reg(s, s->ptr);
+        if (s->ptr != MPU6050_FIFO_R_W) { s->ptr = (s->ptr + 1) & 0x7F; }
+    }
+    if (s->regs[MPU6050_INT_PIN_CFG] & MPU6050_INT_PIN_RD_CLEAR) { s->regs[MPU6050_INT_STATUS] &= ~MPU6050_INT_DATA_RDY; }
+    bool release = vmpu6050_int_release(s);
+    pthread_mutex_unlock(&s->lock);
+
+    if (release && s->int_pin >= 0) { sim_gpio_set(s->int_pin, 0); }
+}
+
+static const sim_i2c_target_t vmpu6050_target = {
+    .write = vmpu6050_i2c_write,
+    .read  = vmpu6050_i2c_read,
+};
+
+bool vmpu6050_start(vmpu6050_t *s, uint64_t seed) {
+    s->rng = seed ? seed : 1;
+    s->truth = calloc(VMPU6050_TRUTH_DEPTH, sizeof(*s->truth));
+    if (s->truth == NULL) { return false; }
+
+    s->lp[2] = VMPU6050_GRAVITY;
+    atomic_store(&s->motion_start_us, 0);
+    pthread_mutex_init(&s->lock, NULL);
+    vmpu6050_reset(s);
+
+    sim_i2c_attach(s->addr, &vmpu6050_target, s);
+    if (pthread_create(&s->thread, NULL, vmpu6050_thread, s) != 0) { return false; }
+    pthread_detach(s->thread);
+
+    return true;
+}
+
+void vmpu6050_set_motion_start(vmpu6050_t *s, int64_t t_us) {
+    atomic_store(&s->motion_start_us, t_us);
+}
+
+bool vmpu6050_truth_at(vmpu6050_t *s, int64_t t_us, vmpu6050_truth_t *out) {
+    bool found = false;
+
+    pthread_mutex_lock(&s->lock);
+    size_t n = s->latches < VMPU6050_TRUTH_DEPTH ? s->latches : VMPU6050_TRUTH_DEPTH;
+
+    // Newest first
+    for (size_t i = 1; i <= n; i++) {
+        const vmpu6050_truth_t *truth = &s->truth[(s->truth_head + VMPU6050_TRUTH_DEPTH - i) % VMPU6050_TRUTH_DEPTH];
+        if (truth->t_us <= t_us) {
+            *out = *truth;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return found;
+}
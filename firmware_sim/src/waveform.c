@@ -0,0 +1,194 @@
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "waveform.h"
+
+#define PULSE_SIGMAS        4.0     // Pulse centre in widths from the start (e^-8 at both ends)
+#define QUAKE_DURATION_S    10.0    // Every wavelet has decayed below 2e-4 of its peak by then
+
+/**
+ * @brief Wavelets of the quake waveform
+ *
+ * Relative amplitude and frequency, centre and width (s). Later, faster
+ * and shorter components model the higher frequency content of the
+ * strong-motion phase.
+ */
+static const struct {
+    double amp, freq, centre, width;
+} quake_wavelets[] = {
+    {1.0, 1.0, 5.0, 1.2},
+    {0.5, 2.3, 4.5, 0.9},
+    {0.3, 4.1, 4.0, 0.6},
+};
+
+void waveform_synthetic(waveform_t *wf, waveform_kind_t kind, int axis, double amplitude, double freq_hz, int cycles) {
+    memset(wf, 0, sizeof(*wf));
+    wf->kind = kind;
+    wf->axis = axis;
+    wf->amplitude = amplitude;
+    wf->freq_hz = freq_hz;
+
+    switch (kind) {
+    case WAVEFORM_SINE:
+        wf->duration_s = cycles / freq_hz;
+        break;
+    case WAVEFORM_PULSE:
+        wf->duration_s = 2.0 * PULSE_SIGMAS / (2.0 * M_PI * freq_hz);
+        break;
+    default:
+        wf->duration_s = QUAKE_DURATION_S;
+        break;
+    }
+}
+
+bool waveform_load(waveform_t *wf, const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    size_t cap = 0;
+
+    if (f == NULL) { return false; }
+
+    memset(wf, 0, sizeof(*wf));
+    wf->kind = WAVEFORM_FILE;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        double t, ax, ay, az;
+
+        // Comments and a header row
+        if (line[0] == '#' || isalpha((unsigned char)line[0])) { continue; }
+        if (sscanf(line, "%lf,%lf,%lf,%lf", &t, &ax, &ay, &az) != 4) { continue; }
+
+        if (wf->n == cap) {
+            cap = cap ? 2 * cap : 4096;
+            wf->t = realloc(wf->t, cap * sizeof(*wf->t));
+            wf->a = realloc(wf->a, cap * sizeof(*wf->a));
+            if (wf->t == NULL || wf->a == NULL) {
+                fclose(f);
+                return false;
+            }
+        }
+        wf->t[wf->n] = t;
+        wf->a[wf->n][0] = ax;
+        wf->a[wf->n][1] = ay;
+        wf->a[wf->n][2] = az;
+        wf->n++;
+    }
+    fclose(f);
+
+    if (wf->n < 2) { return false; }
+
+    wf->v = calloc(wf->n, sizeof(*wf->v));
+    wf->d = calloc(wf->n, sizeof(*wf->d));
+    if (wf->v == NULL || wf->d == NULL) { return false; }
+
+    // Trapezoidal integration from rest, times relative to the first row
+    double t0 = wf->t[0];
+    wf->t[0] = 0.0;
+    for (size_t i = 1; i < wf->n; i++) {
+        wf->t[i] -= t0;
+        double dt = wf->t[i] - wf->t[i - 1];
+
+        for (int k = 0; k < WAVEFORM_AXES; k++) {
+            wf->v[i][k] = wf->v[i - 1][k] + 0.5 * (wf->a[i - 1][k] + wf->a[i][k]) * dt;
+            wf->d[i][k] = wf->d[i - 1][k] + 0.5 * (wf->v[i - 1][k] + wf->v[i][k]) * dt;
+        }
+    }
+    wf->duration_s = wf->t[wf->n - 1];
+
+    return true;
+}
+
+/**
+ * @brief Displacement d = A exp(-tau² / 2 s²) sin(w tau) and its derivatives
+ */
+static void gabor(double amp, double freq, double width, double tau, double out[3]) {
+    double w = 2.0 * M_PI * freq;
+    double s2 = width * width;
+    double e = amp * exp(-tau * tau / (2.0 * s2));
+    double de = -tau / s2 * e;
+    double dde = (tau * tau / (s2 * s2) - 1.0 / s2) * e;
+    double sn = sin(w * tau);
+    double cs = cos(w * tau);
+
+    out[0] += e * sn;
+    out[1] += de * sn + e * w * cs;
+    out[2] += dde * sn + 2.0 * de * w * cs - e * w * w * sn;
+}
+
+static void waveform_eval_file(const waveform_t *wf, double t_s, waveform_state_t *out) {
+    // After the record the ground stays where it ended
+    if (t_s >= wf->t[wf->n - 1]) {
+        memcpy(out->d, wf->d[wf->n - 1], sizeof(out->d));
+        return;
+    }
+
+    // Binary search for the interval, then linear interpolation
+    size_t lo = 0;
+    size_t hi = wf->n - 1;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (wf->t[mid] <= t_s) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    double u = (t_s - wf->t[lo]) / (wf->t[hi] - wf->t[lo]);
+    for (int k = 0; k < WAVEFORM_AXES; k++) {
+        out->a[k] = wf->a[lo][k] + u * (wf->a[hi][k] - wf->a[lo][k]);
+        out->v[k] = wf->v[lo][k] + u * (wf->v[hi][k] - wf->v[lo][k]);
+        out->d[k] = wf->d[lo][k] + u * (wf->d[hi][k] - wf->d[lo][k]);
+    }
+}
+
+void waveform_eval(const waveform_t *wf, double t_s, waveform_state_t *out) {
+    double g[3] = {0.0, 0.0, 0.0};     // displacement, velocity, acceleration
+
+    memset(out, 0, sizeof(*out));
+    if (t_s <= 0.0) { return; }
+
+    if (wf->kind == WAVEFORM_FILE) {
+        waveform_eval_file(wf, t_s, out);
+        return;
+    }
+
+    if (t_s >= wf->duration_s) { return; }
+
+    if (wf->kind == WAVEFORM_SINE) {
+        double w = 2.0 * M_PI * wf->freq_hz;
+        double half = 0.5 * wf->amplitude;
+
+        g[0] = half * (1.0 - cos(w * t_s));
+        g[1] = half * w * sin(w * t_s);
+        g[2] = half * w * w * cos(w * t_s);
+    } else if (wf->kind == WAVEFORM_PULSE) {
+        double s = 1.0 / (2.0 * M_PI * wf->freq_hz);
+        double tau = t_s - PULSE_SIGMAS * s;
+        double s2 = s * s;
+
+        g[0] = wf->amplitude * exp(-tau * tau / (2.0 * s2));
+        g[1] = -tau / s2 * g[0];
+        g[2] = (tau * tau / (s2 * s2) - 1.0 / s2) * g[0];
+    } else {
+        for (size_t i = 0; i < sizeof(quake_wavelets) / sizeof(quake_wavelets[0]); i++) {
+            gabor(wf->amplitude * quake_wavelets[i].amp, wf->freq_hz * quake_wavelets[i].freq,
+                  quake_wavelets[i].width, t_s - quake_wavelets[i].centre, g);
+        }
+    }
+
+    out->d[wf->axis] = g[0];
+    out->v[wf->axis] = g[1];
+    out->a[wf->axis] = g[2];
+}
+
+void waveform_free(waveform_t *wf) {
+    free(wf->t);
+    free(wf->a);
+    free(wf->v);
+    free(wf->d);
+    memset(wf, 0, sizeof(*wf));
+}
@@ -0,0 +1,38 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// --- Host Test Checks ---
+//
+// A failed check prints its location and the test goes on; the test
+// program exits with the number of failures, so ctest reports any of them.
+
+static int check_failures;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) do { \
+        long long check_a = (long long)(a), check_b = (long long)(b); \
+        if (check_a != check_b) { \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, check_a, check_b); \
+            check_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief Report the result of a test program
+ *
+ * @return Exit status: the number of failed checks (0 = passed)
+ */
+static inline int check_report(const char *name) {
+    fprintf(stderr, "%s: %s (%d failed checks)\n", name, check_failures ? "FAILED" : "passed", check_failures);
+    return check_failures;
+}
+
+#endif // CHECK_H
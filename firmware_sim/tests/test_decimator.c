@@ -0,0 +1,258 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "decimator.h"
+
+#include "check.h"
+
+// --- Test Signals ---
+//
+// Tones at the firmware's default decimation, 1 kHz to 20 Hz. Amplitudes are
+// measured as the RMS of the output over whole periods of the output tone,
+// after the filters settled, so the sampling phase does not matter.
+
+#define DECIM_TEST_RATE_HZ      1000    // Input rate
+#define DECIM_TEST_FACTOR       50      // Default update rate (20 Hz)
+#define DECIM_TEST_AMPLITUDE    8000    // Tone amplitude (counts)
+#define DECIM_TEST_SETTLE       20      // Output samples skipped while the filters fill
+#define DECIM_TEST_OUTPUTS      200     // Output samples measured (10 s)
+
+#define DECIM_TEST_LONG_FACTOR  200     // Beyond DECIM_MAX_FACTOR: CIC /4 into FIR /50 (5 Hz)
+
+typedef enum {
+    TEST_FIR,
+    TEST_CIC,
+    TEST_CIC_FIR,       // FIR with a CIC pre-stage, as the readout runs factors past DECIM_MAX_FACTOR
+} test_filter_t;
+
+static decim_fir_kernel_t kernel;
+static decim_fir_t fir;
+static decim_cic_t cic;
+
+static void reset(test_filter_t filter, uint32_t factor) {
+    uint32_t pre = 1;
+
+    if (filter == TEST_CIC) {
+        decim_cic_reset(&cic, factor);
+        return;
+    }
+
+    decim_fir_design(&kernel, filter == TEST_CIC_FIR ? decim_fir_split(factor, &pre) : factor);
+    decim_fir_reset(&fir);
+    decim_cic_reset(&cic, pre);
+}
+
+static bool push(test_filter_t filter, const int16_t in[DECIM_AXES], int16_t out[DECIM_AXES]) {
+    int16_t mid[DECIM_AXES];
+
+    switch (filter) {
+    case TEST_FIR:
+        return decim_fir_push(&fir, &kernel, in, out);
+    case TEST_CIC:
+        return decim_cic_push(&cic, in, out);
+    default:
+        return decim_cic_push(&cic, in, mid) && decim_fir_push(&fir, &kernel, mid, out);
+    }
+}
+
+/**
+ * @brief Decimate a tone and measure what comes out
+ *
+ * The axes get the tone in phase, inverted and at half amplitude, every axis
+ * is checked against the first.
+ *
+ * @return Output amplitude of the X axis (counts)
+ */
+static double tone_amplitude_at(test_filter_t filter, uint32_t factor, double freq_hz) {
+    double sum_sq = 0.0;
+    int outputs = 0;
+
+    reset(filter, factor);
+
+    for (long i = 0; outputs < DECIM_TEST_SETTLE + DECIM_TEST_OUTPUTS; i++) {
+        double x = DECIM_TEST_AMPLITUDE * sin(2.0 * M_PI * freq_hz * i / DECIM_TEST_RATE_HZ);
+        int16_t in[DECIM_AXES] = {(int16_t)lround(x), (int16_t)-lround(x), (int16_t)lround(x / 2)};
+        int16_t out[DECIM_AXES];
+
+        if (!push(filter, in, out)) { continue; }
+        if (outputs++ < DECIM_TEST_SETTLE) { continue; }
+
+        // Rounding of the filters and of the halved input differ by a count or two
+        CHECK(abs(out[0] + out[1]) <= 1);
+        CHECK(abs(out[0] / 2 - out[2]) <= 2);
+        sum_sq += (double)out[0] * out[0];
+    }
+
+    return sqrt(2.0 * sum_sq / DECIM_TEST_OUTPUTS);
+}
+
+static double tone_amplitude(test_filter_t filter, double freq_hz) {
+    return tone_amplitude_at(filter, DECIM_TEST_FACTOR, freq_hz);
+}
+
+/**
+ * @brief Magnitude response of the CIC decimator (sinc^order)
+ */
+static double cic_response(double freq_hz, int factor) {
+    double w = M_PI * freq_hz / DECIM_TEST_RATE_HZ;
+
+    return pow(fabs(sin(w * factor) / (factor * sin(w))), DECIM_CIC_ORDER);
+}
+
+// --- Tests ---
+
+static void test_dc(test_filter_t filter, uint32_t factor, int16_t level) {
+    int16_t in[DECIM_AXES] = {level, (int16_t)-level, 0};
+    int16_t out[DECIM_AXES];
+    int outputs = 0, exact = 0;
+
+    reset(filter, factor);
+
+    // Unity DC gain is exact once the history is full
+    for (uint32_t i = 0; i < (DECIM_FIR_TAPS_PER_PHASE + 4) * factor; i++) {
+        if (!push(filter, in, out)) { continue; }
+        if (++outputs <= DECIM_FIR_TAPS_PER_PHASE) { continue; }
+
+        exact += out[0] == level && out[1] == -level && out[2] == 0;
+    }
+
+    CHECK_EQ(outputs, DECIM_FIR_TAPS_PER_PHASE + 4);
+    CHECK_EQ(exact, 4);
+}
+
+static void test_cic_full_scale(void) {
+    // The largest factor with full-scale input must not overflow the integrators
+    test_dc(TEST_CIC, DECIM_CIC_MAX_FACTOR, INT16_MAX);
+    test_dc(TEST_CIC, DECIM_CIC_MAX_FACTOR, INT16_MIN + 1);
+
+    decim_cic_reset(&cic, 0);
+    CHECK_EQ(cic.factor, 1);
+    decim_cic_reset(&cic, DECIM_CIC_MAX_FACTOR + 1);
+    CHECK_EQ(cic.factor, DECIM_CIC_MAX_FACTOR);
+}
+
+static void test_passband(void) {
+    // Well inside the 10 Hz output Nyquist frequency
+    double fir_2hz = tone_amplitude(TEST_FIR, 2.0);
+    double cic_2hz = tone_amplitude(TEST_CIC, 2.0);
+
+    fprintf(stderr, "passband 2 Hz: fir=%.1f cic=%.1f (of %d)\n", fir_2hz, cic_2hz, DECIM_TEST_AMPLITUDE);
+
+    // The FIR ripples by a fraction of a percent, the CIC droops by its sinc^3 response
+    CHECK(fabs(fir_2hz / DECIM_TEST_AMPLITUDE - 1.0) < 0.01);
+    CHECK(fabs(cic_2hz / (DECIM_TEST_AMPLITUDE * cic_response(2.0, DECIM_TEST_FACTOR)) - 1.0) < 0.005);
+}
+
+static void test_alias(void) {
+    // 33 Hz aliases to 7 Hz at the output, anything that comes out is aliasing
+    double fir_33hz = tone_amplitude(TEST_FIR, 33.0);
+    double cic_33hz = tone_amplitude(TEST_CIC, 33.0);
+    double cic_expected = DECIM_TEST_AMPLITUDE * cic_response(33.0, DECIM_TEST_FACTOR);
+
+    fprintf(stderr, "alias 33 Hz: fir=%.1f cic=%.1f (expected %.1f, of %d)\n",
+            fir_33hz, cic_33hz, cic_expected, DECIM_TEST_AMPLITUDE);
+
+    // Below 0.1 % for the FIR, the CIC follows its response to within a count or two
+    CHECK(fir_33hz < DECIM_TEST_AMPLITUDE * 0.001);
+    CHECK(fabs(cic_33hz - cic_expected) < 2.0);
+    CHECK(cic_33hz < DECIM_TEST_AMPLITUDE * 0.01);
+}
+
+static void test_stopband(void) {
+    // Past the transition band the FIR keeps every tone far below the original amplitude
+    static const double tones_hz[] = {15.0, 21.0, 47.0, 99.0, 151.0, 333.0, 489.0};
+    double worst = 0.0;
+
+    for (size_t i = 0; i < sizeof(tones_hz) / sizeof(tones_hz[0]); i++) {
+        double a = tone_amplitude(TEST_FIR, tones_hz[i]);
+        if (a > worst) { worst = a; }
+        CHECK(a < DECIM_TEST_AMPLITUDE * 0.005);
+    }
+
+    fprintf(stderr, "stopband 15..489 Hz: fir worst=%.1f (of %d)\n", worst, DECIM_TEST_AMPLITUDE);
+}
+
+static void test_fir_rescale(void) {
+    int16_t in[DECIM_AXES] = {12000, -12000, 20000};
+    int16_t out[DECIM_AXES];
+
+    reset(TEST_FIR, DECIM_TEST_FACTOR);
+    for (int i = 0; i < DECIM_FIR_TAPS_PER_PHASE * DECIM_TEST_FACTOR; i++) { push(TEST_FIR, in, out); }
+
+    // One range code coarser: the window halves and the output follows at once
+    decim_fir_rescale(&fir, 1);
+    int16_t coarse[DECIM_AXES] = {6000, -6000, 10000};
+    while (!push(TEST_FIR, coarse, out)) {}
+    CHECK_EQ(out[0], 6000);
+    CHECK_EQ(out[1], -6000);
+    CHECK_EQ(out[2], 10000);
+
+    // Two codes finer: 10000 counts clip at full scale
+    decim_fir_rescale(&fir, -2);
+    int16_t fine[DECIM_AXES] = {24000, -24000, INT16_MAX};
+    while (!push(TEST_FIR, fine, out)) {}
+    CHECK_EQ(out[0], 24000);
+    CHECK_EQ(out[1], -24000);
+    CHECK_EQ(out[2], INT16_MAX);
+}
+
+static void test_split(void) {
+    uint32_t pre;
+
+    // Within the FIR's range there is no pre-stage
+    CHECK_EQ(decim_fir_split(DECIM_TEST_FACTOR, &pre), DECIM_TEST_FACTOR);
+    CHECK_EQ(pre, 1);
+    CHECK_EQ(decim_fir_split(DECIM_MAX_FACTOR, &pre), DECIM_MAX_FACTOR);
+    CHECK_EQ(pre, 1);
+
+    // Exact where a divisor fits, the FIR keeps most of the factor
+    CHECK_EQ(decim_fir_split(DECIM_TEST_LONG_FACTOR, &pre), 50);
+    CHECK_EQ(pre, 4);
+    CHECK_EQ(decim_fir_split(1000, &pre), 50);
+    CHECK_EQ(pre, 20);
+    CHECK_EQ(decim_fir_split(69, &pre), 23);
+    CHECK_EQ(pre, 3);
+
+    // A prime is off by one
+    CHECK_EQ(decim_fir_split(67, &pre), 34);
+    CHECK_EQ(pre, 2);
+
+    // Otherwise within rounding of the FIR factor
+    for (uint32_t factor = DECIM_MAX_FACTOR + 1; factor <= 20000; factor++) {
+        uint16_t f = decim_fir_split(factor, &pre);
+        if (f > DECIM_MAX_FACTOR || f <= DECIM_MAX_FACTOR / 3 || 2 * labs((long)(pre * f) - (long)factor) > (long)pre) {
+            fprintf(stderr, "split %u: cic %u x fir %u\n", factor, pre, f);
+            CHECK(false);
+            break;
+        }
+    }
+}
+
+static void test_long_factor(void) {
+    // 5 Hz out: a 0.5 Hz tone passes, 7 Hz would alias to 2 Hz
+    double pass = tone_amplitude_at(TEST_CIC_FIR, DECIM_TEST_LONG_FACTOR, 0.5);
+    double alias = tone_amplitude_at(TEST_CIC_FIR, DECIM_TEST_LONG_FACTOR, 7.0);
+
+    fprintf(stderr, "cic+fir /%d: 0.5 Hz=%.1f 7 Hz=%.1f (of %d)\n", DECIM_TEST_LONG_FACTOR, pass, alias, DECIM_TEST_AMPLITUDE);
+
+    CHECK(fabs(pass / DECIM_TEST_AMPLITUDE - 1.0) < 0.01);
+    CHECK(alias < DECIM_TEST_AMPLITUDE * 0.001);
+}
+
+int main(void) {
+    test_dc(TEST_FIR, DECIM_TEST_FACTOR, 1234);
+    test_dc(TEST_FIR, DECIM_TEST_FACTOR, -32000);
+    test_dc(TEST_FIR, DECIM_MAX_FACTOR, 7);
+    test_dc(TEST_CIC, DECIM_TEST_FACTOR, 1234);
+    test_dc(TEST_CIC, DECIM_TEST_FACTOR, -32000);
+    test_cic_full_scale();
+    test_passband();
+    test_alias();
+    test_stopband();
+    test_fir_rescale();
+    test_split();
+    test_dc(TEST_CIC_FIR, DECIM_TEST_LONG_FACTOR, -20000);
+    test_long_factor();
+
+    return check_report("test_decimator");
+}
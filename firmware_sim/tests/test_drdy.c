@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+#include "app_tasks.h"
+#include "drdy.h"
+#include "sim_port.h"
+
+#include "check.h"
+
+// --- Simulated Interrupt Source ---
+//
+// The test thread pulses the data-ready pin like the sensor would, the
+// firmware's ISR notifies a readout task that services every sample the way
+// accel_readout_task does. The period is long next to the host's wake-up
+// latency, so the only missed samples are the ones the test leaves out. A
+// case in which the host still delayed a pulse by a quarter period is run
+// again rather than judged.
+
+#define DRDY_TEST_PERIOD_US     20000       // Pulse period, three of them stay within DRDY_TIMEOUT_MS
+#define DRDY_TEST_SETTLE_MS     (DRDY_TIMEOUT_MS + 150) // Idle time between cases, ends in a timeout
+#define DRDY_TEST_GAP_MS        (2 * DRDY_TIMEOUT_MS + 50) // Interrupts stop for this long in the timeout case
+#define DRDY_TEST_ATTEMPTS      3           // Runs of a case before a late host fails it
+#define DRDY_TEST_DRAIN_MS      25          // Servicing time after the last pulse of a case
+
+/**
+ * @brief What the readout task saw, copied out after every wake-up
+ *
+ * timing:               Timing statistics of the readout task
+ * timeouts:             Waits that ended without an interrupt
+ * dt_after_timeout_us:  Integration step of the first sample after the latest timeout
+ */
+typedef struct {
+    drdy_timing_t timing;
+    uint32_t timeouts;
+    int64_t dt_after_timeout_us;
+} readout_view_t;
+
+static pthread_mutex_t view_lock = PTHREAD_MUTEX_INITIALIZER;
+static readout_view_t view;
+
+static void readout_task(void *arg) {
+    (void)arg;
+    drdy_timing_t timing;
+    uint32_t timeouts = 0;
+    bool after_timeout = false;
+    int64_t dt_after_timeout_us = 0;
+
+    drdy_timing_reset(&timing, DRDY_TEST_PERIOD_US);
+
+    for (;;) {
+        int64_t isr_us;
+
+        if (drdy_wait(&timing, DRDY_TIMEOUT_MS, &isr_us)) {
+            int64_t dt_us = drdy_timing_update(&timing, isr_us);
+            if (after_timeout) { dt_after_timeout_us = dt_us; }
+            after_timeout = false;
+        } else {
+            timeouts++;
+            after_timeout = true;
+        }
+
+        pthread_mutex_lock(&view_lock);
+        view = (readout_view_t){.timing = timing, .timeouts = timeouts, .dt_after_timeout_us = dt_after_timeout_us};
+        pthread_mutex_unlock(&view_lock);
+    }
+}
+
+static readout_view_t readout_view(void) {
+    pthread_mutex_lock(&view_lock);
+    readout_view_t v = view;
+    pthread_mutex_unlock(&view_lock);
+
+    return v;
+}
+
+/**
+ * @brief Pulse the pin once per period, leaving out the slots marked in skip
+ *
+ * @return false if a pulse came a quarter period late
+ */
+static bool pulse(int slots, const bool *skip) {
+    int64_t t0 = esp_timer_get_time();
+    bool on_time = true;
+
+    for (int k = 0; k < slots; k++) {
+        int64_t due = t0 + (int64_t)k * DRDY_TEST_PERIOD_US;
+        sim_sleep_until(due);
+        if (skip != NULL && skip[k]) { continue; }
+
+        if (esp_timer_get_time() - due > DRDY_TEST_PERIOD_US / 4) { on_time = false; }
+        sim_gpio_set(MPU6050_INT_IO, 1);
+        sim_gpio_set(MPU6050_INT_IO, 0);
+    }
+
+    usleep(DRDY_TEST_DRAIN_MS * 1000);
+
+    return on_time;
+}
+
+// --- Tests ---
+
+static bool test_regular(void) {
+    readout_view_t before = readout_view();
+    if (!pulse(20, NULL)) { return false; }
+    readout_view_t after = readout_view();
+
+    CHECK_EQ(after.timing.samples - before.timing.samples, 20);
+    CHECK_EQ(after.timing.missed - before.timing.missed, 0);
+    CHECK(after.timing.jitter_max_us < DRDY_TEST_PERIOD_US / 2);
+
+    return true;
+}
+
+static bool test_missed(void) {
+    bool skip[30] = {0};
+
+    // A single interrupt lost and two in a row
+    skip[8] = skip[16] = skip[17] = true;
+
+    readout_view_t before = readout_view();
+    if (!pulse(30, skip)) { return false; }
+    readout_view_t after = readout_view();
+
+    CHECK_EQ(after.timing.samples - before.timing.samples, 27);
+    CHECK_EQ(after.timing.missed - before.timing.missed, 3);
+
+    return true;
+}
+
+static bool test_timeout(void) {
+    readout_view_t before = readout_view();
+    if (!pulse(8, NULL)) { return false; }
+    usleep(DRDY_TEST_GAP_MS * 1000);
+    readout_view_t gap = readout_view();
+    if (!pulse(8, NULL)) { return false; }
+    readout_view_t after = readout_view();
+
+    // The stall ends in a timeout, and the time base restarts at the next sample
+    CHECK(gap.timeouts - before.timeouts >= 1);
+    CHECK(gap.timing.last_isr_us == 0);
+    CHECK_EQ(after.timeouts, gap.timeouts);
+    CHECK_EQ(after.dt_after_timeout_us, DRDY_TEST_PERIOD_US);
+
+    // Neither the gap nor its wait are counted as missed samples
+    CHECK_EQ(after.timing.samples - before.timing.samples, 16);
+    CHECK_EQ(after.timing.missed - before.timing.missed, 0);
+
+    return true;
+}
+
+/**
+ * @brief Run a case from an idle readout until the host kept its timing
+ */
+static void run(const char *name, bool (*test)(void)) {
+    for (int i = 0; i < DRDY_TEST_ATTEMPTS; i++) {
+        usleep(DRDY_TEST_SETTLE_MS * 1000);
+        if (test()) { return; }
+        fprintf(stderr, "%s: host delayed a pulse, running it again\n", name);
+    }
+
+    fprintf(stderr, "%s: host too late in every run\n", name);
+    check_failures++;
+}
+
+int main(void) {
+    gpio_config_t io_conf = {.pin_bit_mask = 1ULL << MPU6050_INT_IO, .mode = GPIO_MODE_INPUT, .intr_type = GPIO_INTR_POSEDGE};
+    TaskHandle_t task;
+
+    sim_port_init(false);
+
+    CHECK_EQ(xTaskCreate(readout_task, "readout", 4096, NULL, READOUT_TASK_PRIORITY, &task), pdPASS);
+    CHECK_EQ(gpio_config(&io_conf), ESP_OK);
+    CHECK_EQ(gpio_install_isr_service(0), ESP_OK);
+    CHECK_EQ(gpio_isr_handler_add(MPU6050_INT_IO, drdy_isr_handler, task), ESP_OK);
+
+    run("regular", test_regular);
+    run("missed", test_missed);
+    run("timeout", test_timeout);
+
+    return check_report("test_drdy");
+}
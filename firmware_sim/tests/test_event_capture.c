@@ -0,0 +1,85 @@
+#include <stdlib.h>
+
+#include "event_capture.h"
+
+#include "check.h"
+
+// The capture window under auto-ranging: samples come tagged with the
+// accelerometer range they were measured at, and the window has to hold a
+// burst measured at a wider range without clipping it.
+
+#define CAPTURE_TEST_GRAVITY    16384   // 1 g on Z at range 0 (±2 g)
+#define CAPTURE_TEST_ONSET      50      // Burst samples at range 0 before the switch
+#define CAPTURE_TEST_SMALL      6000    // Burst amplitude before the switch (counts at range 0)
+#define CAPTURE_TEST_LARGE      20000   // Burst amplitude after the switch (counts at range 2, ~20 g)
+
+static event_capture_t ec;
+static capture_sample_t window[CAPTURE_RING_SAMPLES];
+
+static bool push(int16_t x, uint8_t range, int64_t *t_us) {
+    const int16_t a[CAPTURE_AXES] = {x, 0, (int16_t)(CAPTURE_TEST_GRAVITY >> range)};
+
+    *t_us += 1000;
+    return event_capture_push(&ec, a, range, *t_us);
+}
+
+static void test_widen(void) {
+    int64_t t_us = 0;
+    bool frozen = false;
+
+    event_capture_request(&ec, CAPTURE_REQ_ARM);
+    for (int i = 0; i < CAPTURE_WARMUP + 100; i++) { CHECK(!push(0, 0, &t_us)); }
+    CHECK_EQ(ec.range, 0);
+
+    // The burst triggers at range 0, the sensor switches to range 2 while the window records
+    for (int i = 0; i < CAPTURE_TEST_ONSET; i++) { push(i & 1 ? CAPTURE_TEST_SMALL : -CAPTURE_TEST_SMALL, 0, &t_us); }
+    CHECK_EQ(atomic_load(&ec.state), CAPTURE_TRIGGERED);
+    for (int i = 0; i < CAPTURE_POST_SAMPLES && !frozen; i++) {
+        frozen = push(i & 1 ? CAPTURE_TEST_LARGE : -CAPTURE_TEST_LARGE, 2, &t_us);
+    }
+    CHECK(frozen);
+    CHECK_EQ(ec.range, 2);
+
+    uint16_t n = event_capture_read(&ec, 0, window, CAPTURE_RING_SAMPLES);
+    CHECK_EQ(n, CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES);
+
+    // Every sample in counts of range 2: the quiet part and the start of the burst
+    // rescaled, the large part as measured instead of clipped
+    int quiet = 0, small = 0, large = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        CHECK_EQ(window[i].az, CAPTURE_TEST_GRAVITY >> 2);
+        quiet += window[i].ax == 0;
+        small += abs(window[i].ax) == CAPTURE_TEST_SMALL >> 2;
+        large += abs(window[i].ax) == CAPTURE_TEST_LARGE;
+    }
+    CHECK_EQ(quiet, CAPTURE_PRE_SAMPLES);
+    CHECK_EQ(small, CAPTURE_TEST_ONSET);
+    CHECK_EQ(large, CAPTURE_POST_SAMPLES - CAPTURE_TEST_ONSET);
+}
+
+static void test_narrow(void) {
+    int64_t t_us = 0;
+
+    event_capture_request(&ec, CAPTURE_REQ_ARM);
+    for (int i = 0; i < 100; i++) { push(0, 1, &t_us); }
+    CHECK_EQ(ec.range, 1);
+
+    // Armed, the window only goes back to the finer range once the whole ring was measured at it
+    for (int i = 0; i < CAPTURE_RING_SAMPLES - 1; i++) { push(0, 0, &t_us); }
+    CHECK_EQ(ec.range, 1);
+    push(0, 0, &t_us);
+    CHECK_EQ(ec.range, 0);
+    CHECK_EQ(ec.dc[2] >> CAPTURE_DC_SHIFT, CAPTURE_TEST_GRAVITY);
+
+    // A wider sample widens at once
+    push(0, 3, &t_us);
+    CHECK_EQ(ec.range, 3);
+    CHECK_EQ(ec.dc[2] >> CAPTURE_DC_SHIFT, CAPTURE_TEST_GRAVITY >> 3);
+}
+
+int main(void) {
+    test_widen();
+    test_narrow();
+
+    return check_report("test_event_capture");
+}
@@ -0,0 +1,169 @@
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "driver/i2c_master.h"
+#include "esp_timer.h"
+
+#include "mpu6050.h"
+#include "sim_port.h"
+
+#include "check.h"
+
+// --- Mock Sensor ---
+//
+// A plain register file with an auto-incrementing pointer. Reads can be
+// made to stall on the wire to push the driver into its timeout path.
+
+#define MOCK_REGS               128
+#define MOCK_STALL_SHORT_MS     (MPU6050_TIMEOUT_MS + 15)   // Times out, completes within MPU6050_ABORT_MS
+#define MOCK_STALL_LONG_MS      150                         // Outlasts the timeout and the abort wait
+
+typedef struct {
+    uint8_t regs[MOCK_REGS];
+    uint8_t ptr;
+    atomic_int stall_ms;            // Next read holds the bus this long
+    atomic_int reads;               // Read phases seen on the wire
+} mock_sensor_t;
+
+static void mock_write(void *ctx, const uint8_t *data, size_t len) {
+    mock_sensor_t *m = ctx;
+
+    m->ptr = data[0] % MOCK_REGS;
+    for (size_t i = 1; i < len; i++) {
+        m->regs[m->ptr] = data[i];
+        m->ptr = (m->ptr + 1) % MOCK_REGS;
+    }
+}
+
+static void mock_read(void *ctx, uint8_t *data, size_t len) {
+    mock_sensor_t *m = ctx;
+
+    atomic_fetch_add(&m->reads, 1);
+    int stall_ms = atomic_exchange(&m->stall_ms, 0);
+    if (stall_ms > 0) { usleep(stall_ms * 1000); }
+
+    for (size_t i = 0; i < len; i++) {
+        data[i] = m->regs[m->ptr];
+        m->ptr = (m->ptr + 1) % MOCK_REGS;
+    }
+}
+
+static const sim_i2c_target_t mock_target = {.write = mock_write, .read = mock_read};
+
+static void mock_init(mock_sensor_t *m, uint8_t seed) {
+    memset(m, 0, sizeof(*m));
+    m->regs[MPU6050_WHO_AM_I] = MPU6050_DEVICE_ID;
+    for (int i = 0; i < MPU6050_BURST_SIZE; i++) { m->regs[MPU6050_ACCEL_XOUT_H + i] = (uint8_t)(seed + i); }
+}
+
+static void check_raw(const mpu6050_raw_t *raw, uint8_t seed) {
+    // Burst layout: ax ay az temp gx gy gz, big endian
+    CHECK_EQ(raw->ax, (int16_t)((seed + 0) << 8 | (uint8_t)(seed + 1)));
+    CHECK_EQ(raw->ay, (int16_t)((seed + 2) << 8 | (uint8_t)(seed + 3)));
+    CHECK_EQ(raw->az, (int16_t)((seed + 4) << 8 | (uint8_t)(seed + 5)));
+    CHECK_EQ(raw->gx, (int16_t)((seed + 8) << 8 | (uint8_t)(seed + 9)));
+    CHECK_EQ(raw->gy, (int16_t)((seed + 10) << 8 | (uint8_t)(seed + 11)));
+    CHECK_EQ(raw->gz, (int16_t)((seed + 12) << 8 | (uint8_t)(seed + 13)));
+}
+
+// --- Tests ---
+
+static mock_sensor_t sensor_a, sensor_b;
+static mpu6050_dev_t dev_a, dev_b;
+
+static void test_register_access(void) {
+    uint8_t id = 0;
+    mpu6050_raw_t raw;
+
+    CHECK_EQ(mpu6050_who_am_i(&dev_a, &id), ESP_OK);
+    CHECK_EQ(id, MPU6050_DEVICE_ID);
+
+    CHECK_EQ(mpu6050_set_range(&dev_a, 2, 1), ESP_OK);
+    CHECK_EQ(sensor_a.regs[MPU6050_ACCEL_CONFIG], 2 << MPU6050_FS_SEL_SHIFT);
+    CHECK_EQ(sensor_a.regs[MPU6050_GYRO_CONFIG], 1 << MPU6050_FS_SEL_SHIFT);
+
+    CHECK_EQ(mpu6050_read_raw(&dev_a, &raw), ESP_OK);
+    check_raw(&raw, 0x10);
+    CHECK_EQ(raw.accel_range, 2);
+    CHECK_EQ(raw.gyro_range, 1);
+}
+
+static void test_pipelined_reads(void) {
+    mpu6050_raw_t raw_a, raw_b;
+
+    // Both transfers are queued before either is collected
+    CHECK_EQ(mpu6050_read_raw_start(&dev_a), ESP_OK);
+    CHECK_EQ(mpu6050_read_raw_start(&dev_b), ESP_OK);
+    CHECK_EQ(mpu6050_read_raw_finish(&dev_a, &raw_a, MPU6050_TIMEOUT_MS), ESP_OK);
+    CHECK_EQ(mpu6050_read_raw_finish(&dev_b, &raw_b, MPU6050_TIMEOUT_MS), ESP_OK);
+    check_raw(&raw_a, 0x10);
+    check_raw(&raw_b, 0x80);
+}
+
+static void test_timeout_late_completion(void) {
+    uint8_t id = 0xEE;
+    mpu6050_raw_t raw;
+    uint32_t resets = dev_a.resets;
+
+    // The completion arrives after the timeout but within the abort wait
+    atomic_store(&sensor_a.stall_ms, MOCK_STALL_SHORT_MS);
+    CHECK_EQ(mpu6050_who_am_i(&dev_a, &id), ESP_ERR_TIMEOUT);
+    CHECK_EQ(dev_a.resets, resets + 1);
+    CHECK(!dev_a.busy);
+
+    // Nothing of the aborted read reaches the caller's buffer later on
+    usleep(2 * MOCK_STALL_SHORT_MS * 1000);
+    CHECK_EQ(id, 0xEE);
+
+    // ... or the next transfer of the device
+    CHECK_EQ(mpu6050_read_raw(&dev_a, &raw), ESP_OK);
+    check_raw(&raw, 0x10);
+}
+
+static void test_timeout_stuck_transfer(void) {
+    uint8_t id = 0xEE;
+    mpu6050_raw_t raw;
+
+    // Not even the abort ends the transfer in time: the device stays busy
+    atomic_store(&sensor_a.stall_ms, MOCK_STALL_LONG_MS);
+    int64_t t0 = esp_timer_get_time();
+    CHECK_EQ(mpu6050_who_am_i(&dev_a, &id), ESP_ERR_TIMEOUT);
+    CHECK(dev_a.busy);
+    CHECK(esp_timer_get_time() - t0 < MOCK_STALL_LONG_MS * 1000);
+
+    // The next transfer is refused without touching the bus or the buffers
+    int reads = atomic_load(&sensor_a.reads);
+    CHECK_EQ(mpu6050_read_raw(&dev_a, &raw), ESP_ERR_TIMEOUT);
+    CHECK_EQ(atomic_load(&sensor_a.reads), reads);
+
+    // Once the stuck transfer has completed the device is usable again
+    usleep(MOCK_STALL_LONG_MS * 1000);
+    CHECK_EQ(mpu6050_read_raw(&dev_a, &raw), ESP_OK);
+    check_raw(&raw, 0x10);
+    CHECK(!dev_a.busy);
+    CHECK_EQ(id, 0xEE);
+}
+
+int main(void) {
+    i2c_master_bus_config_t bus_cfg = {.trans_queue_depth = 4};
+    i2c_master_bus_handle_t bus;
+
+    sim_port_init(false);
+
+    mock_init(&sensor_a, 0x10);
+    mock_init(&sensor_b, 0x80);
+    sim_i2c_attach(MPU6050_ADDR, &mock_target, &sensor_a);
+    sim_i2c_attach(MPU6050_ADDR_ALT, &mock_target, &sensor_b);
+
+    CHECK_EQ(i2c_new_master_bus(&bus_cfg, &bus), ESP_OK);
+    CHECK_EQ(mpu6050_add_device(bus, NULL, MPU6050_ADDR, &dev_a), ESP_OK);
+    CHECK_EQ(mpu6050_add_device(bus, NULL, MPU6050_ADDR_ALT, &dev_b), ESP_OK);
+
+    test_register_access();
+    test_pipelined_reads();
+    test_timeout_late_completion();
+    test_timeout_stuck_transfer();
+
+    return check_report("test_mpu6050_bus");
+}
@@ -0,0 +1,235 @@
+#include <string.h>
+#include <unistd.h>
+
+#include "driver/i2c_master.h"
+
+#include "mpu6050.h"
+#include "sim_port.h"
+#include "vmpu6050.h"
+#include "waveform.h"
+
+#include "check.h"
+
+// --- Sensor Control ---
+//
+// The virtual sensor samples at 1 kHz while awake. The tests let it run for
+// a while and put it back to sleep, which freezes the FIFO, so what the
+// driver drains can be compared byte for byte with what the model buffered.
+
+#define FIFO_SHORT_RUN_MS       20      // Well below a full FIFO
+#define FIFO_OVERFLOW_RUN_MS    300     // Over 170 accel frames: the FIFO wraps
+#define FIFO_PARTIAL_BYTES      4       // Bytes of a frame in progress, for the misaligned count
+
+#define VMPU6050_PWR_SLEEP      0x40    // PWR_MGMT_1 sleep bit
+
+static vmpu6050_t sensor;
+static mpu6050_dev_t dev;
+static mpu6050_fifo_t fifo;
+static mpu6050_raw_t frames[MPU6050_FIFO_MAX_FRAMES];
+
+static void sensor_sleep(bool sleep) {
+    pthread_mutex_lock(&sensor.lock);
+    if (sleep) {
+        sensor.regs[MPU6050_PWR_MGMT_1] |= VMPU6050_PWR_SLEEP;
+    } else {
+        sensor.regs[MPU6050_PWR_MGMT_1] &= ~VMPU6050_PWR_SLEEP;
+    }
+    pthread_mutex_unlock(&sensor.lock);
+}
+
+static void sensor_run(int ms) {
+    sensor_sleep(false);
+    usleep(ms * 1000);
+    sensor_sleep(true);
+}
+
+/**
+ * @brief Copy the buffered FIFO bytes, oldest first
+ *
+ * @return Number of bytes
+ */
+static size_t sensor_fifo(uint8_t *out) {
+    pthread_mutex_lock(&sensor.lock);
+    size_t n = sensor.fifo_count;
+    for (size_t i = 0; i < n; i++) { out[i] = sensor.fifo[(sensor.fifo_head + i) % VMPU6050_FIFO_SIZE]; }
+    pthread_mutex_unlock(&sensor.lock);
+
+    return n;
+}
+
+static size_t sensor_fifo_count(void) {
+    pthread_mutex_lock(&sensor.lock);
+    size_t n = sensor.fifo_count;
+    pthread_mutex_unlock(&sensor.lock);
+
+    return n;
+}
+
+static int16_t get16(const uint8_t *src) {
+    return (int16_t)((uint16_t)src[0] << 8 | src[1]);
+}
+
+/**
+ * @brief Check decoded frames against the buffered bytes they came from
+ */
+static void check_frames(const mpu6050_raw_t *raw, size_t n, const uint8_t *bytes) {
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t *f = &bytes[i * fifo.frame_size];
+
+        CHECK_EQ(raw[i].ax, get16(&f[0]));
+        CHECK_EQ(raw[i].ay, get16(&f[2]));
+        CHECK_EQ(raw[i].az, get16(&f[4]));
+        CHECK_EQ(raw[i].gx, fifo.with_gyro ? get16(&f[6]) : 0);
+        CHECK_EQ(raw[i].gy, fifo.with_gyro ? get16(&f[8]) : 0);
+        CHECK_EQ(raw[i].gz, fifo.with_gyro ? get16(&f[10]) : 0);
+    }
+}
+
+// --- Tests ---
+
+static void test_burst_drain(bool with_gyro) {
+    uint8_t bytes[VMPU6050_FIFO_SIZE];
+    size_t n = 0;
+
+    fifo.with_gyro = with_gyro;
+    CHECK_EQ(mpu6050_fifo_enable(&dev, &fifo), ESP_OK);
+    sensor_run(FIFO_SHORT_RUN_MS);
+
+    size_t count = sensor_fifo(bytes);
+    CHECK(count > 0);
+    CHECK_EQ(count % fifo.frame_size, 0);
+
+    // Everything buffered comes out in one read, in order
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, count / fifo.frame_size);
+    check_frames(frames, n, bytes);
+    CHECK_EQ(sensor_fifo_count(), 0);
+
+    // An empty FIFO reads as no frames
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, 0);
+}
+
+static void test_frame_limit(void) {
+    uint8_t bytes[VMPU6050_FIFO_SIZE];
+    size_t n = 0, limit = 5;
+
+    fifo.with_gyro = true;
+    CHECK_EQ(mpu6050_fifo_enable(&dev, &fifo), ESP_OK);
+    sensor_run(FIFO_SHORT_RUN_MS);
+
+    size_t total = sensor_fifo(bytes) / fifo.frame_size;
+    CHECK(total > limit);
+
+    // The first read stops at the limit, the rest follow in order
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, limit, &n), ESP_OK);
+    CHECK_EQ(n, limit);
+    check_frames(frames, n, bytes);
+
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, total - limit);
+    check_frames(frames, n, &bytes[limit * fifo.frame_size]);
+}
+
+static void test_overflow(void) {
+    uint8_t bytes[VMPU6050_FIFO_SIZE];
+    size_t n = 1;
+    uint32_t overflows = fifo.overflows, resyncs = fifo.resyncs;
+
+    fifo.with_gyro = false;
+    CHECK_EQ(mpu6050_fifo_enable(&dev, &fifo), ESP_OK);
+    sensor_run(FIFO_OVERFLOW_RUN_MS);
+
+    // 1024 is no multiple of 6: the oldest frame in the FIFO is cut
+    CHECK_EQ(sensor_fifo_count(), VMPU6050_FIFO_SIZE);
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(n, 0);
+    CHECK_EQ(fifo.overflows, overflows + 1);
+    CHECK_EQ(fifo.resyncs, resyncs + 1);
+    CHECK_EQ(sensor_fifo_count(), 0);
+
+    // Buffering restarts on a frame boundary
+    sensor_run(FIFO_SHORT_RUN_MS);
+    size_t count = sensor_fifo(bytes);
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK(n > 0);
+    CHECK_EQ(n, count / fifo.frame_size);
+    check_frames(frames, n, bytes);
+}
+
+static void test_partial_frame(void) {
+    uint8_t bytes[VMPU6050_FIFO_SIZE];
+    size_t n = 0;
+    uint32_t overflows = fifo.overflows, resyncs = fifo.resyncs;
+
+    fifo.with_gyro = false;
+    CHECK_EQ(mpu6050_fifo_enable(&dev, &fifo), ESP_OK);
+    sensor_run(FIFO_SHORT_RUN_MS);
+
+    // The count read while the sensor writes a frame: only part of it is in the FIFO
+    size_t count = sensor_fifo(bytes);
+    pthread_mutex_lock(&sensor.lock);
+    for (size_t i = 0; i < FIFO_PARTIAL_BYTES; i++) {
+        sensor.fifo[(sensor.fifo_head + sensor.fifo_count) % VMPU6050_FIFO_SIZE] = 0x5A;
+        sensor.fifo_count++;
+    }
+    pthread_mutex_unlock(&sensor.lock);
+
+    // The whole frames are drained, the partial one waits for its remaining bytes
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, count / fifo.frame_size);
+    check_frames(frames, n, bytes);
+    CHECK_EQ(fifo.overflows, overflows);
+    CHECK_EQ(fifo.resyncs, resyncs);
+    CHECK_EQ(sensor_fifo_count(), FIFO_PARTIAL_BYTES);
+
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, 0);
+    CHECK_EQ(sensor_fifo_count(), FIFO_PARTIAL_BYTES);
+
+    // The frame completes and the next drain starts with it, still aligned
+    pthread_mutex_lock(&sensor.lock);
+    for (size_t i = FIFO_PARTIAL_BYTES; i < fifo.frame_size; i++) {
+        sensor.fifo[(sensor.fifo_head + sensor.fifo_count) % VMPU6050_FIFO_SIZE] = 0x5A;
+        sensor.fifo_count++;
+    }
+    pthread_mutex_unlock(&sensor.lock);
+
+    sensor_run(FIFO_SHORT_RUN_MS);
+    count = sensor_fifo(bytes);
+    CHECK_EQ(mpu6050_fifo_read(&dev, &fifo, frames, MPU6050_FIFO_MAX_FRAMES, &n), ESP_OK);
+    CHECK_EQ(n, count / fifo.frame_size);
+    CHECK(n > 1);
+    CHECK_EQ(frames[0].ax, 0x5A5A);
+    CHECK_EQ(frames[0].az, 0x5A5A);
+    check_frames(frames, n, bytes);
+    CHECK_EQ(fifo.resyncs, resyncs);
+}
+
+int main(void) {
+    i2c_master_bus_config_t bus_cfg = {.trans_queue_depth = 4};
+    mpu6050_config_t cfg = {.dlpf_cfg = 1, .smplrt_div = 0};
+    i2c_master_bus_handle_t bus;
+    waveform_t wf;
+
+    sim_port_init(false);
+
+    // At rest, the noise makes consecutive frames differ
+    waveform_synthetic(&wf, WAVEFORM_SINE, 0, 0.0, 1.0, 1);
+    sensor = (vmpu6050_t){.addr = MPU6050_ADDR, .int_pin = -1, .wf = &wf, .noise_rms = 0.05};
+    CHECK(vmpu6050_start(&sensor, 1));
+
+    CHECK_EQ(i2c_new_master_bus(&bus_cfg, &bus), ESP_OK);
+    CHECK_EQ(mpu6050_add_device(bus, NULL, MPU6050_ADDR, &dev), ESP_OK);
+    CHECK_EQ(mpu6050_init(&dev), ESP_OK);
+    CHECK_EQ(mpu6050_config(&dev, &cfg), ESP_OK);
+    sensor_sleep(true);
+
+    test_burst_drain(false);
+    test_burst_drain(true);
+    test_frame_limit();
+    test_overflow();
+    test_partial_frame();
+
+    return check_report("test_mpu6050_fifo");
+}
@@ -0,0 +1,165 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "sample_ring.h"
+
+#include "check.h"
+
+#define RING_THREAD_SAMPLES     1000000     // Samples sent through the ring by the two-thread test
+
+static sample_ring_t ring;
+
+static telemetry_sample_t make_sample(uint32_t seq) {
+    // Every field depends on seq, so a torn or stale slot shows up
+    return (telemetry_sample_t){
+        .dev = (uint8_t)seq,
+        .seq = seq,
+        .t_us = (int64_t)seq * 1000 + 7,
+        .raw = {.ax = (int16_t)seq, .az = (int16_t)~seq},
+    };
+}
+
+static bool sample_matches(const telemetry_sample_t *s, uint32_t seq) {
+    telemetry_sample_t expected = make_sample(seq);
+
+    return s->seq == seq && s->dev == expected.dev && s->t_us == expected.t_us &&
+           s->raw.ax == expected.raw.ax && s->raw.az == expected.raw.az;
+}
+
+// --- Single Thread ---
+
+static void test_full_empty(void) {
+    telemetry_sample_t out[SAMPLE_RING_SIZE];
+    telemetry_sample_t s;
+
+    sample_ring_init(&ring);
+    CHECK_EQ(sample_ring_pop(&ring, out, SAMPLE_RING_SIZE), 0);
+
+    for (uint32_t i = 0; i < SAMPLE_RING_SIZE; i++) {
+        s = make_sample(i);
+        CHECK(sample_ring_push(&ring, &s));
+    }
+    CHECK_EQ(ring.high_water, SAMPLE_RING_SIZE);
+
+    // A full ring drops the new sample and keeps the old ones
+    s = make_sample(SAMPLE_RING_SIZE);
+    CHECK(!sample_ring_push(&ring, &s));
+    CHECK(!sample_ring_push(&ring, &s));
+    CHECK_EQ(ring.overruns, 2);
+
+    CHECK_EQ(sample_ring_pop(&ring, out, SAMPLE_RING_SIZE), SAMPLE_RING_SIZE);
+    for (uint32_t i = 0; i < SAMPLE_RING_SIZE; i++) { CHECK(sample_matches(&out[i], i)); }
+    CHECK_EQ(sample_ring_pop(&ring, out, SAMPLE_RING_SIZE), 0);
+
+    // Init clears the counters
+    sample_ring_init(&ring);
+    CHECK_EQ(ring.overruns, 0);
+    CHECK_EQ(ring.high_water, 0);
+}
+
+static void test_partial_pop(void) {
+    telemetry_sample_t out[TELEMETRY_BATCH_SIZE];
+    uint32_t next = 0;
+
+    sample_ring_init(&ring);
+    for (uint32_t i = 0; i < 40; i++) {
+        telemetry_sample_t s = make_sample(i);
+        CHECK(sample_ring_push(&ring, &s));
+    }
+
+    // Batches stop at max, the remainder stays queued in order
+    size_t n;
+    while ((n = sample_ring_pop(&ring, out, TELEMETRY_BATCH_SIZE)) > 0) {
+        CHECK(n <= TELEMETRY_BATCH_SIZE);
+        for (size_t i = 0; i < n; i++) { CHECK(sample_matches(&out[i], next++)); }
+    }
+    CHECK_EQ(next, 40);
+    CHECK_EQ(ring.high_water, 40);
+}
+
+static void test_wraparound(uint32_t start) {
+    telemetry_sample_t out[TELEMETRY_BATCH_SIZE];
+    uint32_t pushed = 0, popped = 0;
+
+    // Free-running indices close to start, e.g. just below the 32-bit wrap
+    sample_ring_init(&ring);
+    atomic_store(&ring.head, start);
+    atomic_store(&ring.tail, start);
+
+    // Keep the ring nearly full over several laps of the slots
+    while (popped < 4 * SAMPLE_RING_SIZE) {
+        while (pushed - popped < SAMPLE_RING_SIZE) {
+            telemetry_sample_t s = make_sample(pushed);
+            CHECK(sample_ring_push(&ring, &s));
+            pushed++;
+        }
+        size_t n = sample_ring_pop(&ring, out, TELEMETRY_BATCH_SIZE);
+        CHECK_EQ(n, TELEMETRY_BATCH_SIZE);
+        for (size_t i = 0; i < n; i++) { CHECK(sample_matches(&out[i], popped++)); }
+    }
+
+    CHECK_EQ(ring.overruns, 0);
+    CHECK_EQ(ring.high_water, SAMPLE_RING_SIZE);
+    CHECK_EQ(atomic_load(&ring.head) - start, pushed);
+}
+
+// --- Two Threads ---
+
+static atomic_bool producer_done;
+
+static void *producer(void *arg) {
+    (void)arg;
+
+    // Retry on a full ring so that every sample must come through, in order
+    for (uint32_t i = 0; i < RING_THREAD_SAMPLES; i++) {
+        telemetry_sample_t s = make_sample(i);
+        while (!sample_ring_push(&ring, &s)) { sched_yield(); }
+    }
+    atomic_store(&producer_done, true);
+
+    return NULL;
+}
+
+static void test_two_threads(void) {
+    telemetry_sample_t out[TELEMETRY_BATCH_SIZE];
+    uint32_t received = 0, out_of_order = 0, corrupt = 0;
+    pthread_t thread;
+
+    sample_ring_init(&ring);
+    atomic_store(&producer_done, false);
+    CHECK_EQ(pthread_create(&thread, NULL, producer, NULL), 0);
+
+    // An empty ring after the producer finished has nothing more to come
+    for (;;) {
+        bool done = atomic_load(&producer_done);
+        size_t n = sample_ring_pop(&ring, out, TELEMETRY_BATCH_SIZE);
+
+        for (size_t i = 0; i < n; i++) {
+            if (out[i].seq != received) { out_of_order++; }
+            if (!sample_matches(&out[i], out[i].seq)) { corrupt++; }
+            received++;
+        }
+
+        if (n == 0) {
+            if (done) { break; }
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+
+    CHECK_EQ(out_of_order, 0);
+    CHECK_EQ(corrupt, 0);
+    CHECK_EQ(received, RING_THREAD_SAMPLES);
+    CHECK(ring.high_water <= SAMPLE_RING_SIZE);
+}
+
+int main(void) {
+    test_full_empty();
+    test_partial_pop();
+    test_wraparound(0);
+    test_wraparound(UINT32_MAX - SAMPLE_RING_SIZE / 2);
+    test_two_threads();
+
+    return check_report("test_sample_ring");
+}
@@ -0,0 +1,120 @@
+#ifndef RTDT_CLOCK_SYNC_H
+#define RTDT_CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rtdt {
+
+// Device esp_timer to host CLOCK_MONOTONIC, from ping/echo exchanges
+//
+// Each exchange brackets a pair of device stamps (command read, reply
+// written) between the host's write of the ping and the arrival of the
+// reply. Whatever the delays in either direction, the clock offset at the
+// exchange lies within half the round trip (minus the device's
+// turnaround) of the offset between the midpoints of both sides. The
+// model fits offset and rate through the last CLOCK_SYNC_WINDOW exchanges,
+// weighted by the inverse square of their round trips: the serial link
+// adds delay, never removes it, so the fastest exchanges are the tightest.
+
+constexpr size_t CLOCK_SYNC_WINDOW = 64;            // Exchanges the model is fitted over
+constexpr double CLOCK_SYNC_RTT_FLOOR_NS = 10000.0; // Round trips are weighted as at least this (host scheduling noise)
+constexpr double CLOCK_SYNC_MAX_PPM = 500.0;        // Rate estimates beyond this are rejected
+constexpr double CLOCK_SYNC_CRYSTAL_PPM = 100.0;    // Rate difference before it is fitted: two crystals within 50 ppm each
+constexpr double CLOCK_SYNC_MIN_SPAN_NS = 1e9;      // Fitted exchanges must span this before the rate is fitted
+
+/**
+ * @brief One ping/echo exchange
+ *
+ * t1_ns:                Host CLOCK_MONOTONIC when the ping was written
+ * rx_us:                Device esp_timer when the ping line was read
+ * tx_us:                Device esp_timer when the reply was written
+ * t4_ns:                Host CLOCK_MONOTONIC when the reply was decoded
+ */
+struct SyncExchange {
+    uint64_t t1_ns;
+    uint64_t rx_us;
+    uint64_t tx_us;
+    uint64_t t4_ns;
+};
+
+/**
+ * @brief Drift-corrected offset model of the device clock
+ */
+class ClockSync {
+public:
+    /**
+     * @brief Add an exchange and refit
+     *
+     * @return false if the exchange is inconsistent and was ignored
+     */
+    bool add(const SyncExchange &exchange);
+
+    /**
+     * @brief Forget all exchanges, after a device reset
+     */
+    void reset();
+
+    bool synced() const { return n_ > 0; }
+
+    /**
+     * @brief Host time of a device timestamp
+     *
+     * @param t_us Device esp_timer time
+     * @return uint64_t Host CLOCK_MONOTONIC (ns), 0 before the first exchange
+     */
+    uint64_t to_host_ns(uint64_t t_us) const;
+
+    /**
+     * @brief Bound of the mapping error of a device timestamp (ns)
+     *
+     * At an exchange the line is off by at most half its round trip plus
+     * its deviation from the line. Away from it the bound grows by the
+     * uncertainty of the rate: the crystal tolerance until the rate is
+     * fitted, then the least that two exchanges a second or more apart
+     * allow. The smallest over the exchanges holds as long as both clocks
+     * are steady between them.
+     *
+     * @param t_us Device esp_timer time
+     */
+    double error_bound_ns(uint64_t t_us) const;
+
+    /**
+     * @brief Bound of the mapping error at the newest exchange (ns)
+     */
+    double error_bound_ns() const { return n_ ? error_bound_ns(ref_us_) : 0.0; }
+
+    /**
+     * @brief Device clock rate error relative to the host (ppm, positive = device fast)
+     */
+    double drift_ppm() const { return -slope_ * 1e6; }
+
+    double min_rtt_ns() const { return min_rtt_ns_; }
+    uint64_t exchanges() const { return exchanges_; }
+    uint64_t rejected() const { return rejected_; }
+
+private:
+    struct Point {
+        uint64_t dev_us;        // Midpoint of the device stamps
+        double offset_ns;       // Host midpoint - device midpoint
+        double rtt_ns;          // Round trip without the device turnaround
+        double err_ns;          // Bound of the line's error at dev_us, after the fit
+    };
+
+    void fit();
+
+    Point points_[CLOCK_SYNC_WINDOW];
+    size_t n_ = 0;
+    size_t next_ = 0;
+    uint64_t ref_us_ = 0;       // Device time the fitted offset refers to (the newest exchange)
+    double offset_ns_ = 0.0;    // Host - device at ref_us_
+    double slope_ = 0.0;        // Change of the offset per device ns
+    double slope_err_ = CLOCK_SYNC_CRYSTAL_PPM * 1e-6;     // Bound of the error of slope_
+    double min_rtt_ns_ = 0.0;
+    uint64_t exchanges_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+} // namespace rtdt
+
+#endif // RTDT_CLOCK_SYNC_H
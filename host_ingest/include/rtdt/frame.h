@@ -0,0 +1,160 @@
+#ifndef RTDT_FRAME_H
+#define RTDT_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rtdt {
+
+// Device framing, see esp32c6_rtdt_app/src/include/telemetry.h
+//
+// | sync (2) | type (1) | length (1) | payload (length) | crc16 (2) |
+
+constexpr uint8_t FRAME_SYNC_0 = 0xAA;
+constexpr uint8_t FRAME_SYNC_1 = 0x55;
+constexpr size_t FRAME_HEADER_SIZE = 4;
+constexpr size_t FRAME_CRC_SIZE = 2;
+constexpr size_t FRAME_MAX_PAYLOAD = 255;
+constexpr size_t FRAME_MAX_SIZE = FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE;
+
+enum FrameType : uint8_t {
+    FRAME_MOTION = 0x01,
+    FRAME_EVENT = 0x02,
+    FRAME_EVENT_DATA = 0x03,
+    FRAME_RAW = 0x04,
+    FRAME_STATE = 0x06,
+    FRAME_SYNC = 0x07,
+};
+
+#pragma pack(push, 1)
+
+/**
+ * @brief Payload of a motion frame (telemetry_motion_payload_t)
+ */
+struct MotionPayload {
+    uint8_t dev;
+    uint32_t seq;
+    uint64_t t_us;
+    float ax, ay, az;
+    float vx, vy, vz;
+    float dx, dy, dz;
+};
+
+/**
+ * @brief Header of a raw frame (telemetry_raw_header_t), followed by a raw_codec block
+ */
+struct RawHeader {
+    uint8_t dev;
+    uint8_t mode;
+    uint8_t n;
+    uint32_t seq;
+    uint64_t t_us;
+    uint32_t span_us;
+    uint8_t accel_range;
+    uint8_t gyro_range;
+};
+
+/**
+ * @brief Payload of a state frame (telemetry_state_payload_t), control mode output
+ */
+struct StatePayload {
+    uint8_t dev;
+    uint32_t period;
+    uint64_t t_us;
+    float vx, vy, vz;
+    float dx, dy, dz;
+    uint16_t misses;
+};
+
+/**
+ * @brief Payload of a sync frame (telemetry_sync_payload_t), the reply to "ping:<id>"
+ */
+struct SyncPayload {
+    uint32_t id;
+    uint64_t rx_us;
+    uint64_t tx_us;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(MotionPayload) == 49, "motion payload layout");
+static_assert(sizeof(RawHeader) == 21, "raw header layout");
+static_assert(sizeof(StatePayload) == 39, "state payload layout");
+static_assert(sizeof(SyncPayload) == 20, "sync payload layout");
+
+/**
+ * @brief One complete, CRC checked frame
+ *
+ * payload and bytes point into the decoder buffer and are only valid
+ * during the callback.
+ */
+struct Frame {
+    uint8_t type;
+    const uint8_t *payload;
+    size_t length;
+    const uint8_t *bytes;       // Whole frame including sync word and CRC
+    size_t size;
+};
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+uint16_t crc16(const uint8_t *data, size_t len);
+
+/**
+ * @brief Build a frame around a payload
+ *
+ * @param buf Output buffer, at least FRAME_MAX_SIZE bytes
+ * @param type Frame type
+ * @param payload Payload bytes
+ * @param len Payload length (at most FRAME_MAX_PAYLOAD)
+ * @return size_t Number of bytes written to buf
+ */
+size_t encode_frame(uint8_t *buf, uint8_t type, const void *payload, size_t len);
+
+/**
+ * @brief Extracts CRC checked frames from a byte stream mixed with log text
+ *
+ * Receivers resynchronize by scanning for the sync word; a CRC mismatch
+ * skips one byte and rescans.
+ */
+class FrameDecoder {
+public:
+    /**
+     * @brief Feed received bytes and call on_frame for every complete frame
+     *
+     * @param data Received bytes
+     * @param len Number of bytes
+     * @param on_frame Callable taking a const Frame &
+     */
+    template <typename F>
+    void feed(const uint8_t *data, size_t len, F &&on_frame) {
+        buffer_.insert(buffer_.end(), data, data + len);
+
+        size_t pos = 0;
+        while (next(pos)) {
+            const uint8_t *p = &buffer_[pos];
+            size_t length = p[3];
+
+            on_frame(Frame{p[2], p + FRAME_HEADER_SIZE, length, p, FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE});
+            pos += FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE;
+        }
+
+        buffer_.erase(buffer_.begin(), buffer_.begin() + pos);
+    }
+
+    uint64_t crc_errors() const { return crc_errors_; }
+    uint64_t skipped_bytes() const { return skipped_; }
+
+private:
+    bool next(size_t &pos);
+
+    std::vector<uint8_t> buffer_;
+    uint64_t crc_errors_ = 0;
+    uint64_t skipped_ = 0;           // Bytes outside of frames (log text, noise)
+};
+
+} // namespace rtdt
+
+#endif // RTDT_FRAME_H
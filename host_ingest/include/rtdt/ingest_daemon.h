@@ -0,0 +1,137 @@
+#ifndef RTDT_INGEST_DAEMON_H
+#define RTDT_INGEST_DAEMON_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rtdt/clock_sync.h"
+#include "rtdt/frame.h"
+#include "rtdt/shm_ring.h"
+
+namespace rtdt {
+
+constexpr const char *INGEST_DEFAULT_SOCKET = "/tmp/rtdt_ingest.sock";
+constexpr size_t INGEST_READ_CHUNK = 4096;          // Bytes per serial read
+constexpr size_t INGEST_CLIENT_BACKLOG = 256 * 1024; // Unsent bytes after which a socket client is dropped
+constexpr int INGEST_POLL_MS = 100;                  // Poll timeout, bounds the reaction to stop()
+constexpr uint32_t INGEST_SYNC_MS = 1000;            // Default ping period of the clock sync
+constexpr size_t INGEST_SYNC_PENDING = 4;            // Pings awaiting their reply, older ones are forgotten
+constexpr uint32_t INGEST_SYNC_DITHER_US = 1000;     // Ping period dither, one USB full speed frame
+
+/**
+ * @brief Daemon configuration
+ *
+ * device:               Serial device (or pty) of the board
+ * shm_name:             Shared memory ring name, empty to disable
+ * socket_path:          Unix socket for fallback clients, empty to disable
+ * capacity:             Shared memory ring slots (power of two)
+ * sync_ms:              Ping period of the clock sync, 0 to disable
+ */
+struct IngestOptions {
+    std::string device;
+    std::string shm_name = SHM_RING_DEFAULT_NAME;
+    std::string socket_path = INGEST_DEFAULT_SOCKET;
+    uint32_t capacity = SHM_RING_DEFAULT_CAPACITY;
+    uint32_t sync_ms = INGEST_SYNC_MS;
+};
+
+/**
+ * @brief Counters, written by the daemon thread only
+ */
+struct IngestStats {
+    std::atomic<uint64_t> bytes{0};         // Bytes read from the device
+    std::atomic<uint64_t> frames{0};        // Valid frames
+    std::atomic<uint64_t> samples{0};       // Samples published to the ring
+    std::atomic<uint64_t> crc_errors{0};
+    std::atomic<uint64_t> bad_frames{0};    // Valid CRC but undecodable payload
+    std::atomic<uint64_t> clients{0};       // Socket clients accepted
+    std::atomic<uint64_t> dropped_clients{0};
+    std::atomic<uint64_t> pings{0};         // Clock sync pings written
+    std::atomic<uint64_t> syncs{0};         // Replies fed to the clock model
+};
+
+/**
+ * @brief Owns the device, decodes its stream and fans the samples out
+ *
+ * Samples from motion and raw frames go into the shared memory ring,
+ * mapped to host time by a clock model fed with periodic pings.
+ * Socket clients receive every valid frame as is (log text removed), so
+ * the existing frame decoders work on the socket unchanged, and may send
+ * command lines, which are forwarded to the device.
+ */
+class IngestDaemon {
+public:
+    explicit IngestDaemon(IngestOptions options);
+    ~IngestDaemon();
+    IngestDaemon(const IngestDaemon &) = delete;
+    IngestDaemon &operator=(const IngestDaemon &) = delete;
+
+    /**
+     * @brief Open the device and create the ring and the socket
+     *
+     * @return 0 on success, otherwise an errno value (the failing step is logged)
+     */
+    int open();
+
+    /**
+     * @brief Serve until stop() is called or the device goes away
+     *
+     * @return 0 after stop(), otherwise the errno value of the device error
+     */
+    int run();
+
+    void stop() { stop_.store(true, std::memory_order_relaxed); }
+
+    const IngestStats &stats() const { return stats_; }
+
+    /**
+     * @brief Clock model, only consistent once run() has returned
+     */
+    const ClockSync &clock() const { return clock_; }
+
+private:
+    struct Client {
+        int fd;
+        std::string out;        // Frames not yet accepted by the socket
+        std::string in;         // Partial command line
+    };
+
+    struct Ping {
+        uint32_t id;
+        uint64_t t1_ns;
+    };
+
+    void on_frame(const Frame &frame, uint64_t rx_ns);
+    void on_sync(const SyncPayload &sync, uint64_t rx_ns);
+    void map_time(Sample &sample) const;
+    void send_ping();
+    void broadcast(const uint8_t *data, size_t len);
+    void flush_client(Client &client);
+    void accept_clients();
+    bool serve_client(Client &client);
+
+    IngestOptions options_;
+    int device_fd_ = -1;
+    int listen_fd_ = -1;
+    ShmWriter ring_;
+    bool ring_enabled_ = false;
+    FrameDecoder decoder_;
+    std::vector<Client> clients_;
+    IngestStats stats_;
+    ClockSync clock_;
+    Ping pings_[INGEST_SYNC_PENDING] = {};
+    uint32_t ping_id_ = 0;
+    uint64_t next_ping_ns_ = 0;
+    std::atomic<bool> stop_{false};
+};
+
+/**
+ * @brief CLOCK_MONOTONIC in nanoseconds, the time base of Sample::rx_ns
+ */
+uint64_t monotonic_ns();
+
+} // namespace rtdt
+
+#endif // RTDT_INGEST_DAEMON_H
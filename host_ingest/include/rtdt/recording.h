@@ -0,0 +1,138 @@
+#ifndef RTDT_RECORDING_H
+#define RTDT_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rtdt {
+
+// Recording format written by disp_monitor_ui/rtdt_rec.py: a HEADER_SIZE
+// file header (magic, version, JSON metadata) followed by chunks of one
+// stream each, stored column by column with every column 8-byte aligned.
+
+constexpr char RECORDING_MAGIC[8] = {'R', 'T', 'D', 'T', 'R', 'E', 'C', '1'};
+constexpr uint32_t RECORDING_VERSION = 2;                // 1 (no raw range columns) is still read
+constexpr size_t RECORDING_HEADER_SIZE = 4096;
+constexpr size_t RECORDING_ALIGN = 8;
+
+/**
+ * @brief Streams stored in a recording
+ *
+ * STREAM_MOTION:        Motion frames, float columns ax..az, vx..vz, dx..dz
+ * STREAM_RAW:           Raw stream, int16 columns accel X..Z, gyro X..Z counts, then
+ *                       uint8 columns of the accel and gyro range codes they were
+ *                       measured at (version 2)
+ */
+enum RecordingStream : uint8_t {
+    STREAM_MOTION = 1,
+    STREAM_RAW = 2,
+};
+
+#pragma pack(push, 1)
+
+/**
+ * @brief On-disk chunk header (32 bytes)
+ */
+struct ChunkHeader {
+    char magic[4];              // "CHNK"
+    uint8_t stream;             // RecordingStream
+    uint8_t reserved0;
+    uint16_t n;                 // Samples in the chunk
+    uint32_t size;              // Column data bytes following the header
+    int64_t t_min_us;
+    int64_t t_max_us;
+    uint32_t reserved1;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(ChunkHeader) == 32, "chunk header layout is part of the file format");
+
+/**
+ * @brief A chunk of a mapped recording, columns point into the mapping
+ */
+struct Chunk {
+    uint8_t stream;
+    uint32_t n;
+    int64_t t_min_us;
+    int64_t t_max_us;
+    const int64_t *t_us;
+    const uint32_t *seq;
+    const uint8_t *dev;
+    const int16_t *raw[6];      // STREAM_RAW only
+    const uint8_t *accel_range; // STREAM_RAW only, null in version 1 recordings
+    const uint8_t *gyro_range;  // STREAM_RAW only, null in version 1 recordings
+    const float *motion[9];     // STREAM_MOTION only
+};
+
+/**
+ * @brief Sensor configuration and calibration from the recording's info frames
+ */
+struct SensorInfo {
+    float bias[6];              // ax, ay, az (m/s²), gx, gy, gz (°/s)
+    float sample_rate_hz;
+    uint32_t update_rate_ms;
+    int accel_range;            // AFS_SEL 0..3 (±2..16 g), -1 if the info frame does not say
+};
+
+/**
+ * @brief Memory mapped, read only view of a recording
+ */
+class Recording {
+public:
+    Recording() = default;
+    ~Recording();
+    Recording(const Recording &) = delete;
+    Recording &operator=(const Recording &) = delete;
+
+    /**
+     * @brief Map a recording and index its chunks
+     *
+     * An incomplete last chunk (interrupted recording) is left out and
+     * counted in truncated().
+     *
+     * @param path File name
+     * @return 0 on success, otherwise an errno value (EPROTO if the file is not a recording)
+     */
+    int open(const std::string &path);
+
+    const std::string &path() const { return path_; }
+    uint32_t version() const { return version_; }
+    const std::string &metadata() const { return metadata_; }
+    const std::vector<Chunk> &chunks() const { return chunks_; }
+    size_t truncated() const { return truncated_; }
+
+    /**
+     * @brief Sensor indices present in a stream, ascending
+     */
+    std::vector<uint8_t> devices(uint8_t stream) const;
+
+    /**
+     * @brief Number of samples of one sensor in a stream
+     */
+    uint64_t count(uint8_t stream, uint8_t dev) const;
+
+    /**
+     * @brief Look up a sensor's info in the metadata
+     *
+     * @param dev Sensor index
+     * @param info Output
+     * @return false if the recording holds no info frame for the sensor
+     */
+    bool sensor_info(uint8_t dev, SensorInfo *info) const;
+
+private:
+    std::string path_;
+    uint32_t version_ = 0;
+    std::string metadata_;
+    std::vector<Chunk> chunks_;
+    const uint8_t *map_ = nullptr;
+    size_t size_ = 0;
+    size_t truncated_ = 0;
+};
+
+} // namespace rtdt
+
+#endif // RTDT_RECORDING_H
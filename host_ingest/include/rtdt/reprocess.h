@@ -0,0 +1,183 @@
+#ifndef RTDT_REPROCESS_H
+#define RTDT_REPROCESS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rtdt/recording.h"
+
+namespace rtdt {
+
+// Offline reprocessing of the raw stream of recordings with the firmware's
+// float motion pipeline (mpu6050_raw_to_data + process_accel_data), for
+// many parameter sets at once.
+//
+// The integration is a recurrence in time, so a single stream cannot be
+// split across SIMD lanes or threads. Parameter sets can: the kernel runs
+// REPROCESS_LANES of them side by side on every sample (one SIMD lane
+// each, branch free), and the jobs (stream x block of parameter sets) are
+// spread over the worker threads. The arithmetic is the firmware's,
+// operation for operation in float32 without contraction, so a lane with
+// the firmware's parameters reproduces the device bit for bit.
+
+constexpr size_t REPROCESS_LANES = 16;                  // Parameter sets per kernel pass
+constexpr float REPROCESS_ACCEL_SCALE = 9.80665f / 16384.0f; // ACCEL_SCALE in mpu6050.h, ±2 g
+constexpr uint32_t REPROCESS_MAX_DT_US = 1000000;       // Longer gaps are a paused stream, integrated as one nominal step
+
+/**
+ * @brief m/s² per count at an accelerometer range, mpu6050_accel_scale[accel_range]
+ *
+ * @param accel_range AFS_SEL 0..3 (±2..16 g)
+ */
+constexpr float reprocess_accel_scale(int accel_range) {
+    return REPROCESS_ACCEL_SCALE * static_cast<float>(1 << accel_range);
+}
+
+/**
+ * @brief Tunable parameters of process_accel_data
+ *
+ * noise_floor:          accel_noise_floor, smaller accelerations are zeroed (m/s²)
+ * stationary:           MOTION_STATIONARY_THRESHOLD, stillness threshold (m/s²)
+ * hold_cycles:          MOTION_HOLD_CYCLES, still samples before the velocity is zeroed
+ */
+struct MotionParams {
+    float noise_floor;
+    float stationary;
+    int32_t hold_cycles;
+};
+
+/**
+ * @brief Outcome of one parameter set on one stream
+ *
+ * samples:              Samples processed
+ * held:                 Samples with the velocity held at zero, per axis
+ * peak_v, peak_d:       Largest |velocity| (m/s) and |displacement| (m) per axis
+ * final_d:              Displacement after the last sample (m), the drift if the stream ends at rest
+ */
+struct MotionSummary {
+    uint64_t samples;
+    uint64_t held[3];
+    float peak_v[3];
+    float peak_d[3];
+    float final_d[3];
+};
+
+/**
+ * @brief One sensor's raw stream in a recording
+ *
+ * recording:            Mapped recording
+ * dev:                  Sensor index
+ * accel_range:          AFS_SEL 0..3 of samples recorded without their range (version 1),
+ *                       later recordings carry it per sample
+ * bias:                 Accelerometer calibration bias (m/s²)
+ * nominal_dt_us:        Time step of the first sample and after gaps
+ */
+struct ReprocessInput {
+    const Recording *recording;
+    uint8_t dev;
+    int accel_range;
+    float bias[3];
+    uint32_t nominal_dt_us;
+};
+
+/**
+ * @brief Work done by a reprocess() call
+ *
+ * evaluations:          Samples x parameter sets
+ * wall_s:               Elapsed time
+ * cpu_s:                CPU time summed over the worker threads
+ * threads:              Worker threads used
+ */
+struct ReprocessStats {
+    uint64_t evaluations;
+    double wall_s;
+    double cpu_s;
+    unsigned threads;
+};
+
+/**
+ * @brief Vectorized process_accel_data state of REPROCESS_LANES parameter sets
+ *
+ * Structure of arrays, one element per lane. Unused lanes repeat the first
+ * parameter set and are not reported.
+ */
+class MotionBatch {
+public:
+    /**
+     * @param params Parameter sets
+     * @param n Number of parameter sets, 1..REPROCESS_LANES
+     */
+    MotionBatch(const MotionParams *params, size_t n);
+
+    /**
+     * @brief Process a block of samples with every parameter set
+     *
+     * @param a Bias compensated acceleration per axis (m/s²)
+     * @param dt Time step per sample (s)
+     * @param n Number of samples
+     */
+    void run(const float *const a[3], const float *dt, size_t n);
+
+    MotionSummary summary(size_t lane) const;
+    size_t lanes() const { return lanes_; }
+
+private:
+    alignas(64) float noise_floor_[REPROCESS_LANES];
+    alignas(64) float stationary_[REPROCESS_LANES];
+    alignas(64) int32_t hold_cycles_[REPROCESS_LANES];
+    alignas(64) float v_[3][REPROCESS_LANES];
+    alignas(64) float d_[3][REPROCESS_LANES];
+    alignas(64) int32_t still_count_[3][REPROCESS_LANES];
+    alignas(64) float peak_v_[3][REPROCESS_LANES];
+    alignas(64) float peak_d_[3][REPROCESS_LANES];
+    uint64_t held_[3][REPROCESS_LANES];
+    uint64_t samples_ = 0;
+    size_t lanes_;
+};
+
+/**
+ * @brief Reprocess every input with every parameter set
+ *
+ * @param inputs Sensor streams
+ * @param params Parameter sets
+ * @param threads Worker threads (0 = one per CPU)
+ * @param stats Output work and timing, may be null
+ * @return Summaries, input i with parameter set p at i * params.size() + p
+ */
+std::vector<MotionSummary> reprocess(const std::vector<ReprocessInput> &inputs, const std::vector<MotionParams> &params,
+                                     unsigned threads, ReprocessStats *stats);
+
+/**
+ * @brief Reprocess one input sample by sample with the firmware's process_accel_data
+ *
+ * The reference for reprocess(): it calls the firmware source, so it only
+ * varies the noise floor; the stillness threshold and hold cycles are the
+ * compiled-in reference_params() values.
+ *
+ * @param input Sensor stream
+ * @param noise_floor accel_noise_floor (m/s²)
+ * @return Summary, comparable to the one of reprocess() with reference_params()
+ */
+MotionSummary reprocess_reference(const ReprocessInput &input, float noise_floor);
+
+/**
+ * @brief Reprocess one input sample by sample with the firmware's Kalman estimator
+ *
+ * Gains are solved for the input's nominal time step and the bias estimate
+ * starts from its calibration, as with set_drift:kalman. held counts the
+ * samples with a zero-velocity update.
+ *
+ * @param input Sensor stream
+ * @return Summary, comparable to the one of reprocess_reference()
+ */
+MotionSummary reprocess_kalman(const ReprocessInput &input);
+
+/**
+ * @brief The firmware's parameters with a given noise floor
+ */
+MotionParams reference_params(float noise_floor);
+
+} // namespace rtdt
+
+#endif // RTDT_REPROCESS_H
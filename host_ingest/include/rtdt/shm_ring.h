@@ -0,0 +1,178 @@
+#ifndef RTDT_SHM_RING_H
+#define RTDT_SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rtdt {
+
+constexpr uint32_t SHM_RING_MAGIC = 0x52544454;     // "RTDT"
+constexpr uint32_t SHM_RING_VERSION = 2;
+constexpr uint32_t SHM_RING_DEFAULT_CAPACITY = 8192; // Slots, must be a power of two (8 s of 1 kHz data)
+constexpr const char *SHM_RING_DEFAULT_NAME = "/rtdt_ingest";
+
+/**
+ * @brief Sample kinds
+ *
+ * SAMPLE_MOTION:        Motion frame, `motion` holds ax..az, vx..vz, dx..dz
+ * SAMPLE_RAW:           Raw stream sample, `raw` holds accel X..Z, gyro X..Z counts,
+ *                       `reserved` the range codes they were measured at, accel in
+ *                       the low byte and gyro in the high byte
+ * SAMPLE_STATE:         Control mode state frame, `motion` as SAMPLE_MOTION with zero
+ *                       acceleration, `seq` is the control period, `reserved` the
+ *                       device's deadline miss count
+ */
+enum SampleKind : uint8_t {
+    SAMPLE_MOTION = 1,
+    SAMPLE_RAW = 2,
+    SAMPLE_STATE = 3,
+};
+
+/**
+ * @brief Decoded sample as published in the ring (72 bytes)
+ */
+struct Sample {
+    uint64_t rx_ns;             // Host CLOCK_MONOTONIC when the frame was decoded
+    uint64_t t_us;              // Device timestamp
+    uint64_t host_ns;           // Device timestamp mapped to CLOCK_MONOTONIC by the clock sync, 0 before it
+    uint32_t seq;               // Device sequence number (per sensor)
+    uint8_t dev;                // Sensor index
+    uint8_t kind;               // SampleKind
+    uint16_t reserved;
+    union {
+        float motion[9];
+        int16_t raw[6];
+    };
+    uint32_t host_err_ns;       // Error bound of host_ns (saturating), 0 before the clock sync
+};
+
+static_assert(sizeof(Sample) == 72, "sample layout is part of the shared memory ABI");
+
+/**
+ * @brief Shared memory layout: a header followed by `capacity` slots
+ *
+ * One writer, any number of readers, nobody waits for anybody: the writer
+ * overwrites the oldest slot and readers that fall behind by more than the
+ * capacity lose samples (and know how many).
+ *
+ * Every slot carries a sequence word: odd while the writer fills the slot,
+ * 2 * (index + 1) once sample `index` is complete. A reader copies the
+ * slot between two loads of the word and retries nothing: if the word
+ * changed, the sample was overwritten and counts as lost.
+ */
+struct ShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slot_size;
+    std::atomic<uint64_t> head;         // Number of samples published
+    std::atomic<uint32_t> notify;       // Futex word, bumped after every published batch
+    std::atomic<uint32_t> waiters;      // Readers blocked on `notify`
+    std::atomic<uint32_t> writer_pid;   // 0 once the writer has gone away
+    uint32_t reserved[7];
+};
+
+struct ShmSlot {
+    std::atomic<uint64_t> seq;
+    Sample sample;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory atomics must be lock free");
+static_assert(sizeof(ShmHeader) == 64, "header layout is part of the shared memory ABI");
+
+/**
+ * @brief Creates the ring and publishes samples into it (single writer)
+ */
+class ShmWriter {
+public:
+    ShmWriter() = default;
+    ~ShmWriter();
+    ShmWriter(const ShmWriter &) = delete;
+    ShmWriter &operator=(const ShmWriter &) = delete;
+
+    /**
+     * @brief Create (or replace) the shared memory object
+     *
+     * @param name POSIX shared memory name ("/...")
+     * @param capacity Number of slots, power of two
+     * @return 0 on success, otherwise an errno value
+     */
+    int create(const std::string &name, uint32_t capacity = SHM_RING_DEFAULT_CAPACITY);
+
+    /**
+     * @brief Publish one sample, readers see it after the next notify()
+     */
+    void publish(const Sample &sample);
+
+    /**
+     * @brief Wake readers blocked in ShmReader::wait
+     */
+    void notify();
+
+    uint64_t published() const { return header_ ? header_->head.load(std::memory_order_relaxed) : 0; }
+
+private:
+    std::string name_;
+    ShmHeader *header_ = nullptr;
+    ShmSlot *slots_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Attaches to a ring and reads samples from it
+ *
+ * Each reader has its own position, readers do not affect each other or
+ * the writer.
+ */
+class ShmReader {
+public:
+    ShmReader() = default;
+    ~ShmReader();
+    ShmReader(const ShmReader &) = delete;
+    ShmReader &operator=(const ShmReader &) = delete;
+
+    /**
+     * @brief Map the ring, reading starts with the next published sample
+     *
+     * @param name POSIX shared memory name
+     * @return 0 on success, otherwise an errno value (EPROTO for a foreign layout)
+     */
+    int attach(const std::string &name);
+
+    /**
+     * @brief Copy up to max samples, oldest first
+     *
+     * @param out Output samples
+     * @param max Capacity of out
+     * @return size_t Number of samples copied
+     */
+    size_t read(Sample *out, size_t max);
+
+    /**
+     * @brief Block until new samples are published or the timeout expires
+     *
+     * @param timeout_ms Timeout in milliseconds
+     * @return true if samples are available
+     */
+    bool wait(int timeout_ms);
+
+    /**
+     * @brief Whether the writer process is still publishing
+     */
+    bool writer_alive() const;
+
+    uint64_t lost() const { return lost_; }
+
+private:
+    ShmHeader *header_ = nullptr;
+    ShmSlot *slots_ = nullptr;
+    size_t size_ = 0;
+    uint64_t next_ = 0;
+    uint64_t lost_ = 0;
+};
+
+} // namespace rtdt
+
+#endif // RTDT_SHM_RING_H
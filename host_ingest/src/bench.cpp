@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "rtdt/ingest_daemon.h"
+
+// Latency from the first byte of a frame written to a pty (standing in for
+// the board) to the sample being available in each consumer path.
+
+struct BenchOptions {
+    uint32_t samples = 20000;
+    uint32_t rate_hz = 1000;        // 0 = write as fast as the pty takes it
+    uint32_t batch = 1;             // Frames per write, the firmware writes up to 16
+};
+
+struct Latencies {
+    std::vector<uint64_t> ns;
+    uint64_t received = 0;
+
+    void add(uint64_t value) {
+        ns.push_back(value);
+        received++;
+    }
+
+    void report(const char *name, uint32_t expected) {
+        if (ns.empty()) {
+            printf("%-16s n=0\n", name);
+            return;
+        }
+        std::sort(ns.begin(), ns.end());
+        auto pct = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))] / 1000.0; };
+        printf("%-16s n=%-6llu lost=%-5llu p50=%7.1f us p99=%7.1f us p99.9=%7.1f us max=%7.1f us\n", name,
+               (unsigned long long)received, (unsigned long long)(expected - std::min<uint64_t>(received, expected)),
+               pct(0.50), pct(0.99), pct(0.999), ns.back() / 1000.0);
+    }
+};
+
+static std::vector<std::atomic<uint64_t>> *sent_ns;
+
+static uint64_t sent_time(uint32_t seq) {
+    return (*sent_ns)[seq].load(std::memory_order_acquire);
+}
+
+static void shm_consumer(const std::string &name, uint32_t expected, Latencies *rx, Latencies *end_to_end,
+                         std::atomic<bool> *done) {
+    rtdt::ShmReader reader;
+    if (reader.attach(name) != 0) { return; }
+
+    rtdt::Sample samples[64];
+    while (!done->load(std::memory_order_relaxed) && end_to_end->received < expected) {
+        if (!reader.wait(50)) { continue; }
+
+        size_t n = reader.read(samples, 64);
+        uint64_t now = rtdt::monotonic_ns();
+        for (size_t i = 0; i < n; i++) {
+            uint64_t sent = sent_time(samples[i].seq);
+            rx->add(samples[i].rx_ns - sent);
+            end_to_end->add(now - sent);
+        }
+    }
+}
+
+static void socket_consumer(const std::string &path, uint32_t expected, Latencies *lat, std::atomic<bool> *done) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return;
+    }
+
+    struct timeval tv = {0, 50000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    rtdt::FrameDecoder decoder;
+    uint8_t buf[4096];
+    while (!done->load(std::memory_order_relaxed) && lat->received < expected) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) { continue; }
+
+        uint64_t now = rtdt::monotonic_ns();
+        decoder.feed(buf, n, [&](const rtdt::Frame &frame) {
+            if (frame.type != rtdt::FRAME_MOTION || frame.length != sizeof(rtdt::MotionPayload)) { return; }
+            rtdt::MotionPayload motion;
+            memcpy(&motion, frame.payload, sizeof(motion));
+            lat->add(now - sent_time(motion.seq));
+        });
+    }
+    close(fd);
+}
+
+static int open_pty(std::string *slave) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) { return -1; }
+
+    *slave = ptsname(master);
+
+    // Keep the master side raw too, the daemon configures the slave side
+    struct termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    return master;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        uint32_t value = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 0));
+        if (strcmp(argv[i], "--samples") == 0) {
+            options.samples = value;
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.rate_hz = value;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            options.batch = std::max<uint32_t>(value, 1);
+        } else {
+            fprintf(stderr, "usage: %s [--samples n] [--rate hz (0 = unpaced)] [--batch frames]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::string slave;
+    int master = open_pty(&slave);
+    if (master < 0) {
+        perror("rtdt_ingest_bench: pty");
+        return 1;
+    }
+
+    rtdt::IngestOptions ingest;
+    ingest.device = slave;
+    ingest.shm_name = "/rtdt_ingest_bench_" + std::to_string(getpid());
+    ingest.socket_path = "/tmp/rtdt_ingest_bench_" + std::to_string(getpid()) + ".sock";
+
+    rtdt::IngestDaemon daemon(ingest);
+    if (daemon.open() != 0) { return 1; }
+
+    std::vector<std::atomic<uint64_t>> sent(options.samples);
+    sent_ns = &sent;
+
+    Latencies daemon_rx, shm_rx, socket_rx;
+    std::atomic<bool> done{false};
+
+    std::thread daemon_thread([&] { daemon.run(); });
+    std::thread shm_thread(shm_consumer, ingest.shm_name, options.samples, &daemon_rx, &shm_rx, &done);
+    std::thread socket_thread(socket_consumer, ingest.socket_path, options.samples, &socket_rx, &done);
+
+    // Let the socket client connect before the first frame
+    usleep(100000);
+
+    std::vector<uint8_t> out(options.batch * rtdt::FRAME_MAX_SIZE);
+    uint64_t period_ns = options.rate_hz ? 1000000000ull * options.batch / options.rate_hz : 0;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    uint64_t start = rtdt::monotonic_ns();
+    for (uint32_t seq = 0; seq < options.samples;) {
+        size_t len = 0;
+        uint32_t first = seq;
+
+        for (uint32_t j = 0; j < options.batch && seq < options.samples; j++, seq++) {
+            rtdt::MotionPayload motion = {};
+            motion.seq = seq;
+            motion.t_us = seq * 1000ull;
+            motion.az = 9.81f;
+            len += rtdt::encode_frame(&out[len], rtdt::FRAME_MOTION, &motion, sizeof(motion));
+        }
+
+        uint64_t now = rtdt::monotonic_ns();
+        for (uint32_t s = first; s < seq; s++) { sent[s].store(now, std::memory_order_release); }
+
+        for (size_t off = 0; off < len;) {
+            ssize_t n = write(master, &out[off], len - off);
+            if (n < 0 && errno != EINTR) {
+                perror("rtdt_ingest_bench: write");
+                return 1;
+            }
+            if (n > 0) { off += n; }
+        }
+
+        if (period_ns) {
+            next.tv_nsec += period_ns;
+            while (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+    }
+    double elapsed_s = (rtdt::monotonic_ns() - start) / 1e9;
+
+    // Give the consumers a moment to drain, then stop everything
+    for (int i = 0; i < 100 && (shm_rx.received < options.samples || socket_rx.received < options.samples); i++) {
+        usleep(10000);
+    }
+    done.store(true);
+    daemon.stop();
+    shm_thread.join();
+    socket_thread.join();
+    daemon_thread.join();
+    close(master);
+
+    printf("%u samples, %u frames per write, %.0f samples/s offered (%s)\n", options.samples, options.batch,
+           options.samples / elapsed_s, options.rate_hz ? "paced" : "unpaced");
+    daemon_rx.report("pty -> daemon", options.samples);
+    shm_rx.report("pty -> shm", options.samples);
+    socket_rx.report("pty -> socket", options.samples);
+    printf("daemon: frames=%llu crc_errors=%llu\n", (unsigned long long)daemon.stats().frames.load(),
+           (unsigned long long)daemon.stats().crc_errors.load());
+
+    return 0;
+}
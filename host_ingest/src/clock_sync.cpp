@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+
+#include "rtdt/clock_sync.h"
+
+namespace rtdt {
+
+bool ClockSync::add(const SyncExchange &exchange) {
+    if (exchange.t4_ns < exchange.t1_ns || exchange.tx_us < exchange.rx_us) {
+        rejected_++;
+        return false;
+    }
+
+    // The device clock restarts with the device
+    if (n_ > 0 && exchange.rx_us < points_[(next_ + CLOCK_SYNC_WINDOW - 1) % CLOCK_SYNC_WINDOW].dev_us) { reset(); }
+
+    double turnaround_ns = (exchange.tx_us - exchange.rx_us) * 1000.0;
+    double rtt_ns = static_cast<double>(exchange.t4_ns - exchange.t1_ns) - turnaround_ns;
+    uint64_t dev_us = exchange.rx_us + (exchange.tx_us - exchange.rx_us) / 2;
+    double host_ns = exchange.t1_ns + (exchange.t4_ns - exchange.t1_ns) / 2.0;
+
+    // Rate errors make the turnaround look longer than the round trip on fast links
+    points_[next_] = Point{dev_us, host_ns - dev_us * 1000.0, rtt_ns > 0.0 ? rtt_ns : 0.0, 0.0};
+    next_ = (next_ + 1) % CLOCK_SYNC_WINDOW;
+    if (n_ < CLOCK_SYNC_WINDOW) { n_++; }
+    exchanges_++;
+
+    fit();
+
+    return true;
+}
+
+void ClockSync::reset() {
+    n_ = 0;
+    next_ = 0;
+    slope_ = 0.0;
+    slope_err_ = CLOCK_SYNC_CRYSTAL_PPM * 1e-6;
+}
+
+void ClockSync::fit() {
+    // Weighted least squares, device time relative to the newest exchange
+    ref_us_ = points_[(next_ + CLOCK_SYNC_WINDOW - 1) % CLOCK_SYNC_WINDOW].dev_us;
+    double sw = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, x_min = 0.0;
+    min_rtt_ns_ = points_[0].rtt_ns;
+    for (size_t i = 0; i < n_; i++) {
+        const Point &p = points_[i];
+        double x = (static_cast<double>(p.dev_us) - static_cast<double>(ref_us_)) * 1000.0;
+        double rtt = std::max(p.rtt_ns, CLOCK_SYNC_RTT_FLOOR_NS);
+        double w = 1.0 / (rtt * rtt);
+        sw += w;
+        sx += w * x;
+        sy += w * p.offset_ns;
+        sxx += w * x * x;
+        sxy += w * x * p.offset_ns;
+        x_min = std::min(x_min, x);
+        min_rtt_ns_ = std::min(min_rtt_ns_, p.rtt_ns);
+    }
+
+    // Too short a span for the rate: keep the previous one, fit the offset only
+    bool rate_fitted = false;
+    if (n_ >= 2 && -x_min >= CLOCK_SYNC_MIN_SPAN_NS) {
+        double slope = (sw * sxy - sx * sy) / (sw * sxx - sx * sx);
+        if (std::fabs(slope) <= CLOCK_SYNC_MAX_PPM * 1e-6) {
+            slope_ = slope;
+            rate_fitted = true;
+        }
+    }
+    offset_ns_ = (sy - slope_ * sx) / sw;
+
+    // The true offset is within half the round trip of an exchange's
+    for (size_t i = 0; i < n_; i++) {
+        Point &p = points_[i];
+        double x = (static_cast<double>(p.dev_us) - static_cast<double>(ref_us_)) * 1000.0;
+        p.err_ns = p.rtt_ns / 2.0 + std::fabs(p.offset_ns - offset_ns_ - slope_ * x);
+    }
+
+    // Line and clock can differ in rate by no more than any two exchanges allow
+    slope_err_ = CLOCK_SYNC_CRYSTAL_PPM * 1e-6;
+    if (!rate_fitted) { return; }
+    for (size_t i = 0; i < n_; i++) {
+        for (size_t j = 0; j < n_; j++) {
+            double span_ns = (static_cast<double>(points_[j].dev_us) - static_cast<double>(points_[i].dev_us)) * 1000.0;
+            if (span_ns < CLOCK_SYNC_MIN_SPAN_NS) { continue; }
+            slope_err_ = std::min(slope_err_, (points_[i].err_ns + points_[j].err_ns) / span_ns);
+        }
+    }
+}
+
+double ClockSync::error_bound_ns(uint64_t t_us) const {
+    double bound = 0.0;
+
+    for (size_t i = 0; i < n_; i++) {
+        double distance_ns = std::fabs(static_cast<double>(t_us) - static_cast<double>(points_[i].dev_us)) * 1000.0;
+        double at = points_[i].err_ns + slope_err_ * distance_ns;
+        bound = i == 0 ? at : std::min(bound, at);
+    }
+
+    return bound;
+}
+
+uint64_t ClockSync::to_host_ns(uint64_t t_us) const {
+    if (n_ == 0) { return 0; }
+
+    double x = (static_cast<double>(t_us) - static_cast<double>(ref_us_)) * 1000.0;
+    int64_t offset = std::llround(offset_ns_ + slope_ * x);
+
+    return static_cast<uint64_t>(static_cast<int64_t>(t_us * 1000) + offset);
+}
+
+} // namespace rtdt
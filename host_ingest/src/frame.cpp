@@ -0,0 +1,73 @@
+#include <cstring>
+
+#include "rtdt/frame.h"
+
+namespace rtdt {
+
+uint16_t crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+size_t encode_frame(uint8_t *buf, uint8_t type, const void *payload, size_t len) {
+    buf[0] = FRAME_SYNC_0;
+    buf[1] = FRAME_SYNC_1;
+    buf[2] = type;
+    buf[3] = static_cast<uint8_t>(len);
+    memcpy(&buf[FRAME_HEADER_SIZE], payload, len);
+
+    uint16_t crc = crc16(&buf[2], 2 + len);
+    buf[FRAME_HEADER_SIZE + len]     = crc & 0xFF;
+    buf[FRAME_HEADER_SIZE + len + 1] = crc >> 8;
+
+    return FRAME_HEADER_SIZE + len + FRAME_CRC_SIZE;
+}
+
+bool FrameDecoder::next(size_t &pos) {
+    const size_t end = buffer_.size();
+
+    while (pos < end) {
+        // Scan for the sync word
+        const uint8_t *start = static_cast<const uint8_t *>(memchr(&buffer_[pos], FRAME_SYNC_0, end - pos));
+        size_t sync = start ? static_cast<size_t>(start - buffer_.data()) : end;
+        skipped_ += sync - pos;
+        pos = sync;
+
+        if (end - pos < FRAME_HEADER_SIZE) {
+            // Keep a partial header (or a trailing sync byte) for the next read
+            return false;
+        }
+        if (buffer_[pos + 1] != FRAME_SYNC_1) {
+            pos++;
+            skipped_++;
+            continue;
+        }
+
+        size_t length = buffer_[pos + 3];
+        size_t size = FRAME_HEADER_SIZE + length + FRAME_CRC_SIZE;
+        if (end - pos < size) { return false; }
+
+        uint16_t crc = buffer_[pos + size - 2] | (buffer_[pos + size - 1] << 8);
+        if (crc16(&buffer_[pos + 2], 2 + length) != crc) {
+            // False sync or corrupted frame: skip the sync byte and rescan
+            crc_errors_++;
+            pos++;
+            skipped_++;
+            continue;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace rtdt
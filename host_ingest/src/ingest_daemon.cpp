@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+extern "C" {
+#include "raw_codec.h"
+}
+
+#include "rtdt/ingest_daemon.h"
+
+namespace rtdt {
+
+uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static int open_device(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) { return -errno; }
+
+    // Raw bytes: no line discipline, no echo, no CR/LF translation
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);      // Ignored by the USB-Serial-JTAG console, needed by UART bridges
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    return fd;
+}
+
+static int open_socket(const std::string &path) {
+    struct sockaddr_un addr = {};
+    if (path.size() >= sizeof(addr.sun_path)) { return -ENAMETOOLONG; }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) { return -errno; }
+
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+
+    return fd;
+}
+
+IngestDaemon::IngestDaemon(IngestOptions options) : options_(std::move(options)) {}
+
+IngestDaemon::~IngestDaemon() {
+    for (Client &client : clients_) { close(client.fd); }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(options_.socket_path.c_str());
+    }
+    if (device_fd_ >= 0) { close(device_fd_); }
+}
+
+int IngestDaemon::open() {
+    device_fd_ = open_device(options_.device);
+    if (device_fd_ < 0) {
+        fprintf(stderr, "rtdt_ingest: %s: %s\n", options_.device.c_str(), strerror(-device_fd_));
+        return -device_fd_;
+    }
+
+    if (!options_.shm_name.empty()) {
+        int res = ring_.create(options_.shm_name, options_.capacity);
+        if (res != 0) {
+            fprintf(stderr, "rtdt_ingest: shared memory %s: %s\n", options_.shm_name.c_str(), strerror(res));
+            return res;
+        }
+        ring_enabled_ = true;
+    }
+
+    if (!options_.socket_path.empty()) {
+        listen_fd_ = open_socket(options_.socket_path);
+        if (listen_fd_ < 0) {
+            fprintf(stderr, "rtdt_ingest: socket %s: %s\n", options_.socket_path.c_str(), strerror(-listen_fd_));
+            return -listen_fd_;
+        }
+    }
+
+    return 0;
+}
+
+void IngestDaemon::send_ping() {
+    char line[32];
+    Ping &ping = pings_[++ping_id_ % INGEST_SYNC_PENDING];
+    int len = snprintf(line, sizeof(line), "ping:%u\n", ping_id_);
+
+    ping.id = ping_id_;
+    ping.t1_ns = monotonic_ns();
+    if (write(device_fd_, line, len) != len) {
+        ping.id = 0;
+        return;
+    }
+    stats_.pings.fetch_add(1, std::memory_order_relaxed);
+}
+
+void IngestDaemon::on_sync(const SyncPayload &sync, uint64_t rx_ns) {
+    Ping &ping = pings_[sync.id % INGEST_SYNC_PENDING];
+
+    // Replies to our own pings only, each once
+    if (sync.id == 0 || ping.id != sync.id) { return; }
+    ping.id = 0;
+
+    if (clock_.add(SyncExchange{ping.t1_ns, sync.rx_us, sync.tx_us, rx_ns})) {
+        stats_.syncs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void IngestDaemon::map_time(Sample &sample) const {
+    if (!clock_.synced()) { return; }
+
+    sample.host_ns = clock_.to_host_ns(sample.t_us);
+    sample.host_err_ns = static_cast<uint32_t>(std::min(clock_.error_bound_ns(sample.t_us), 4294967295.0));
+}
+
+void IngestDaemon::on_frame(const Frame &frame, uint64_t rx_ns) {
+    stats_.frames.fetch_add(1, std::memory_order_relaxed);
+    broadcast(frame.bytes, frame.size);
+
+    if (frame.type == FRAME_SYNC && frame.length == sizeof(SyncPayload)) {
+        SyncPayload sync;
+        memcpy(&sync, frame.payload, sizeof(sync));
+        on_sync(sync, rx_ns);
+        return;
+    }
+
+    if (!ring_enabled_) { return; }
+
+    Sample sample = {};
+    sample.rx_ns = rx_ns;
+
+    if (frame.type == FRAME_MOTION && frame.length == sizeof(MotionPayload)) {
+        MotionPayload motion;
+        memcpy(&motion, frame.payload, sizeof(motion));
+
+        sample.t_us = motion.t_us;
+        map_time(sample);
+        sample.seq = motion.seq;
+        sample.dev = motion.dev;
+        sample.kind = SAMPLE_MOTION;
+        const float values[9] = {motion.ax, motion.ay, motion.az, motion.vx, motion.vy, motion.vz,
+                                 motion.dx, motion.dy, motion.dz};
+        memcpy(sample.motion, values, sizeof(values));
+
+        ring_.publish(sample);
+        stats_.samples.fetch_add(1, std::memory_order_relaxed);
+
+    } else if (frame.type == FRAME_STATE && frame.length == sizeof(StatePayload)) {
+        StatePayload state;
+        memcpy(&state, frame.payload, sizeof(state));
+
+        sample.t_us = state.t_us;
+        map_time(sample);
+        sample.seq = state.period;
+        sample.dev = state.dev;
+        sample.kind = SAMPLE_STATE;
+        sample.reserved = state.misses;
+        const float values[9] = {0.0f, 0.0f, 0.0f, state.vx, state.vy, state.vz, state.dx, state.dy, state.dz};
+        memcpy(sample.motion, values, sizeof(values));
+
+        ring_.publish(sample);
+        stats_.samples.fetch_add(1, std::memory_order_relaxed);
+
+    } else if (frame.type == FRAME_RAW && frame.length >= sizeof(RawHeader)) {
+        RawHeader header;
+        int16_t block[RAW_CODEC_BLOCK][RAW_CODEC_CHANNELS];
+        memcpy(&header, frame.payload, sizeof(header));
+
+        if (!raw_codec_decode(frame.payload + sizeof(header), frame.length - sizeof(header),
+                              static_cast<raw_codec_mode_t>(header.mode), block, header.n)) {
+            stats_.bad_frames.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        sample.dev = header.dev;
+        sample.kind = SAMPLE_RAW;
+        sample.reserved = header.accel_range | header.gyro_range << 8;
+        for (uint8_t i = 0; i < header.n; i++) {
+            // Samples of a block are evenly spread over its span
+            sample.seq = header.seq + i;
+            sample.t_us = header.t_us + (header.n > 1 ? static_cast<uint64_t>(header.span_us) * i / (header.n - 1) : 0);
+            map_time(sample);
+            memcpy(sample.raw, block[i], sizeof(block[i]));
+
+            ring_.publish(sample);
+        }
+        stats_.samples.fetch_add(header.n, std::memory_order_relaxed);
+    }
+}
+
+void IngestDaemon::flush_client(Client &client) {
+    while (!client.out.empty()) {
+        ssize_t n = send(client.fd, client.out.data(), client.out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n <= 0) { return; }
+        client.out.erase(0, n);
+    }
+}
+
+void IngestDaemon::broadcast(const uint8_t *data, size_t len) {
+    for (Client &client : clients_) {
+        // Never block on a client: queue what the socket does not take
+        client.out.append(reinterpret_cast<const char *>(data), len);
+        if (client.out.size() == len) { flush_client(client); }
+    }
+}
+
+void IngestDaemon::accept_clients() {
+    int fd;
+
+    while ((fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        clients_.push_back(Client{fd, {}, {}});
+        stats_.clients.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool IngestDaemon::serve_client(Client &client) {
+    char buf[256];
+    ssize_t n;
+
+    // Command lines from clients go to the device as they are
+    while ((n = recv(client.fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        client.in.append(buf, n);
+
+        size_t eol;
+        while ((eol = client.in.find('\n')) != std::string::npos) {
+            std::string line = client.in.substr(0, eol + 1);
+            client.in.erase(0, eol + 1);
+            if (write(device_fd_, line.data(), line.size()) < 0) {
+                fprintf(stderr, "rtdt_ingest: command write: %s\n", strerror(errno));
+            }
+        }
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) { return false; }
+
+    flush_client(client);
+
+    // A reader that stopped reading is dropped rather than slowing down everybody else
+    if (client.out.size() > INGEST_CLIENT_BACKLOG) {
+        stats_.dropped_clients.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+int IngestDaemon::run() {
+    uint8_t buf[INGEST_READ_CHUNK];
+    std::vector<struct pollfd> fds;
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        // Pings go out on their own timer, not right after a read: the link
+        // delivers in frames, and a ping sent just after one waits for the
+        // next. The dither (the clock's low bits) spreads them over the frame
+        // so the fastest round trips are the symmetric ones.
+        uint64_t now = monotonic_ns();
+        uint64_t wait_ns = INGEST_POLL_MS * 1000000ull;
+        if (options_.sync_ms != 0) {
+            if (now >= next_ping_ns_) {
+                send_ping();
+                next_ping_ns_ = now + options_.sync_ms * 1000000ull + now % (INGEST_SYNC_DITHER_US * 1000ull);
+            }
+            wait_ns = std::min(wait_ns, next_ping_ns_ - now);
+        }
+
+        fds.clear();
+        fds.push_back({device_fd_, POLLIN, 0});
+        if (listen_fd_ >= 0) { fds.push_back({listen_fd_, POLLIN, 0}); }
+        for (const Client &client : clients_) {
+            fds.push_back({client.fd, static_cast<short>(POLLIN | (client.out.empty() ? 0 : POLLOUT)), 0});
+        }
+
+        struct timespec timeout = {static_cast<time_t>(wait_ns / 1000000000ull), static_cast<long>(wait_ns % 1000000000ull)};
+        if (ppoll(fds.data(), fds.size(), &timeout, nullptr) < 0) {
+            if (errno == EINTR) { continue; }
+            return errno;
+        }
+
+        if (fds[0].revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) {
+            ssize_t n = read(device_fd_, buf, sizeof(buf));
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                fprintf(stderr, "rtdt_ingest: %s: %s\n", options_.device.c_str(), strerror(errno));
+                return errno;
+            }
+            // A hung up tty (USB unplug) reads 0 and polls ready forever: what was
+            // buffered has been read, nothing more will come
+            bool hung_up = (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) && n < 0;
+            if (n == 0 || hung_up) {
+                fprintf(stderr, "rtdt_ingest: %s: device gone\n", options_.device.c_str());
+                return ENODEV;
+            }
+            if (n > 0) {
+                // One timestamp per read: every frame completed by this read arrived now
+                uint64_t rx_ns = monotonic_ns();
+                stats_.bytes.fetch_add(n, std::memory_order_relaxed);
+
+                uint64_t before = ring_.published();
+                decoder_.feed(buf, n, [&](const Frame &frame) { on_frame(frame, rx_ns); });
+                stats_.crc_errors.store(decoder_.crc_errors(), std::memory_order_relaxed);
+
+                if (ring_enabled_ && ring_.published() != before) { ring_.notify(); }
+            }
+        }
+
+        size_t first_client = 1;
+        if (listen_fd_ >= 0) {
+            if (fds[1].revents & POLLIN) { accept_clients(); }
+            first_client = 2;
+        }
+
+        // Clients accepted in this round are served in the next one
+        for (size_t i = first_client, c = 0; i < fds.size(); i++) {
+            Client &client = clients_[c];
+            if (fds[i].revents == 0 || serve_client(client)) {
+                c++;
+                continue;
+            }
+            close(client.fd);
+            clients_.erase(clients_.begin() + c);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace rtdt
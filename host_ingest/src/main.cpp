@@ -0,0 +1,77 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "rtdt/ingest_daemon.h"
+
+static rtdt::IngestDaemon *daemon_instance;
+
+static void on_signal(int) {
+    if (daemon_instance != nullptr) { daemon_instance->stop(); }
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [options] <device>\n"
+            "  --shm <name>        shared memory ring name (default %s, \"\" disables)\n"
+            "  --socket <path>     fallback socket (default %s, \"\" disables)\n"
+            "  --capacity <slots>  ring slots, power of two (default %u)\n"
+            "  --sync <ms>         clock sync ping period (default %u, 0 disables)\n",
+            argv0, rtdt::SHM_RING_DEFAULT_NAME, rtdt::INGEST_DEFAULT_SOCKET, rtdt::SHM_RING_DEFAULT_CAPACITY,
+            rtdt::INGEST_SYNC_MS);
+}
+
+int main(int argc, char **argv) {
+    rtdt::IngestOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            options.shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--capacity") == 0 && i + 1 < argc) {
+            options.capacity = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc) {
+            options.sync_ms = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        } else if (argv[i][0] != '-' && options.device.empty()) {
+            options.device = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.device.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    rtdt::IngestDaemon daemon(options);
+    if (daemon.open() != 0) { return 1; }
+
+    daemon_instance = &daemon;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    fprintf(stderr, "rtdt_ingest: %s -> shm %s, socket %s\n", options.device.c_str(),
+            options.shm_name.empty() ? "(off)" : options.shm_name.c_str(),
+            options.socket_path.empty() ? "(off)" : options.socket_path.c_str());
+
+    int res = daemon.run();
+
+    const rtdt::IngestStats &stats = daemon.stats();
+    fprintf(stderr, "rtdt_ingest: bytes=%llu frames=%llu samples=%llu crc_errors=%llu bad_frames=%llu clients=%llu dropped=%llu\n",
+            (unsigned long long)stats.bytes.load(), (unsigned long long)stats.frames.load(),
+            (unsigned long long)stats.samples.load(), (unsigned long long)stats.crc_errors.load(),
+            (unsigned long long)stats.bad_frames.load(), (unsigned long long)stats.clients.load(),
+            (unsigned long long)stats.dropped_clients.load());
+
+    const rtdt::ClockSync &clock = daemon.clock();
+    if (clock.synced()) {
+        fprintf(stderr, "rtdt_ingest: clock sync pings=%llu replies=%llu drift=%.2f ppm min rtt=%.1f us error bound=%.1f us\n",
+                (unsigned long long)stats.pings.load(), (unsigned long long)stats.syncs.load(), clock.drift_ppm(),
+                clock.min_rtt_ns() / 1000.0, clock.error_bound_ns() / 1000.0);
+    }
+
+    return res == 0 ? 0 : 1;
+}
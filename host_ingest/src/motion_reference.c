@@ -0,0 +1,82 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "motion.h"
+#include "kalman.h"
+
+// The firmware's float motion pipeline behind a plain C interface, the
+// reference rtdt_reprocess checks its kernel against. Built from the
+// firmware sources with the simulator's IDF stand-in headers.
+
+// reprocess.cpp declares the state types by layout (Reference* there), a
+// field change in motion.h or kalman.h has to be made on both sides
+_Static_assert(sizeof(motion_state_t) == 9 * sizeof(float), "ReferenceState");
+_Static_assert(offsetof(motion_state_t, ax) == 0 && offsetof(motion_state_t, vx) == 3 * sizeof(float) &&
+               offsetof(motion_state_t, dx) == 6 * sizeof(float), "ReferenceState");
+_Static_assert(sizeof(motion_hold_t) == 3 * sizeof(uint16_t) && offsetof(motion_hold_t, ax_still_count) == 0 &&
+               offsetof(motion_hold_t, az_still_count) == 2 * sizeof(uint16_t), "ReferenceHold");
+_Static_assert(sizeof(kalman_params_t) == 28 && offsetof(kalman_params_t, kd) == 4 && offsetof(kalman_params_t, kb) == 12 &&
+               offsetof(kalman_params_t, still_c) == 16 && offsetof(kalman_params_t, still_threshold) == 20 &&
+               offsetof(kalman_params_t, iterations) == 24, "ReferenceKalmanParams");
+_Static_assert(sizeof(kalman_state_t) == 32 && offsetof(kalman_state_t, lp) == 12 && offsetof(kalman_state_t, still_s) == 24 &&
+               offsetof(kalman_state_t, updates) == 28, "ReferenceKalman");
+
+const float rtdt_reference_stationary = MOTION_STATIONARY_THRESHOLD;
+const int rtdt_reference_hold_cycles = MOTION_HOLD_CYCLES;
+
+/**
+ * @brief Process one raw sample as process_sample does with MATH_FLOAT
+ *
+ * @param raw Accelerometer counts X..Z
+ * @param accel_scale m/s² per count, mpu6050_accel_scale[] of the sensor's range
+ * @param bias Accelerometer bias (m/s²)
+ * @param noise_floor accel_noise_floor (m/s²)
+ * @param dt_us Time step (us)
+ * @param state Motion state, updated
+ * @param hold Stillness counters, updated
+ */
+void rtdt_reference_step(const int16_t raw[3], float accel_scale, const float bias[3], float noise_floor, uint32_t dt_us,
+                         motion_state_t *state, motion_hold_t *hold) {
+    // mpu6050_raw_to_data
+    mpu6050_data_t data = {0};
+    data.ax = raw[0] * accel_scale;
+    data.ay = raw[1] * accel_scale;
+    data.az = raw[2] * accel_scale;
+
+    mpu6050_cal_data_t cal = {.ax_bias = bias[0], .ay_bias = bias[1], .az_bias = bias[2]};
+    process_accel_data(data, cal, noise_floor, dt_us / 1e6f, state, hold);
+}
+
+/**
+ * @brief Solve the Kalman gains and start the estimator as set_drift:kalman does
+ *
+ * @param dt_us Nominal time step (us)
+ * @param bias Accelerometer bias (m/s²), the initial bias estimate
+ * @param params Gains, output
+ * @param kf Estimator state, output
+ */
+void rtdt_reference_kalman_init(uint32_t dt_us, const float bias[3], kalman_params_t *params, kalman_state_t *kf) {
+    mpu6050_cal_data_t cal = {.ax_bias = bias[0], .ay_bias = bias[1], .az_bias = bias[2]};
+    kalman_params_init(params, dt_us);
+    kalman_init(kf, &cal);
+}
+
+/**
+ * @brief Process one raw sample as process_sample does with set_drift:kalman
+ *
+ * @param raw Accelerometer counts X..Z
+ * @param accel_scale m/s² per count, mpu6050_accel_scale[] of the sensor's range
+ * @param dt_us Time step (us)
+ * @param params Gains from rtdt_reference_kalman_init
+ * @param kf Estimator state, updated
+ * @param state Motion state, updated
+ */
+void rtdt_reference_kalman_step(const int16_t raw[3], float accel_scale, uint32_t dt_us, const kalman_params_t *params,
+                                kalman_state_t *kf, motion_state_t *state) {
+    mpu6050_data_t data = {0};
+    data.ax = raw[0] * accel_scale;
+    data.ay = raw[1] * accel_scale;
+    data.az = raw[2] * accel_scale;
+
+    kalman_update(params, &data, dt_us / 1e6f, kf, state);
+}
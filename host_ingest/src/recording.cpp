@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rtdt/recording.h"
+
+namespace rtdt {
+
+#pragma pack(push, 1)
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t metadata_len;
+};
+
+#pragma pack(pop)
+
+static size_t pad(size_t size) {
+    return (size + RECORDING_ALIGN - 1) & ~(RECORDING_ALIGN - 1);
+}
+
+// Column data size of a chunk of n samples, the layout is fixed per stream and format version
+static size_t chunk_data_size(uint32_t version, uint8_t stream, size_t n) {
+    size_t size = pad(n * sizeof(int64_t)) + pad(n * sizeof(uint32_t)) + pad(n);
+    if (stream == STREAM_RAW) { return size + 6 * pad(n * sizeof(int16_t)) + (version >= 2 ? 2 * pad(n) : 0); }
+    return size + 9 * pad(n * sizeof(float));
+}
+
+Recording::~Recording() {
+    if (map_ != nullptr) { munmap(const_cast<uint8_t *>(map_), size_); }
+}
+
+int Recording::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { return errno; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return err;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size < RECORDING_HEADER_SIZE) {
+        close(fd);
+        return EPROTO;
+    }
+
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) { return errno; }
+    // Chunks are read front to back, once per parameter block
+    madvise(mem, size, MADV_SEQUENTIAL);
+
+    const uint8_t *map = static_cast<const uint8_t *>(mem);
+    FileHeader header;
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 || header.version < 1 ||
+        header.version > RECORDING_VERSION ||
+        sizeof(header) + header.metadata_len > RECORDING_HEADER_SIZE) {
+        munmap(mem, size);
+        return EPROTO;
+    }
+
+    if (map_ != nullptr) { munmap(const_cast<uint8_t *>(map_), size_); }
+    map_ = map;
+    size_ = size;
+    path_ = path;
+    version_ = header.version;
+    metadata_.assign(reinterpret_cast<const char *>(map) + sizeof(header), header.metadata_len);
+    chunks_.clear();
+
+    size_t offset = RECORDING_HEADER_SIZE;
+    while (offset + sizeof(ChunkHeader) <= size) {
+        ChunkHeader ch;
+        memcpy(&ch, map + offset, sizeof(ch));
+        if (memcmp(ch.magic, "CHNK", 4) != 0 || (ch.stream != STREAM_MOTION && ch.stream != STREAM_RAW) ||
+            ch.size != chunk_data_size(header.version, ch.stream, ch.n) || offset + sizeof(ChunkHeader) + ch.size > size) {
+            break; // truncated tail of an interrupted recording
+        }
+
+        Chunk chunk = {};
+        chunk.stream = ch.stream;
+        chunk.n = ch.n;
+        chunk.t_min_us = ch.t_min_us;
+        chunk.t_max_us = ch.t_max_us;
+
+        // The header is 32 bytes and columns are padded, so every column is aligned
+        const uint8_t *p = map + offset + sizeof(ChunkHeader);
+        chunk.t_us = reinterpret_cast<const int64_t *>(p);
+        p += pad(ch.n * sizeof(int64_t));
+        chunk.seq = reinterpret_cast<const uint32_t *>(p);
+        p += pad(ch.n * sizeof(uint32_t));
+        chunk.dev = p;
+        p += pad(ch.n);
+        if (ch.stream == STREAM_RAW) {
+            for (auto &column : chunk.raw) {
+                column = reinterpret_cast<const int16_t *>(p);
+                p += pad(ch.n * sizeof(int16_t));
+            }
+            if (header.version >= 2) {
+                chunk.accel_range = p;
+                chunk.gyro_range = p + pad(ch.n);
+            }
+        } else {
+            for (auto &column : chunk.motion) {
+                column = reinterpret_cast<const float *>(p);
+                p += pad(ch.n * sizeof(float));
+            }
+        }
+
+        chunks_.push_back(chunk);
+        offset += sizeof(ChunkHeader) + ch.size;
+    }
+    truncated_ = size - offset;
+
+    return 0;
+}
+
+std::vector<uint8_t> Recording::devices(uint8_t stream) const {
+    bool seen[256] = {};
+    for (const Chunk &chunk : chunks_) {
+        if (chunk.stream != stream) { continue; }
+        for (uint32_t i = 0; i < chunk.n; i++) { seen[chunk.dev[i]] = true; }
+    }
+
+    std::vector<uint8_t> devs;
+    for (int dev = 0; dev < 256; dev++) {
+        if (seen[dev]) { devs.push_back(static_cast<uint8_t>(dev)); }
+    }
+    return devs;
+}
+
+uint64_t Recording::count(uint8_t stream, uint8_t dev) const {
+    uint64_t n = 0;
+    for (const Chunk &chunk : chunks_) {
+        if (chunk.stream != stream) { continue; }
+        n += std::count(chunk.dev, chunk.dev + chunk.n, dev);
+    }
+    return n;
+}
+
+// Numeric member of a flat JSON object, [begin, end) spans the object
+static bool json_number(const std::string &json, size_t begin, size_t end, const char *key, double *value) {
+    std::string quoted = std::string("\"") + key + "\"";
+    size_t pos = json.find(quoted, begin);
+    if (pos == std::string::npos || pos >= end) { return false; }
+
+    pos = json.find(':', pos + quoted.size());
+    if (pos == std::string::npos || pos >= end) { return false; }
+
+    const char *start = json.c_str() + pos + 1;
+    char *stop;
+    *value = strtod(start, &stop);
+    return stop != start;
+}
+
+bool Recording::sensor_info(uint8_t dev, SensorInfo *info) const {
+    // The metadata is written by rtdt_rec.py: "sensors": {"<dev>": {flat info frame fields}, ...}
+    size_t sensors = metadata_.find("\"sensors\"");
+    if (sensors == std::string::npos) { return false; }
+
+    std::string key = "\"" + std::to_string(dev) + "\"";
+    size_t pos = metadata_.find(key, sensors);
+    if (pos == std::string::npos) { return false; }
+    size_t begin = metadata_.find('{', pos);
+    size_t end = metadata_.find('}', begin);
+    if (begin == std::string::npos || end == std::string::npos) { return false; }
+
+    static const char *const bias_keys[6] = {"ax_bias", "ay_bias", "az_bias", "gx_bias", "gy_bias", "gz_bias"};
+    double value;
+    for (int i = 0; i < 6; i++) {
+        if (!json_number(metadata_, begin, end, bias_keys[i], &value)) { return false; }
+        info->bias[i] = static_cast<float>(value);
+    }
+    info->sample_rate_hz = json_number(metadata_, begin, end, "sample_rate_hz", &value) ? static_cast<float>(value) : 0;
+    info->update_rate_ms = json_number(metadata_, begin, end, "update_rate_ms", &value) ? static_cast<uint32_t>(value) : 0;
+    info->accel_range = json_number(metadata_, begin, end, "accel_range", &value) && value >= 0 && value <= 3
+                            ? static_cast<int>(value) : -1;
+    return true;
+}
+
+} // namespace rtdt
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include "rtdt/reprocess.h"
+
+// Firmware reference, src/motion_reference.c
+extern "C" {
+struct ReferenceState {         // motion_state_t
+    float a[3], v[3], d[3];
+};
+struct ReferenceHold {          // motion_hold_t
+    uint16_t still_count[3];
+};
+struct ReferenceKalmanParams {  // kalman_params_t
+    uint32_t dt_us;
+    float kd, kv, kb;
+    float still_c;
+    float still_threshold;
+    uint32_t iterations;
+};
+struct ReferenceKalman {        // kalman_state_t
+    float b[3], lp[3], still_s;
+    uint32_t updates;
+};
+// motion_reference.c checks the firmware's types against the same sizes and offsets
+static_assert(sizeof(ReferenceState) == 36 && sizeof(ReferenceHold) == 6, "motion.h layouts");
+static_assert(sizeof(ReferenceKalmanParams) == 28 && offsetof(ReferenceKalmanParams, iterations) == 24, "kalman.h layouts");
+static_assert(sizeof(ReferenceKalman) == 32 && offsetof(ReferenceKalman, updates) == 28, "kalman.h layouts");
+extern const float rtdt_reference_stationary;
+extern const int rtdt_reference_hold_cycles;
+void rtdt_reference_step(const int16_t raw[3], float accel_scale, const float bias[3], float noise_floor, uint32_t dt_us,
+                         ReferenceState *state, ReferenceHold *hold);
+void rtdt_reference_kalman_init(uint32_t dt_us, const float bias[3], ReferenceKalmanParams *params, ReferenceKalman *kf);
+void rtdt_reference_kalman_step(const int16_t raw[3], float accel_scale, uint32_t dt_us, const ReferenceKalmanParams *params,
+                                ReferenceKalman *kf, ReferenceState *state);
+}
+
+namespace rtdt {
+
+/**
+ * @brief Walks the raw samples of one sensor chunk by chunk
+ *
+ * Time steps are the timestamp differences, like the firmware's ISR or
+ * loop timestamps, with the nominal step for the first sample and after a
+ * pause of the stream.
+ */
+class RawStream {
+public:
+    explicit RawStream(const ReprocessInput &input) : input_(input) {
+        size_t max_n = 0;
+        for (const Chunk &chunk : input.recording->chunks()) { max_n = std::max<size_t>(max_n, chunk.n); }
+        for (auto &axis : raw_) { axis.resize(max_n); }
+        accel_scale_.resize(max_n);
+        dt_us_.resize(max_n);
+    }
+
+    /**
+     * @brief Collect the sensor's samples of the next chunk that has any
+     *
+     * @return Number of samples, 0 at the end of the recording
+     */
+    size_t next() {
+        const std::vector<Chunk> &chunks = input_.recording->chunks();
+        while (chunk_ < chunks.size()) {
+            const Chunk &chunk = chunks[chunk_++];
+            if (chunk.stream != STREAM_RAW) { continue; }
+
+            size_t n = 0;
+            for (uint32_t i = 0; i < chunk.n; i++) {
+                if (chunk.dev[i] != input_.dev) { continue; }
+
+                uint32_t dt_us = input_.nominal_dt_us;
+                int64_t diff = chunk.t_us[i] - last_t_us_;
+                if (last_t_us_ >= 0 && diff >= 0 && diff <= REPROCESS_MAX_DT_US) { dt_us = static_cast<uint32_t>(diff); }
+                last_t_us_ = chunk.t_us[i];
+
+                raw_[0][n] = chunk.raw[0][i];
+                raw_[1][n] = chunk.raw[1][i];
+                raw_[2][n] = chunk.raw[2][i];
+                // Auto-ranged samples carry the range they were measured at
+                int range = chunk.accel_range != nullptr ? chunk.accel_range[i] & 0x03 : input_.accel_range;
+                accel_scale_[n] = reprocess_accel_scale(range);
+                dt_us_[n] = dt_us;
+                n++;
+            }
+            if (n > 0) { return n; }
+        }
+        return 0;
+    }
+
+    const int16_t *raw(int axis) const { return raw_[axis].data(); }
+    const float *accel_scale() const { return accel_scale_.data(); }
+    const uint32_t *dt_us() const { return dt_us_.data(); }
+
+private:
+    const ReprocessInput &input_;
+    size_t chunk_ = 0;
+    int64_t last_t_us_ = -1;
+    std::vector<int16_t> raw_[3];
+    std::vector<float> accel_scale_;
+    std::vector<uint32_t> dt_us_;
+};
+
+MotionBatch::MotionBatch(const MotionParams *params, size_t n) : lanes_(n) {
+    for (size_t l = 0; l < REPROCESS_LANES; l++) {
+        const MotionParams &p = params[l < n ? l : 0];
+        noise_floor_[l] = p.noise_floor;
+        stationary_[l] = p.stationary;
+        hold_cycles_[l] = p.hold_cycles;
+    }
+    memset(v_, 0, sizeof(v_));
+    memset(d_, 0, sizeof(d_));
+    memset(still_count_, 0, sizeof(still_count_));
+    memset(peak_v_, 0, sizeof(peak_v_));
+    memset(peak_d_, 0, sizeof(peak_d_));
+    memset(held_, 0, sizeof(held_));
+}
+
+// 8 lanes per instruction where the CPU has AVX2, 4 (SSE2) otherwise
+__attribute__((target_clones("avx2", "default")))
+void MotionBatch::run(const float *const a[3], const float *dt, size_t n) {
+    // Axes are independent: one axis at a time keeps a lane's state in registers
+    for (int k = 0; k < 3; k++) {
+        const float *x = a[k];
+        float v[REPROCESS_LANES], d[REPROCESS_LANES], peak_v[REPROCESS_LANES], peak_d[REPROCESS_LANES];
+        int32_t count[REPROCESS_LANES], held[REPROCESS_LANES];
+        memcpy(v, v_[k], sizeof(v));
+        memcpy(d, d_[k], sizeof(d));
+        memcpy(peak_v, peak_v_[k], sizeof(peak_v));
+        memcpy(peak_d, peak_d_[k], sizeof(peak_d));
+        memcpy(count, still_count_[k], sizeof(count));
+        memset(held, 0, sizeof(held));
+
+        for (size_t i = 0; i < n; i++) {
+            const float xi = x[i];
+            const float h = dt[i];
+
+            // process_accel_data, one parameter set per lane, branches as selects
+            for (size_t l = 0; l < REPROCESS_LANES; l++) {
+                const float al = std::fabs(xi) < noise_floor_[l] ? 0.0f : xi;
+                const int32_t still = std::fabs(al) < stationary_[l];
+                const int32_t c = (count[l] + (count[l] < hold_cycles_[l])) * still;
+                const int32_t zero = still & (c >= hold_cycles_[l]);
+
+                const float vn = v[l] + al * h;
+                const float dn = d[l] + vn * h;
+                const float vs = zero ? 0.0f : v[l];
+                v[l] = still ? vs : vn;
+                d[l] = still ? d[l] : dn;
+                count[l] = c;
+
+                held[l] += zero;
+                const float av = std::fabs(v[l]);
+                const float ad = std::fabs(d[l]);
+                peak_v[l] = av > peak_v[l] ? av : peak_v[l];
+                peak_d[l] = ad > peak_d[l] ? ad : peak_d[l];
+            }
+        }
+
+        memcpy(v_[k], v, sizeof(v));
+        memcpy(d_[k], d, sizeof(d));
+        memcpy(peak_v_[k], peak_v, sizeof(peak_v));
+        memcpy(peak_d_[k], peak_d, sizeof(peak_d));
+        memcpy(still_count_[k], count, sizeof(count));
+        for (size_t l = 0; l < REPROCESS_LANES; l++) { held_[k][l] += static_cast<uint32_t>(held[l]); }
+    }
+    samples_ += n;
+}
+
+MotionSummary MotionBatch::summary(size_t lane) const {
+    MotionSummary s = {};
+    s.samples = samples_;
+    for (int k = 0; k < 3; k++) {
+        s.held[k] = held_[k][lane];
+        s.peak_v[k] = peak_v_[k][lane];
+        s.peak_d[k] = peak_d_[k][lane];
+        s.final_d[k] = d_[k][lane];
+    }
+    return s;
+}
+
+// Runs a block of up to REPROCESS_LANES parameter sets over one stream
+static void run_job(const ReprocessInput &input, const MotionParams *params, size_t n, MotionSummary *out) {
+    MotionBatch batch(params, n);
+    RawStream stream(input);
+    std::vector<float> a[3];
+    std::vector<float> dt;
+
+    while (size_t count = stream.next()) {
+        for (auto &axis : a) { axis.resize(count); }
+        dt.resize(count);
+
+        // mpu6050_raw_to_data, bias compensation and the firmware's dt_us / 1e6f
+        for (int k = 0; k < 3; k++) {
+            const int16_t *raw = stream.raw(k);
+            const float *scale = stream.accel_scale();
+            for (size_t i = 0; i < count; i++) { a[k][i] = raw[i] * scale[i] - input.bias[k]; }
+        }
+        for (size_t i = 0; i < count; i++) { dt[i] = stream.dt_us()[i] / 1e6f; }
+
+        const float *const axes[3] = {a[0].data(), a[1].data(), a[2].data()};
+        batch.run(axes, dt.data(), count);
+    }
+
+    for (size_t l = 0; l < n; l++) { out[l] = batch.summary(l); }
+}
+
+static double thread_cpu_seconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+std::vector<MotionSummary> reprocess(const std::vector<ReprocessInput> &inputs, const std::vector<MotionParams> &params,
+                                     unsigned threads, ReprocessStats *stats) {
+    std::vector<MotionSummary> results(inputs.size() * params.size());
+
+    // Jobs are (input, block of parameter sets), claimed in order by the workers
+    struct Job {
+        size_t input;
+        size_t first;
+        size_t n;
+    };
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (size_t p = 0; p < params.size(); p += REPROCESS_LANES) {
+            jobs.push_back({i, p, std::min(REPROCESS_LANES, params.size() - p)});
+        }
+    }
+
+    if (threads == 0) { threads = std::max(1u, std::thread::hardware_concurrency()); }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(jobs.size(), 1)));
+
+    std::atomic<size_t> next{0};
+    std::vector<double> cpu_s(threads, 0.0);
+    auto worker = [&](unsigned t) {
+        double start = thread_cpu_seconds();
+        for (size_t j; (j = next.fetch_add(1, std::memory_order_relaxed)) < jobs.size();) {
+            const Job &job = jobs[j];
+            run_job(inputs[job.input], &params[job.first], job.n, &results[job.input * params.size() + job.first]);
+        }
+        cpu_s[t] = thread_cpu_seconds() - start;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++) { pool.emplace_back(worker, t); }
+    worker(0);
+    for (auto &thread : pool) { thread.join(); }
+    auto wall = std::chrono::steady_clock::now() - start;
+
+    if (stats != nullptr) {
+        stats->evaluations = 0;
+        for (size_t i = 0; i < inputs.size(); i++) { stats->evaluations += results[i * params.size()].samples * params.size(); }
+        stats->wall_s = std::chrono::duration<double>(wall).count();
+        stats->cpu_s = 0;
+        for (double s : cpu_s) { stats->cpu_s += s; }
+        stats->threads = threads;
+    }
+    return results;
+}
+
+MotionParams reference_params(float noise_floor) {
+    return {noise_floor, rtdt_reference_stationary, rtdt_reference_hold_cycles};
+}
+
+MotionSummary reprocess_reference(const ReprocessInput &input, float noise_floor) {
+    MotionSummary s = {};
+    ReferenceState state = {};
+    ReferenceHold hold = {};
+    RawStream stream(input);
+
+    while (size_t count = stream.next()) {
+        for (size_t i = 0; i < count; i++) {
+            const int16_t raw[3] = {stream.raw(0)[i], stream.raw(1)[i], stream.raw(2)[i]};
+            rtdt_reference_step(raw, stream.accel_scale()[i], input.bias, noise_floor, stream.dt_us()[i], &state, &hold);
+
+            for (int k = 0; k < 3; k++) {
+                bool still = std::fabs(state.a[k]) < rtdt_reference_stationary;
+                s.held[k] += still && hold.still_count[k] >= rtdt_reference_hold_cycles;
+                s.peak_v[k] = std::max(s.peak_v[k], std::fabs(state.v[k]));
+                s.peak_d[k] = std::max(s.peak_d[k], std::fabs(state.d[k]));
+            }
+        }
+        s.samples += count;
+    }
+
+    for (int k = 0; k < 3; k++) { s.final_d[k] = state.d[k]; }
+    return s;
+}
+
+MotionSummary reprocess_kalman(const ReprocessInput &input) {
+    MotionSummary s = {};
+    ReferenceState state = {};
+    ReferenceKalmanParams params;
+    ReferenceKalman kf;
+    RawStream stream(input);
+
+    rtdt_reference_kalman_init(input.nominal_dt_us, input.bias, &params, &kf);
+    while (size_t count = stream.next()) {
+        for (size_t i = 0; i < count; i++) {
+            const int16_t raw[3] = {stream.raw(0)[i], stream.raw(1)[i], stream.raw(2)[i]};
+            uint32_t updates = kf.updates;
+            rtdt_reference_kalman_step(raw, stream.accel_scale()[i], stream.dt_us()[i], &params, &kf, &state);
+
+            for (int k = 0; k < 3; k++) {
+                s.held[k] += kf.updates != updates;
+                s.peak_v[k] = std::max(s.peak_v[k], std::fabs(state.v[k]));
+                s.peak_d[k] = std::max(s.peak_d[k], std::fabs(state.d[k]));
+            }
+        }
+        s.samples += count;
+    }
+
+    for (int k = 0; k < 3; k++) { s.final_d[k] = state.d[k]; }
+    return s;
+}
+
+} // namespace rtdt
@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rtdt/reprocess.h"
+
+// Replays the raw stream of recordings through the firmware's motion
+// pipeline for a grid of parameter sets and reports the outcome of each.
+
+constexpr int BIAS_SAMPLES = 100;          // MPU6050_CAL_SAMPLES, for recordings without info frames
+
+struct ReprocessOptions {
+    std::vector<double> noise_floor = {0.05};
+    std::vector<double> stationary = {0.05};
+    std::vector<double> hold = {10};
+    unsigned threads = 0;
+    int dev = -1;                           // -1 = every sensor
+    int accel_range = -1;                   // -1 = from the info frames
+    const char *csv = nullptr;
+    size_t top = 10;
+    bool check = false;
+    bool kalman = false;
+};
+
+static int usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options] RECORDING...\n"
+            "  --noise-floor LIST   accel_noise_floor values (m/s², default 0.05)\n"
+            "  --stationary LIST    stillness thresholds (m/s², default 0.05)\n"
+            "  --hold LIST          hold cycles (default 10)\n"
+            "  --threads N          worker threads (default: one per CPU)\n"
+            "  --dev N              only this sensor\n"
+            "  --accel-range N      AFS_SEL 0..3 (±2..16 g) of version 1 recordings whose info frame does not give it\n"
+            "  --csv FILE           one row per recording, sensor and parameter set\n"
+            "  --top N              parameter sets listed in the summary (default 10)\n"
+            "  --check              compare with the firmware's process_accel_data and time both\n"
+            "  --kalman             compare the firmware's Kalman estimator with process_accel_data\n"
+            "                       at the first noise floor, drift and time per sample\n"
+            "LIST is comma separated values or start:stop:step, the grid is every combination.\n",
+            name);
+    return 2;
+}
+
+// "a,b,c" or "start:stop:step" (stop included)
+static bool parse_list(const char *arg, std::vector<double> *out) {
+    out->clear();
+    double start, stop, step;
+    char tail;
+    if (sscanf(arg, "%lf:%lf:%lf%c", &start, &stop, &step, &tail) == 3) {
+        if (step <= 0 || stop < start) { return false; }
+        size_t n = static_cast<size_t>(std::floor((stop - start) / step + 1e-9)) + 1;
+        for (size_t i = 0; i < n; i++) { out->push_back(start + i * step); }
+        return true;
+    }
+
+    for (const char *p = arg; *p != '\0';) {
+        char *end;
+        double value = strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) { return false; }
+        out->push_back(value);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !out->empty();
+}
+
+// Mean of the first samples, like mpu6050_calibrate at rest
+static bool estimate_bias(const rtdt::Recording &rec, uint8_t dev, int accel_range, float bias[3]) {
+    float sum[3] = {};
+    int n = 0;
+    for (const rtdt::Chunk &chunk : rec.chunks()) {
+        if (chunk.stream != rtdt::STREAM_RAW) { continue; }
+        for (uint32_t i = 0; i < chunk.n && n < BIAS_SAMPLES; i++) {
+            if (chunk.dev[i] != dev) { continue; }
+            int range = chunk.accel_range != nullptr ? chunk.accel_range[i] & 0x03 : accel_range;
+            for (int k = 0; k < 3; k++) { sum[k] += chunk.raw[k][i] * rtdt::reprocess_accel_scale(range); }
+            n++;
+        }
+        if (n == BIAS_SAMPLES) { break; }
+    }
+    if (n == 0) { return false; }
+    for (int k = 0; k < 3; k++) { bias[k] = sum[k] / n; }
+    return true;
+}
+
+// Nominal time step: the configured sample rate, else the first timestamp difference
+static uint32_t nominal_dt_us(const rtdt::Recording &rec, uint8_t dev, const rtdt::SensorInfo *info) {
+    if (info != nullptr && info->sample_rate_hz > 0) { return static_cast<uint32_t>(1e6f / info->sample_rate_hz); }
+
+    int64_t last = -1;
+    for (const rtdt::Chunk &chunk : rec.chunks()) {
+        if (chunk.stream != rtdt::STREAM_RAW) { continue; }
+        for (uint32_t i = 0; i < chunk.n; i++) {
+            if (chunk.dev[i] != dev) { continue; }
+            if (last >= 0 && chunk.t_us[i] > last) { return static_cast<uint32_t>(chunk.t_us[i] - last); }
+            last = chunk.t_us[i];
+        }
+    }
+    return 1000;
+}
+
+static float norm(const float v[3]) {
+    return std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+}
+
+static float max3(const float v[3]) {
+    return std::max(v[0], std::max(v[1], v[2]));
+}
+
+// Bit for bit, so that -0.0 and 0.0 or different NaNs count as a difference
+static bool same(const rtdt::MotionSummary &a, const rtdt::MotionSummary &b) {
+    return a.samples == b.samples && memcmp(a.held, b.held, sizeof(a.held)) == 0 &&
+           memcmp(a.peak_v, b.peak_v, sizeof(a.peak_v)) == 0 && memcmp(a.peak_d, b.peak_d, sizeof(a.peak_d)) == 0 &&
+           memcmp(a.final_d, b.final_d, sizeof(a.final_d)) == 0;
+}
+
+static double held_fraction(const rtdt::MotionSummary &s) {
+    return s.samples ? (s.held[0] + s.held[1] + s.held[2]) / (3.0 * s.samples) : 0.0;
+}
+
+static void write_csv(FILE *f, const std::vector<rtdt::ReprocessInput> &inputs, const std::vector<rtdt::MotionParams> &params,
+                      const std::vector<rtdt::MotionSummary> &results) {
+    fprintf(f, "recording,dev,noise_floor,stationary,hold_cycles,samples,held_x,held_y,held_z,"
+               "peak_vx,peak_vy,peak_vz,peak_dx,peak_dy,peak_dz,final_dx,final_dy,final_dz\n");
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (size_t p = 0; p < params.size(); p++) {
+            const rtdt::MotionSummary &s = results[i * params.size() + p];
+            fprintf(f, "%s,%u,%g,%g,%d,%llu,%llu,%llu,%llu,%g,%g,%g,%g,%g,%g,%g,%g,%g\n",
+                    inputs[i].recording->path().c_str(), inputs[i].dev, params[p].noise_floor, params[p].stationary,
+                    params[p].hold_cycles, (unsigned long long)s.samples, (unsigned long long)s.held[0],
+                    (unsigned long long)s.held[1], (unsigned long long)s.held[2], s.peak_v[0], s.peak_v[1], s.peak_v[2],
+                    s.peak_d[0], s.peak_d[1], s.peak_d[2], s.final_d[0], s.final_d[1], s.final_d[2]);
+        }
+    }
+}
+
+// Parameter sets ranked by the mean final drift over all streams
+static void print_summary(const std::vector<rtdt::ReprocessInput> &inputs, const std::vector<rtdt::MotionParams> &params,
+                          const std::vector<rtdt::MotionSummary> &results, size_t top) {
+    struct Row {
+        size_t param;
+        double drift_mm;
+        double peak_mm;
+        double held;
+    };
+    std::vector<Row> rows;
+    for (size_t p = 0; p < params.size(); p++) {
+        Row row = {p, 0, 0, 0};
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const rtdt::MotionSummary &s = results[i * params.size() + p];
+            row.drift_mm += norm(s.final_d) * 1e3 / inputs.size();
+            row.peak_mm = std::max(row.peak_mm, max3(s.peak_d) * 1e3);
+            row.held += held_fraction(s) / inputs.size();
+        }
+        rows.push_back(row);
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.drift_mm < b.drift_mm; });
+
+    printf("%11s %10s %5s %14s %13s %7s\n", "noise_floor", "stationary", "hold", "mean drift mm", "peak |d| mm", "held %");
+    for (size_t r = 0; r < std::min(top, rows.size()); r++) {
+        const rtdt::MotionParams &mp = params[rows[r].param];
+        printf("%11.4f %10.4f %5d %14.3f %13.3f %7.1f\n", mp.noise_floor, mp.stationary, mp.hold_cycles, rows[r].drift_mm,
+               rows[r].peak_mm, rows[r].held * 100);
+    }
+}
+
+// Runs the firmware's process_accel_data on every input for each noise floor
+// and compares with the batch kernel
+static bool check(const std::vector<rtdt::ReprocessInput> &inputs, const std::vector<double> &noise_floor, unsigned threads,
+                  double batch_rate) {
+    std::vector<rtdt::MotionParams> params;
+    for (double nf : noise_floor) { params.push_back(rtdt::reference_params(static_cast<float>(nf))); }
+    std::vector<rtdt::MotionSummary> batch = rtdt::reprocess(inputs, params, threads, nullptr);
+
+    size_t mismatches = 0;
+    uint64_t evaluations = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        for (size_t p = 0; p < params.size(); p++) {
+            rtdt::MotionSummary ref = rtdt::reprocess_reference(inputs[i], params[p].noise_floor);
+            evaluations += ref.samples;
+            if (!same(ref, batch[i * params.size() + p])) {
+                fprintf(stderr, "check: %s dev %u noise_floor %g differs from the firmware\n",
+                        inputs[i].recording->path().c_str(), inputs[i].dev, params[p].noise_floor);
+                mismatches++;
+            }
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double scalar_rate = elapsed > 0 ? evaluations / elapsed : 0;
+
+    printf("check: %zu of %zu runs bit-identical to process_accel_data (stationary %g, hold %d)\n",
+           inputs.size() * params.size() - mismatches, inputs.size() * params.size(), params[0].stationary,
+           params[0].hold_cycles);
+    printf("check: process_accel_data %.3g samples/s on one core, batch kernel %.1fx faster per core\n", scalar_rate,
+           scalar_rate > 0 ? batch_rate / scalar_rate : 0.0);
+    return mismatches == 0;
+}
+
+// Runs the firmware's Kalman estimator and process_accel_data on every input
+static void compare_kalman(const std::vector<rtdt::ReprocessInput> &inputs, float noise_floor) {
+    double hold_s = 0, kalman_s = 0, hold_drift = 0, kalman_drift = 0;
+    uint64_t samples = 0;
+
+    printf("\n%-32s %3s %16s %16s %16s %16s %8s\n", "kalman", "dev", "hold drift mm", "kalman drift mm", "hold peak mm",
+           "kalman peak mm", "zupt %");
+    for (const rtdt::ReprocessInput &input : inputs) {
+        auto start = std::chrono::steady_clock::now();
+        rtdt::MotionSummary hold = rtdt::reprocess_reference(input, noise_floor);
+        auto mid = std::chrono::steady_clock::now();
+        rtdt::MotionSummary kalman = rtdt::reprocess_kalman(input);
+        auto end = std::chrono::steady_clock::now();
+
+        hold_s += std::chrono::duration<double>(mid - start).count();
+        kalman_s += std::chrono::duration<double>(end - mid).count();
+        hold_drift += norm(hold.final_d) * 1e3 / inputs.size();
+        kalman_drift += norm(kalman.final_d) * 1e3 / inputs.size();
+        samples += hold.samples;
+
+        printf("%-32s %3u %16.3f %16.3f %16.3f %16.3f %8.1f\n", input.recording->path().c_str(), input.dev,
+               norm(hold.final_d) * 1e3, norm(kalman.final_d) * 1e3, max3(hold.peak_d) * 1e3, max3(kalman.peak_d) * 1e3,
+               kalman.samples ? 100.0 * kalman.held[0] / kalman.samples : 0.0);
+    }
+    printf("kalman: mean drift %.3f mm (hold %.3f mm at noise floor %g), %.0f ns/sample (hold %.0f ns/sample)\n",
+           kalman_drift, hold_drift, noise_floor, samples ? kalman_s * 1e9 / samples : 0.0,
+           samples ? hold_s * 1e9 / samples : 0.0);
+}
+
+int main(int argc, char **argv) {
+    ReprocessOptions opts;
+    std::vector<const char *> paths;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--check") == 0) {
+            opts.check = true;
+            continue;
+        }
+        if (strcmp(arg, "--kalman") == 0) {
+            opts.kalman = true;
+            continue;
+        }
+        if (arg[0] != '-') {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) { return usage(argv[0]); }
+
+        const char *value = argv[++i];
+        bool ok = true;
+        if (strcmp(arg, "--noise-floor") == 0) {
+            ok = parse_list(value, &opts.noise_floor);
+        } else if (strcmp(arg, "--stationary") == 0) {
+            ok = parse_list(value, &opts.stationary);
+        } else if (strcmp(arg, "--hold") == 0) {
+            ok = parse_list(value, &opts.hold);
+        } else if (strcmp(arg, "--threads") == 0) {
+            opts.threads = static_cast<unsigned>(strtoul(value, nullptr, 0));
+        } else if (strcmp(arg, "--dev") == 0) {
+            opts.dev = static_cast<int>(strtol(value, nullptr, 0));
+        } else if (strcmp(arg, "--accel-range") == 0) {
+            opts.accel_range = static_cast<int>(strtol(value, nullptr, 0));
+            ok = opts.accel_range >= 0 && opts.accel_range <= 3;
+        } else if (strcmp(arg, "--csv") == 0) {
+            opts.csv = value;
+        } else if (strcmp(arg, "--top") == 0) {
+            opts.top = strtoul(value, nullptr, 0);
+        } else {
+            return usage(argv[0]);
+        }
+        if (!ok) {
+            fprintf(stderr, "%s: bad value for %s: %s\n", argv[0], arg, value);
+            return 2;
+        }
+    }
+    if (paths.empty()) { return usage(argv[0]); }
+
+    std::vector<rtdt::MotionParams> params;
+    for (double nf : opts.noise_floor) {
+        for (double st : opts.stationary) {
+            for (double hold : opts.hold) {
+                params.push_back({static_cast<float>(nf), static_cast<float>(st), static_cast<int32_t>(hold)});
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<rtdt::Recording>> recordings;
+    std::vector<rtdt::ReprocessInput> inputs;
+    for (const char *path : paths) {
+        auto rec = std::make_unique<rtdt::Recording>();
+        int res = rec->open(path);
+        if (res != 0) {
+            fprintf(stderr, "%s: %s: %s\n", argv[0], path, res == EPROTO ? "not an RTDT recording" : strerror(res));
+            return 1;
+        }
+        if (rec->truncated() > 0) { fprintf(stderr, "%s: %s: ignoring %zu bytes of incomplete chunk\n", argv[0], path, rec->truncated()); }
+
+        for (uint8_t dev : rec->devices(rtdt::STREAM_RAW)) {
+            if (opts.dev >= 0 && dev != opts.dev) { continue; }
+
+            rtdt::SensorInfo info;
+            bool have_info = rec->sensor_info(dev, &info);
+
+            // Counts mean nothing without the range they were taken at, which version 1 recordings do not store
+            int accel_range = have_info && info.accel_range >= 0 ? info.accel_range : opts.accel_range;
+            if (accel_range < 0 && rec->version() < 2) {
+                fprintf(stderr, "%s: %s: no accelerometer range for sensor %u in the info frames, pass --accel-range\n",
+                        argv[0], path, dev);
+                return 1;
+            }
+
+            rtdt::ReprocessInput input = {rec.get(), dev, accel_range, {}, 0};
+            if (have_info) {
+                memcpy(input.bias, info.bias, sizeof(input.bias));
+            } else {
+                estimate_bias(*rec, dev, accel_range, input.bias);
+                fprintf(stderr, "%s: %s: no calibration for sensor %u, bias estimated from its first samples\n", argv[0],
+                        path, dev);
+            }
+            input.nominal_dt_us = nominal_dt_us(*rec, dev, have_info ? &info : nullptr);
+            inputs.push_back(input);
+        }
+        recordings.push_back(std::move(rec));
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "%s: no raw stream samples (record with set_output:raw)\n", argv[0]);
+        return 1;
+    }
+
+    rtdt::ReprocessStats stats;
+    std::vector<rtdt::MotionSummary> results = rtdt::reprocess(inputs, params, opts.threads, &stats);
+
+    print_summary(inputs, params, results, opts.top);
+
+    uint64_t samples = 0;
+    for (size_t i = 0; i < inputs.size(); i++) { samples += results[i * params.size()].samples; }
+    double per_core = stats.cpu_s > 0 ? stats.evaluations / stats.cpu_s : 0;
+    printf("\n%zu streams, %llu samples, %zu parameter sets: %.3g sample evaluations in %.3f s on %u threads\n",
+           inputs.size(), (unsigned long long)samples, params.size(), (double)stats.evaluations, stats.wall_s, stats.threads);
+    printf("throughput: %.3g samples/s total, %.3g samples/s per core\n",
+           stats.wall_s > 0 ? stats.evaluations / stats.wall_s : 0.0, per_core);
+
+    if (opts.csv != nullptr) {
+        FILE *f = fopen(opts.csv, "w");
+        if (f == nullptr) {
+            fprintf(stderr, "%s: %s: %s\n", argv[0], opts.csv, strerror(errno));
+            return 1;
+        }
+        write_csv(f, inputs, params, results);
+        fclose(f);
+    }
+
+    if (opts.kalman) { compare_kalman(inputs, static_cast<float>(opts.noise_floor[0])); }
+    if (opts.check && !check(inputs, opts.noise_floor, opts.threads, per_core)) { return 1; }
+    return 0;
+}
@@ -0,0 +1,194 @@
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <csignal>
+#include <ctime>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "rtdt/shm_ring.h"
+
+namespace rtdt {
+
+static long futex(std::atomic<uint32_t> *word, int op, uint32_t value, const struct timespec *timeout) {
+    // Shared (not FUTEX_PRIVATE) operations: waiters live in other processes
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, nullptr, 0);
+}
+
+static size_t ring_size(uint32_t capacity) {
+    return sizeof(ShmHeader) + static_cast<size_t>(capacity) * sizeof(ShmSlot);
+}
+
+ShmWriter::~ShmWriter() {
+    if (header_ == nullptr) { return; }
+
+    // Tell attached readers, then remove the name; mappings stay valid until unmapped
+    header_->writer_pid.store(0, std::memory_order_release);
+    notify();
+    munmap(header_, size_);
+    shm_unlink(name_.c_str());
+}
+
+int ShmWriter::create(const std::string &name, uint32_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) { return EINVAL; }
+
+    // A stale object from a crashed daemon is replaced, readers re-attach
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) { return errno; }
+
+    size_t size = ring_size(capacity);
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        close(fd);
+        shm_unlink(name.c_str());
+        return err;
+    }
+
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        int err = errno;
+        shm_unlink(name.c_str());
+        return err;
+    }
+
+    // The object is zero filled: slots start with seq 0 (never written)
+    header_ = new (mem) ShmHeader{};
+    slots_ = reinterpret_cast<ShmSlot *>(header_ + 1);
+    size_ = size;
+    name_ = name;
+
+    header_->capacity = capacity;
+    header_->slot_size = sizeof(ShmSlot);
+    header_->version = SHM_RING_VERSION;
+    header_->writer_pid.store(static_cast<uint32_t>(getpid()), std::memory_order_relaxed);
+
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = SHM_RING_MAGIC;
+
+    return 0;
+}
+
+void ShmWriter::publish(const Sample &sample) {
+    uint64_t index = header_->head.load(std::memory_order_relaxed);
+    ShmSlot &slot = slots_[index & (header_->capacity - 1)];
+
+    // Odd while the slot is being written
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample = sample;
+    slot.seq.store(2 * (index + 1), std::memory_order_release);
+
+    header_->head.store(index + 1, std::memory_order_release);
+}
+
+void ShmWriter::notify() {
+    header_->notify.fetch_add(1, std::memory_order_seq_cst);
+
+    // The syscall is only paid when somebody sleeps
+    if (header_->waiters.load(std::memory_order_seq_cst) > 0) {
+        futex(&header_->notify, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+ShmReader::~ShmReader() {
+    if (header_ != nullptr) { munmap(header_, size_); }
+}
+
+int ShmReader::attach(const std::string &name) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) { return errno; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmHeader)) {
+        close(fd);
+        return EPROTO;
+    }
+
+    // Read-write: blocking readers register themselves in `waiters`
+    void *mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) { return errno; }
+
+    auto *header = static_cast<ShmHeader *>(mem);
+    bool valid = header->magic == SHM_RING_MAGIC && header->version == SHM_RING_VERSION &&
+                 header->slot_size == sizeof(ShmSlot) &&
+                 ring_size(header->capacity) <= static_cast<size_t>(st.st_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid) {
+        munmap(mem, st.st_size);
+        return EPROTO;
+    }
+
+    header_ = header;
+    slots_ = reinterpret_cast<ShmSlot *>(header_ + 1);
+    size_ = st.st_size;
+    next_ = header_->head.load(std::memory_order_acquire);
+
+    return 0;
+}
+
+size_t ShmReader::read(Sample *out, size_t max) {
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    uint32_t capacity = header_->capacity;
+    size_t n = 0;
+
+    // Fell behind by more than the ring: skip to the oldest slot still intact
+    if (head - next_ > capacity) {
+        lost_ += head - next_ - capacity;
+        next_ = head - capacity;
+    }
+
+    while (next_ < head && n < max) {
+        const ShmSlot &slot = slots_[next_ & (capacity - 1)];
+        uint64_t expected = 2 * (next_ + 1);
+
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        out[n] = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.seq.load(std::memory_order_relaxed);
+
+        // Overwritten while copying (or before): the writer has lapped this reader
+        if (before != expected || after != expected) {
+            lost_++;
+        } else {
+            n++;
+        }
+        next_++;
+    }
+
+    return n;
+}
+
+bool ShmReader::wait(int timeout_ms) {
+    uint32_t seen = header_->notify.load(std::memory_order_acquire);
+    if (header_->head.load(std::memory_order_acquire) != next_) { return true; }
+
+    struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+
+    header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+    // Recheck after registering, a notify in between would otherwise be missed
+    if (header_->head.load(std::memory_order_seq_cst) == next_) {
+        futex(&header_->notify, FUTEX_WAIT, seen, &timeout);
+    }
+    header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    return header_->head.load(std::memory_order_acquire) != next_;
+}
+
+bool ShmReader::writer_alive() const {
+    uint32_t pid = header_->writer_pid.load(std::memory_order_acquire);
+
+    return pid != 0 && (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM);
+}
+
+} // namespace rtdt
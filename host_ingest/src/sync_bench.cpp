@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "rtdt/ingest_daemon.h"
+
+// Clock sync error of rtdt_ingest against a device stand-in on a pty. The
+// stand-in runs its own clock, offset and rate-shifted from the host's,
+// answers pings like the firmware and streams motion frames stamped with
+// the device time of each sample. Like USB full speed, it only exchanges
+// bytes with the host at frame boundaries, which delays pings and samples
+// by up to a frame. The true host time of every sample is known, so the
+// error of its mapped time (Sample::host_ns) is measured directly.
+
+struct SyncBenchOptions {
+    uint32_t seconds = 30;
+    uint32_t rate_hz = 1000;
+    uint32_t frame_us = 1000;       // USB frame, 0 = bytes pass at once
+    uint32_t sync_ms = rtdt::INGEST_SYNC_MS;
+    double ppm = 40.0;              // Device clock rate error (positive = fast)
+    uint32_t warmup_s = 5;          // Samples before this are not counted
+};
+
+// Device clock of the stand-in: it booted long before the host started
+// counting and runs ppm fast
+struct DeviceClock {
+    uint64_t start_ns;
+    double ppm;
+
+    uint64_t us(uint64_t host_ns) const {
+        return 123456789ull + static_cast<uint64_t>((host_ns - start_ns) * (1.0 + ppm * 1e-6) / 1000.0);
+    }
+};
+
+struct Errors {
+    std::vector<double> ns;
+
+    void report(const char *name, const char *what) {
+        if (ns.empty()) {
+            printf("%-16s n=0\n", name);
+            return;
+        }
+        std::sort(ns.begin(), ns.end());
+        auto pct = [&](double p) { return ns[std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()))] / 1000.0; };
+        printf("%-16s n=%-6zu p50=%7.1f us p99=%7.1f us max=%7.1f us  (%s)\n", name, ns.size(), pct(0.50), pct(0.99),
+               ns.back() / 1000.0, what);
+    }
+};
+
+static int open_pty(std::string *slave) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) { return -1; }
+
+    *slave = ptsname(master);
+
+    struct termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    return master;
+}
+
+static void sleep_until_ns(uint64_t t_ns) {
+    struct timespec ts = {static_cast<time_t>(t_ns / 1000000000ull), static_cast<long>(t_ns % 1000000000ull)};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+}
+
+/**
+ * @brief The device: answers pings and streams samples until done
+ *
+ * Wakes at every frame boundary (or at every sample without frames),
+ * takes the ping lines that arrived, and writes their replies together
+ * with the samples latched since the last boundary.
+ */
+static void device_standin(int master, const SyncBenchOptions &options, const DeviceClock &clock,
+                           std::vector<std::atomic<uint64_t>> *truth, std::atomic<bool> *done) {
+    uint64_t sample_ns = 1000000000ull / options.rate_hz;
+    uint64_t step_ns = options.frame_us ? options.frame_us * 1000ull : sample_ns;
+    uint64_t latch_ns = clock.start_ns + sample_ns / 3;    // Sensor clock out of phase with the frames
+    uint64_t wake_ns = clock.start_ns;
+    uint32_t seq = 0;
+    std::string in;
+    std::vector<uint8_t> out;
+    uint8_t frame[rtdt::FRAME_MAX_SIZE];
+    char buf[256];
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    while (!done->load(std::memory_order_relaxed) && seq < truth->size()) {
+        wake_ns += step_ns;
+        sleep_until_ns(wake_ns);
+        out.clear();
+
+        // Pings are read at the frame they arrived in
+        ssize_t n;
+        while ((n = read(master, buf, sizeof(buf))) > 0) { in.append(buf, n); }
+        uint64_t rx_us = clock.us(rtdt::monotonic_ns());
+
+        std::vector<uint32_t> pings;
+        size_t eol;
+        while ((eol = in.find('\n')) != std::string::npos) {
+            if (in.compare(0, 5, "ping:") == 0) { pings.push_back(strtoul(in.c_str() + 5, nullptr, 10)); }
+            in.erase(0, eol + 1);
+        }
+
+        for (uint64_t now = rtdt::monotonic_ns(); latch_ns <= now && seq < truth->size(); latch_ns += sample_ns, seq++) {
+            rtdt::MotionPayload motion = {};
+            motion.seq = seq;
+            motion.t_us = clock.us(latch_ns);
+            motion.az = 9.81f;
+            (*truth)[seq].store(latch_ns, std::memory_order_release);
+
+            size_t len = rtdt::encode_frame(frame, rtdt::FRAME_MOTION, &motion, sizeof(motion));
+            out.insert(out.end(), frame, frame + len);
+        }
+
+        // Replies are stamped last, right before the write like telemetry_emit_sync
+        for (uint32_t id : pings) {
+            rtdt::SyncPayload sync = {id, rx_us, clock.us(rtdt::monotonic_ns())};
+            size_t len = rtdt::encode_frame(frame, rtdt::FRAME_SYNC, &sync, sizeof(sync));
+            out.insert(out.end(), frame, frame + len);
+        }
+
+        for (size_t off = 0; off < out.size();) {
+            ssize_t w = write(master, &out[off], out.size() - off);
+            if (w < 0 && errno != EINTR && errno != EAGAIN) { return; }
+            if (w > 0) { off += w; }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    SyncBenchOptions options;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        double value = strtod(argv[i + 1], nullptr);
+        if (strcmp(argv[i], "--seconds") == 0) {
+            options.seconds = static_cast<uint32_t>(value);
+        } else if (strcmp(argv[i], "--rate") == 0) {
+            options.rate_hz = std::max<uint32_t>(static_cast<uint32_t>(value), 1);
+        } else if (strcmp(argv[i], "--frame-us") == 0) {
+            options.frame_us = static_cast<uint32_t>(value);
+        } else if (strcmp(argv[i], "--sync") == 0) {
+            options.sync_ms = std::max<uint32_t>(static_cast<uint32_t>(value), 1);
+        } else if (strcmp(argv[i], "--ppm") == 0) {
+            options.ppm = value;
+        } else if (strcmp(argv[i], "--warmup") == 0) {
+            options.warmup_s = static_cast<uint32_t>(value);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds n] [--rate hz] [--frame-us us (0 = none)] [--sync ms] [--ppm drift] [--warmup s]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    std::string slave;
+    int master = open_pty(&slave);
+    if (master < 0) {
+        perror("rtdt_sync_bench: pty");
+        return 1;
+    }
+
+    rtdt::IngestOptions ingest;
+    ingest.device = slave;
+    ingest.shm_name = "/rtdt_sync_bench_" + std::to_string(getpid());
+    ingest.socket_path = "";
+    ingest.sync_ms = options.sync_ms;
+
+    rtdt::IngestDaemon daemon(ingest);
+    if (daemon.open() != 0) { return 1; }
+
+    rtdt::ShmReader reader;
+    if (reader.attach(ingest.shm_name) != 0) {
+        fprintf(stderr, "rtdt_sync_bench: cannot attach %s\n", ingest.shm_name.c_str());
+        return 1;
+    }
+
+    std::vector<std::atomic<uint64_t>> truth(static_cast<size_t>(options.seconds) * options.rate_hz);
+    DeviceClock clock = {rtdt::monotonic_ns(), options.ppm};
+    std::atomic<bool> done{false};
+
+    std::thread daemon_thread([&] { daemon.run(); });
+    std::thread device_thread(device_standin, master, std::cref(options), std::cref(clock), &truth, &done);
+
+    // Mapped time and arrival time against the true latch time, after the warm-up
+    Errors sync_err, bound, arrival;
+    uint64_t unsynced = 0, within = 0, seen = 0;
+    uint64_t warmup_ns = clock.start_ns + options.warmup_s * 1000000000ull;
+    rtdt::Sample samples[64];
+    while (seen < truth.size()) {
+        if (!reader.wait(500)) { break; }
+
+        size_t n = reader.read(samples, 64);
+        for (size_t i = 0; i < n; i++, seen++) {
+            uint64_t latch_ns = truth[samples[i].seq].load(std::memory_order_acquire);
+            if (latch_ns < warmup_ns) { continue; }
+            if (samples[i].host_ns == 0) {
+                unsynced++;
+                continue;
+            }
+            double err = std::fabs(static_cast<double>(samples[i].host_ns) - static_cast<double>(latch_ns));
+            sync_err.ns.push_back(err);
+            bound.ns.push_back(samples[i].host_err_ns);
+            if (err <= samples[i].host_err_ns) { within++; }
+            arrival.ns.push_back(static_cast<double>(samples[i].rx_ns - latch_ns));
+        }
+    }
+
+    done.store(true);
+    daemon.stop();
+    device_thread.join();
+    daemon_thread.join();
+    close(master);
+
+    const rtdt::ClockSync &model = daemon.clock();
+    printf("%u s at %u Hz, device clock %+.1f ppm, %u us frames, ping every %u ms\n", options.seconds,
+           options.rate_hz, options.ppm, options.frame_us, options.sync_ms);
+    printf("clock model: exchanges=%llu drift=%+.2f ppm min rtt=%.1f us error bound=%.1f us\n",
+           (unsigned long long)model.exchanges(), model.drift_ppm(), model.min_rtt_ns() / 1000.0,
+           model.error_bound_ns() / 1000.0);
+    size_t n_synced = sync_err.ns.size();
+    sync_err.report("|sync error|", "mapped host time - true latch");
+    bound.report("error bound", "Sample::host_err_ns");
+    arrival.report("arrival delay", "host receive - true latch, unsynced");
+    printf("within bound: %.2f%% of %zu samples, %llu before the first reply\n",
+           n_synced ? 100.0 * within / n_synced : 0.0, n_synced, (unsigned long long)unsynced);
+
+    return 0;
+}
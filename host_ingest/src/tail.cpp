@@ -0,0 +1,50 @@
+#include <cstdio>
+#include <cstring>
+
+#include "rtdt/shm_ring.h"
+
+// Prints the samples published by rtdt_ingest, one line per sample
+int main(int argc, char **argv) {
+    const char *name = argc > 1 ? argv[1] : rtdt::SHM_RING_DEFAULT_NAME;
+    rtdt::ShmReader reader;
+
+    int res = reader.attach(name);
+    if (res != 0) {
+        fprintf(stderr, "rtdt_tail: %s: %s\n", name, strerror(res));
+        return 1;
+    }
+
+    rtdt::Sample samples[64];
+    uint64_t lost = 0;
+
+    while (reader.writer_alive()) {
+        if (!reader.wait(500)) { continue; }
+
+        size_t n = reader.read(samples, 64);
+        for (size_t i = 0; i < n; i++) {
+            const rtdt::Sample &s = samples[i];
+
+            if (s.kind == rtdt::SAMPLE_MOTION) {
+                printf("%u %u %llu a=%.3f,%.3f,%.3f v=%.3f,%.3f,%.3f d=%.3f,%.3f,%.3f\n",
+                       s.dev, s.seq, (unsigned long long)s.t_us,
+                       s.motion[0], s.motion[1], s.motion[2], s.motion[3], s.motion[4], s.motion[5],
+                       s.motion[6], s.motion[7], s.motion[8]);
+            } else if (s.kind == rtdt::SAMPLE_STATE) {
+                printf("%u %u %llu v=%.3f,%.3f,%.3f d=%.3f,%.3f,%.3f misses=%u\n",
+                       s.dev, s.seq, (unsigned long long)s.t_us,
+                       s.motion[3], s.motion[4], s.motion[5], s.motion[6], s.motion[7], s.motion[8], s.reserved);
+            } else if (s.kind == rtdt::SAMPLE_RAW) {
+                printf("%u %u %llu raw=%d,%d,%d,%d,%d,%d ranges=%u,%u\n", s.dev, s.seq, (unsigned long long)s.t_us,
+                       s.raw[0], s.raw[1], s.raw[2], s.raw[3], s.raw[4], s.raw[5], s.reserved & 0xFF, s.reserved >> 8);
+            }
+        }
+
+        if (reader.lost() != lost) {
+            fprintf(stderr, "rtdt_tail: lost %llu samples\n", (unsigned long long)(reader.lost() - lost));
+            lost = reader.lost();
+        }
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "motion.h"
+
+#include "check.h"
+
+// process_accel_block against process_accel_data, both from the firmware
+// source and built like rtdt_reprocess (no fused multiply-add). The state
+// after every sample must be bit-identical, whatever the time steps and
+// however the stream is cut into blocks.
+
+#define MOTION_TEST_SAMPLES     200000      // Samples per stream
+#define MOTION_TEST_DT_US       1000        // Nominal time step (1 kHz)
+#define MOTION_TEST_NOISE_FLOOR 0.1f        // accel_noise_floor (m/s²)
+#define MOTION_TEST_STILL       300         // Samples at rest between movements, longer than MOTION_HOLD_CYCLES
+#define MOTION_TEST_MOVE        500         // Samples of each movement
+
+static const mpu6050_cal_data_t bias = {.ax_bias = 0.21f, .ay_bias = -0.13f, .az_bias = 9.79f};
+
+static float ax[MOTION_TEST_SAMPLES], ay[MOTION_TEST_SAMPLES], az[MOTION_TEST_SAMPLES];
+static int64_t t_us[MOTION_TEST_SAMPLES];
+static float ref[9][MOTION_TEST_SAMPLES], out[9][MOTION_TEST_SAMPLES];
+static motion_hold_t ref_hold[MOTION_TEST_SAMPLES];
+
+static uint32_t rng = 12345;
+
+static uint32_t next_random(void) {
+    // xorshift32, the same stream on every libc
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/**
+ * @brief Random counts in [-range, range]
+ */
+static int random_counts(int range) {
+    return (int)(next_random() % (2 * range + 1)) - range;
+}
+
+/**
+ * @brief Sensor counts of a stream alternating rest and movement, as m/s²
+ *
+ * At rest the noise stays below the noise floor, then below and above the
+ * stillness threshold in movements, so every branch of the stillness logic
+ * is taken.
+ */
+static void make_stream(void) {
+    const float bias_counts[3] = {bias.ax_bias / ACCEL_SCALE, bias.ay_bias / ACCEL_SCALE, bias.az_bias / ACCEL_SCALE};
+
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) {
+        int phase = i % (MOTION_TEST_STILL + MOTION_TEST_MOVE);
+        int excitation[3] = {0, 0, 0};
+
+        if (phase >= MOTION_TEST_STILL) {
+            // A movement on X, a smaller one on Y, Z mostly within the noise floor
+            int k = phase - MOTION_TEST_STILL;
+            excitation[0] = (k < MOTION_TEST_MOVE / 2 ? 1 : -1) * 300 + random_counts(100);
+            excitation[1] = random_counts(60);
+            excitation[2] = random_counts(25);
+        }
+
+        ax[i] = (int16_t)(bias_counts[0] + excitation[0] + random_counts(10)) * ACCEL_SCALE;
+        ay[i] = (int16_t)(bias_counts[1] + excitation[1] + random_counts(10)) * ACCEL_SCALE;
+        az[i] = (int16_t)(bias_counts[2] + excitation[2] + random_counts(10)) * ACCEL_SCALE;
+    }
+}
+
+static void make_constant_times(void) {
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) { t_us[i] = (int64_t)(i + 1) * MOTION_TEST_DT_US; }
+}
+
+static void make_jittered_times(void) {
+    int64_t t = 0;
+
+    // Readout jitter, runs of equal steps as in FIFO drains and the odd stall
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) {
+        uint32_t r = next_random() % 100;
+        if (r < 40 && i > 0) {
+            t += t_us[i - 1] - (i > 1 ? t_us[i - 2] : 0);
+        } else if (r < 99) {
+            t += MOTION_TEST_DT_US - 150 + next_random() % 301;
+        } else {
+            t += 20 * MOTION_TEST_DT_US + next_random() % 5000;
+        }
+        t_us[i] = t;
+    }
+}
+
+/**
+ * @brief Run process_accel_data sample by sample, recording the state after each one
+ */
+static void run_reference(void) {
+    motion_state_t state = {0};
+    motion_hold_t hold = {0};
+    int64_t t_prev = 0;
+
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) {
+        // Time step as process_sample computes it
+        uint32_t dt_us = (uint32_t)(t_us[i] - t_prev);
+        t_prev = t_us[i];
+
+        mpu6050_data_t data = {.ax = ax[i], .ay = ay[i], .az = az[i]};
+        process_accel_data(data, bias, MOTION_TEST_NOISE_FLOOR, dt_us / 1e6f, &state, &hold);
+
+        const float s[9] = {state.ax, state.ay, state.az, state.vx, state.vy, state.vz, state.dx, state.dy, state.dz};
+        for (int k = 0; k < 9; k++) { ref[k][i] = s[k]; }
+        ref_hold[i] = hold;
+    }
+}
+
+/**
+ * @brief Run process_accel_block over the stream cut into blocks of block_len samples
+ *
+ * @return Number of samples at which a state or a stillness counter differs from the reference
+ */
+static int run_blocks(size_t block_len) {
+    motion_state_t state = {0};
+    motion_hold_t hold = {0};
+    int mismatches = 0;
+
+    memset(out, 0xFF, sizeof(out));
+
+    for (size_t start = 0; start < MOTION_TEST_SAMPLES; start += block_len) {
+        size_t n = MOTION_TEST_SAMPLES - start < block_len ? MOTION_TEST_SAMPLES - start : block_len;
+        motion_block_t block = {.ax = ax + start, .ay = ay + start, .az = az + start, .t_us = t_us + start,
+                                .t_prev_us = start ? t_us[start - 1] : 0, .n = n};
+        motion_track_t track = {.ax = out[0] + start, .ay = out[1] + start, .az = out[2] + start,
+                                .vx = out[3] + start, .vy = out[4] + start, .vz = out[5] + start,
+                                .dx = out[6] + start, .dy = out[7] + start, .dz = out[8] + start};
+
+        process_accel_block(&block, &bias, MOTION_TEST_NOISE_FLOOR, &state, &hold, &track);
+
+        // The counters are only returned at the end of a block
+        size_t last = start + n - 1;
+        if (memcmp(&hold, &ref_hold[last], sizeof(hold)) != 0) { mismatches++; }
+    }
+
+    // Bit for bit: memcmp also tells -0.0f from 0.0f
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) {
+        bool same = true;
+        for (int k = 0; k < 9; k++) { same = same && memcmp(&out[k][i], &ref[k][i], sizeof(float)) == 0; }
+        mismatches += !same;
+    }
+
+    const float final[9] = {state.ax, state.ay, state.az, state.vx, state.vy, state.vz, state.dx, state.dy, state.dz};
+    for (int k = 0; k < 9; k++) { mismatches += memcmp(&final[k], &ref[k][MOTION_TEST_SAMPLES - 1], sizeof(float)) != 0; }
+
+    return mismatches;
+}
+
+/**
+ * @brief Compare the block path with the reference for one set of sample times
+ */
+static void check_times(const char *name) {
+    // One sample, a typical FIFO drain, the staging size and one more, a whole stream
+    static const size_t block_lens[] = {1, 50, MOTION_BLOCK_STEPS, MOTION_BLOCK_STEPS + 1, 1000, MOTION_TEST_SAMPLES};
+    uint64_t held = 0;
+
+    run_reference();
+
+    // The stream has to reach the stillness hold and integrate, or the comparison proves little
+    for (int i = 0; i < MOTION_TEST_SAMPLES; i++) { held += ref_hold[i].ax_still_count >= MOTION_HOLD_CYCLES; }
+    CHECK(held > MOTION_TEST_SAMPLES / 4);
+    CHECK(held < MOTION_TEST_SAMPLES * 3 / 4);
+    CHECK(ref[6][MOTION_TEST_SAMPLES - 1] != 0.0f);
+
+    for (size_t b = 0; b < sizeof(block_lens) / sizeof(block_lens[0]); b++) {
+        int mismatches = run_blocks(block_lens[b]);
+        if (mismatches != 0) { fprintf(stderr, "%s times, blocks of %zu: %d mismatches\n", name, block_lens[b], mismatches); }
+        CHECK_EQ(mismatches, 0);
+    }
+
+    // No track: the state still comes out the same
+    motion_state_t state = {0};
+    motion_hold_t hold = {0};
+    motion_block_t block = {.ax = ax, .ay = ay, .az = az, .t_us = t_us, .t_prev_us = 0, .n = MOTION_TEST_SAMPLES};
+    process_accel_block(&block, &bias, MOTION_TEST_NOISE_FLOOR, &state, &hold, NULL);
+    CHECK(memcmp(&state.dx, &ref[6][MOTION_TEST_SAMPLES - 1], sizeof(float)) == 0);
+    CHECK(memcmp(&hold, &ref_hold[MOTION_TEST_SAMPLES - 1], sizeof(hold)) == 0);
+}
+
+int main(void) {
+    make_stream();
+
+    make_constant_times();
+    check_times("constant");
+
+    make_jittered_times();
+    check_times("jittered");
+
+    return check_report("test_motion_block");
+}
@@ -0,0 +1,325 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "rtdt/ingest_daemon.h"
+#include "rtdt/shm_ring.h"
+
+#include "check.h"
+
+// ShmWriter and ShmReader in one process, on a ring named after the test's
+// pid so a running daemon is left alone. Readers are threads here, but they
+// map the ring on their own like separate processes do.
+
+constexpr uint32_t SHM_TEST_CAPACITY = 16;          // Slots of the lapping tests
+constexpr uint32_t SHM_TEST_STRESS_CAPACITY = 64;   // Slots of the concurrent lapping test
+constexpr uint32_t SHM_TEST_STRESS_SAMPLES = 500000; // Samples published flat out by the writer thread
+constexpr int SHM_TEST_READERS = 4;                 // Blocking readers of the wakeup test
+constexpr int SHM_TEST_BATCHES = 20;                // Batches published to the sleeping readers
+constexpr int SHM_TEST_BATCH = 10;                  // Samples per batch
+constexpr int SHM_TEST_TIMEOUT_MS = 5000;           // Reader wait timeout, far beyond any wakeup
+constexpr int SHM_TEST_ASLEEP_MS = 5;               // Time given to registered readers to enter the futex wait
+
+static const std::string ring_name = "/rtdt_test_" + std::to_string(getpid());
+
+static rtdt::Sample make_sample(uint32_t seq) {
+    // Every field depends on seq, so a torn copy shows up
+    rtdt::Sample s = {};
+    s.rx_ns = seq * 3ULL + 1;
+    s.t_us = seq * 1000ULL;
+    s.seq = seq;
+    s.dev = static_cast<uint8_t>(seq);
+    s.kind = rtdt::SAMPLE_MOTION;
+    for (int k = 0; k < 9; k++) { s.motion[k] = static_cast<float>(seq) + k; }
+    s.host_err_ns = ~seq;
+
+    return s;
+}
+
+static bool sample_matches(const rtdt::Sample &s, uint32_t seq) {
+    rtdt::Sample expected = make_sample(seq);
+
+    return s.seq == seq && s.rx_ns == expected.rx_ns && s.t_us == expected.t_us && s.dev == expected.dev &&
+           s.motion[0] == expected.motion[0] && s.motion[8] == expected.motion[8] && s.host_err_ns == expected.host_err_ns;
+}
+
+/**
+ * @brief Map the ring's header, as a process poking at the shared memory would
+ */
+static rtdt::ShmHeader *map_ring(size_t *size) {
+    int fd = shm_open(ring_name.c_str(), O_RDWR, 0);
+    if (fd < 0) { return nullptr; }
+
+    *size = static_cast<size_t>(lseek(fd, 0, SEEK_END));
+    void *mem = mmap(nullptr, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return mem == MAP_FAILED ? nullptr : static_cast<rtdt::ShmHeader *>(mem);
+}
+
+// --- Single Thread ---
+
+static void test_attach() {
+    rtdt::ShmWriter writer;
+    rtdt::ShmReader reader;
+
+    CHECK_EQ(reader.attach(ring_name), ENOENT);
+    CHECK_EQ(writer.create(ring_name, 0), EINVAL);
+    CHECK_EQ(writer.create(ring_name, 24), EINVAL);
+    CHECK_EQ(writer.create(ring_name, SHM_TEST_CAPACITY), 0);
+
+    // Reading starts with the first sample published after the attach
+    for (uint32_t i = 0; i < 3; i++) { writer.publish(make_sample(i)); }
+    CHECK_EQ(reader.attach(ring_name), 0);
+    CHECK(reader.writer_alive());
+
+    rtdt::Sample out[SHM_TEST_CAPACITY];
+    CHECK_EQ(reader.read(out, SHM_TEST_CAPACITY), 0);
+    for (uint32_t i = 3; i < 8; i++) { writer.publish(make_sample(i)); }
+    writer.notify();
+
+    CHECK_EQ(reader.read(out, 2), 2);
+    CHECK(sample_matches(out[0], 3) && sample_matches(out[1], 4));
+    CHECK_EQ(reader.read(out, SHM_TEST_CAPACITY), 3);
+    CHECK(sample_matches(out[0], 5) && sample_matches(out[2], 7));
+    CHECK_EQ(reader.lost(), 0);
+}
+
+static void test_lapped() {
+    rtdt::ShmWriter writer;
+    rtdt::ShmReader reader;
+    rtdt::Sample out[SHM_TEST_CAPACITY];
+
+    CHECK_EQ(writer.create(ring_name, SHM_TEST_CAPACITY), 0);
+    CHECK_EQ(reader.attach(ring_name), 0);
+
+    // Exactly one ring behind: nothing lost yet
+    for (uint32_t i = 0; i < SHM_TEST_CAPACITY; i++) { writer.publish(make_sample(i)); }
+    CHECK_EQ(reader.read(out, 4), 4);
+    CHECK(sample_matches(out[0], 0));
+    CHECK_EQ(reader.lost(), 0);
+
+    // The writer laps the reader: it resumes with the oldest sample still in the ring
+    for (uint32_t i = SHM_TEST_CAPACITY; i < 3 * SHM_TEST_CAPACITY + 5; i++) { writer.publish(make_sample(i)); }
+    size_t n = reader.read(out, SHM_TEST_CAPACITY);
+    CHECK_EQ(n, SHM_TEST_CAPACITY);
+    CHECK_EQ(reader.lost(), 2 * SHM_TEST_CAPACITY + 5 - 4);
+    for (size_t i = 0; i < n; i++) { CHECK(sample_matches(out[i], 2 * SHM_TEST_CAPACITY + 5 + i)); }
+
+    // Caught up, the count stays
+    writer.publish(make_sample(3 * SHM_TEST_CAPACITY + 5));
+    CHECK_EQ(reader.read(out, SHM_TEST_CAPACITY), 1);
+    CHECK(sample_matches(out[0], 3 * SHM_TEST_CAPACITY + 5));
+    CHECK_EQ(reader.lost(), 2 * SHM_TEST_CAPACITY + 1);
+    CHECK_EQ(reader.read(out, SHM_TEST_CAPACITY), 0);
+}
+
+static void test_overwritten_slot() {
+    rtdt::ShmWriter writer;
+    rtdt::ShmReader reader;
+    rtdt::Sample out[SHM_TEST_CAPACITY];
+    size_t size = 0;
+
+    CHECK_EQ(writer.create(ring_name, SHM_TEST_CAPACITY), 0);
+    CHECK_EQ(reader.attach(ring_name), 0);
+    for (uint32_t i = 0; i < 8; i++) { writer.publish(make_sample(i)); }
+
+    // A writer that has started on slot 2 again after the reader loaded the head
+    rtdt::ShmHeader *header = map_ring(&size);
+    CHECK(header != nullptr);
+    if (header == nullptr) { return; }
+    auto *slots = reinterpret_cast<rtdt::ShmSlot *>(header + 1);
+    slots[2].seq.store(2 * (2 + SHM_TEST_CAPACITY) + 1, std::memory_order_relaxed);
+
+    // The slot is skipped and counted, its neighbours come through
+    CHECK_EQ(reader.read(out, SHM_TEST_CAPACITY), 7);
+    CHECK_EQ(reader.lost(), 1);
+    CHECK(sample_matches(out[1], 1) && sample_matches(out[2], 3));
+
+    munmap(header, size);
+}
+
+// --- Threads ---
+
+static void test_lapped_concurrent() {
+    rtdt::ShmWriter writer;
+    rtdt::ShmReader reader;
+    std::atomic<bool> done{false};
+
+    CHECK_EQ(writer.create(ring_name, SHM_TEST_STRESS_CAPACITY), 0);
+    CHECK_EQ(reader.attach(ring_name), 0);
+
+    // The writer runs flat out into a small ring, so the reader is lapped over and over
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < SHM_TEST_STRESS_SAMPLES; i++) {
+            writer.publish(make_sample(i));
+            if (i % 64 == 63) { std::this_thread::yield(); }
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    rtdt::Sample out[SHM_TEST_STRESS_CAPACITY];
+    uint64_t received = 0, out_of_order = 0, corrupt = 0;
+    int64_t last = -1;
+    for (uint64_t loop = 0;; loop++) {
+        bool finished = done.load(std::memory_order_acquire);
+        size_t n = reader.read(out, SHM_TEST_STRESS_CAPACITY / 2);
+
+        for (size_t i = 0; i < n; i++) {
+            if (static_cast<int64_t>(out[i].seq) <= last) { out_of_order++; }
+            if (!sample_matches(out[i], out[i].seq)) { corrupt++; }
+            last = out[i].seq;
+        }
+        received += n;
+
+        if (n == 0 && finished) { break; }
+        if (n == 0) { std::this_thread::yield(); }
+
+        // Nap now and then, like a consumer that was descheduled
+        if (loop % 256 == 255) { std::this_thread::sleep_for(std::chrono::microseconds(200)); }
+    }
+    producer.join();
+
+    // Every sample is either received intact and in order or counted as lost
+    fprintf(stderr, "concurrent lapping: received %llu, lost %llu\n", (unsigned long long)received,
+            (unsigned long long)reader.lost());
+    CHECK_EQ(out_of_order, 0);
+    CHECK_EQ(corrupt, 0);
+    CHECK_EQ(received + reader.lost(), SHM_TEST_STRESS_SAMPLES);
+    CHECK_EQ(last, SHM_TEST_STRESS_SAMPLES - 1);
+    CHECK(reader.lost() > 0);
+}
+
+/**
+ * @brief What one blocking reader saw
+ */
+struct WaitResult {
+    uint64_t received = 0;
+    uint64_t timeouts = 0;
+    uint64_t lost = 0;
+    uint64_t out_of_order = 0;
+    uint64_t max_wake_ns = 0;
+};
+
+static void test_wakeup() {
+    rtdt::ShmWriter writer;
+    std::vector<WaitResult> results(SHM_TEST_READERS);
+    std::vector<std::atomic<uint64_t>> progress(SHM_TEST_READERS);
+    std::vector<std::thread> readers;
+    std::atomic<uint64_t> notified_ns{0};
+    const uint64_t expected = static_cast<uint64_t>(SHM_TEST_BATCHES) * SHM_TEST_BATCH;
+    size_t size = 0;
+
+    CHECK_EQ(writer.create(ring_name, rtdt::SHM_RING_DEFAULT_CAPACITY), 0);
+    rtdt::ShmHeader *header = map_ring(&size);
+    CHECK(header != nullptr);
+    if (header == nullptr) { return; }
+
+    for (int r = 0; r < SHM_TEST_READERS; r++) {
+        readers.emplace_back([&, r] {
+            WaitResult &res = results[r];
+            rtdt::ShmReader reader;
+            rtdt::Sample out[SHM_TEST_BATCH];
+
+            if (reader.attach(ring_name) != 0) { return; }
+            while (res.received < expected) {
+                if (!reader.wait(SHM_TEST_TIMEOUT_MS)) {
+                    if (++res.timeouts > 1) { break; }
+                    continue;
+                }
+
+                uint64_t wake_ns = rtdt::monotonic_ns() - notified_ns.load(std::memory_order_acquire);
+                if (wake_ns > res.max_wake_ns) { res.max_wake_ns = wake_ns; }
+
+                size_t n = reader.read(out, SHM_TEST_BATCH);
+                for (size_t i = 0; i < n; i++) { res.out_of_order += out[i].seq != res.received + i; }
+                res.received += n;
+                progress[r].store(res.received, std::memory_order_release);
+            }
+            res.lost = reader.lost();
+        });
+    }
+
+    // Every batch goes out once all readers caught up and sleep on the futex, one notify must wake them all
+    uint32_t seq = 0;
+    for (int b = 0; b < SHM_TEST_BATCHES; b++) {
+        auto asleep = [&] {
+            for (auto &p : progress) {
+                if (p.load(std::memory_order_acquire) != seq) { return false; }
+            }
+            return header->waiters.load() == SHM_TEST_READERS;
+        };
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SHM_TEST_TIMEOUT_MS / 2);
+        while (!asleep() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(asleep());
+
+        // Registered readers are only about to call the futex, give them time to get there
+        std::this_thread::sleep_for(std::chrono::milliseconds(SHM_TEST_ASLEEP_MS));
+
+        for (int i = 0; i < SHM_TEST_BATCH; i++) { writer.publish(make_sample(seq++)); }
+        notified_ns.store(rtdt::monotonic_ns(), std::memory_order_release);
+        writer.notify();
+    }
+
+    for (auto &t : readers) { t.join(); }
+
+    for (int r = 0; r < SHM_TEST_READERS; r++) {
+        CHECK_EQ(results[r].received, expected);
+        CHECK_EQ(results[r].timeouts, 0);
+        CHECK_EQ(results[r].lost, 0);
+        CHECK_EQ(results[r].out_of_order, 0);
+        CHECK(results[r].max_wake_ns < SHM_TEST_TIMEOUT_MS * 1000000ULL / 5);
+    }
+    CHECK_EQ(header->waiters.load(), 0);
+
+    munmap(header, size);
+}
+
+static void test_writer_exit() {
+    auto writer = std::make_unique<rtdt::ShmWriter>();
+    rtdt::ShmReader reader;
+    size_t size = 0;
+
+    CHECK_EQ(writer->create(ring_name, SHM_TEST_CAPACITY), 0);
+    CHECK_EQ(reader.attach(ring_name), 0);
+    rtdt::ShmHeader *header = map_ring(&size);
+    CHECK(header != nullptr);
+    if (header == nullptr) { return; }
+
+    // A reader asleep when the writer goes away is woken and sees it gone
+    uint64_t start_ns = rtdt::monotonic_ns();
+    std::thread sleeper([&] { CHECK(!reader.wait(SHM_TEST_TIMEOUT_MS)); });
+    while (header->waiters.load() < 1) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    writer.reset();
+    sleeper.join();
+
+    CHECK(rtdt::monotonic_ns() - start_ns < SHM_TEST_TIMEOUT_MS * 1000000ULL / 5);
+    CHECK(!reader.writer_alive());
+
+    // The name is gone with the writer
+    rtdt::ShmReader late;
+    CHECK_EQ(late.attach(ring_name), ENOENT);
+
+    munmap(header, size);
+}
+
+int main() {
+    test_attach();
+    test_lapped();
+    test_overwritten_slot();
+    test_lapped_concurrent();
+    test_wakeup();
+    test_writer_exit();
+
+    return check_report("test_shm_ring");
+}